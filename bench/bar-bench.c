@@ -16,7 +16,6 @@
 #include <smlt_context.h>
 #include <smlt_generator.h>
 #include <smlt_barrier.h>
-#include <smlt_barrier.h>
 #include <numa.h>
 #include <platforms/measurement_framework.h>
 
@@ -32,12 +31,14 @@ uint32_t* active_cores;
 
 struct smlt_context *context = NULL;
 static struct smlt_topology *active_topo;
+static struct smlt_barrier *active_bar;
 static pthread_barrier_t bar;
 
 __thread struct sk_measurement m;
 __thread struct sk_measurement m2;
 
-#define TOPO_NAME(x,y) sprintf(x, "%s_%s", y, smlt_topology_get_name(active_topo));
+#define TOPO_NAME(x,y) sprintf(x, "%s_%s_%s", y, smlt_topology_get_name(active_topo), \
+                              smlt_barrier_type_to_name(smlt_barrier_get_type(active_bar)));
 /**
  * \brief get a array of cores with a ceartain placement
  */
@@ -109,7 +110,7 @@ static void* barrier(void* a)
 
     for (int j = 0; j < NUM_RUNS; j++) {
         sk_m_restart_tsc(&m);
-        smlt_barrier_wait(context);
+        smlt_barrier_enter(active_bar);
 
         if (smlt_node_get_id() == (active_cores[active_threads-1])) {
             sk_m_add(&m);
@@ -124,6 +125,42 @@ static void* barrier(void* a)
     return 0;
 }
 
+/**
+ * \brief runs every barrier algorithm on the active context
+ */
+static void run_barriers(uint32_t* cores, int n)
+{
+    errval_t err;
+
+    for (int t = SMLT_BARRIER_TREE; t < SMLT_BARRIER_NUM_TYPES; t++) {
+        err = smlt_barrier_create(context, (smlt_barrier_type_t) t, &active_bar);
+        if (smlt_err_is_fail(err)) {
+            printf("FAILED TO CREATE %s BARRIER !\n",
+                   smlt_barrier_type_to_name((smlt_barrier_type_t) t));
+            continue;
+        }
+
+        pthread_barrier_init(&bar, NULL, n);
+
+        struct smlt_node *node;
+        for (uint64_t j = 0; j < n; j++) {
+            node = smlt_get_node_by_id(cores[j]);
+            err = smlt_node_start(node, barrier, (void*) j);
+            if (smlt_err_is_fail(err)) {
+                printf("Staring node failed \n");
+            }
+        }
+
+        for (int j=0; j < n; j++) {
+            node = smlt_get_node_by_id(cores[j]);
+            smlt_node_join(node);
+        }
+
+        pthread_barrier_destroy(&bar);
+        smlt_barrier_free(active_bar);
+    }
+}
+
 int main(int argc, char **argv)
 {
     char name[100];
@@ -138,7 +175,6 @@ int main(int argc, char **argv)
 
     for (int i = 4; i < num_threads+1; i++) {
 
-        pthread_barrier_init(&bar, NULL, i);
         printf("Running %d cores\n", i);
 
         active_threads = i;
@@ -173,24 +209,11 @@ int main(int argc, char **argv)
         printf("Executing Barrier with %d cores rr\n", i);
         printf("----------------------------------------\n");
         
-        struct smlt_node *node;
-        for (uint64_t j = 0; j < i; j++) {
-            node = smlt_get_node_by_id(cores[j]);
-            err = smlt_node_start(node, barrier, (void*) j);
-            if (smlt_err_is_fail(err)) {
-                printf("Staring node failed \n");
-            }   
-        }
-
-        for (int j=0; j < i; j++) {
-            node = smlt_get_node_by_id(cores[j]);
-            smlt_node_join(node);
-        }
+        run_barriers(cores, i);
     }
 
     for (int i = 4; i < num_threads+1; i++) {
 
-        pthread_barrier_init(&bar, NULL, i);
 
         active_threads = i;
         uint32_t* cores = placement(i, true);
@@ -221,19 +244,7 @@ int main(int argc, char **argv)
         printf("Executing Barrier with %d cores fill\n", i);
         printf("----------------------------------------\n");
         
-        struct smlt_node *node;
-        for (uint64_t j = 0; j < i; j++) {
-            node = smlt_get_node_by_id(cores[j]);
-            err = smlt_node_start(node, barrier, (void*) j);
-            if (smlt_err_is_fail(err)) {
-                printf("Staring node failed \n");
-            }   
-        }
-
-        for (int j=0; j < i; j++) {
-            node = smlt_get_node_by_id(cores[j]);
-            smlt_node_join(node);
-        }
+        run_barriers(cores, i);
     }
 
 }
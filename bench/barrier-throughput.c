@@ -84,7 +84,32 @@ static void* barrier(void* a)
     return NULL;
 }
 
-#define NUM_EXP 2
+static void* split_barrier(void* a)
+{
+    cycles_t *buf = (cycles_t*) malloc(sizeof(cycles_t)*NUM_RESULTS);
+    assert (buf!=NULL);
+
+    char skmtitle[100];
+    snprintf(skmtitle, 100, "barriers_split-barrier%d", num_threads);
+    sk_m_init(&m, NUM_RESULTS, skmtitle, buf);
+
+    smlt_barrier_arrive(ctx);
+    for (unsigned j=0; j<NUM_RESULTS; j++) {
+        sk_m_restart_tsc(&m);
+        for (int epoch=0; epoch<NUM_RUNS; epoch++) {
+            // the next arrival overlaps with the release of the previous one
+            smlt_barrier_arrive(ctx);
+            smlt_barrier_depart(ctx);
+        }
+        sk_m_add(&m);
+    }
+    smlt_barrier_depart(ctx);
+    sk_m_print(&m);
+
+    return NULL;
+}
+
+#define NUM_EXP 3
 
 #define max(a,b) \
     ({ __typeof__ (a) _a = (a); \
@@ -109,11 +134,13 @@ int main(int argc, char **argv)
     worker_func_t* workers[NUM_EXP] = {
         &barrier,
         &mcs_barrier,
+        &split_barrier,
     };
 
     const char *labels[NUM_EXP] = {
         "Smelt barrier",
         "MCS barrier",
+        "Smelt split barrier",
     };
 
 
@@ -0,0 +1,159 @@
+/*
+ * Copyright (c) 2016 ETH Zurich.
+ * All rights reserved.
+ *
+ * This file is distributed under the terms in the attached LICENSE file.
+ * If you do not find this file, copies can be found by writing to:
+ * ETH Zurich D-INFK, Universitaetstr. 6, CH-8092 Zurich. Attn: Systems Group.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <smlt.h>
+#include <smlt_topology.h>
+#include <smlt_context.h>
+#include <smlt_generator.h>
+#include <smlt_consensus.h>
+#include <platforms/measurement_framework.h>
+
+#define NUM_RUNS 10000
+#define NUM_RESULTS 1000
+
+#define NUM_EXP 4
+
+uint32_t num_threads;
+
+struct smlt_context *context = NULL;
+
+///< batch size and window of the experiments
+static uint32_t batch_sizes[NUM_EXP] = { 1, 8, 32, 32 };
+static uint32_t windows[NUM_EXP] = { 1, 64, 64, 256 };
+static uint32_t exp_idx;
+
+__thread struct sk_measurement m;
+
+/**
+ * \brief the replicated state: a counter per node
+ */
+static void apply(uint64_t idx, struct smlt_msg *cmd, void *arg)
+{
+    uint64_t *state = (uint64_t *)arg;
+    state[cmd->data[0] % num_threads] += cmd->data[1];
+}
+
+static void* consensus(void* a)
+{
+    errval_t err;
+    char outname[1024];
+    struct smlt_consensus *cons;
+    uint64_t state[num_threads];
+
+    memset(state, 0, sizeof(state));
+
+    uint32_t batch_size = batch_sizes[exp_idx];
+    uint32_t window = windows[exp_idx];
+
+    err = smlt_consensus_create(context, batch_size, window, apply, state,
+                                &cons);
+    if (smlt_err_is_fail(err)) {
+        printf("FAILED TO CREATE THE REPLICATED LOG\n");
+        return 0;
+    }
+
+    if (!smlt_context_is_root(context)) {
+        smlt_consensus_run(cons);
+        smlt_consensus_destroy(cons);
+        return 0;
+    }
+
+    cycles_t *buf = (cycles_t*) malloc(sizeof(cycles_t)*NUM_RESULTS);
+    sprintf(outname, "consensus_b%u_w%u_%d", batch_size, window, num_threads);
+    sk_m_init(&m, NUM_RESULTS, outname, buf);
+
+    struct smlt_msg* msg = smlt_message_alloc(2);
+    msg->words = 2;
+
+    cycles_t start = bench_tsc();
+    for (int j = 0; j < NUM_RUNS; j++) {
+        sk_m_restart_tsc(&m);
+        for (uint32_t k = 0; k < batch_size; k++) {
+            msg->data[0] = k;
+            msg->data[1] = j;
+            smlt_consensus_propose(cons, msg);
+        }
+        sk_m_add(&m);
+    }
+    smlt_consensus_shutdown(cons);
+    cycles_t end = bench_tsc();
+
+    sk_m_print(&m);
+
+    printf("consensus_b%u_w%u_%d ops=%" PRIu64 " cycles/op=%.2f\n",
+           batch_size, window, num_threads, smlt_consensus_get_applied(cons),
+           (double)(end - start) / smlt_consensus_get_applied(cons));
+
+    smlt_consensus_destroy(cons);
+
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    errval_t err;
+
+    if (argc == 2) {
+        num_threads = atoi(argv[1]);
+    } else {
+        num_threads = sysconf(_SC_NPROCESSORS_ONLN);
+    }
+
+    err = smlt_init(num_threads, true);
+    if (smlt_err_is_fail(err)) {
+        printf("FAILED TO INITIALIZE !\n");
+        return 1;
+    }
+
+    uint32_t cores[num_threads];
+    for (unsigned int i = 0; i < num_threads; i++) {
+        cores[i] = i;
+    }
+
+    struct smlt_generated_model* model = NULL;
+    err = smlt_generate_model(cores, num_threads, NULL, &model);
+    if (smlt_err_is_fail(err)) {
+        model = NULL;
+    }
+
+    struct smlt_topology *topo = NULL;
+    err = smlt_topology_create(model, "adaptivetree", &topo);
+    if (smlt_err_is_fail(err)) {
+        printf("FAILED TO CREATE TOPOLOGY !\n");
+        return 1;
+    }
+
+    err = smlt_context_create(topo, &context);
+    if (smlt_err_is_fail(err)) {
+        printf("FAILED TO INITIALIZE CONTEXT !\n");
+        return 1;
+    }
+
+    for (exp_idx = 0; exp_idx < NUM_EXP; exp_idx++) {
+        struct smlt_node *node;
+        for (uint64_t j = 0; j < num_threads; j++) {
+            node = smlt_get_node_by_id(j);
+            err = smlt_node_start(node, consensus, (void*) j);
+            if (smlt_err_is_fail(err)) {
+                printf("Staring node failed \n");
+            }
+        }
+
+        for (unsigned int j = 0; j < num_threads; j++) {
+            node = smlt_get_node_by_id(j);
+            smlt_node_join(node);
+        }
+    }
+
+    return 0;
+}
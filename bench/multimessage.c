@@ -433,6 +433,9 @@ int main(int argc, char **argv)
             printf("FAILED TO INITIALIZE queuepair! for core %lu\n", s);
             abort();
         }
+
+        printf("UMP push mode 0->%zu: %s\n", s,
+               smlt_ump_queue_push_name((*src)->q.ump.tx.push));
     }
 
     smlt_platform_pin_thread(sender); // << pin master thread
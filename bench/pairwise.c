@@ -10,6 +10,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>
+#include <string.h>
 #include <smlt.h>
 #include <smlt_node.h>
 #include <smlt_queuepair.h>
@@ -22,6 +23,10 @@
 
 static coreid_t step_size = 1;
 
+// the transport of the measured queue pairs
+static smlt_qp_type_t qp_type = SMLT_QP_TYPE_UMP;
+static const char *qp_type_name = "ump";
+
 // defines the batch size
 #define NUM_MESSAGES 8
 static size_t num_messages = NUM_MESSAGES;
@@ -143,11 +148,26 @@ int main(int argc, char **argv)
     coreid_t num_cores = (coreid_t) sysconf(_SC_NPROCESSORS_CONF);
     printf("NUM_CORES=%d\n", num_cores);
 
-    if (argc == 2) {
+    if (argc >= 2) {
         step_size = atoi(argv[1]);
     }
 
+    if (argc >= 3) {
+        qp_type_name = argv[2];
+        if (!strcmp(qp_type_name, "ump")) {
+            qp_type = SMLT_QP_TYPE_UMP;
+        } else if (!strcmp(qp_type_name, "ffq")) {
+            qp_type = SMLT_QP_TYPE_FFQ;
+        } else if (!strcmp(qp_type_name, "shm")) {
+            qp_type = SMLT_QP_TYPE_SHM;
+        } else {
+            printf("usage: %s [step_size] [ump|ffq|shm]\n", argv[0]);
+            return 1;
+        }
+    }
+
     printf("STEP_SIZE=%d\n", step_size);
+    printf("QP_TYPE=%s\n", qp_type_name);
 
 
 // enable this, if you want to make NUM_MSG depend ot the number of cores per cluster
@@ -206,7 +226,7 @@ int main(int argc, char **argv)
             struct smlt_qp **src = &(queue_pairs[s][r]);
             struct smlt_qp **dst = &(queue_pairs[r][s]);
 
-            err = smlt_queuepair_create(SMLT_QP_TYPE_UMP,
+            err = smlt_queuepair_create(qp_type,
                                         src, dst, s, r);
             if (smlt_err_is_fail(err)) {
                 printf("FAILED TO INITIALIZE !\n");
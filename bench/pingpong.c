@@ -217,6 +217,10 @@ int main(int argc, char **argv)
 
         assert(src);
         assert(dst);
+
+        printf("UMP push mode %u->0: %s, 0->%u: %s\n", s,
+               smlt_ump_queue_push_name((*src)->q.ump.tx.push), s,
+               smlt_ump_queue_push_name((*dst)->q.ump.tx.push));
     }
 
     smlt_platform_pin_thread(0);
@@ -0,0 +1,48 @@
+/*
+ * Copyright (c) 2016 ETH Zurich.
+ * All rights reserved.
+ *
+ * This file is distributed under the terms in the attached LICENSE file.
+ * If you do not find this file, copies can be found by writing to:
+ * ETH Zurich D-INFK, Universitaetstr. 6, CH-8092 Zurich. Attn: Systems Group.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <smlt.h>
+#include <smlt_generator.h>
+#include <smlt_profiler.h>
+
+/*
+ * Measures the pairwise link costs of this machine and stores them in the
+ * per-host profile cache, which is used by the generator whenever the
+ * Simulator is not available.
+ */
+int main(int argc, char **argv)
+{
+    errval_t err;
+    char path[256];
+
+    uint32_t num_cores = (uint32_t) sysconf(_SC_NPROCESSORS_ONLN);
+
+    err = smlt_init(num_cores, false);
+    if (smlt_err_is_fail(err)) {
+        printf("FAILED TO INITIALIZE !\n");
+        return 1;
+    }
+
+    smlt_profiler_get_path(path, sizeof(path));
+    printf("Profiling %" PRIu32 " cores, writing profile to %s\n",
+           smlt_get_num_proc(), path);
+
+    err = smlt_generator_update_measurments();
+    if (smlt_err_is_fail(err)) {
+        printf("FAILED TO PROFILE THE MACHINE !\n");
+        return 1;
+    }
+
+    printf("Profile written to %s\n", path);
+
+    return 0;
+}
@@ -41,6 +41,9 @@ struct smlt_context* ctx;
 
 int num_threads = 0;
 
+// options of the shared memory channel
+uint32_t shm_flags = SMLT_CHANNEL_FLAG_NONE;
+
 
 __thread struct sk_measurement m;
 __thread cycles_t buf[NUM_VALUES];
@@ -53,8 +56,9 @@ void* shm_func(void* arg)
     char writer[128];
     char reader[128];
 
-    sprintf(writer, "writer_shm%d", num_threads);
-    sprintf(reader, "reader_shm%d", num_threads);
+    const char *layout = (shm_flags & SMLT_CHANNEL_FLAG_SEP_HEADER) ? "sep" : "";
+    sprintf(writer, "writer_shm%s%d", layout, num_threads);
+    sprintf(reader, "reader_shm%s%d", layout, num_threads);
 
     if (id == 0) {
         sk_m_init(&m, NUM_VALUES, writer, buf);
@@ -236,7 +240,8 @@ void run(bool use_mp, bool use_tree)
 
         }else {
             c = &shm;
-            smlt_channel_create(&c, &cores[0], &cores[1], 1, i-1);  
+            smlt_channel_create_flags(&c, &cores[0], &cores[1], 1, i-1,
+                                      shm_flags);
         } 
 
         struct smlt_node* node;
@@ -277,6 +282,9 @@ int main(int argc, char ** argv)
 
     // shared memory
     run(false, false);
+    // shared memory, separate headers
+    shm_flags = SMLT_CHANNEL_FLAG_SEP_HEADER;
+    run(false, false);
     // message passing
     run(true, false);
     // tree
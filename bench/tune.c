@@ -0,0 +1,74 @@
+/*
+ * Copyright (c) 2016 ETH Zurich.
+ * All rights reserved.
+ *
+ * This file is distributed under the terms in the attached LICENSE file.
+ * If you do not find this file, copies can be found by writing to:
+ * ETH Zurich D-INFK, Universitaetstr. 6, CH-8092 Zurich. Attn: Systems Group.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <smlt.h>
+#include <smlt_barrier.h>
+#include <smlt_tune.h>
+
+static const char *op_names[SMLT_TUNE_NUM_OPS] = {
+    "barrier", "broadcast", "reduce", "reduce_all"
+};
+
+int main(int argc, char **argv)
+{
+    errval_t err;
+    uint32_t num_threads;
+
+    if (argc == 2) {
+        num_threads = atoi(argv[1]);
+    } else {
+        num_threads = sysconf(_SC_NPROCESSORS_ONLN);
+    }
+
+    err = smlt_init(num_threads, true);
+    if (smlt_err_is_fail(err)) {
+        printf("FAILED TO INITIALIZE !\n");
+        return 1;
+    }
+
+    coreid_t cores[num_threads];
+    for (unsigned int i = 0; i < num_threads; i++) {
+        cores[i] = i;
+    }
+
+    printf("Tuning %u cores\n", num_threads);
+
+    err = smlt_tune_run(cores, num_threads);
+    if (smlt_err_is_fail(err)) {
+        printf("FAILED TO TUNE !\n");
+        return 1;
+    }
+
+    char topo[SMLT_TUNE_NAMELEN];
+    smlt_tune_get_topology(cores, num_threads, topo, sizeof(topo));
+    printf("context topology: %s\n", topo);
+
+    for (int op = 0; op < SMLT_TUNE_NUM_OPS; op++) {
+        struct smlt_tune_entry e;
+        err = smlt_tune_get_entry(cores, num_threads, (smlt_tune_op_t) op, &e);
+        if (smlt_err_is_fail(err)) {
+            continue;
+        }
+
+        if (op == SMLT_TUNE_BARRIER) {
+            printf("%-10s %s/%s cycles=%" PRIu64 "\n", op_names[op],
+                   smlt_barrier_type_to_name((smlt_barrier_type_t) e.barrier),
+                   e.topo, e.cycles);
+            continue;
+        }
+
+        printf("%-10s %s cycles=%" PRIu64 "\n", op_names[op], e.topo,
+               e.cycles);
+    }
+
+    return 0;
+}
@@ -12,6 +12,9 @@
 
 #define PORT "25041"
 
+// initial size of the receive buffer, grows as needed
+#define RECV_BUF_SIZE (64 * 1024)
+
 /**
  * \brief Read from environment variable as string
  */
@@ -28,71 +31,326 @@ static char* get_env_str(const char *envname, const char *defaultvalue)
     return env;
 }
 
-int smlt_tree_parse_wrapper(const char* json_string,
-                            unsigned ncores,
-                            uint16_t** model,
-                            uint32_t * num_leafs,
-                            uint32_t** leafs,
-                            uint32_t* t_root,
-                            uint32_t* len_model)
+/*
+ * ===========================================================================
+ * model parser
+ * ===========================================================================
+ *
+ * The Simulator returns a JSON object of the form
+ *
+ *   { "root": 0, "leaf_nodes": [ ... ], "model": [ [ ... ], ... ], ... }
+ *
+ * The parser below walks the string once and decodes the arrays directly into
+ * the result buffers. Unknown keys are skipped, a missing "root" defaults to
+ * the first node of the model.
+ */
+
+struct smlt_json_cursor {
+    const char *p;
+    const char *end;
+};
+
+static void smlt_json_skip_ws(struct smlt_json_cursor *c)
 {
+    while (c->p < c->end && (*c->p == ' ' || *c->p == '\n' ||
+                             *c->p == '\t' || *c->p == '\r')) {
+        c->p++;
+    }
+}
 
-    try {
+static bool smlt_json_expect(struct smlt_json_cursor *c, char ch)
+{
+    smlt_json_skip_ws(c);
+    if (c->p < c->end && *c->p == ch) {
+        c->p++;
+        return true;
+    }
+    return false;
+}
 
-        Json::Value root;
-        // Json::CharReaderBuilder rbuilder;
-        // rbuilder["collectComments"] = false;
-        std::string errs;
-        // bool ok = Json::parseFromStream(rbuilder, rec, &root, &errs);
+static bool smlt_json_peek(struct smlt_json_cursor *c, char ch)
+{
+    smlt_json_skip_ws(c);
+    return (c->p < c->end && *c->p == ch);
+}
 
-        Json::CharReaderBuilder rbuilder;
-        Json::CharReader* reader = rbuilder.newCharReader();
+/**
+ * \brief Parses a string, returns its contents without copying
+ */
+static bool smlt_json_string(struct smlt_json_cursor *c, const char **str,
+                             size_t *len)
+{
+    if (!smlt_json_expect(c, '"')) {
+        return false;
+    }
 
-        reader->parse(json_string, json_string+strlen(json_string)-1,
-                      &root, &errs);
-        // Extract last node
-        Json::Value ln = root.get("root", "");
-        int lnval = ln.asInt();
-        *t_root = (uint32_t)lnval;
+    const char *start = c->p;
+    while (c->p < c->end && *c->p != '"') {
+        if (*c->p == '\\') {
+            c->p++;
+        }
+        c->p++;
+    }
 
-        // Extract GIT revision number
-        Json::Value git_revision = root.get("git-version", "");
-        printf("Simulator GIT revision %s\n", git_revision.asString().c_str());
+    if (c->p >= c->end) {
+        return false;
+    }
 
-        // Extract leaf node
+    *str = start;
+    *len = c->p - start;
+    c->p++;
 
-        Json::Value leafs_j = root.get("leaf_nodes", "");
-        *num_leafs = leafs_j.size();
-        *leafs = (uint32_t*) malloc(sizeof(uint32_t)* (*num_leafs));
-        assert(*leafs != NULL);
+    return true;
+}
 
-        for (unsigned i=0; i<*num_leafs; i++) {
-            (*leafs)[i] = leafs_j.get(i, Json::Value()).asInt();
+static bool smlt_json_uint(struct smlt_json_cursor *c, uint32_t *val)
+{
+    smlt_json_skip_ws(c);
+
+    uint64_t v = 0;
+    const char *start = c->p;
+    while (c->p < c->end && *c->p >= '0' && *c->p <= '9') {
+        v = v * 10 + (*c->p - '0');
+        if (v > UINT32_MAX) {
+            return false;
         }
+        c->p++;
+    }
+
+    *val = (uint32_t)v;
+    return (c->p != start);
+}
 
-        Json::Value elem = root.get("model", "");
-        *model = (uint16_t*)  malloc(sizeof(uint16_t)*elem.size()*elem.size());
-        assert(*model != NULL);
-        int x = 0;
-        int y = 0;
-        *len_model = elem.size();
-        for (Json::ValueIterator i=elem.begin(); i != elem.end(); i++) {
-            y = 0;
-            Json::Value inner = (*i);
-            for (Json::ValueIterator k=inner.begin(); k != inner.end(); k++) {
-
-                Json::Value val = (*k);
-                (*model)[x*elem.size()+y] = (uint32_t) val.asInt();
-                y++;
+/**
+ * \brief Skips over an arbitrary value
+ */
+static bool smlt_json_skip_value(struct smlt_json_cursor *c)
+{
+    const char *str;
+    size_t len;
+
+    smlt_json_skip_ws(c);
+    if (c->p >= c->end) {
+        return false;
+    }
+
+    if (*c->p == '"') {
+        return smlt_json_string(c, &str, &len);
+    }
+
+    if (*c->p != '[' && *c->p != '{') {
+        /* number or literal */
+        while (c->p < c->end && !strchr(",}] \t\r\n", *c->p)) {
+            c->p++;
+        }
+        return true;
+    }
+
+    int depth = 0;
+    do {
+        if (c->p >= c->end) {
+            return false;
+        }
+        if (*c->p == '"') {
+            if (!smlt_json_string(c, &str, &len)) {
+                return false;
             }
-            x++;
+            continue;
+        }
+        if (*c->p == '[' || *c->p == '{') {
+            depth++;
+        } else if (*c->p == ']' || *c->p == '}') {
+            depth--;
         }
+        c->p++;
+    } while (depth > 0);
 
+    return true;
+}
+
+/**
+ * \brief Counts the elements of the array starting at the cursor
+ *
+ * Only used on flat arrays of numbers, does not move the cursor.
+ */
+static uint32_t smlt_json_count_elements(struct smlt_json_cursor *c)
+{
+    struct smlt_json_cursor look = *c;
+    uint32_t count = 0;
+
+    if (!smlt_json_expect(&look, '[')) {
+        return 0;
+    }
+    if (smlt_json_peek(&look, ']')) {
         return 0;
-    } catch (...) {
+    }
+
+    count = 1;
+    while (look.p < look.end && *look.p != ']') {
+        if (*look.p == ',') {
+            count++;
+        }
+        look.p++;
+    }
+
+    return count;
+}
+
+/**
+ * \brief Decodes a flat array of numbers into vals
+ */
+static bool smlt_json_uint_array(struct smlt_json_cursor *c, uint32_t *vals,
+                                 uint32_t num, uint32_t max)
+{
+    if (!smlt_json_expect(c, '[')) {
+        return false;
+    }
+
+    for (uint32_t i = 0; i < num; i++) {
+        uint32_t v;
+        if (i > 0 && !smlt_json_expect(c, ',')) {
+            return false;
+        }
+        if (!smlt_json_uint(c, &v) || v > max) {
+            return false;
+        }
+        vals[i] = v;
+    }
+
+    return smlt_json_expect(c, ']');
+}
+
+static bool smlt_json_parse_model(struct smlt_json_cursor *c,
+                                  uint16_t** model,
+                                  uint32_t* len_model)
+{
+    if (!smlt_json_expect(c, '[')) {
+        return false;
+    }
+
+    /* the length of the first row determines the size of the matrix */
+    uint32_t len = smlt_json_count_elements(c);
+    if (len == 0) {
+        return false;
+    }
 
+    *model = (uint16_t*) malloc(sizeof(uint16_t) * len * len);
+    assert(*model != NULL);
+    *len_model = len;
+
+    for (uint32_t x = 0; x < len; x++) {
+        if (x > 0 && !smlt_json_expect(c, ',')) {
+            return false;
+        }
+        if (!smlt_json_expect(c, '[')) {
+            return false;
+        }
+        for (uint32_t y = 0; y < len; y++) {
+            uint32_t v;
+            if (y > 0 && !smlt_json_expect(c, ',')) {
+                return false;
+            }
+            if (!smlt_json_uint(c, &v) || v > UINT16_MAX) {
+                return false;
+            }
+            (*model)[x * len + y] = (uint16_t)v;
+        }
+        if (!smlt_json_expect(c, ']')) {
+            return false;
+        }
+    }
+
+    return smlt_json_expect(c, ']');
+}
+
+#define SMLT_JSON_KEY(str, len, key) \
+    ((len) == sizeof(key) - 1 && strncmp(str, key, len) == 0)
+
+int smlt_tree_parse_buffer(const char* json_string,
+                           size_t json_len,
+                           unsigned ncores,
+                           uint16_t** model,
+                           uint32_t * num_leafs,
+                           uint32_t** leafs,
+                           uint32_t* t_root,
+                           uint32_t* len_model)
+{
+    struct smlt_json_cursor c = { json_string, json_string + json_len };
+    bool first = true, has_model = false;
+
+    *model = NULL;
+    *leafs = NULL;
+    *num_leafs = 0;
+    *t_root = 0;
+
+    if (!smlt_json_expect(&c, '{')) {
         return -1;
     }
+
+    while (!smlt_json_peek(&c, '}')) {
+        const char *key, *str;
+        size_t key_len, str_len;
+        bool ok;
+
+        if (!first && !smlt_json_expect(&c, ',')) {
+            goto error;
+        }
+        first = false;
+
+        if (!smlt_json_string(&c, &key, &key_len) || !smlt_json_expect(&c, ':')) {
+            goto error;
+        }
+
+        if (SMLT_JSON_KEY(key, key_len, "root")) {
+            ok = smlt_json_uint(&c, t_root);
+        } else if (SMLT_JSON_KEY(key, key_len, "leaf_nodes") && !*leafs) {
+            *num_leafs = smlt_json_count_elements(&c);
+            *leafs = (uint32_t*) malloc(sizeof(uint32_t) * (*num_leafs + 1));
+            assert(*leafs != NULL);
+            ok = smlt_json_uint_array(&c, *leafs, *num_leafs, UINT32_MAX);
+        } else if (SMLT_JSON_KEY(key, key_len, "model") && !has_model) {
+            ok = smlt_json_parse_model(&c, model, len_model);
+            has_model = true;
+        } else if (SMLT_JSON_KEY(key, key_len, "git-version") &&
+                   smlt_json_peek(&c, '"')) {
+            ok = smlt_json_string(&c, &str, &str_len);
+            if (ok) {
+                printf("Simulator GIT revision %.*s\n", (int)str_len, str);
+            }
+        } else {
+            ok = smlt_json_skip_value(&c);
+        }
+
+        if (!ok) {
+            goto error;
+        }
+    }
+
+    if (!has_model || *t_root >= *len_model) {
+        goto error;
+    }
+
+    return 0;
+
+ error:
+    free(*model);
+    free(*leafs);
+    *model = NULL;
+    *leafs = NULL;
+    *num_leafs = 0;
+    return -1;
+}
+
+int smlt_tree_parse_wrapper(const char* json_string,
+                            unsigned ncores,
+                            uint16_t** model,
+                            uint32_t * num_leafs,
+                            uint32_t** leafs,
+                            uint32_t* t_root,
+                            uint32_t* len_model)
+{
+    return smlt_tree_parse_buffer(json_string, strlen(json_string), ncores,
+                                  model, num_leafs, leafs, t_root, len_model);
 }
 
 static int smlt_tree_config_request(const char *hostname,
@@ -162,38 +420,49 @@ static int smlt_tree_config_request(const char *hostname,
     assert (bytes_sent==len);
 
     ssize_t bytes_recieved;
-    char incomming_data_buffer[1000];
-
-    std::string rec;
+    size_t rec_size = RECV_BUF_SIZE;
+    size_t rec_len = 0;
+    char *rec = (char*) malloc(rec_size);
+    assert(rec != NULL);
 
     do {
-        bytes_recieved = recv(socketfd, incomming_data_buffer,1000, 0);
+        // keep space for the terminating zero
+        if (rec_len + 1 == rec_size) {
+            rec_size *= 2;
+            rec = (char*) realloc(rec, rec_size);
+            assert(rec != NULL);
+        }
+
+        bytes_recieved = recv(socketfd, rec + rec_len, rec_size - rec_len - 1, 0);
 
         // If no data arrives, the program will just wait here until some data arrives.
         if (bytes_recieved > 0) {
-            incomming_data_buffer[bytes_recieved] = '\0' ;
-
-            rec.append(incomming_data_buffer);
+            rec_len += bytes_recieved;
         }
         else {
             if (bytes_recieved == 0) {
                printf("host shut down \n");
             } else if (bytes_recieved == -1) {
                printf("receive error \n");
+               free(rec);
                return 1;
             }
         }
 
     } while(bytes_recieved>0);
+    rec[rec_len] = '\0';
 
 
     freeaddrinfo(host_info_list);
     shutdown(socketfd, SHUT_RDWR);
+    close(socketfd);
     assert(model != NULL);
-    char* inp = (char*) rec.c_str();
 
-    return smlt_tree_parse_wrapper(inp, ncores, model, num_leafs,
-                                   leafs, t_root, len_model);
+    int ret = smlt_tree_parse_buffer(rec, rec_len, ncores, model, num_leafs,
+                                     leafs, t_root, len_model);
+    free(rec);
+
+    return ret;
 }
 
 #define NAMELEN 1000U
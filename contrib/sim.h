@@ -2,6 +2,7 @@
 #define SIM_H 1
 
 #include <stdint.h>
+#include <stddef.h>
 
 int smlt_tree_generate_wrapper(uint32_t ncores,
                                uint32_t *cores,
@@ -18,5 +19,13 @@ int smlt_tree_parse_wrapper(const char* json_string,
                             uint32_t** leafs,
                             uint32_t* t_root,
                             uint32_t* len_model);
+int smlt_tree_parse_buffer(const char* json_string,
+                           size_t json_len,
+                           uint32_t ncores,
+                           uint16_t** model,
+                           uint32_t* num_leafs,
+                           uint32_t** leafs,
+                           uint32_t* t_root,
+                           uint32_t* len_model);
 
 #endif
@@ -3,16 +3,14 @@
 #include <stdio.h>
 #include <unistd.h>
 
-#define MAX_ATTEMPTS 10
-
 #include <iostream>
 
 using namespace std;
 
 /**
- * \brief Retrieve a model from the simulator
+ * \brief Parse a model from a JSON string
  *
- * Retry up to MAX_ATTEMPTS times in case of failure.
+ * Parsing is deterministic, hence there is no point in retrying.
  */
 int smlt_tree_parse(const char* json_string,
                     uint32_t ncores,
@@ -22,20 +20,9 @@ int smlt_tree_parse(const char* json_string,
                     uint32_t* last_node,
                     uint32_t* len_model)
 {
-    int res = -1;
-    int attempts = 0;
-
-    while (res!=0 && attempts<MAX_ATTEMPTS) {
-
-            res = smlt_tree_parse_wrapper(json_string, ncores,
-                                          model, num_leafs, leafs,
-                                          last_node, len_model);
-            if (res!=0) {
-                sleep(2);
-            }
-    }
-
-    return res;
+    return smlt_tree_parse_wrapper(json_string, ncores,
+                                   model, num_leafs, leafs,
+                                   last_node, len_model);
 }
 
 extern "C" {
@@ -10,6 +10,12 @@
 #define SMLT_ARCH_H_ 1
 
 #include <stdbool.h>
+#include <stdint.h>
+#include <cpuid.h>
+#include <emmintrin.h>
+#ifdef __AVX__
+#include <immintrin.h>
+#endif
 
 
 /**
@@ -71,6 +77,82 @@ static inline cycles_t smlt_arch_tsc(void)
 }
 
 
+/*
+ * ---------------------------------------------------------------------------
+ * Non-temporal stores and cache line pushing
+ * ---------------------------------------------------------------------------
+ */
+
+/// stores a 32-bit word bypassing the cache
+static inline void smlt_arch_stream_32(void *dst, uint32_t val)
+{
+    _mm_stream_si32((int *)dst, (int)val);
+}
+
+/// stores a 64-bit word bypassing the cache
+static inline void smlt_arch_stream_64(void *dst, uint64_t val)
+{
+    _mm_stream_si64((long long *)dst, (long long)val);
+}
+
+/// stores 16 bytes bypassing the cache, dst and src must be 16-byte aligned
+static inline void smlt_arch_stream_128(void *dst, const void *src)
+{
+    _mm_stream_si128((__m128i *)dst, _mm_load_si128((const __m128i *)src));
+}
+
+/// stores 32 bytes bypassing the cache, dst must be 32-byte aligned
+static inline void smlt_arch_stream_256(void *dst, const void *src)
+{
+#ifdef __AVX__
+    _mm256_stream_si256((__m256i *)dst, _mm256_loadu_si256((const __m256i *)src));
+#else
+    smlt_arch_stream_128(dst, src);
+    smlt_arch_stream_128((char *)dst + 16, (const char *)src + 16);
+#endif
+}
+
+/// orders the non-temporal stores before all subsequent stores
+static inline void smlt_arch_store_fence(void)
+{
+    _mm_sfence();
+}
+
+/// hints the CPU to move the cache line to a cache shared with other cores
+static inline void smlt_arch_cldemote(volatile void *addr)
+{
+    /* cldemote (%rax), executes as a NOP on CPUs without support */
+    __asm volatile (".byte 0x0f, 0x1c, 0x00" :: "a" (addr) : "memory");
+}
+
+/// writes the cache line back to memory, retaining it in the cache
+static inline void smlt_arch_clwb(volatile void *addr)
+{
+    /* clwb (%rax), may fault on CPUs without support */
+    __asm volatile (".byte 0x66, 0x0f, 0xae, 0x30" :: "a" (addr) : "memory");
+}
+
+/// checks whether the CPU supports the clwb instruction
+static inline bool smlt_arch_has_clwb(void)
+{
+    uint32_t eax, ebx, ecx, edx;
+    if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) {
+        return false;
+    }
+    return (ebx >> 24) & 1;
+}
+
+/// checks whether the CPU supports the cldemote instruction
+static inline bool smlt_arch_has_cldemote(void)
+{
+    uint32_t eax, ebx, ecx, edx;
+    if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) {
+        return false;
+    }
+    return (ecx >> 25) & 1;
+}
+
+
 
 
 #endif /* SMLT_ARCH_H_ */
@@ -17,31 +17,64 @@ typedef uint16_t smlt_ffq_idx_t;
 ///< payload type of the fast forward queue
 typedef uint64_t smlt_ffq_payload_t;
 
-///< an empty FFQ slot has this value
-#define SMLT_FFQ_SLOT_EMPTY ((smlt_ffq_payload_t)-1)
+/*
+ * Every slot starts with a header word, the payload is never interpreted by
+ * the queue. The header holds the sequence number of the slot, the first
+ * slot of a message also holds its length in words. A slot is valid if its
+ * sequence number is the one the receiver expects next, hence the receiver
+ * does not clear the slots it has consumed. Instead, it publishes the number
+ * of consumed slots every SMLT_FFQ_RELEASE_BATCH slots on a separate
+ * cacheline, which the sender caches.
+ */
+
+///< number of bits of the sequence number in the header
+#define SMLT_FFQ_SEQ_BITS 48
+
+///< mask of the sequence number in the header
+#define SMLT_FFQ_SEQ_MASK ((((smlt_ffq_payload_t)1) << SMLT_FFQ_SEQ_BITS) - 1)
+
+///< maximum length of a message in words
+#define SMLT_FFQ_MAX_WORDS ((uint32_t)(((smlt_ffq_payload_t)-1) >> SMLT_FFQ_SEQ_BITS))
 
-#define SMLT_FFQ_SLOT_NOTIFY ((smlt_ffq_payload_t)0)
+///< builds a header word from a sequence number and a message length
+#define SMLT_FFQ_HEADER(seq, words) \
+    ((((smlt_ffq_payload_t)(words)) << SMLT_FFQ_SEQ_BITS) | \
+     ((seq) & SMLT_FFQ_SEQ_MASK))
+
+///< the receiver publishes its position after this many slots
+#define SMLT_FFQ_RELEASE_BATCH 8
 
 /**
- * the size of a FFQ message in bytes
+ * the size of a FFQ slot in bytes
  * this should be a multiple of the archteicture's cacheline
  */
 #define SMLT_FFQ_MSG_BYTES  (1 * SMLT_ARCH_CACHELINE_SIZE)
 
 /**
- * the number of (payload) words a message consists of.
+ * the number of (payload) words a slot holds.
  */
-#define SMLT_FFQ_MSG_WORDS  (SMLT_FFQ_MSG_BYTES / sizeof(smlt_ffq_payload_t))
+#define SMLT_FFQ_SLOT_WORDS  ((SMLT_FFQ_MSG_BYTES / sizeof(smlt_ffq_payload_t)) - 1)
 
 
 struct SMLT_ARCH_ATTR_ALIGN smlt_ffq_slot
 {
-    smlt_ffq_payload_t data[SMLT_FFQ_MSG_WORDS];
+    smlt_ffq_payload_t header;
+    smlt_ffq_payload_t data[SMLT_FFQ_SLOT_WORDS];
 };
 
-/* the size of a contorl word had to be smaller than the payload word */
+/* the slot has to fill the message exactly */
 SMLT_STATIC_ASSERT(sizeof(struct smlt_ffq_slot) == SMLT_FFQ_MSG_BYTES);
 
+/**
+ * @brief returns the size of the shared buffer of a FFQ queue
+ *
+ * @param slots the number of slots of the queue
+ *
+ * The slots are followed by the cacheline holding the receiver's position.
+ */
+#define SMLT_FFQ_QUEUE_BYTES(slots) \
+    (((size_t)(slots) * SMLT_FFQ_MSG_BYTES) + SMLT_ARCH_CACHELINE_SIZE)
+
 
 typedef enum {
     SMLT_FFQ_DIRECTION_SEND,
@@ -52,18 +85,16 @@ typedef enum {
 struct smlt_ffq_queue
 {
     volatile struct smlt_ffq_slot *slots;
+    volatile uint64_t *release;     ///< slots consumed by the receiver
+    uint64_t seq;                   ///< sequence number of the next slot
+    uint64_t released;              ///< last known/published value of release
     smlt_ffq_idx_t size;
     smlt_ffq_idx_t pos;
+    smlt_ffq_idx_t batch;           ///< slots released at once
+    smlt_ffq_idx_t max_slots;       ///< maximum number of slots per message
     smlt_ffq_direction_t direction;
 };
 
-//struct smlt_ffq_rx
-//{
-//    struct smlt_ffq_slot *slots;
-//    smlt_ffq_idx_t size;
-//    smlt_ffq_idx_t tail;
-//};
-
 /*
  * ===========================================================================
  * FFQ channel initialization
@@ -72,7 +103,7 @@ struct smlt_ffq_queue
 
 
 /**
- * @brief Initialize UMP transmit queue state
+ * @brief Initialize FFQ transmit queue state
  *
  * @param       c       Pointer to queue-state structure to initialize.
  * @param       buf     Pointer to ring buffer for the queue.
@@ -81,13 +112,13 @@ struct smlt_ffq_queue
  * @returns SMLT_SUCCESS or error value
  *
  * The state structure and buffer must already be allocated and appropriately
- * aligned.
+ * aligned. The buffer has to be SMLT_FFQ_QUEUE_BYTES(slots) large.
  */
 errval_t smlt_ffq_queue_init_tx(struct smlt_ffq_queue *q, void *buf,
                                 smlt_ffq_idx_t slots);
 
 /**
- * @brief Initialize UMP receive queue state
+ * @brief Initialize FFQ receive queue state
  *
  * @param       c       Pointer to queue-state structure to initialize.
  * @param       buf     Pointer to ring buffer for the queue.
@@ -96,7 +127,7 @@ errval_t smlt_ffq_queue_init_tx(struct smlt_ffq_queue *q, void *buf,
  * @returns SMLT_SUCCESS or error value
  *
  * The state structure and buffer must already be allocated and appropriately
- * aligned.
+ * aligned. The buffer has to be SMLT_FFQ_QUEUE_BYTES(slots) large.
 */
 errval_t smlt_ffq_queue_init_rx(struct smlt_ffq_queue *q, void *buf,
                                 smlt_ffq_idx_t slots);
@@ -108,104 +139,140 @@ errval_t smlt_ffq_queue_init_rx(struct smlt_ffq_queue *q, void *buf,
  * ===========================================================================
  */
 
- /**
-  * @brief obtains a pointer to the next message to be used for sending
-  *
-  * @param c     the UMP channel to get the next message for
-  *
-  * @return pointer to a message slot
-  */
-static inline volatile
-struct smlt_ffq_slot *smlt_ffq_queue_get_next(struct smlt_ffq_queue *q)
+/**
+ * @brief returns the number of slots a message occupies
+ *
+ * @param words the length of the message in words
+ *
+ * @returns number of slots
+ */
+static inline uint32_t smlt_ffq_queue_num_slots(uint32_t words)
 {
-    SMLT_ASSERT(q->direction == SMLT_FFQ_DIRECTION_SEND);
-
-    return q->slots + q->pos;
+    if (words == 0) {
+        return 1;
+    }
+    return (words + SMLT_FFQ_SLOT_WORDS - 1) / SMLT_FFQ_SLOT_WORDS;
 }
 
 /**
- * @brief checks if a message can be sent on that queue-state
+ * @brief checks if a message of a number of slots can be sent
  *
- * @param q the ffq queue
+ * @param q     the ffq queue
+ * @param slots the number of slots of the message
  *
- * @returns TRUE iff a message can be sent, FALSE otherwise
+ * @returns TRUE iff the slots are free, FALSE otherwise
+ *
+ * The receiver's position is read only if the cached one does not suffice.
  */
-static inline bool smlt_ffq_queue_can_send(struct smlt_ffq_queue *q)
+static inline bool smlt_ffq_queue_can_send_slots(struct smlt_ffq_queue *q,
+                                                 uint32_t slots)
 {
-    SMLT_ASSERT(c);
-    SMLT_ASSERT(c->slots);
+    SMLT_ASSERT(q);
+    SMLT_ASSERT(q->slots);
 
     /* check the direction */
     if (q->direction != SMLT_FFQ_DIRECTION_SEND) {
         return false;
     }
 
-    volatile struct smlt_ffq_slot *slot = q->slots + q->pos;
+    if (q->seq - 1 + slots - q->released <= q->size) {
+        return true;
+    }
+
+    q->released = *q->release;
 
-    return (slot->data[0] == SMLT_FFQ_SLOT_EMPTY);
+    return (q->seq - 1 + slots - q->released <= q->size);
+}
+
+/**
+ * @brief checks if a message can be sent on that queue-state
+ *
+ * @param q the ffq queue
+ *
+ * @returns TRUE iff a message can be sent, FALSE otherwise
+ */
+static inline bool smlt_ffq_queue_can_send(struct smlt_ffq_queue *q)
+{
+    return smlt_ffq_queue_can_send_slots(q, 1);
 }
 
 
  /**
-  * @brief sends a message on the UMP channel
+  * @brief sends a message on the FFQ channel
+  *
+  * @param q       the FFQ queue to send on
+  * @param val_ptr the payload of the message
+  * @param num     the length of the message in words
+  *
+  * @returns SMLT_SUCCESS, SMLT_ERR_QUEUE_FULL if there are not enough free
+  *          slots or SMLT_ERR_INVAL if the message never fits into the queue
   *
-  * @param c     the UMP channel to send on
-  * @param msg   pointer to the message slot in the channel`
-  * @param ctrl  partial control word for the message
+  * Messages longer than SMLT_FFQ_SLOT_WORDS span several slots. The header
+  * of the first slot is written last.
   */
 static inline errval_t smlt_ffq_queue_send_raw(struct smlt_ffq_queue *q,
                                                smlt_ffq_payload_t *val_ptr,
-                                               smlt_ffq_idx_t num)
+                                               uint32_t num)
 {
-    if (!smlt_ffq_queue_can_send(q)) {
+    uint32_t slots = smlt_ffq_queue_num_slots(num);
+    if (slots > q->max_slots || num > SMLT_FFQ_MAX_WORDS) {
+        return SMLT_ERR_INVAL;
+    }
+
+    if (!smlt_ffq_queue_can_send_slots(q, slots)) {
         return SMLT_ERR_QUEUE_FULL;
     }
 
-    volatile struct smlt_ffq_slot *s = q->slots + q->pos;
+    volatile struct smlt_ffq_slot *first = q->slots + q->pos;
+    uint64_t seq = q->seq;
+
+    /* the continuation slots become visible with the first header */
+    smlt_ffq_idx_t pos = q->pos;
+    uint32_t offset = 0;
+    for (uint32_t s = 0; s < slots; s++) {
+        volatile struct smlt_ffq_slot *slot = q->slots + pos;
+        uint32_t words = num - offset;
+        if (words > SMLT_FFQ_SLOT_WORDS) {
+            words = SMLT_FFQ_SLOT_WORDS;
+        }
 
-    if (num > SMLT_FFQ_MSG_WORDS) {
-        num = SMLT_FFQ_MSG_WORDS;
-    }
+        for (uint32_t i = 0; i < words; ++i) {
+            slot->data[i] = val_ptr[offset + i];
+        }
+        offset += words;
 
-    for (smlt_ffq_idx_t i = 1; i < num; ++i) {
-        s->data[i] = val_ptr[i];
+        if (s > 0) {
+            slot->header = SMLT_FFQ_HEADER(seq + s, 0);
+        }
+
+        if (++pos == q->size) {
+            pos = 0;
+        }
     }
 
     smlt_arch_write_barrier();
 
-    s->data[0] = val_ptr[0];
+    first->header = SMLT_FFQ_HEADER(seq, num);
 
-    if (++q->pos == q->size) {
-        q->pos = 0;
-    }
+    q->pos = pos;
+    q->seq = seq + slots;
 
     return SMLT_SUCCESS;
 }
 
 
  /**
-  * @brief sends a notification on the UMP channel
+  * @brief sends a notification on the FFQ channel
+  *
+  * @param q     the FFQ queue to send on
   *
-  * @param c     the UMP channel to send on
-  * @param msg   pointer to the message slot in the channel`
-  * @param ctrl  partial control word for the message
+  * @returns SMLT_SUCCESS or SMLT_ERR_QUEUE_FULL
+  *
+  * A notification is a message without payload.
   */
  static inline errval_t smlt_ffq_queue_notify(struct smlt_ffq_queue *q)
  {
-    if (!smlt_ffq_queue_can_send(q)) {
-        return SMLT_ERR_QUEUE_FULL;
-    }
-    volatile struct smlt_ffq_slot *s = q->slots + q->pos;
-
-    SMLT_ASSERT(s->data[0] == SMLT_FFQ_SLOT_EMTPY);
-
-    s->data[0] = SMLT_FFQ_SLOT_NOTIFY;
-
-    if (++q->pos == q->size) {
-        q->pos = 0;
-    }
-
-    return SMLT_SUCCESS;
+    return smlt_ffq_queue_send_raw(q, NULL, 0);
  }
 
 
@@ -218,11 +285,11 @@ static inline errval_t smlt_ffq_queue_send_raw(struct smlt_ffq_queue *q,
 /**
 * @brief checks if there is a message to be received
 *
-* @param c     the UMP channel to be polled
+* @param c     the FFQ channel to be polled
 *
 * @returns TRUE if there is a pending message, false otherwise
 */
-static inline volatile bool smlt_ffq_queue_can_recv(struct smlt_ffq_queue *c)
+static inline bool smlt_ffq_queue_can_recv(struct smlt_ffq_queue *c)
 {
     SMLT_ASSERT(c);
     SMLT_ASSERT(c->slots);
@@ -234,46 +301,84 @@ static inline volatile bool smlt_ffq_queue_can_recv(struct smlt_ffq_queue *c)
 
     volatile struct smlt_ffq_slot *slot = c->slots + c->pos;
 
-    return (slot->data[0] != SMLT_FFQ_SLOT_EMPTY);
+    return ((slot->header & SMLT_FFQ_SEQ_MASK) == (c->seq & SMLT_FFQ_SEQ_MASK));
 }
 
 /**
- * @brief Receives a pointer to an outsanding message
+ * @brief releases the consumed slots to the sender, if a batch is complete
  *
- * @param c     the UMP channel to be received on
+ * @param q     the FFQ queue
+ */
+static inline void smlt_ffq_queue_release(struct smlt_ffq_queue *q)
+{
+    uint64_t consumed = q->seq - 1;
+
+    if (consumed - q->released >= q->batch) {
+        /* the payload has been read before the slots are handed back */
+        smlt_arch_write_barrier();
+        *q->release = consumed;
+        q->released = consumed;
+    }
+}
+
+/**
+ * @brief Receives an outstanding message
+ *
+ * @param q         the FFQ queue to be received on
+ * @param val_ptr   buffer for the payload, may be NULL
+ * @param capacity  size of the buffer in words
+ * @param words     returns the length of the message, may be NULL
  *
- * @returns pointer to the message or NULL otherwise
+ * @returns SMLT_SUCCESS, SMLT_ERR_QUEUE_EMPTY or SMLT_ERR_INVAL if the
+ *          message did not fit into the buffer
  *
- * the returned pointer is the raw UMP message in the channel and will be
- * overwritten on reuse.
+ * A message that does not fit into the buffer is truncated and consumed.
  */
 static inline errval_t smlt_ffq_queue_recv_raw(struct smlt_ffq_queue *q,
                                                smlt_ffq_payload_t *val_ptr,
-                                               smlt_ffq_idx_t num)
+                                               uint32_t capacity,
+                                               uint32_t *words)
 {
     SMLT_ASSERT(q);
-    SMLT_ASSERT(q->direction != smlt_ffq_DIRECTION_RECV);
-
-    volatile struct smlt_ffq_slot *s = q->slots + q->pos;
+    SMLT_ASSERT(q->direction == SMLT_FFQ_DIRECTION_RECV);
 
-    if (s->data[0] == SMLT_FFQ_SLOT_EMPTY) {
+    if (!smlt_ffq_queue_can_recv(q)) {
         return SMLT_ERR_QUEUE_EMPTY;
     }
 
-    if (val_ptr) {
-        if (num > SMLT_FFQ_MSG_WORDS) {
-            num = SMLT_FFQ_MSG_WORDS;
+    volatile struct smlt_ffq_slot *first = q->slots + q->pos;
+    uint32_t num = (uint32_t)(first->header >> SMLT_FFQ_SEQ_BITS);
+    uint32_t slots = smlt_ffq_queue_num_slots(num);
+
+    if (val_ptr == NULL) {
+        capacity = 0;
+    }
+
+    smlt_ffq_idx_t pos = q->pos;
+    uint32_t offset = 0;
+    for (uint32_t s = 0; s < slots; s++) {
+        volatile struct smlt_ffq_slot *slot = q->slots + pos;
+        for (uint32_t i = 0; i < SMLT_FFQ_SLOT_WORDS && offset < capacity
+                             && offset < num; ++i) {
+            val_ptr[offset++] = slot->data[i];
         }
 
-        for (smlt_ffq_idx_t i = 0; i < num; ++i) {
-            val_ptr[i] = s->data[i];
+        if (++pos == q->size) {
+            pos = 0;
         }
     }
 
-    s->data[0] = SMLT_FFQ_SLOT_EMPTY;
+    q->pos = pos;
+    q->seq += slots;
+
+    smlt_ffq_queue_release(q);
+
+    if (words) {
+        *words = num;
+    }
 
-    if (++q->pos == q->size) {
-        q->pos = 0;
+    if (val_ptr && num > capacity) {
+        return SMLT_ERR_INVAL;
     }
 
     return SMLT_SUCCESS;
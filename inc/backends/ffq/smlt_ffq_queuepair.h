@@ -77,7 +77,7 @@ errval_t smlt_ffq_queuepair_send(struct smlt_qp *qp,
  */
 static inline errval_t smlt_ffq_queuepair_send_raw(struct smlt_ffq_queuepair *qp,
                                                    smlt_ffq_payload_t *val_ptr,
-                                                   smlt_ffq_idx_t num)
+                                                   uint32_t num)
 {
     return smlt_ffq_queue_send_raw(&qp->tx, val_ptr, num);
 }
@@ -134,16 +134,19 @@ bool smlt_ffq_queuepair_can_send(struct smlt_qp *qp);
  /**
   * @brief receives a message on the queuepair
   *
-  * @param qp     The smelt queuepair to send on
-  * @param msg    the Smelt message to receive in
+  * @param qp       The smelt queuepair to send on
+  * @param val_ptr  buffer for the payload
+  * @param capacity size of the buffer in words
+  * @param words    returns the length of the message, may be NULL
   *
   * @returns SMELT_SUCCESS of the messessage could be received.
   */
 static inline errval_t smlt_ffq_queuepair_recv_raw(struct smlt_ffq_queuepair *qp,
                                                    smlt_ffq_payload_t *val_ptr,
-                                                   smlt_ffq_idx_t num)
+                                                   uint32_t capacity,
+                                                   uint32_t *words)
 {
-    return smlt_ffq_queue_recv_raw(&qp->rx, val_ptr, num);
+    return smlt_ffq_queue_recv_raw(&qp->rx, val_ptr, capacity, words);
 }
 
  /**
@@ -168,7 +171,7 @@ static inline errval_t smlt_ffq_queuepair_recv_raw(struct smlt_ffq_queuepair *qp
  */
 static inline errval_t smlt_ffq_queuepair_recv_notify_raw(struct smlt_ffq_queuepair *qp)
 {
-    return smlt_ffq_queue_recv_raw(&qp->rx, NULL, 0);
+    return smlt_ffq_queue_recv_raw(&qp->rx, NULL, 0, NULL);
 }
 
 /**
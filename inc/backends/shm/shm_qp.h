@@ -10,72 +10,49 @@
 #define SHM_QP_H 1
 
 #include <inttypes.h>
+#include <stdbool.h>
+#include <shm/swmr.h>
 
 /*
  * Definitions for shared memory queue
  */
-#define DEFAULT_SHM_Q_SIZE 64 // Number of slots in shared memory queue
-#define CACHELINE_SIZE 64
-#define DEFAULT_SHM_SIZE DEFAULT_SHM_Q_SIZE*CACHELINE_SIZE
-
-union __attribute__((aligned(64))) pos_pointer{
-    uint64_t pos;
-    uint8_t padding[CACHELINE_SIZE];
-};
-
+#define DEFAULT_SHM_Q_SIZE 64 // Number of cachelines of a shared memory queue
 
 /**
- * \brief Per-thread datastructure representing a SHM queue.
+ * \brief One direction of a shared memory queuepair.
+ *
+ * This is a SWMR queue with a single reader, hence it supports the separate
+ * header layout and messages spanning several slots as well.
  */
-struct shm_context {
-    // Number of slots (depends on num_readers)
-    uint64_t num_slots;
-    /* local position pointer, global will be updated
-     * when the end of the queue is reached
-     */
-    uint16_t l_pos;
-
-    // shm impl
-    uint64_t next_sync;
-    uint64_t next_seq;
-
-    // The shared memory itself
-    uint8_t* shm;
-    uint8_t* data;
-
-    // Positions of readers/writer within shared queue
-    volatile union pos_pointer* reader_pos;
-};
-
 struct shm_qp {
-    struct shm_context src;
-    struct shm_context dst;
+    struct swmr_context src;    ///< the writer end
+    struct swmr_context dst;    ///< the reader end
 };
 
-struct shm_qp* shm_queuepair_create(uint32_t src,
-                                    uint32_t dst);
-
-void shm_q_send(struct shm_context* context,
-                uintptr_t p1,
-                uintptr_t p2,
-                uintptr_t p3,
-                uintptr_t p4,
-                uintptr_t p5,
-                uintptr_t p6,
-                uintptr_t p7);
-void shm_q_send0(struct shm_context* context);
-
-void shm_q_recv(struct shm_context* context,
-                   uintptr_t *p1,
-                   uintptr_t *p2,
-                   uintptr_t *p3,
-                   uintptr_t *p4,
-                   uintptr_t *p5,
-                   uintptr_t *p6,
-                   uintptr_t *p7);
-void shm_q_recv0(struct shm_context* context);
+/**
+ * \brief initializes one direction of a shared memory queuepair
+ *
+ * \param qp         the queue to initialize
+ * \param src        core of the sender
+ * \param dst        core of the receiver
+ * \param sep_header keep the headers in a separate, compact array
+ *
+ * \returns SMLT_SUCCESS or SMLT_ERR_MALLOC_FAIL
+ *
+ * The memory is allocated on the NUMA node of the receiver.
+ */
+errval_t shm_queuepair_init(struct shm_qp* qp,
+                            coreid_t src,
+                            coreid_t dst,
+                            bool sep_header);
 
-bool shm_q_can_send(struct shm_context* context);
-bool shm_q_can_recv(struct shm_context* context);
+/**
+ * \brief frees the memory of a shared memory queue
+ *
+ * \param qp    the queue to destroy
+ *
+ * Every copy of the queue becomes invalid.
+ */
+void shm_queuepair_destroy(struct shm_qp* qp);
 
-#endif /* SYNC_SHM_H */
+#endif /* SHM_QP_H */
@@ -21,6 +21,15 @@
 #define SWMRQ_SIZE 64 // Number of slots in shared memory queue
 #define CACHELINE_SIZE 64
 
+// Number of payload words in a slot, the first word is the header
+#define SWMR_PAYLOAD_WORDS 7
+
+// Default number of reads after which a reader publishes its position
+#define SWMR_PUBLISH_INTERVAL 16
+
+// Header flag of the first slot of a message spanning several slots
+#define SWMR_HEADER_LONG (((uintptr_t)1) << 63)
+
 union __attribute__((aligned(64))) pos_point{
     uint64_t pos;
     uint8_t padding[CACHELINE_SIZE];
@@ -35,6 +44,8 @@ struct swmr_context {
     uint8_t* shm;
     uint8_t* data;
     uint8_t* header;
+    // distance of the headers of two slots in words
+    uint64_t header_stride;
 
     // Positions of readers/writer within shared queue
     volatile union pos_point* write_pos;
@@ -52,6 +63,10 @@ struct swmr_context {
     // shm4 impl
     uint64_t next_sync;
     uint64_t next_seq;
+    // reader: publish the position when (next_seq & publish_mask) == 0
+    uint64_t publish_mask;
+    // writer: last read position of every reader
+    uint64_t* cached_pos;
 };
 
 struct swmr_queue {
@@ -63,12 +78,39 @@ void swmr_init_context(void* shm, struct swmr_context* queue,
                        uint8_t num_readers, uint8_t id, 
 		       bool sep_header, uint32_t queue_size);
 
+/**
+ * \brief sets how often a reader publishes its position
+ *
+ * \param context  the reader context
+ * \param interval publish after every interval-th read, rounded down to a
+ *                  power of two and at most a quarter of the queue
+ */
+void swmr_set_publish_interval(struct swmr_context* context,
+                               uint32_t interval);
+
+/**
+ * \brief computes the size of the shared memory of a queue
+ *
+ * \param queue_size size of the queue in cachelines
+ * \param sep_header whether the headers are kept in a separate array
+ *
+ * \returns size in bytes
+ */
+size_t swmr_queue_bytes(uint32_t queue_size, bool sep_header);
+
 void swmr_queue_create(struct swmr_queue**,
                        uint32_t src,
                        uint32_t* dst,
                        uint16_t count,
                        bool sep_header);
 
+/**
+ * \brief frees the shared memory and the reader contexts of a queue
+ *
+ * \param queue the queue to destroy
+ */
+void swmr_queue_destroy(struct swmr_queue* queue);
+
 void swmr_send_raw(struct swmr_context* context,
                   uintptr_t p1,
                   uintptr_t p2,
@@ -80,6 +122,16 @@ void swmr_send_raw(struct swmr_context* context,
 
 void swmr_send_raw0(struct swmr_context* context);
 
+/**
+ * \brief sends a message of arbitrary length, spanning several slots
+ *
+ * \param context  the writer context
+ * \param data     the payload
+ * \param words    length of the payload in words
+ */
+void swmr_send(struct swmr_context* context, const uintptr_t* data,
+               uint32_t words);
+
 void swmr_receive_raw(struct swmr_context* context,
               uintptr_t *p1,
               uintptr_t *p2,
@@ -91,6 +143,28 @@ void swmr_receive_raw(struct swmr_context* context,
 
 void swmr_receive_raw0(struct swmr_context* context);
 
+bool swmr_receive_non_blocking(struct swmr_context* context,
+              uintptr_t *p1,
+              uintptr_t *p2,
+              uintptr_t *p3,
+              uintptr_t *p4,
+              uintptr_t *p5,
+              uintptr_t *p6,
+              uintptr_t *p7);
+
+/**
+ * \brief receives a message of arbitrary length, spanning several slots
+ *
+ * \param context  the reader context
+ * \param data     buffer for the payload, at least SWMR_PAYLOAD_WORDS words
+ * \param capacity size of the buffer in words
+ *
+ * \returns the length of the message in words, words beyond the capacity
+ *          are dropped
+ */
+uint32_t swmr_receive(struct swmr_context* context, uintptr_t* data,
+                      uint32_t capacity);
+
 bool swmr_can_send(struct swmr_context* context);
 bool swmr_can_receive(struct swmr_context* context);
 
@@ -10,6 +10,7 @@
 #define SMLT_UMP_QUEUE_H_ 1
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 #include <arch/x86_64.h>
 #include <smlt.h>
@@ -119,6 +120,10 @@ struct smlt_ump_message {
 /* the size of the message has to be the right size */
 SMLT_STATIC_ASSERT(sizeof(struct smlt_ump_message) == SMLT_UMP_MSG_BYTES);
 
+/* the streaming send path relies on the payload starting at the second word */
+SMLT_STATIC_ASSERT(offsetof(struct smlt_ump_message, data) ==
+                   sizeof(smlt_ump_payload_word_t));
+
 
 /*
  * Channel
@@ -136,6 +141,17 @@ typedef enum {
     SMLT_UMP_DIRECTION_SEND
 } smlt_ump_direction_t;
 
+/**
+ * how the sender moves a written message slot towards the receiver
+ */
+typedef enum {
+    SMLT_UMP_PUSH_NONE,      ///< regular stores, the receiver pulls the line
+    SMLT_UMP_PUSH_STREAM,    ///< non-temporal stores, bypassing the cache
+    SMLT_UMP_PUSH_CLDEMOTE,  ///< regular stores, line demoted after sending
+    SMLT_UMP_PUSH_CLWB,      ///< regular stores, line written back after sending
+    SMLT_UMP_PUSH_NUM_MODES
+} smlt_ump_push_t;
+
 /**
  * represents an uni-directional UMP channel.
  */
@@ -147,6 +163,7 @@ struct smlt_ump_queue
     smlt_ump_idx_t num_msg;         ///< buffer size in message
     bool epoch;                     ///< next message epoch
     smlt_ump_direction_t direction; ///< direction of the channel
+    smlt_ump_push_t push;           ///< how messages are pushed (send only)
 
 };
 
@@ -189,6 +206,29 @@ errval_t smlt_ump_queue_init_rx(struct smlt_ump_queue *q, void *buf,
                                 smlt_ump_idx_t slots);
 
 
+/**
+ * @brief selects the push mode for a queue between two NUMA nodes
+ *
+ * @param node_src  the node of the sender
+ * @param node_dst  the node of the receiver
+ *
+ * @returns the push mode to be used for sending
+ *
+ * The mode is taken from SMLT_UMP_PUSH (none, stream, cldemote or clwb) and
+ * applies to queues crossing NUMA nodes only, unless SMLT_UMP_PUSH_LOCAL=1.
+ * Modes the CPU does not support fall back to SMLT_UMP_PUSH_NONE.
+ */
+smlt_ump_push_t smlt_ump_queue_push_mode(uint8_t node_src, uint8_t node_dst);
+
+/**
+ * @brief obtains the name of a push mode
+ *
+ * @param push  the push mode
+ *
+ * @returns string representation of the mode
+ */
+const char *smlt_ump_queue_push_name(smlt_ump_push_t push);
+
 static inline smlt_ump_idx_t smlt_ump_queue_last_ack(struct smlt_ump_queue *q)
 {
     return *q->last_ack;
@@ -245,6 +285,72 @@ static inline void smlt_ump_queue_send(struct smlt_ump_queue *c,
 }
 
 
+/**
+ * @brief writes a payload to the message slot and sends it
+ *
+ * @param c     the UMP channel to send on
+ * @param msg   pointer to the message slot in the channel`
+ * @param data  the payload words
+ * @param words the number of payload words
+ * @param ctrl  partial control word for the message
+ *
+ * With SMLT_UMP_PUSH_STREAM the whole slot is written with non-temporal
+ * stores: the payload first, then, after a store fence, the control word.
+ * The control word must not become visible before the payload, and the
+ * ordering of the two halves of a single write-combining line is not
+ * guaranteed, hence the fence. With cldemote/clwb the slot is written
+ * normally and the line is pushed out after the control word.
+ */
+static inline void smlt_ump_queue_send_words(struct smlt_ump_queue *c,
+                                             struct smlt_ump_message *msg,
+                                             const smlt_ump_payload_word_t *data,
+                                             uint32_t words,
+                                             union smlt_ump_ctrl ctrl)
+{
+    SMLT_ASSERT(words <= SMLT_UMP_PAYLOAD_WORDS);
+
+    if (c->push != SMLT_UMP_PUSH_STREAM) {
+        for (uint32_t i = 0; i < words; ++i) {
+            msg->data[i] = data[i];
+        }
+
+        smlt_ump_queue_send(c, msg, ctrl);
+
+        if (c->push == SMLT_UMP_PUSH_CLDEMOTE) {
+            smlt_arch_cldemote(msg);
+        } else if (c->push == SMLT_UMP_PUSH_CLWB) {
+            smlt_arch_clwb(msg);
+        }
+        return;
+    }
+
+    // must submit in order
+    SMLT_ASSERT(msg == &c->buf[c->pos]);
+
+    // stage the full payload so that complete lines are written combined
+    struct smlt_ump_message line SMLT_ARCH_ATTR_ALIGN;
+    for (uint32_t i = 0; i < SMLT_UMP_PAYLOAD_WORDS; ++i) {
+        line.data[i] = (i < words) ? data[i] : 0;
+    }
+
+    smlt_arch_stream_64(&msg->data[0], line.data[0]);
+    smlt_arch_stream_128(&msg->data[1], &line.data[1]);
+    smlt_arch_stream_256(&msg->data[3], &line.data[3]);
+    smlt_arch_store_fence();
+
+    // write control word (thus sending the message)
+    ctrl.c.epoch = c->epoch;
+    smlt_arch_stream_32(&msg->ctrl.raw, ctrl.raw);
+    smlt_arch_store_fence();
+
+    // update pos
+    if (++c->pos == c->num_msg) {
+        c->pos = 0;
+        c->epoch = !c->epoch;
+    }
+}
+
+
 /**
  * @brief sends a notification on the UMP channel
  *
@@ -280,7 +386,7 @@ static inline void smlt_ump_queue_notify(struct smlt_ump_queue *c,
  *
  * @returns TRUE if there is a pending message, false otherwise
  */
-static inline volatile bool smlt_ump_queue_can_recv(struct smlt_ump_queue *c)
+static inline bool smlt_ump_queue_can_recv(struct smlt_ump_queue *c)
 {
     SMLT_ASSERT(c);
     SMLT_ASSERT(c->buf);
@@ -61,7 +61,7 @@ errval_t smlt_ump_queuepair_destroy(struct smlt_ump_queuepair *qp);
  *
  * @returns TRUE if message can be sent, FALSE if the queue is full
  */
-static inline volatile bool smlt_ump_queuepair_can_send_raw(struct smlt_ump_queuepair *qp)
+static inline bool smlt_ump_queuepair_can_send_raw(struct smlt_ump_queuepair *qp)
 {
     if ((smlt_ump_idx_t)(qp->seq_id - qp->last_ack) <= qp->tx.num_msg) {
         return true;
@@ -121,6 +121,23 @@ static inline errval_t smlt_ump_queuepair_send_raw(struct smlt_ump_queuepair *qp
     return SMLT_SUCCESS;
 }
 
+static inline errval_t smlt_ump_queuepair_send_words(struct smlt_ump_queuepair *qp,
+                                                     struct smlt_ump_message *msg,
+                                                     const smlt_ump_payload_word_t *data,
+                                                     uint32_t words)
+{
+    union smlt_ump_ctrl ctrl;
+
+    SMLT_ASSERT(smlt_ump_queuepair_can_send_raw(qp));
+
+    ctrl.c.last_ack = qp->seq_id;
+
+    qp->seq_id++;
+    smlt_ump_queue_send_words(&qp->tx, msg, data, words, ctrl);
+
+    return SMLT_SUCCESS;
+}
+
 /* send function pointer */
 
 /**
@@ -186,7 +203,7 @@ bool smlt_ump_queuepair_can_send(struct smlt_qp *qp);
   *
   * @returns TRUE if there is something pending on the queue, FALSE otherwise
   */
- static inline volatile bool smlt_ump_queuepair_can_recv_raw(struct smlt_ump_queuepair *qp)
+ static inline bool smlt_ump_queuepair_can_recv_raw(struct smlt_ump_queuepair *qp)
  {
      return smlt_ump_queue_can_recv(&qp->rx);
  }
@@ -44,6 +44,9 @@
 ///< the smelt node id        XXX or is this the endpoint id ?
 typedef uint32_t smlt_nid_t;
 
+///< there is no node with this id, or the core does not run a node
+#define SMLT_NID_INVALID ((smlt_nid_t)-1)
+
 /**
  * represents a handle to a smelt instance.
  */
@@ -71,6 +74,22 @@ struct smlt_instance;
  */
 errval_t smlt_init(uint32_t num_proc, bool eagerly);
 
+/**
+ * @brief initializes the Smelt library on a set of cores
+ *
+ * @param cores     the cores to run the nodes on, node i runs on cores[i].
+ *                  NULL for the cores 0 .. num_proc-1
+ * @param num_proc  the number of processors
+ * @param eagerly   create an all-to-all connection mesh
+ *
+ * @returns SMLT_SUCCESS on success
+ *          SMLT_ERR_INVAL if a core does not exist or is given twice
+ *
+ * Allows several Smelt instances to run on disjoint subsets of the cores
+ * of a machine. The node ids are always 0 .. num_proc-1.
+ */
+errval_t smlt_init_cores(coreid_t *cores, uint32_t num_proc, bool eagerly);
+
 /**
  * @brief obtains the node based on the id
  *
@@ -80,6 +99,26 @@ errval_t smlt_init(uint32_t num_proc, bool eagerly);
  */
 struct smlt_node *smlt_get_node_by_id(smlt_nid_t id);
 
+/**
+ * @brief obtains the core a node runs on
+ *
+ * @param id    node id
+ *
+ * @return core id of the node, the node id itself if Smelt is not
+ *         initialized or there is no such node
+ */
+coreid_t smlt_get_core_by_id(smlt_nid_t id);
+
+/**
+ * @brief obtains the node that runs on a core
+ *
+ * @param core  core id
+ *
+ * @return node id or SMLT_NID_INVALID if no node runs on the core. The
+ *         core id itself if Smelt is not initialized
+ */
+smlt_nid_t smlt_get_id_by_core(coreid_t core);
+
 /*
  * ===========================================================================
  * sending functions
@@ -0,0 +1,492 @@
+/*
+ * Copyright (c) 2016 ETH Zurich.
+ * All rights reserved.
+ *
+ * This file is distributed under the terms in the attached LICENSE file.
+ * If you do not find this file, copies can be found by writing to:
+ * ETH Zurich D-INFK, Universitaetstr. 6, CH-8092 Zurich. Attn: Systems Group.
+ */
+#ifndef SMLT_ASYNC_HPP_
+#define SMLT_ASYNC_HPP_ 1
+
+#if __cplusplus < 202002L
+#error "smlt_async.hpp needs C++20 coroutines, compile with -std=c++20"
+#endif
+
+#include <coroutine>
+#include <cstdlib>
+#include <deque>
+#include <exception>
+
+#include <smlt_queue.hpp>
+
+extern "C" {
+#include <smlt_barrier.h>
+#include <smlt_debug.h>
+}
+
+/*
+ * ===========================================================================
+ * Smelt coroutines
+ * ===========================================================================
+ *
+ * Many logical tasks can share the thread of a node. A task is a coroutine
+ * returning smlt::async::Task, it is started by the Executor of the node.
+ * Instead of spinning on a queue, a task suspends itself with
+ *
+ *     T obj = co_await smlt::async::recv<T>(end);
+ *     errval_t err = co_await smlt::async::recv(end, obj);
+ *     co_await smlt::async::send(end, obj);
+ *     co_await smlt::async::barrier(ctx);
+ *
+ * and the executor runs the other tasks of the node in the meantime. The
+ * executor polls the suspended tasks in the order they suspended and
+ * resumes those that can make progress. It never blocks and does not use
+ * any thread besides the one calling Executor::run().
+ *
+ * The ends are the smlt::Queue and smlt::Channel ends of smlt_queue.hpp and
+ * smlt_channel.hpp. Polling a suspended task is a single try_recv() or
+ * try_send() on its end, hence idle tasks cost no more than the check of
+ * the queue the blocking functions would spin on.
+ */
+
+namespace smlt {
+namespace async {
+
+class Executor;
+
+namespace detail {
+
+/**
+ * @brief a task suspended until its operation can complete
+ *
+ * The waiter lives in the frame of the suspended coroutine, hence
+ * suspending does not allocate.
+ */
+class Waiter
+{
+  public:
+    /**
+     * @brief tries to complete the operation
+     *
+     * @returns TRUE if the task can be resumed
+     */
+    virtual bool poll() = 0;
+
+  protected:
+    ~Waiter() = default;
+
+    void suspend(std::coroutine_handle<> h);
+
+  private:
+    friend class async::Executor;
+
+    Waiter *next_ = nullptr;
+    std::coroutine_handle<> handle_;
+};
+
+} /* namespace detail */
+
+
+/*
+ * ===========================================================================
+ * Task
+ * ===========================================================================
+ */
+
+/**
+ * @brief a coroutine run by an Executor
+ *
+ * A task is started by Executor::spawn(), which takes over the coroutine.
+ * A task that is never spawned is destroyed with the Task object.
+ */
+class Task
+{
+  public:
+    struct promise_type
+    {
+        Task get_return_object()
+        {
+            typedef std::coroutine_handle<promise_type> handle;
+            return Task(handle::from_promise(*this));
+        }
+
+        /* the executor starts the task */
+        std::suspend_always initial_suspend() noexcept { return {}; }
+
+        /* the executor destroys the finished task */
+        std::suspend_always final_suspend() noexcept { return {}; }
+
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+
+    Task(Task &&other) noexcept : handle_(other.handle_)
+    {
+        other.handle_ = nullptr;
+    }
+
+    Task(const Task &) = delete;
+    Task &operator=(const Task &) = delete;
+
+    ~Task()
+    {
+        if (handle_) {
+            handle_.destroy();
+        }
+    }
+
+  private:
+    friend class Executor;
+
+    explicit Task(std::coroutine_handle<promise_type> h) : handle_(h) {}
+
+    std::coroutine_handle<> release()
+    {
+        std::coroutine_handle<> h = handle_;
+        handle_ = nullptr;
+        return h;
+    }
+
+    std::coroutine_handle<promise_type> handle_;
+};
+
+
+/*
+ * ===========================================================================
+ * Executor
+ * ===========================================================================
+ */
+
+/**
+ * @brief runs the tasks of a node
+ *
+ * An executor belongs to the thread that calls run() or run_once(), the
+ * tasks it runs suspend on the executor of their thread. There is one
+ * executor per node thread.
+ */
+class Executor
+{
+  public:
+    Executor() = default;
+    Executor(const Executor &) = delete;
+    Executor &operator=(const Executor &) = delete;
+
+    ///< destroys the tasks that did not finish
+    ~Executor()
+    {
+        for (std::coroutine_handle<> h : ready_) {
+            h.destroy();
+        }
+        for (detail::Waiter *w = head_; w != nullptr;) {
+            detail::Waiter *next = w->next_;
+            w->handle_.destroy();
+            w = next;
+        }
+    }
+
+    /**
+     * @brief starts a task on the next call to run() or run_once()
+     */
+    void spawn(Task task)
+    {
+        ready_.push_back(task.release());
+        num_tasks_++;
+    }
+
+    ///< returns the number of tasks that have not finished
+    size_t num_tasks() const
+    {
+        return num_tasks_;
+    }
+
+    /**
+     * @brief resumes the tasks that can make progress, without blocking
+     *
+     * @returns TRUE if a task has been resumed
+     */
+    bool run_once()
+    {
+        Executor *prev = current_;
+        current_ = this;
+
+        /* move the waiters that can complete to the ready tasks */
+        detail::Waiter **prevp = &head_;
+        detail::Waiter *last = nullptr;
+        while (*prevp != nullptr) {
+            detail::Waiter *w = *prevp;
+            if (w->poll()) {
+                *prevp = w->next_;
+                ready_.push_back(w->handle_);
+            } else {
+                last = w;
+                prevp = &w->next_;
+            }
+        }
+        tail_ = last;
+
+        /* tasks made ready while resuming run in the next round */
+        bool progress = !ready_.empty();
+        for (size_t n = ready_.size(); n > 0; n--) {
+            std::coroutine_handle<> h = ready_.front();
+            ready_.pop_front();
+            h.resume();
+            if (h.done()) {
+                h.destroy();
+                num_tasks_--;
+            }
+        }
+
+        current_ = prev;
+        return progress;
+    }
+
+    /**
+     * @brief runs the tasks until all of them finished, BLOCKING
+     */
+    void run()
+    {
+        while (num_tasks_ > 0) {
+            run_once();
+        }
+    }
+
+    ///< returns the executor running on the calling thread
+    static Executor *current()
+    {
+        return current_;
+    }
+
+  private:
+    friend class detail::Waiter;
+
+    void wait(detail::Waiter *w, std::coroutine_handle<> h)
+    {
+        w->handle_ = h;
+        w->next_ = nullptr;
+        if (tail_ == nullptr) {
+            head_ = w;
+        } else {
+            tail_->next_ = w;
+        }
+        tail_ = w;
+    }
+
+    std::deque<std::coroutine_handle<>> ready_;  ///< tasks to be resumed
+    detail::Waiter *head_ = nullptr;             ///< suspended tasks
+    detail::Waiter *tail_ = nullptr;
+    size_t num_tasks_ = 0;
+
+    static inline thread_local Executor *current_ = nullptr;
+};
+
+inline void detail::Waiter::suspend(std::coroutine_handle<> h)
+{
+    Executor::current()->wait(this, h);
+}
+
+
+/*
+ * ===========================================================================
+ * Awaitables
+ * ===========================================================================
+ *
+ * The awaitables complete without suspending if the operation succeeds
+ * right away.
+ */
+
+namespace detail {
+
+template <typename End, typename T>
+class Recv final : public Waiter
+{
+  public:
+    explicit Recv(End &end) : end_(end) {}
+
+    bool poll() override
+    {
+        err_ = end_.try_recv_obj(*obj());
+        return err_ != SMLT_ERR_QUEUE_EMPTY;
+    }
+
+    bool await_ready() { return poll(); }
+    void await_suspend(std::coroutine_handle<> h) { suspend(h); }
+
+    T await_resume()
+    {
+        /* a partly filled T must not reach the task */
+        if (smlt_err_is_fail(err_)) {
+            SMLT_ABORT("smlt::async::recv: message larger than the %zu byte "
+                       "object\n", sizeof(T));
+        }
+        return *obj();
+    }
+
+  private:
+    /* T does not need to be default constructible */
+    T *obj() { return reinterpret_cast<T *>(&buf_); }
+
+    End &end_;
+    errval_t err_ = SMLT_SUCCESS;
+    alignas(T) unsigned char buf_[sizeof(T)];
+};
+
+template <typename End, typename T>
+class RecvInto final : public Waiter
+{
+  public:
+    RecvInto(End &end, T &obj) : end_(end), obj_(obj) {}
+
+    bool poll() override
+    {
+        err_ = end_.try_recv_obj(obj_);
+        return err_ != SMLT_ERR_QUEUE_EMPTY;
+    }
+
+    bool await_ready() { return poll(); }
+    void await_suspend(std::coroutine_handle<> h) { suspend(h); }
+    errval_t await_resume() { return err_; }
+
+  private:
+    End &end_;
+    T &obj_;
+    errval_t err_ = SMLT_SUCCESS;
+};
+
+template <typename End, typename T>
+class Send final : public Waiter
+{
+  public:
+    Send(End &end, const T &obj) : end_(end), obj_(obj) {}
+
+    bool poll() override
+    {
+        return end_.try_send_obj(obj_) != SMLT_ERR_QUEUE_FULL;
+    }
+
+    bool await_ready() { return poll(); }
+    void await_suspend(std::coroutine_handle<> h) { suspend(h); }
+    void await_resume() {}
+
+  private:
+    End &end_;
+    T obj_;
+};
+
+template <typename End>
+class RecvWords final : public Waiter
+{
+  public:
+    RecvWords(End &end, word_t *data) : end_(end), data_(data) {}
+
+    bool poll() override
+    {
+        err_ = end_.try_recv(data_);
+        return err_ != SMLT_ERR_QUEUE_EMPTY;
+    }
+
+    bool await_ready() { return poll(); }
+    void await_suspend(std::coroutine_handle<> h) { suspend(h); }
+    errval_t await_resume() { return err_; }
+
+  private:
+    End &end_;
+    word_t *data_;
+    errval_t err_ = SMLT_SUCCESS;
+};
+
+class Barrier final : public Waiter
+{
+  public:
+    explicit Barrier(struct smlt_context *ctx) : ctx_(ctx) {}
+
+    bool poll() override
+    {
+        return smlt_barrier_test(ctx_);
+    }
+
+    bool await_ready()
+    {
+        err_ = smlt_barrier_arrive(ctx_);
+        return smlt_err_is_fail(err_) || poll();
+    }
+
+    void await_suspend(std::coroutine_handle<> h) { suspend(h); }
+
+    errval_t await_resume()
+    {
+        return smlt_err_is_fail(err_) ? err_ : smlt_barrier_depart(ctx_);
+    }
+
+  private:
+    struct smlt_context *ctx_;
+    errval_t err_ = SMLT_SUCCESS;
+};
+
+} /* namespace detail */
+
+/**
+ * @brief receives a T from a queue or channel end, see smlt::recv()
+ *
+ * Suspends the task while the end is empty, the co_await yields the T.
+ * A message larger than a T aborts, use recv(end, obj) where the sender
+ * may send other types.
+ */
+template <typename T, typename End>
+detail::Recv<End, T> recv(End &end)
+{
+    return detail::Recv<End, T>(end);
+}
+
+/**
+ * @brief receives a T from a queue or channel end into obj
+ *
+ * Suspends the task while the end is empty, the co_await yields
+ * SMLT_SUCCESS or SMLT_ERR_INVAL if the message was larger than a T, as
+ * smlt::recv(end, obj) does.
+ */
+template <typename T, typename End>
+detail::RecvInto<End, T> recv(End &end, T &obj)
+{
+    return detail::RecvInto<End, T>(end, obj);
+}
+
+/**
+ * @brief receives a message of words from a queue or channel end
+ *
+ * Suspends the task while the end is empty, the co_await yields the
+ * error value of End::try_recv().
+ */
+template <typename End>
+detail::RecvWords<End> recv(End &end, word_t *data)
+{
+    return detail::RecvWords<End>(end, data);
+}
+
+/**
+ * @brief sends obj on a queue or channel end, see smlt::send()
+ *
+ * Suspends the task while the end is full.
+ */
+template <typename T, typename End>
+detail::Send<End, T> send(End &end, const T &obj)
+{
+    return detail::Send<End, T>(end, obj);
+}
+
+/**
+ * @brief enters the split barrier of a context, see smlt_barrier_arrive()
+ *
+ * Suspends the task until all nodes of the context arrived, the co_await
+ * yields the error value of smlt_barrier_depart(). The barrier is among
+ * the nodes, only one task per node may be in the barrier at a time.
+ */
+inline detail::Barrier barrier(struct smlt_context *ctx)
+{
+    return detail::Barrier(ctx);
+}
+
+} /* namespace async */
+} /* namespace smlt */
+
+#endif /* SMLT_ASYNC_HPP_ */
@@ -30,13 +30,22 @@ struct smlt_dissem_barrier;
  */
 
 /**
- * the smelt barrier data structure
+ * the barrier algorithms
  */
-struct smlt_barrier
-{
-    bool use_payload;
+typedef enum smlt_barrier_type {
+    SMLT_BARRIER_DEFAULT,       ///< SMLT_BARRIER, the auto-tuner or tree
+    SMLT_BARRIER_TREE,          ///< reduction and broadcast on the context
+    SMLT_BARRIER_DISSEMINATION, ///< dissemination over Smelt channels
+    SMLT_BARRIER_TOURNAMENT,    ///< tournament with static winners
+    SMLT_BARRIER_COMBINING,     ///< combining tree of shared counters
+    SMLT_BARRIER_MCS,           ///< MCS tree with 4-ary arrival, binary wakeup
+    SMLT_BARRIER_NUM_TYPES
+} smlt_barrier_type_t;
 
-};
+/**
+ * the smelt barrier data structure
+ */
+struct smlt_barrier;
 
 
 /*
@@ -72,6 +81,122 @@ errval_t smlt_barrier_destroy(struct smlt_context *ctx);
  */
 errval_t smlt_barrier_wait(struct smlt_context *ctx);
 
+/*
+ * ===========================================================================
+ * Barrier algorithms
+ * ===========================================================================
+ *
+ * A barrier handle runs one of several algorithms over the nodes of a
+ * context. The tree and dissemination barriers use Smelt channels, the
+ * others spin on shared memory. The handle is created once and then used by
+ * all nodes of the context.
+ */
+
+/**
+ * @brief creates a barrier over all nodes of a context
+ *
+ * @param ctx   the Smelt context
+ * @param type  the barrier algorithm to use
+ * @param ret   returns the barrier
+ *
+ * @returns SMLT_SUCCESS, SMLT_ERR_INVAL for an unknown type,
+ *          SMLT_ERR_MALLOC_FAIL or SMLT_ERR_CHAN_CREATE
+ */
+errval_t smlt_barrier_create(struct smlt_context *ctx,
+                             smlt_barrier_type_t type,
+                             struct smlt_barrier **ret);
+
+/**
+ * @brief frees a barrier
+ *
+ * @param bar   the barrier to free
+ *
+ * @returns SMLT_SUCCESS
+ */
+errval_t smlt_barrier_free(struct smlt_barrier *bar);
+
+/**
+ * @brief waits until all nodes of the context entered the barrier
+ *
+ * @param bar   the barrier
+ *
+ * @returns SMLT_SUCCESS or SMLT_ERR_INVAL if the node is not in the context
+ */
+errval_t smlt_barrier_enter(struct smlt_barrier *bar);
+
+/**
+ * @brief obtains the algorithm of a barrier
+ *
+ * @param bar   the barrier
+ *
+ * @returns the barrier type, never SMLT_BARRIER_DEFAULT
+ */
+smlt_barrier_type_t smlt_barrier_get_type(struct smlt_barrier *bar);
+
+/**
+ * @brief obtains the name of a barrier algorithm
+ *
+ * @param type  the barrier type
+ *
+ * @returns the name or NULL if the type is unknown
+ */
+const char *smlt_barrier_type_to_name(smlt_barrier_type_t type);
+
+/**
+ * @brief looks up a barrier algorithm by its name
+ *
+ * @param name  the name of the algorithm
+ *
+ * @returns the barrier type or SMLT_BARRIER_NUM_TYPES if it is unknown
+ */
+smlt_barrier_type_t smlt_barrier_type_from_name(const char *name);
+
+/*
+ * ===========================================================================
+ * Split barrier interface
+ * ===========================================================================
+ *
+ * The barrier is split into an arrive and a depart operation, a node may do
+ * local work in between. Every arrival starts a new epoch, and a depart waits
+ * for the oldest epoch the node has not departed from yet. Arrivals and
+ * releases carry the epoch and are cumulative, so a node may arrive at the
+ * next epoch before departing from the previous one, overlapping the up
+ * phase of the next barrier with the down phase of the previous one.
+ *
+ * The split barrier must not be in flight together with other collectives
+ * on the same context.
+ */
+
+/**
+ * @brief arrives at the next epoch of the split barrier without blocking
+ *
+ * @param ctx the Smelt context
+ *
+ * @returns SMLT_SUCCESS or SMLT_ERR_INVAL if the node is not in the context
+ */
+errval_t smlt_barrier_arrive(struct smlt_context *ctx);
+
+/**
+ * @brief checks if the oldest epoch not departed from has been released
+ *
+ * @param ctx the Smelt context
+ *
+ * @returns TRUE if smlt_barrier_depart() would not block
+ *
+ * Makes progress on the barrier, it can be polled while doing local work.
+ */
+bool smlt_barrier_test(struct smlt_context *ctx);
+
+/**
+ * @brief waits until the oldest epoch not departed from has been released
+ *
+ * @param ctx the Smelt context
+ *
+ * @returns SMLT_SUCCESS or SMLT_ERR_INVAL if the node is not in the context
+ *          or has not arrived at a new epoch
+ */
+errval_t smlt_barrier_depart(struct smlt_context *ctx);
+
 
 
 
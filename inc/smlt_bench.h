@@ -50,6 +50,8 @@ errval_t smlt_bench_ctl_init(struct smlt_bench_ctl *ctl,
 
 void smlt_bench_ctl_reset(struct smlt_bench_ctl *ctl);
 
+void smlt_bench_ctl_destroy(struct smlt_bench_ctl *ctl);
+
 
 /*
  * ===========================================================================
@@ -80,6 +80,51 @@ errval_t smlt_broadcast_notify(struct smlt_context *ctx);
  */
 
 
+/*
+ * ===========================================================================
+ * Smelt atomic broadcast
+ * ===========================================================================
+ *
+ * Any node may submit a message. The submissions of a round travel up the
+ * tree to the root, which acts as the sequencer: it stamps each message with
+ * the next global sequence number and broadcasts the batch down the tree.
+ * All nodes therefore deliver the same messages in the same order.
+ *
+ * A round is a collective operation, every node of the context takes part
+ * with at most one submission.
+ */
+
+///< number of payload words of an atomically broadcast message
+#define SMLT_ABCAST_PAYLOAD_WORDS 5
+
+/**
+ * @brief called for every message delivered by the atomic broadcast
+ *
+ * @param msg       the delivered message
+ * @param origin    the node that submitted the message
+ * @param seq       the global sequence number of the message, starting at 1
+ * @param arg       argument passed to smlt_atomic_broadcast()
+ */
+typedef void (*smlt_abcast_deliver_fn_t)(struct smlt_msg *msg,
+                                         smlt_nid_t origin, uint64_t seq,
+                                         void *arg);
+
+/**
+ * @brief performs a round of the totally ordered atomic broadcast
+ *
+ * @param ctx       the Smelt context to broadcast on
+ * @param msg       the message to submit, NULL for none
+ * @param deliver   function called for each message of the round in order
+ * @param arg       argument passed to the deliver function
+ *
+ * @returns SMLT_SUCCESS or SMLT_ERR_INVAL if the message is too large
+ */
+errval_t smlt_atomic_broadcast(struct smlt_context *ctx,
+                               struct smlt_msg *msg,
+                               smlt_abcast_deliver_fn_t deliver,
+                               void *arg);
+
+
 /*
   TODO
   uintptr_t mp_receive_forward(uintptr_t);  
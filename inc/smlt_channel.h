@@ -42,6 +42,7 @@ struct smlt_channel
     uint32_t m;
     uint32_t n;
     bool use_shm;
+    bool borrowed;  ///< the queues belong to the channel of another context
     /* type specific queue pair */
     union {
         struct mp {
@@ -82,12 +83,41 @@ errval_t smlt_channel_create(struct smlt_channel **chan,
                              uint16_t count_src,
                              uint16_t count_dst);
 
+///< no channel options
+#define SMLT_CHANNEL_FLAG_NONE       0
+
+///< 1:n channels keep the message headers in a separate, compact array
+#define SMLT_CHANNEL_FLAG_SEP_HEADER (1 << 0)
+
+ /**
+  * @brief creates the queue pair with options
+  *
+  * @param chan     return pointer to the channel
+  * @param src      src core ids
+  * @param dst      array of core ids to desinations
+  * @param count_src    length of array src;
+  * @param count_dst    length of array dst;
+  * @param flags    SMLT_CHANNEL_FLAG_* options of the channel
+  *
+  * @returns SMLT_SUCCESS or failure
+  *
+  * With SMLT_CHANNEL_FLAG_SEP_HEADER the readers of a 1:n channel poll an
+  * array of headers, eight to a cacheline, instead of the first word of every
+  * message slot. The flag is ignored for 1:1 channels.
+  */
+errval_t smlt_channel_create_flags(struct smlt_channel **chan,
+                                   uint32_t* src,
+                                   uint32_t* dst,
+                                   uint16_t count_src,
+                                   uint16_t count_dst,
+                                   uint32_t flags);
+
  /**
-  * @brief destroys the channel
+  * @brief destroys the channel and frees its queues
   *
-  * @param
+  * @param chan     the channel to destroy
   *
-  * @returns 0
+  * @returns SMLT_SUCCESS or failure
   */
 errval_t smlt_channel_destroy(struct smlt_channel *chan);
 
@@ -192,6 +222,17 @@ static inline bool smlt_channel_can_send(struct smlt_channel *chan)
 {
     bool result = true;
     uint32_t num_chan = chan->m > chan->n ? chan->m : chan->n;
+    if (chan->use_shm) {
+        if (chan->owner == smlt_node_self_id) {
+            return swmr_can_send(&chan->c.shm.send_owner.src);
+        }
+        for (unsigned int i = 0; i < chan->m; i++) {
+            if (chan->c.shm.dst[i] == smlt_node_self_id) {
+                return smlt_queuepair_can_send(chan->c.shm.recv[i]);
+            }
+        }
+        return false;
+    }
     for (unsigned int i = 0; i < num_chan; i++) {
         if (chan->owner == smlt_node_self_id) {
             if (!smlt_queuepair_can_send(&chan->c.mp.send[i])) {
@@ -315,6 +356,53 @@ static inline errval_t smlt_channel_recv_index(struct smlt_channel *chan,
     }
 }
 
+/**
+ * @brief checks if there is a message to be received from the owner
+ *
+ * @param chan      the Smelt channel to call the check function on
+ * @param index     for 1:n channels the receiving end, otherwise ignored
+ *
+ * @returns TRUE if smlt_channel_recv_index() would not block
+ *          FALSE otherwise
+ */
+static inline bool smlt_channel_can_recv_index(struct smlt_channel *chan,
+                                               uint32_t index)
+{
+    if (chan->use_shm) {
+        return swmr_can_receive(&chan->c.shm.send_owner.dst[index]);
+    }
+    return smlt_queuepair_can_recv(&chan->c.mp.recv[0]);
+}
+
+/**
+ * @brief obtains the number of queues the owner of the channel receives on
+ *
+ * @param chan      the Smelt channel
+ *
+ * @returns one queue per reader for 1:n channels, one otherwise
+ */
+static inline uint32_t smlt_channel_get_num_owner_queues(struct smlt_channel *chan)
+{
+    return chan->use_shm ? chan->m : 1;
+}
+
+/**
+ * @brief obtains a queue the owner of the channel receives on
+ *
+ * @param chan      the Smelt channel
+ * @param index     index of the queue, the reader for 1:n channels
+ *
+ * @returns the queuepair end of the owner
+ */
+static inline struct smlt_qp *smlt_channel_get_owner_queue(struct smlt_channel *chan,
+                                                           uint32_t index)
+{
+    if (chan->use_shm) {
+        return chan->c.shm.recv_owner[index];
+    }
+    return &chan->c.mp.send[0];
+}
+
 /**
  * @brief checks if there is a message to be received
  *
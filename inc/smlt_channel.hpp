@@ -0,0 +1,347 @@
+/*
+ * Copyright (c) 2016 ETH Zurich.
+ * All rights reserved.
+ *
+ * This file is distributed under the terms in the attached LICENSE file.
+ * If you do not find this file, copies can be found by writing to:
+ * ETH Zurich D-INFK, Universitaetstr. 6, CH-8092 Zurich. Attn: Systems Group.
+ */
+#ifndef SMLT_CHANNEL_HPP_
+#define SMLT_CHANNEL_HPP_ 1
+
+#include <smlt_queue.hpp>
+
+/* the C channel functions use variable length arrays */
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wvla"
+extern "C" {
+#include <smlt_channel.h>
+}
+#pragma GCC diagnostic pop
+
+/*
+ * ===========================================================================
+ * Smelt C++ channels
+ * ===========================================================================
+ *
+ * smlt::Channel<Backend, Fanout, Words> is a view on a channel created by
+ * smlt_channel_create(). Whether the calling node owns the channel is
+ * decided once when an end is attached, the number of receivers is a
+ * template parameter. Sending and receiving hence do not test the channel
+ * type or the owner per message.
+ *
+ * As in smlt_channel_create(), a 1:1 channel is a queuepair of the backend,
+ * a 1:n channel broadcasts on a SWMR queue and receives the replies on one
+ * queuepair per receiver.
+ *
+ * The typed smlt::send() and smlt::recv() work on both ends, except that
+ * the owner of a 1:n channel receives its replies with recv_all().
+ */
+
+namespace smlt {
+
+namespace detail {
+
+/**
+ * @brief the owner end of a channel to Fanout receivers
+ */
+template <typename Backend, uint32_t Fanout, uint32_t Words,
+          bool Multi = (Fanout > 1)>
+class ChannelOwner;
+
+/**
+ * @brief a receiving end of a channel to Fanout receivers
+ */
+template <typename Backend, uint32_t Fanout, uint32_t Words,
+          bool Multi = (Fanout > 1)>
+class ChannelMember;
+
+/* 1:1 channels */
+
+template <typename Backend, uint32_t Fanout, uint32_t Words>
+class ChannelOwner<Backend, Fanout, Words, false>
+{
+  public:
+    errval_t attach(struct smlt_channel *chan)
+    {
+        if (chan->use_shm || chan->m != 1) {
+            return SMLT_ERR_INVAL;
+        }
+        return queue_.attach(chan->c.mp.send);
+    }
+
+    errval_t try_send(const word_t *data) { return queue_.try_send(data); }
+    void send(const word_t *data) { queue_.send(data); }
+    void notify() { queue_.notify(); }
+    bool can_send() { return queue_.can_send(); }
+
+    errval_t recv(word_t *data) { return queue_.recv(data); }
+    void recv_notification() { queue_.recv_notification(); }
+    bool can_recv() { return queue_.can_recv(); }
+
+    template <typename T>
+    errval_t try_send_obj(const T &obj) { return queue_.try_send_obj(obj); }
+    template <typename T>
+    errval_t try_recv_obj(T &obj) { return queue_.try_recv_obj(obj); }
+
+  private:
+    Queue<Backend, Backend::default_slots, Words> queue_;
+};
+
+template <typename Backend, uint32_t Fanout, uint32_t Words>
+class ChannelMember<Backend, Fanout, Words, false>
+{
+  public:
+    errval_t attach(struct smlt_channel *chan, smlt_nid_t self)
+    {
+        if (chan->use_shm || chan->m != 1 || chan->trg != self) {
+            return SMLT_ERR_INVAL;
+        }
+        return queue_.attach(chan->c.mp.recv);
+    }
+
+    errval_t try_send(const word_t *data) { return queue_.try_send(data); }
+    void send(const word_t *data) { queue_.send(data); }
+    void notify() { queue_.notify(); }
+    bool can_send() { return queue_.can_send(); }
+
+    errval_t recv(word_t *data) { return queue_.recv(data); }
+    void recv_notification() { queue_.recv_notification(); }
+    bool can_recv() { return queue_.can_recv(); }
+
+    template <typename T>
+    errval_t try_send_obj(const T &obj) { return queue_.try_send_obj(obj); }
+    template <typename T>
+    errval_t try_recv_obj(T &obj) { return queue_.try_recv_obj(obj); }
+
+  private:
+    Queue<Backend, Backend::default_slots, Words> queue_;
+};
+
+/* 1:n channels */
+
+template <typename Backend, uint32_t Fanout, uint32_t Words>
+class ChannelOwner<Backend, Fanout, Words, true>
+{
+  public:
+    errval_t attach(struct smlt_channel *chan)
+    {
+        if (!chan->use_shm || chan->m != Fanout) {
+            return SMLT_ERR_INVAL;
+        }
+
+        writer_ = &chan->c.shm.send_owner.src;
+        for (uint32_t i = 0; i < Fanout; i++) {
+            errval_t err = replies_[i].attach(chan->c.shm.recv_owner[i]);
+            if (smlt_err_is_fail(err)) {
+                return err;
+            }
+        }
+        return SMLT_SUCCESS;
+    }
+
+    errval_t try_send(const word_t *data)
+    {
+        return swmr_try_send<Words>(writer_, WordSrc{data});
+    }
+
+    void send(const word_t *data)
+    {
+        while (try_send(data) == SMLT_ERR_QUEUE_FULL)
+            ;
+    }
+
+    void notify()
+    {
+        while (!swmr_can_send(writer_))
+            ;
+        swmr_send_raw0(writer_);
+    }
+
+    bool can_send() { return swmr_can_send(writer_); }
+
+    /**
+     * @brief receives one message from every receiver
+     *
+     * @param data  buffer of Fanout * Words words, NULL drops the payload
+     */
+    errval_t recv(word_t *data)
+    {
+        errval_t err = SMLT_SUCCESS;
+        for (uint32_t i = 0; i < Fanout; i++) {
+            err = replies_[i].recv(data ? data + i * Words : NULL);
+            if (smlt_err_is_fail(err)) {
+                return err;
+            }
+        }
+        return err;
+    }
+
+    void recv_notification() { recv(NULL); }
+
+    bool can_recv()
+    {
+        for (uint32_t i = 0; i < Fanout; i++) {
+            if (!replies_[i].can_recv()) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    template <typename T>
+    errval_t try_send_obj(const T &obj)
+    {
+        typedef Payload<T, UINT32_MAX> p;
+        return swmr_try_send<p::words>(writer_, ObjSrc<T>{&obj});
+    }
+
+    /**
+     * @brief receives a T from every receiver
+     *
+     * @param objs  array of Fanout objects
+     */
+    template <typename T>
+    errval_t recv_all(T *objs)
+    {
+        errval_t err = SMLT_SUCCESS;
+        for (uint32_t i = 0; i < Fanout; i++) {
+            err = smlt::recv(replies_[i], objs[i]);
+            if (smlt_err_is_fail(err)) {
+                return err;
+            }
+        }
+        return err;
+    }
+
+  private:
+    struct swmr_context *writer_;
+    Queue<Backend, Backend::default_slots, Words> replies_[Fanout];
+};
+
+template <typename Backend, uint32_t Fanout, uint32_t Words>
+class ChannelMember<Backend, Fanout, Words, true>
+{
+  public:
+    errval_t attach(struct smlt_channel *chan, smlt_nid_t self)
+    {
+        if (!chan->use_shm || chan->m != Fanout) {
+            return SMLT_ERR_INVAL;
+        }
+
+        for (uint32_t i = 0; i < Fanout; i++) {
+            if (chan->c.shm.dst[i] == self) {
+                reader_ = &chan->c.shm.send_owner.dst[i];
+                return reply_.attach(chan->c.shm.recv[i]);
+            }
+        }
+        return SMLT_ERR_INVAL;
+    }
+
+    errval_t try_send(const word_t *data) { return reply_.try_send(data); }
+    void send(const word_t *data) { reply_.send(data); }
+    void notify() { reply_.notify(); }
+    bool can_send() { return reply_.can_send(); }
+
+    errval_t recv(word_t *data)
+    {
+        errval_t err;
+        do {
+            err = data ? swmr_try_recv<Words>(reader_, WordSink{data})
+                       : swmr_try_recv<Words>(reader_, NullSink());
+        } while (err == SMLT_ERR_QUEUE_EMPTY);
+        return err;
+    }
+
+    void recv_notification() { recv(NULL); }
+    bool can_recv() { return swmr_can_receive(reader_); }
+
+    template <typename T>
+    errval_t try_send_obj(const T &obj) { return reply_.try_send_obj(obj); }
+
+    template <typename T>
+    errval_t try_recv_obj(T &obj)
+    {
+        typedef Payload<T, UINT32_MAX> p;
+        return swmr_try_recv<p::words>(reader_, ObjSink<T>{&obj});
+    }
+
+  private:
+    struct swmr_context *reader_;
+    Queue<Backend, Backend::default_slots, Words> reply_;
+};
+
+} /* namespace detail */
+
+/**
+ * @brief a channel specialized for a backend, fanout and message size
+ *
+ * @tparam Backend  backend of the queuepairs of the channel
+ * @tparam Fanout   number of receivers of the channel
+ * @tparam Words    number of payload words of a message
+ *
+ * Usage: the owner attaches a Channel::Owner, the receivers a
+ * Channel::Member to the same struct smlt_channel.
+ */
+template <typename Backend, uint32_t Fanout,
+          uint32_t Words = Backend::slot_words>
+struct Channel
+{
+    static_assert(Fanout > 0, "a channel needs a receiver");
+
+    static constexpr uint32_t fanout = Fanout;
+    static constexpr uint32_t words = Words;
+
+    /**
+     * the owner end: sends to all receivers, receives one message from each
+     */
+    class Owner : public detail::ChannelOwner<Backend, Fanout, Words>
+    {
+      public:
+        /**
+         * @brief attaches to the channel if the caller is its owner
+         *
+         * @param chan  the channel
+         * @param self  node id of the caller
+         *
+         * @returns SMLT_SUCCESS or SMLT_ERR_INVAL
+         */
+        errval_t attach(struct smlt_channel *chan,
+                        smlt_nid_t self = smlt_node_self_id)
+        {
+            if (chan == NULL || chan->owner != self) {
+                return SMLT_ERR_INVAL;
+            }
+            return detail::ChannelOwner<Backend, Fanout, Words>::attach(chan);
+        }
+    };
+
+    /**
+     * a receiving end: receives from and replies to the owner
+     */
+    class Member : public detail::ChannelMember<Backend, Fanout, Words>
+    {
+      public:
+        /**
+         * @brief attaches to the channel if the caller is a receiver
+         *
+         * @param chan  the channel
+         * @param self  node id of the caller
+         *
+         * @returns SMLT_SUCCESS or SMLT_ERR_INVAL
+         */
+        errval_t attach(struct smlt_channel *chan,
+                        smlt_nid_t self = smlt_node_self_id)
+        {
+            if (chan == NULL) {
+                return SMLT_ERR_INVAL;
+            }
+            return detail::ChannelMember<Backend, Fanout, Words>::attach(chan,
+                                                                         self);
+        }
+    };
+};
+
+} /* namespace smlt */
+
+#endif /* SMLT_CHANNEL_HPP_ */
@@ -0,0 +1,163 @@
+/*
+ * Copyright (c) 2016 ETH Zurich.
+ * All rights reserved.
+ *
+ * This file is distributed under the terms in the attached LICENSE file.
+ * If you do not find this file, copies can be found by writing to:
+ * ETH Zurich D-INFK, Universitaetstr. 6, CH-8092 Zurich. Attn: Systems Group.
+ */
+#ifndef SMLT_CONSENSUS_H_
+#define SMLT_CONSENSUS_H_ 1
+
+/* forward declaration */
+struct smlt_context;
+struct smlt_msg;
+struct smlt_consensus;
+
+/*
+ * ===========================================================================
+ * Smelt consensus
+ * ===========================================================================
+ *
+ * A leader driven replicated log. The root of the context is the leader, it
+ * appends commands to the log and sends them down the tree in batches. Each
+ * node acknowledges a batch once it and its whole subtree stored it. When the
+ * acknowledgement reaches the leader the entries are committed, and the
+ * commit index is sent down the tree. Every node applies the committed
+ * entries in log order.
+ *
+ * Proposals are pipelined: the leader does not wait for a batch to commit
+ * before sending the next one, as long as no more than `window` entries are
+ * uncommitted.
+ */
+
+///< number of payload words of a log entry
+#define SMLT_CONSENSUS_PAYLOAD_WORDS 5
+
+/**
+ * @brief called for every committed entry of the log
+ *
+ * @param idx   the index of the entry in the log, starting at 1
+ * @param cmd   the command stored in the entry
+ * @param arg   argument passed to smlt_consensus_create()
+ */
+typedef void (*smlt_consensus_apply_fn_t)(uint64_t idx, struct smlt_msg *cmd,
+                                          void *arg);
+
+/*
+ * ===========================================================================
+ * creation and destruction
+ * ===========================================================================
+ */
+
+/**
+ * @brief creates the replicated log state of the calling node
+ *
+ * @param ctx           the Smelt context to replicate on
+ * @param batch_size    number of entries the leader sends per batch
+ * @param window        maximum number of uncommitted entries
+ * @param apply         function called for every committed entry
+ * @param arg           argument passed to the apply function
+ * @param ret           returns the replicated log
+ *
+ * @returns SMLT_SUCCESS, SMLT_ERR_INVAL if the sizes are not valid
+ *          or SMLT_ERR_MALLOC_FAIL
+ *
+ * Every node of the context calls this function with the same arguments.
+ */
+errval_t smlt_consensus_create(struct smlt_context *ctx, uint32_t batch_size,
+                               uint32_t window,
+                               smlt_consensus_apply_fn_t apply, void *arg,
+                               struct smlt_consensus **ret);
+
+/**
+ * @brief destroys the replicated log state of the calling node
+ *
+ * @param cons  the replicated log
+ *
+ * @returns SMLT_SUCCESS
+ */
+errval_t smlt_consensus_destroy(struct smlt_consensus *cons);
+
+/*
+ * ===========================================================================
+ * leader functions
+ * ===========================================================================
+ */
+
+/**
+ * @brief appends a command to the log
+ *
+ * @param cons  the replicated log
+ * @param cmd   the command to append
+ *
+ * @returns SMLT_SUCCESS, SMLT_ERR_INVAL if the command is too large or
+ *          the calling node is not the leader
+ *
+ * The command is sent with the next full batch or smlt_consensus_flush().
+ * This function blocks while the window of uncommitted entries is full.
+ */
+errval_t smlt_consensus_propose(struct smlt_consensus *cons,
+                                struct smlt_msg *cmd);
+
+/**
+ * @brief sends the current, possibly partial, batch
+ *
+ * @param cons  the replicated log
+ *
+ * @returns SMLT_SUCCESS or SMLT_ERR_INVAL if the node is not the leader
+ */
+errval_t smlt_consensus_flush(struct smlt_consensus *cons);
+
+/**
+ * @brief flushes the batch and waits until all entries are committed
+ *
+ * @param cons  the replicated log
+ *
+ * @returns SMLT_SUCCESS or SMLT_ERR_INVAL if the node is not the leader
+ */
+errval_t smlt_consensus_sync(struct smlt_consensus *cons);
+
+/**
+ * @brief commits all entries and stops the replicas
+ *
+ * @param cons  the replicated log
+ *
+ * @returns SMLT_SUCCESS or SMLT_ERR_INVAL if the node is not the leader
+ */
+errval_t smlt_consensus_shutdown(struct smlt_consensus *cons);
+
+/*
+ * ===========================================================================
+ * replica functions
+ * ===========================================================================
+ */
+
+/**
+ * @brief processes the pending messages without blocking
+ *
+ * @param cons  the replicated log
+ *
+ * @returns SMLT_SUCCESS
+ */
+errval_t smlt_consensus_poll(struct smlt_consensus *cons);
+
+/**
+ * @brief replicates the log until the leader shuts it down
+ *
+ * @param cons  the replicated log
+ *
+ * @returns SMLT_SUCCESS or SMLT_ERR_INVAL if the node is the leader
+ */
+errval_t smlt_consensus_run(struct smlt_consensus *cons);
+
+/**
+ * @brief obtains the index of the last applied entry
+ *
+ * @param cons  the replicated log
+ *
+ * @returns the index of the last applied entry, 0 if there is none
+ */
+uint64_t smlt_consensus_get_applied(struct smlt_consensus *cons);
+
+#endif /* SMLT_CONSENSUS_H_ */
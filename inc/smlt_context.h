@@ -16,6 +16,9 @@ struct smlt_channel;
 
 #define SMLT_CONTEXT_CHECK(_ctx)
 
+///< color of nodes that do not take part in a split
+#define SMLT_CONTEXT_SPLIT_UNDEFINED ((uint32_t)-1)
+
 /*
  * ===========================================================================
  * type declarations
@@ -28,6 +31,11 @@ struct smlt_channel;
  */
 struct smlt_context;
 
+/**
+ * a set of prepared contexts over the same nodes, see smlt_context_switch()
+ */
+struct smlt_context_set;
+
 
 /*
  * ===========================================================================
@@ -48,15 +56,118 @@ struct smlt_context;
 errval_t smlt_context_create(struct smlt_topology *topo,
                              struct smlt_context **ret_ctx);
 
+/**
+ * @brief creates a new smelt context over a set of cores
+ *
+ * @param cores     the cores of the context, cores[0] becomes the root
+ * @param len       length of the cores array
+ * @param name      name of the tree topology, NULL for SMLT_TOPO
+ * @param ret_ctx   returns the new Smelt context
+ *
+ * @return  SMLT_ERR_INVAL if no node runs on one of the cores
+ *          SMLT_ERR_MALLOC_FAIL
+ *          SMLT_SUCCESS
+ *
+ * The topology is generated for the given cores only and destroyed
+ * together with the context. If the Simulator cannot provide it, a
+ * NUMA-aware cluster tree is used.
+ */
+errval_t smlt_context_create_from_cores(coreid_t *cores, uint32_t len,
+                                        const char *name,
+                                        struct smlt_context **ret_ctx);
+
 /**
  * @brief destroys the Smelt context and frees its resources
  *
  * @param ctx   Smelt context to destroy
  *
  * @return  SMLT_SUCCESS
+ *
+ * Channels reused from another context by smlt_context_split() are left to
+ * that context, hence contexts obtained from a split have to be destroyed
+ * before the context they were split from.
  */
 errval_t smlt_context_destroy(struct smlt_context *ctx);
 
+/**
+ * @brief splits the context into disjoint sub-contexts
+ *
+ * @param ctx       the context to split
+ * @param color     nodes with the same color end up in the same context,
+ *                  SMLT_CONTEXT_SPLIT_UNDEFINED to not take part
+ * @param key       orders the nodes within the new context, the node with
+ *                  the lowest key becomes the root
+ * @param ret_ctx   returns the new context, NULL for SMLT_CONTEXT_SPLIT_UNDEFINED
+ *
+ * @return SMLT_SUCCESS or error value
+ *
+ * This has to be called by all nodes of the context. The new trees are built
+ * with the topology of ctx, message passing channels of ctx are reused for
+ * edges present in both trees. Hence, collectives on ctx must not overlap
+ * with collectives on the new contexts.
+ */
+errval_t smlt_context_split(struct smlt_context *ctx, uint32_t color,
+                            uint32_t key, struct smlt_context **ret_ctx);
+
+
+/*
+ * ===========================================================================
+ * Switching contexts
+ * ===========================================================================
+ */
+
+/**
+ * @brief creates a set of contexts to switch between at runtime
+ *
+ * @param contexts      the prepared contexts, contexts[0] is active initially
+ * @param num_contexts  number of contexts
+ * @param ret_set       returns the context set
+ *
+ * @return SMLT_ERR_INVAL if the contexts do not span the same nodes
+ *         SMLT_ERR_MALLOC_FAIL
+ *         SMLT_SUCCESS
+ *
+ * Typically the contexts use different topologies, e.g. a latency optimal
+ * tree for barriers and a wide tree for bulk broadcasts.
+ */
+errval_t smlt_context_set_create(struct smlt_context **contexts,
+                                 uint32_t num_contexts,
+                                 struct smlt_context_set **ret_set);
+
+/**
+ * @brief destroys the context set, but not its contexts
+ *
+ * @param set   the context set
+ *
+ * @return SMLT_SUCCESS
+ */
+errval_t smlt_context_set_destroy(struct smlt_context_set *set);
+
+/**
+ * @brief returns the context the current node uses
+ *
+ * @param set   the context set
+ *
+ * @return the active context or NULL if the node is not part of the set
+ */
+struct smlt_context *smlt_context_set_get_active(struct smlt_context_set *set);
+
+/**
+ * @brief switches all nodes of the set to another prepared context
+ *
+ * @param set   the context set
+ * @param idx   index of the context to switch to
+ *
+ * @return SMLT_ERR_INVAL if there is no such context
+ *         SMLT_ERR_NODE_INVALD if the node is not part of the set
+ *         SMLT_SUCCESS
+ *
+ * This has to be called by all nodes of the set with the same index. A
+ * barrier on the active context ensures that every node has completed its
+ * collectives before the new one is used. No channels are created.
+ */
+errval_t smlt_context_switch(struct smlt_context_set *set, uint32_t idx);
+
 
 /*
  * ===========================================================================
@@ -134,6 +245,40 @@ errval_t smlt_context_get_parent_channel(struct smlt_context *ctx,
  * ===========================================================================
  */
 
+/**
+ * @brief obtains the number of nodes of the context
+ *
+ * @param ctx   Smelt context
+ *
+ * @return number of nodes
+ */
+uint32_t smlt_context_get_num_nodes(struct smlt_context *ctx);
+
+///< rank returned for nodes that are not part of the context
+#define SMLT_CONTEXT_RANK_NONE ((uint32_t)-1)
+
+/**
+ * @brief obtains the id of the node with the given rank
+ *
+ * @param ctx   Smelt context
+ * @param rank  rank of the node, smaller than the number of nodes
+ *
+ * @return the node id
+ *
+ * The nodes of a context are ranked from 0 to the number of nodes - 1 in
+ * the order of the topology.
+ */
+smlt_nid_t smlt_context_get_node_id(struct smlt_context *ctx, uint32_t rank);
+
+/**
+ * @brief obtains the rank of the calling node in the context
+ *
+ * @param ctx   Smelt context
+ *
+ * @return the rank or SMLT_CONTEXT_RANK_NONE if the node is not part of it
+ */
+uint32_t smlt_context_get_rank(struct smlt_context *ctx);
+
 
 /**
  * @brief checks if the node is the root in the context
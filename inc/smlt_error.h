@@ -68,6 +68,13 @@ enum smlt_err_code {
     /* send erros */
     SMLT_ERR_SEND,
     SMLT_ERR_NOTIFY,
+
+    /* profiler errors */
+    SMLT_ERR_PROFILE_IO, ///< reading or writing the cost profile failed
+
+    /* tuner errors */
+    SMLT_ERR_TUNE_NOTFOUND, ///< there is no decision table for the cores
+
     SMLT_ERR
 };
 
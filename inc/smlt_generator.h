@@ -7,10 +7,16 @@
  * ETH Zurich D-INFK, Universitaetstr. 6, CH-8092 Zurich. Attn: Systems Group.
  */
 #include <stdint.h>
+#include <stdbool.h>
 #ifndef SMLT_GENERATOR_H_
 #define SMLT_GENERATOR_H_ 1
 
 
+/**
+ * a model as returned by the Simulator. The matrix is indexed by core id,
+ * i.e. len is larger than the highest core participating, which is not
+ * necessarily the number of cores of the machine.
+ */
 struct smlt_generated_model {
     // number of cores participating
     uint32_t ncores;
@@ -23,6 +29,36 @@ struct smlt_generated_model {
     uint32_t* leafs;
 };
 
+///< the node has no parent, i.e. it is the root or not part of the model
+#define SMLT_MODEL_NO_PARENT UINT32_MAX
+
+///< types of the edges in the sparse model
+#define SMLT_MODEL_EDGE_MP  0   ///< message passing
+#define SMLT_MODEL_EDGE_SHM 1   ///< shared memory
+
+/**
+ * sparse representation of a model: a parent array and the child lists
+ * in compressed sparse row format.
+ *
+ * The children of node i are children[child_offset[i]] up to
+ * children[child_offset[i+1]-1]. The first num_children[i] of them are
+ * connected by message passing, in the order the messages are sent, the
+ * remaining num_children_shm[i] by shared memory.
+ */
+struct smlt_sparse_model {
+    uint32_t len;               ///< number of nodes
+    uint32_t root;              ///< the root node
+    uint32_t *parent;           ///< parent of each node or SMLT_MODEL_NO_PARENT
+    uint8_t *parent_edge;       ///< type of the edge to the parent
+    uint32_t *child_idx;        ///< position among the parent's children
+    uint32_t *num_children;     ///< number of message passing children
+    uint32_t *num_children_shm; ///< number of shared memory children
+    uint32_t *child_offset;     ///< start of the child list of each node
+    uint32_t *children;         ///< the child lists
+    uint32_t num_leafs;         ///< number of leafs
+    uint32_t *leafs;            ///< the leafs
+};
+
 /**
  * @brief generates a model using the simulator
  *
@@ -37,11 +73,59 @@ struct smlt_generated_model {
  *
  * @return              SMLT_SUCCESS if there was no parser/connection
  *                      error otherwise SMLT_ERR_GENERATOR
+ *
+ * Built-in topologies are generated directly. Otherwise, the model cache is
+ * consulted before contacting the Simulator, and models returned by the
+ * Simulator are added to it.
  */
 errval_t smlt_generate_model(coreid_t* cores,
                          uint32_t len,
                          const char* name,
                          struct smlt_generated_model** model);
+struct smlt_profile;
+
+/**
+ * @brief generates a model from a measured cost profile
+ *
+ * @param profile       the pairwise link costs of the machine
+ * @param cores         an arry of cores that contains the
+ *                      cores of the model, cores[0] becomes the root
+ * @param len           length of the cores array
+ * @param model         (return value) in struct encoded model
+ *
+ * @return              SMLT_SUCCESS or SMLT_ERR_GENERATOR if a core
+ *                      is not part of the profile
+ */
+errval_t smlt_generate_model_from_profile(struct smlt_profile *profile,
+                                          coreid_t* cores, uint32_t len,
+                                          struct smlt_generated_model** model);
+
+/**
+ * @brief checks whether the name refers to a built-in topology
+ *
+ * @param name          name of the topology, NULL for SMLT_TOPO
+ *
+ * @return              true if the topology can be generated without
+ *                      the Simulator
+ */
+bool smlt_generator_is_builtin(const char* name);
+
+/**
+ * @brief generates one of the built-in tree topologies
+ *
+ * @param name          name of the topology (SMLT_TOPO_*), NULL for SMLT_TOPO
+ * @param cores         an arry of cores that contains the
+ *                      cores of the model, cores[0] becomes the root
+ * @param len           length of the cores array
+ * @param model         (return value) in struct encoded model
+ *
+ * @return              SMLT_SUCCESS or SMLT_ERR_INVAL if the name is not
+ *                      a built-in topology
+ */
+errval_t smlt_generate_builtin_model(const char* name, coreid_t* cores,
+                                     uint32_t len,
+                                     struct smlt_generated_model** model);
+
 /**
  * @brief generates a model from a file storing a json string
  *
@@ -58,11 +142,165 @@ errval_t smlt_generate_modal_from_file(char* filepath, uint32_t ncores,
 
 /**
  * @brief update measurements on the generator
- *        i.e. make new measurements and send them to
- *        generator service
+ *        i.e. measure the pairwise link costs of the machine and
+ *        store them in the per-host profile cache
  *
- * @return SMLT_SUCCESS or SMLT_ERR_GENERATOR if communication
- *         to the generator failed
+ * @return SMLT_SUCCESS or SMLT_ERR_GENERATOR if the measurement
+ *         or storing the profile failed
  */
 errval_t smlt_generator_update_measurments(void);
+
+/**
+ * @brief looks up a previously generated model in the model cache
+ *
+ * @param cores         an arry of cores that contains the
+ *                      cores of the model
+ * @param len           length of the cores array
+ * @param name          name of the tree topology, NULL for SMLT_TOPO
+ * @param model         (return value) in struct encoded model
+ *
+ * @return              SMLT_SUCCESS if a model for this machine, core set
+ *                      and topology was found, SMLT_ERR_GENERATOR otherwise
+ */
+errval_t smlt_model_cache_lookup(coreid_t* cores, uint32_t len,
+                                 const char* name,
+                                 struct smlt_generated_model** model);
+
+/**
+ * @brief stores a generated model in the model cache
+ *
+ * @param model         the model to store
+ * @param cores         an arry of cores that contains the
+ *                      cores of the model
+ * @param len           length of the cores array
+ * @param name          name of the tree topology, NULL for SMLT_TOPO
+ *
+ * @return              SMLT_SUCCESS or SMLT_ERR_GENERATOR if the cache
+ *                      could not be written
+ */
+errval_t smlt_model_cache_store(struct smlt_generated_model* model,
+                                coreid_t* cores, uint32_t len,
+                                const char* name);
+
+/**
+ * @brief creates an empty sparse model
+ *
+ * @param len           number of nodes in the model
+ * @param root          the root node
+ * @param sparse        (return value) the sparse model
+ *
+ * @return              SMLT_SUCCESS or SMLT_ERR_MALLOC_FAIL
+ */
+errval_t smlt_sparse_model_create(uint32_t len, uint32_t root,
+                                  struct smlt_sparse_model **sparse);
+
+/**
+ * @brief frees the sparse model
+ *
+ * @param sparse        the sparse model
+ */
+void smlt_sparse_model_destroy(struct smlt_sparse_model *sparse);
+
+/**
+ * @brief appends a child to the children of the parent
+ *
+ * @param sparse        the sparse model
+ * @param parent        the parent node
+ * @param child         the child node
+ * @param edge          the type of the edge (SMLT_MODEL_EDGE_*)
+ *
+ * @return              SMLT_SUCCESS or SMLT_ERR_INVAL if the child is
+ *                      already connected
+ *
+ * There is no limit on the number of children of a node.
+ */
+errval_t smlt_sparse_model_add_child(struct smlt_sparse_model *sparse,
+                                     uint32_t parent, uint32_t child,
+                                     uint8_t edge);
+
+/**
+ * @brief builds the child lists and the leafs of the sparse model
+ *
+ * @param sparse        the sparse model
+ *
+ * @return              SMLT_SUCCESS or SMLT_ERR_GENERATOR
+ */
+errval_t smlt_sparse_model_finalize(struct smlt_sparse_model *sparse);
+
+/**
+ * @brief converts a dense model into the sparse representation
+ *
+ * @param model         the dense model
+ * @param sparse        (return value) the sparse model
+ *
+ * @return              SMLT_SUCCESS or SMLT_ERR_GENERATOR if the model
+ *                      cannot be parsed
+ */
+errval_t smlt_sparse_model_from_dense(struct smlt_generated_model *model,
+                                      struct smlt_sparse_model **sparse);
+
+/**
+ * @brief converts a sparse model into the dense matrix representation
+ *
+ * @param sparse        the sparse model
+ * @param model         (return value) the dense model
+ *
+ * @return              SMLT_SUCCESS, SMLT_ERR_MALLOC_FAIL or
+ *                      SMLT_ERR_GENERATOR if a node has more than
+ *                      TOPO_MATRIX_MAX_MP message passing children
+ */
+errval_t smlt_sparse_model_to_dense(struct smlt_sparse_model *sparse,
+                                    struct smlt_generated_model **model);
+
+/**
+ * @brief generates one of the built-in tree topologies as sparse model
+ *
+ * @param name          name of the topology (SMLT_TOPO_*), NULL for SMLT_TOPO
+ * @param cores         an arry of cores that contains the
+ *                      cores of the model, cores[0] becomes the root
+ * @param len           length of the cores array
+ * @param sparse        (return value) the sparse model
+ *
+ * @return              SMLT_SUCCESS or SMLT_ERR_INVAL if the name is not
+ *                      a built-in topology
+ */
+errval_t smlt_generate_builtin_sparse_model(const char* name, coreid_t* cores,
+                                            uint32_t len,
+                                            struct smlt_sparse_model** sparse);
+
+/**
+ * @brief generates a model as sparse model
+ *
+ * @param cores         an arry of cores that contains the
+ *                      cores of the model, cores[0] becomes the root
+ * @param len           length of the cores array
+ * @param name          name of the tree topology, NULL for SMLT_TOPO
+ * @param sparse        (return value) the sparse model
+ *
+ * @return              SMLT_SUCCESS or SMLT_ERR_GENERATOR
+ *
+ * Like smlt_generate_model(), but built-in topologies and models from the
+ * local cost profile are built without the matrix, so they are not bound by
+ * the TOPO_MATRIX_MAX_MP children per node of the matrix encoding. Models of
+ * the Simulator or the model cache still come as a matrix.
+ */
+errval_t smlt_generate_sparse_model(coreid_t* cores, uint32_t len,
+                                    const char* name,
+                                    struct smlt_sparse_model** sparse);
+
+/**
+ * @brief generates a sparse model from a measured cost profile
+ *
+ * @param profile       the pairwise link costs of the machine
+ * @param cores         an arry of cores that contains the
+ *                      cores of the model, cores[0] becomes the root
+ * @param len           length of the cores array
+ * @param sparse        (return value) the sparse model
+ *
+ * @return              SMLT_SUCCESS or SMLT_ERR_GENERATOR if a core
+ *                      is not part of the profile
+ */
+errval_t smlt_generate_sparse_model_from_profile(struct smlt_profile *profile,
+                                                 coreid_t* cores, uint32_t len,
+                                                 struct smlt_sparse_model** sparse);
 #endif /* SMLT_GENERATOR_H_ */
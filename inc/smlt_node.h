@@ -178,13 +178,13 @@ static inline smlt_nid_t smlt_node_get_id(void)
 }
 
 /**
- * @brief gets the ID of the current node
+ * @brief gets the core ID of the node
  *
  * @param node  the smelt node
  *
- * @returns integer value representing the node id
+ * @returns integer value representing the coreid
  */
-static inline smlt_nid_t smlt_node_get_coreid_of_node(struct smlt_node *node)
+static inline coreid_t smlt_node_get_coreid_of_node(struct smlt_node *node)
 {
     return node->core;
 }
@@ -194,7 +194,7 @@ static inline smlt_nid_t smlt_node_get_coreid_of_node(struct smlt_node *node)
  *
  * @returns integer value representing the coreid
  */
-static inline smlt_nid_t smlt_node_get_coreid(void)
+static inline coreid_t smlt_node_get_coreid(void)
 {
     return smlt_node_get_coreid_of_node(smlt_node_self);
 }
@@ -124,6 +124,30 @@ errval_t smlt_platform_lock_init(smlt_platform_lock_t *lock);
 void smlt_platform_lock_acquire(smlt_platform_lock_t *lock);
 void smlt_platfrom_lock_release(smlt_platform_lock_t *lock);
 
+/*
+ * ===========================================================================
+ * Waiting
+ * ===========================================================================
+ */
+
+/**
+ * @brief blocks the calling thread while a word holds the given value
+ *
+ * @param word  the word to wait on
+ * @param val   the value the caller last read from the word
+ *
+ * For threads that are not pinned to a core of their own, so they do not
+ * take the time of the nodes by polling.
+ */
+void smlt_platform_wait(volatile uint32_t *word, uint32_t val);
+
+/**
+ * @brief wakes the threads waiting on a word
+ *
+ * @param word  the word, changed by the caller before
+ */
+void smlt_platform_wake(volatile uint32_t *word);
+
 /*
  * ===========================================================================
  * Thread Control
@@ -0,0 +1,83 @@
+/*
+ * Copyright (c) 2016 ETH Zurich.
+ * All rights reserved.
+ *
+ * This file is distributed under the terms in the attached LICENSE file.
+ * If you do not find this file, copies can be found by writing to:
+ * ETH Zurich D-INFK, Universitaetstr. 6, CH-8092 Zurich. Attn: Systems Group.
+ */
+#ifndef SMLT_POOL_H_
+#define SMLT_POOL_H_ 1
+
+#include <smlt_node.h>
+
+/* forward declaration */
+struct smlt_context;
+
+/*
+ * ===========================================================================
+ * type declarations
+ * ===========================================================================
+ */
+
+/**
+ * the persistent node threads of a context
+ */
+struct smlt_pool;
+
+/*
+ * ===========================================================================
+ * node pool
+ * ===========================================================================
+ *
+ * smlt_node_start() creates and pins a new thread every time it is called.
+ * A pool starts the nodes of a context once and keeps them running: the
+ * root waits for work from the thread that owns the pool, the other nodes
+ * wait in a broadcast on the channel from their parent. A parallel region
+ * is a broadcast of the function and its argument, followed by a
+ * reduction without payload once every node returned from the function.
+ * The owner sleeps until the root wakes it after the reduction, so it does
+ * not take the time of a node it shares a core with.
+ *
+ * The function may use the collectives of the context.
+ */
+
+/**
+ * @brief starts the nodes of a context as a pool
+ *
+ * @param ctx   the Smelt context
+ * @param ret   returns the pool
+ *
+ * @returns SMLT_SUCCESS, SMLT_ERR_INVAL, SMLT_ERR_MALLOC_FAIL or the error of
+ *          starting a node
+ *
+ * The nodes of the context must not be running. If a node fails to start,
+ * the nodes started before are stopped again.
+ */
+errval_t smlt_pool_create(struct smlt_context *ctx, struct smlt_pool **ret);
+
+/**
+ * @brief stops the nodes of a pool and frees it
+ *
+ * @param pool  the pool
+ *
+ * @returns SMLT_SUCCESS
+ */
+errval_t smlt_pool_free(struct smlt_pool *pool);
+
+/**
+ * @brief runs a function on every node of the pool
+ *
+ * @param pool  the pool
+ * @param fn    the function, its return value is ignored
+ * @param arg   argument of the function
+ *
+ * @returns SMLT_SUCCESS or SMLT_ERR_INVAL
+ *
+ * Returns after all nodes returned from the function. This function is
+ * BLOCKING and must not be called by a node of the pool.
+ */
+errval_t smlt_pool_run(struct smlt_pool *pool, smlt_node_start_fn_t fn,
+                       void *arg);
+
+#endif /* SMLT_POOL_H_ */
@@ -0,0 +1,158 @@
+/*
+ * Copyright (c) 2016 ETH Zurich.
+ * All rights reserved.
+ *
+ * This file is distributed under the terms in the attached LICENSE file.
+ * If you do not find this file, copies can be found by writing to:
+ * ETH Zurich D-INFK, Universitaetstr. 6, CH-8092 Zurich. Attn: Systems Group.
+ */
+#ifndef SMLT_PROFILER_H_
+#define SMLT_PROFILER_H_ 1
+
+/*
+ * ===========================================================================
+ * Smelt profiler configuration
+ * ===========================================================================
+ */
+
+///< number of measurements taken per core pair
+#define SMLT_PROFILER_ROUNDS 1000
+
+///< number of messages sent back-to-back when measuring send/receive cost
+#define SMLT_PROFILER_BATCH     8
+
+/*
+ * ===========================================================================
+ * type declarations
+ * ===========================================================================
+ */
+
+/**
+ * pairwise link costs of a machine in cycles.
+ *
+ * The matrices are indexed by the position of the core in the cores array,
+ * i.e. send[i * ncores + j] is the cost of sending a message from cores[i]
+ * to cores[j]. All arrays live in a single buffer, which is also the on-disk
+ * representation of the profile.
+ */
+struct smlt_profile {
+    uint32_t ncores;        ///< number of cores in the profile
+    coreid_t *cores;        ///< core ids of the profiled cores
+    uint32_t *send;         ///< cost of enqueuing a message
+    uint32_t *recv;         ///< cost of dequeuing a message
+    uint32_t *prop;         ///< propagation time of a message
+    void *buf;              ///< backing buffer of the profile
+    size_t bufsize;         ///< size of the backing buffer in bytes
+};
+
+/*
+ * ===========================================================================
+ * measuring
+ * ===========================================================================
+ */
+
+/**
+ * @brief measures the pairwise send, receive and propagation costs
+ *
+ * @param cores         array of core ids to profile
+ * @param ncores        length of the cores array
+ * @param max_pairs     maximum number of core pairs measured concurrently,
+ *                      0 measures all disjoint pairs of a round in parallel
+ * @param ret_profile   returns the measured profile
+ *
+ * @return SMLT_SUCCESS or error value
+ *
+ * The pairs are scheduled as a round-robin tournament, such that every
+ * core takes part in at most one measurement at a time.
+ */
+errval_t smlt_profiler_measure(coreid_t *cores, uint32_t ncores,
+                               uint32_t max_pairs,
+                               struct smlt_profile **ret_profile);
+
+/**
+ * @brief frees the profile
+ *
+ * @param profile   the profile to free
+ */
+void smlt_profiler_destroy(struct smlt_profile *profile);
+
+/*
+ * ===========================================================================
+ * persistence
+ * ===========================================================================
+ */
+
+/**
+ * @brief writes the profile to a file
+ *
+ * @param profile   the profile to store
+ * @param path      path of the file, NULL for the per-host default
+ *
+ * @return SMLT_SUCCESS or SMLT_ERR_PROFILE_IO
+ */
+errval_t smlt_profiler_store(struct smlt_profile *profile, const char *path);
+
+/**
+ * @brief reads a profile from a file
+ *
+ * @param path          path of the file, NULL for the per-host default
+ * @param ret_profile   returns the profile
+ *
+ * @return SMLT_SUCCESS or SMLT_ERR_PROFILE_IO
+ */
+errval_t smlt_profiler_load(const char *path, struct smlt_profile **ret_profile);
+
+/**
+ * @brief obtains the path of the per-host profile cache
+ *
+ * @param buf   buffer to write the path to
+ * @param len   length of the buffer
+ *
+ * The path is taken from SMLT_PROFILE if set, otherwise it is
+ * $SMLT_PROFILE_DIR/smlt-<machine>.prof where the machine name is
+ * SMLT_MACHINE or the hostname.
+ */
+void smlt_profiler_get_path(char *buf, size_t len);
+
+/*
+ * ===========================================================================
+ * queries
+ * ===========================================================================
+ */
+
+/**
+ * @brief looks up the index of a core in the profile
+ *
+ * @param profile   the profile
+ * @param core      the core id
+ *
+ * @return index of the core or -1 if the core is not part of the profile
+ */
+static inline int32_t smlt_profiler_core_idx(struct smlt_profile *profile,
+                                             coreid_t core)
+{
+    for (uint32_t i = 0; i < profile->ncores; i++) {
+        if (profile->cores[i] == core) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief returns the end-to-end cost of a message between two profile indices
+ *
+ * @param profile   the profile
+ * @param src       index of the sending core
+ * @param dst       index of the receiving core
+ *
+ * @return cost in cycles
+ */
+static inline uint64_t smlt_profiler_msg_cost(struct smlt_profile *profile,
+                                              uint32_t src, uint32_t dst)
+{
+    uint32_t idx = src * profile->ncores + dst;
+    return (uint64_t)profile->send[idx] + profile->prop[idx] + profile->recv[idx];
+}
+
+#endif /* SMLT_PROFILER_H_ */
@@ -0,0 +1,836 @@
+/*
+ * Copyright (c) 2016 ETH Zurich.
+ * All rights reserved.
+ *
+ * This file is distributed under the terms in the attached LICENSE file.
+ * If you do not find this file, copies can be found by writing to:
+ * ETH Zurich D-INFK, Universitaetstr. 6, CH-8092 Zurich. Attn: Systems Group.
+ */
+#ifndef SMLT_QUEUE_HPP_
+#define SMLT_QUEUE_HPP_ 1
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <type_traits>
+
+extern "C" {
+#include <smlt.h>
+#include <smlt_queuepair.h>
+}
+
+/*
+ * ===========================================================================
+ * Smelt C++ queues
+ * ===========================================================================
+ *
+ * smlt::Queue<Backend, Slots, Words> is a view on a queuepair end created by
+ * smlt_queuepair_create(). The backend, the number of slots of the queue and
+ * the size of the messages are template parameters, hence the send and
+ * receive paths are inlined into the caller and the ring arithmetic is
+ * resolved at compile time. No call goes through the function pointers of
+ * struct smlt_qp.
+ *
+ * The state of the queue stays in the struct smlt_qp, so the C and the C++
+ * functions can be used on the same queue.
+ */
+
+namespace smlt {
+
+///< payload word of the C++ queues
+typedef smlt_msg_payload_t word_t;
+
+namespace detail {
+
+/**
+ * @brief compile time arithmetic on a ring of Slots slots
+ */
+template <uint32_t Slots>
+struct Ring
+{
+    static_assert(Slots > 0, "a ring needs at least one slot");
+
+    ///< whether the index can be wrapped with a mask
+    static constexpr bool pow2 = (Slots & (Slots - 1)) == 0;
+
+    /**
+     * @brief returns the position n slots after pos
+     */
+    static constexpr uint32_t advance(uint32_t pos, uint32_t n)
+    {
+        return pow2 ? ((pos + n) & (Slots - 1)) : ((pos + n) % Slots);
+    }
+
+    /**
+     * @brief returns the position after pos
+     */
+    static constexpr uint32_t next(uint32_t pos)
+    {
+        return pow2 ? ((pos + 1) & (Slots - 1))
+                    : ((pos + 1 == Slots) ? 0 : pos + 1);
+    }
+
+    /**
+     * @brief returns true if the position after pos is the first slot
+     */
+    static constexpr bool wraps(uint32_t pos)
+    {
+        return pos + 1 == Slots;
+    }
+};
+
+/**
+ * @brief returns the smaller of two values
+ */
+static constexpr uint32_t min(uint32_t a, uint32_t b)
+{
+    return a < b ? a : b;
+}
+
+/**
+ * @brief returns the number of slots of size slot_words a message occupies
+ */
+static constexpr uint32_t div_up(uint32_t words, uint32_t slot_words)
+{
+    return words == 0 ? 1 : (words + slot_words - 1) / slot_words;
+}
+
+/*
+ * Sources and sinks of the payload. A source returns the i-th payload word
+ * of a message, a sink stores it. The backends copy between the ring and
+ * the source or sink word by word, hence a message is copied exactly once.
+ */
+
+///< reads the payload from an array of words
+struct WordSrc
+{
+    const word_t *data;
+
+    word_t operator()(uint32_t i) const
+    {
+        return data[i];
+    }
+};
+
+///< writes the payload to an array of words
+struct WordSink
+{
+    static constexpr bool drops = false;
+    word_t *data;
+
+    void operator()(uint32_t i, word_t w) const
+    {
+        data[i] = w;
+    }
+};
+
+///< the empty payload of a notification
+struct NullSrc
+{
+    word_t operator()(uint32_t) const
+    {
+        return 0;
+    }
+};
+
+///< drops the payload
+struct NullSink
+{
+    static constexpr bool drops = true;
+
+    void operator()(uint32_t, word_t) const
+    {
+    }
+};
+
+/**
+ * @brief the payload of a message holding a T
+ *
+ * T is copied as raw bytes, the last word is padded with zeroes.
+ */
+template <typename T, uint32_t MaxWords>
+struct Payload
+{
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "only trivially copyable types can be sent");
+
+    static constexpr uint32_t words =
+        (sizeof(T) + sizeof(word_t) - 1) / sizeof(word_t);
+
+    static_assert(words <= MaxWords, "the type does not fit into the queue");
+
+    ///< returns the number of bytes of T in the i-th word
+    static constexpr size_t bytes(uint32_t i)
+    {
+        return sizeof(T) - i * sizeof(word_t) < sizeof(word_t)
+                    ? sizeof(T) - i * sizeof(word_t) : sizeof(word_t);
+    }
+};
+
+///< reads the payload from the bytes of a T
+template <typename T>
+struct ObjSrc
+{
+    typedef Payload<T, UINT32_MAX> payload;
+    const T *obj;
+
+    word_t operator()(uint32_t i) const
+    {
+        word_t w = 0;
+        memcpy(&w, (const char *)obj + i * sizeof(word_t), payload::bytes(i));
+        return w;
+    }
+};
+
+///< writes the payload to the bytes of a T
+template <typename T>
+struct ObjSink
+{
+    typedef Payload<T, UINT32_MAX> payload;
+    static constexpr bool drops = false;
+    T *obj;
+
+    void operator()(uint32_t i, word_t w) const
+    {
+        memcpy((char *)obj + i * sizeof(word_t), &w, payload::bytes(i));
+    }
+};
+
+/**
+ * @brief copies Words words of a source into an array
+ */
+template <uint32_t Words, typename Src>
+static inline void gather(const Src &src, word_t *data)
+{
+    for (uint32_t i = 0; i < Words; i++) {
+        data[i] = src(i);
+    }
+}
+
+/**
+ * @brief returns the i-th word of a source of Words words, zero beyond
+ */
+template <uint32_t Words, typename Src>
+static inline word_t word(const Src &src, uint32_t i)
+{
+    return i < Words ? src(i) : 0;
+}
+
+/**
+ * @brief sends Words words on a SWMR writer context
+ *
+ * @returns SMLT_SUCCESS or SMLT_ERR_QUEUE_FULL
+ */
+template <uint32_t Words, typename Src>
+static inline errval_t swmr_try_send(struct swmr_context *ctx, const Src &src)
+{
+    if (!swmr_can_send(ctx)) {
+        return SMLT_ERR_QUEUE_FULL;
+    }
+
+    if (Words == 0) {
+        swmr_send_raw0(ctx);
+        return SMLT_SUCCESS;
+    }
+
+    /* a message spanning several slots is fragmented by the library */
+    if (Words > SWMR_PAYLOAD_WORDS) {
+        word_t d[Words > SWMR_PAYLOAD_WORDS ? Words : 1];
+        gather<Words>(src, d);
+        swmr_send(ctx, d, Words);
+        return SMLT_SUCCESS;
+    }
+
+    swmr_send_raw(ctx, word<Words>(src, 0), word<Words>(src, 1),
+                  word<Words>(src, 2), word<Words>(src, 3),
+                  word<Words>(src, 4), word<Words>(src, 5),
+                  word<Words>(src, 6));
+
+    return SMLT_SUCCESS;
+}
+
+/**
+ * @brief receives up to Words words from a SWMR reader context
+ *
+ * @returns SMLT_SUCCESS or SMLT_ERR_QUEUE_EMPTY
+ */
+template <uint32_t Words, typename Sink>
+static inline errval_t swmr_try_recv(struct swmr_context *ctx,
+                                     const Sink &sink)
+{
+    if (!swmr_can_receive(ctx)) {
+        return SMLT_ERR_QUEUE_EMPTY;
+    }
+
+    if (Sink::drops) {
+        swmr_receive_raw0(ctx);
+        return SMLT_SUCCESS;
+    }
+
+    /* swmr_receive() always writes a full slot */
+    word_t d[Words > SWMR_PAYLOAD_WORDS ? Words : SWMR_PAYLOAD_WORDS];
+    swmr_receive(ctx, d, Words > SWMR_PAYLOAD_WORDS ? Words
+                                                    : SWMR_PAYLOAD_WORDS);
+    for (uint32_t i = 0; i < Words; i++) {
+        sink(i, d[i]);
+    }
+
+    return SMLT_SUCCESS;
+}
+
+} /* namespace detail */
+
+
+/*
+ * ===========================================================================
+ * Backends
+ * ===========================================================================
+ *
+ * A backend provides the operations on its part of struct smlt_qp. The
+ * operations take the number of slots and the message size as template
+ * parameters, and read the payload from a source or write it to a sink
+ * (see detail::WordSrc).
+ */
+
+/**
+ * the UMP backend: one message per slot, acknowledged in batches
+ */
+struct UMP
+{
+    static constexpr smlt_qp_type_t type = SMLT_QP_TYPE_UMP;
+    static constexpr uint32_t slot_words = SMLT_UMP_PAYLOAD_WORDS;
+    ///< smlt_ump_queue_init_tx() keeps one slot of the buffer unused
+    static constexpr uint32_t default_slots = SMLT_UMP_DEFAULT_SLOTS - 1;
+
+    template <uint32_t Slots>
+    static constexpr uint32_t max_words()
+    {
+        return slot_words;
+    }
+
+    static uint32_t num_slots(struct smlt_qp *qp)
+    {
+        return qp->q.ump.tx.num_msg;
+    }
+
+    template <uint32_t Slots>
+    static inline bool can_send(struct smlt_qp *qp)
+    {
+        struct smlt_ump_queuepair *ump = &qp->q.ump;
+
+        if ((smlt_ump_idx_t)(ump->seq_id - ump->last_ack) <= Slots) {
+            return true;
+        }
+
+        ump->last_ack = smlt_ump_queue_last_ack(&ump->tx);
+
+        return (smlt_ump_idx_t)(ump->seq_id - ump->last_ack) <= Slots;
+    }
+
+    template <uint32_t Slots, uint32_t Words, typename Src>
+    static inline errval_t try_send(struct smlt_qp *qp, const Src &src)
+    {
+        typedef detail::Ring<Slots> ring;
+        struct smlt_ump_queuepair *ump = &qp->q.ump;
+        struct smlt_ump_queue *tx = &ump->tx;
+
+        if (!can_send<Slots>(qp)) {
+            return SMLT_ERR_QUEUE_FULL;
+        }
+
+        union smlt_ump_ctrl ctrl;
+        ctrl.c.last_ack = ump->seq_id++;
+
+        volatile struct smlt_ump_message *m = tx->buf + tx->pos;
+
+        /* the push modes need the cacheline instructions of the C path */
+        if (tx->push != SMLT_UMP_PUSH_NONE) {
+            word_t data[slot_words];
+            detail::gather<Words>(src, data);
+            smlt_ump_queue_send_words(tx, (struct smlt_ump_message *)m, data,
+                                      Words, ctrl);
+            return SMLT_SUCCESS;
+        }
+
+        for (uint32_t i = 0; i < Words; i++) {
+            m->data[i] = src(i);
+        }
+
+        smlt_arch_write_barrier();
+
+        ctrl.c.epoch = tx->epoch;
+        m->ctrl.raw = ctrl.raw;
+
+        if (ring::wraps(tx->pos)) {
+            tx->epoch = !tx->epoch;
+        }
+        tx->pos = ring::next(tx->pos);
+
+        return SMLT_SUCCESS;
+    }
+
+    template <uint32_t Slots>
+    static inline bool can_recv(struct smlt_qp *qp)
+    {
+        struct smlt_ump_queue *rx = &qp->q.ump.rx;
+        return rx->buf[rx->pos].ctrl.c.epoch == rx->epoch;
+    }
+
+    template <uint32_t Slots, uint32_t Words, typename Sink>
+    static inline errval_t try_recv(struct smlt_qp *qp, const Sink &sink)
+    {
+        typedef detail::Ring<Slots> ring;
+        struct smlt_ump_queue *rx = &qp->q.ump.rx;
+
+        volatile struct smlt_ump_message *m = rx->buf + rx->pos;
+
+        union smlt_ump_ctrl ctrl;
+        ctrl.raw = m->ctrl.raw;
+        if (ctrl.c.epoch != rx->epoch) {
+            return SMLT_ERR_QUEUE_EMPTY;
+        }
+
+        if (!Sink::drops) {
+            for (uint32_t i = 0; i < Words; i++) {
+                sink(i, m->data[i]);
+            }
+        }
+
+        /* acknowledge in the middle and at the end of the ring */
+        if (rx->pos == (Slots >> 1)) {
+            *(rx->last_ack) = ctrl.c.last_ack;
+        }
+
+        if (ring::wraps(rx->pos)) {
+            rx->epoch = !rx->epoch;
+            *(rx->last_ack) = ctrl.c.last_ack;
+        }
+        rx->pos = ring::next(rx->pos);
+
+        return SMLT_SUCCESS;
+    }
+};
+
+/**
+ * the FastForward backend: messages span several slots, released in batches
+ */
+struct FFQ
+{
+    static constexpr smlt_qp_type_t type = SMLT_QP_TYPE_FFQ;
+    static constexpr uint32_t slot_words = SMLT_FFQ_SLOT_WORDS;
+    static constexpr uint32_t default_slots = SMLT_FFQ_DEFAULT_SLOTS;
+
+    ///< see smlt_ffq_queue_init_common()
+    template <uint32_t Slots>
+    static constexpr uint32_t batch()
+    {
+        return Slots / 2 == 0 ? 1 : detail::min(SMLT_FFQ_RELEASE_BATCH,
+                                                Slots / 2);
+    }
+
+    template <uint32_t Slots>
+    static constexpr uint32_t max_words()
+    {
+        return (Slots - batch<Slots>() + 1) * slot_words;
+    }
+
+    static uint32_t num_slots(struct smlt_qp *qp)
+    {
+        return qp->q.ffq.tx.size;
+    }
+
+    template <uint32_t Slots>
+    static inline bool can_send_slots(struct smlt_ffq_queue *q, uint32_t n)
+    {
+        if (q->seq - 1 + n - q->released <= Slots) {
+            return true;
+        }
+
+        q->released = *q->release;
+
+        return (q->seq - 1 + n - q->released <= Slots);
+    }
+
+    template <uint32_t Slots>
+    static inline bool can_send(struct smlt_qp *qp)
+    {
+        return can_send_slots<Slots>(&qp->q.ffq.tx, 1);
+    }
+
+    template <uint32_t Slots, uint32_t Words, typename Src>
+    static inline errval_t try_send(struct smlt_qp *qp, const Src &src)
+    {
+        typedef detail::Ring<Slots> ring;
+        static constexpr uint32_t slots = detail::div_up(Words, slot_words);
+
+        struct smlt_ffq_queue *q = &qp->q.ffq.tx;
+
+        if (!can_send_slots<Slots>(q, slots)) {
+            return SMLT_ERR_QUEUE_FULL;
+        }
+
+        uint32_t pos = q->pos;
+        for (uint32_t s = 0; s < slots; s++) {
+            volatile struct smlt_ffq_slot *slot = q->slots + pos;
+            uint32_t words = detail::min(Words - s * slot_words, slot_words);
+            for (uint32_t i = 0; i < words; i++) {
+                slot->data[i] = src(s * slot_words + i);
+            }
+
+            if (s > 0) {
+                slot->header = SMLT_FFQ_HEADER(q->seq + s, 0);
+            }
+
+            pos = ring::next(pos);
+        }
+
+        smlt_arch_write_barrier();
+
+        q->slots[q->pos].header = SMLT_FFQ_HEADER(q->seq, Words);
+
+        q->pos = pos;
+        q->seq += slots;
+
+        return SMLT_SUCCESS;
+    }
+
+    template <uint32_t Slots>
+    static inline bool can_recv(struct smlt_qp *qp)
+    {
+        struct smlt_ffq_queue *q = &qp->q.ffq.rx;
+        return (q->slots[q->pos].header & SMLT_FFQ_SEQ_MASK)
+                    == (q->seq & SMLT_FFQ_SEQ_MASK);
+    }
+
+    template <uint32_t Slots, uint32_t Words, typename Sink>
+    static inline errval_t try_recv(struct smlt_qp *qp, const Sink &sink)
+    {
+        typedef detail::Ring<Slots> ring;
+        struct smlt_ffq_queue *q = &qp->q.ffq.rx;
+
+        if (!can_recv<Slots>(qp)) {
+            return SMLT_ERR_QUEUE_EMPTY;
+        }
+
+        uint32_t num = (uint32_t)(q->slots[q->pos].header >> SMLT_FFQ_SEQ_BITS);
+        uint32_t slots = detail::div_up(num, slot_words);
+        uint32_t words = detail::min(num, Sink::drops ? 0 : Words);
+
+        uint32_t pos = q->pos;
+        for (uint32_t s = 0; s < slots; s++) {
+            volatile struct smlt_ffq_slot *slot = q->slots + pos;
+            for (uint32_t i = 0; i < slot_words && s * slot_words + i < words;
+                 i++) {
+                sink(s * slot_words + i, slot->data[i]);
+            }
+            pos = ring::next(pos);
+        }
+
+        q->pos = pos;
+        q->seq += slots;
+
+        if (q->seq - 1 - q->released >= batch<Slots>()) {
+            smlt_arch_write_barrier();
+            *q->release = q->seq - 1;
+            q->released = q->seq - 1;
+        }
+
+        return (num > words && !Sink::drops) ? SMLT_ERR_INVAL : SMLT_SUCCESS;
+    }
+};
+
+/**
+ * the shared memory backend: a SWMR queue with a single reader
+ *
+ * The SWMR queue is implemented in the library, its functions are called
+ * directly but not inlined. As with the C functions, a message spanning
+ * several slots waits for the slots after the first one.
+ */
+struct SHM
+{
+    static constexpr smlt_qp_type_t type = SMLT_QP_TYPE_SHM;
+    static constexpr uint32_t slot_words = SWMR_PAYLOAD_WORDS;
+    static constexpr uint32_t default_slots = DEFAULT_SHM_Q_SIZE - 2;
+
+    template <uint32_t Slots>
+    static constexpr uint32_t max_words()
+    {
+        return UINT32_MAX;
+    }
+
+    static uint32_t num_slots(struct smlt_qp *qp)
+    {
+        return (uint32_t)qp->queue_tx.shm.src.num_slots;
+    }
+
+    template <uint32_t Slots>
+    static inline bool can_send(struct smlt_qp *qp)
+    {
+        return swmr_can_send(&qp->queue_tx.shm.src);
+    }
+
+    template <uint32_t Slots, uint32_t Words, typename Src>
+    static inline errval_t try_send(struct smlt_qp *qp, const Src &src)
+    {
+        return detail::swmr_try_send<Words>(&qp->queue_tx.shm.src, src);
+    }
+
+    template <uint32_t Slots>
+    static inline bool can_recv(struct smlt_qp *qp)
+    {
+        return swmr_can_receive(&qp->queue_rx.shm.dst);
+    }
+
+    template <uint32_t Slots, uint32_t Words, typename Sink>
+    static inline errval_t try_recv(struct smlt_qp *qp, const Sink &sink)
+    {
+        return detail::swmr_try_recv<Words>(&qp->queue_rx.shm.dst, sink);
+    }
+};
+
+
+/*
+ * ===========================================================================
+ * Queue
+ * ===========================================================================
+ */
+
+/**
+ * @brief a queuepair end specialized for a backend, queue and message size
+ *
+ * @tparam Backend  smlt::UMP, smlt::FFQ or smlt::SHM
+ * @tparam Slots    number of slots of the queue, has to match the queuepair
+ * @tparam Words    number of payload words of a message
+ */
+template <typename Backend,
+          uint32_t Slots = Backend::default_slots,
+          uint32_t Words = Backend::slot_words>
+class Queue
+{
+  public:
+    static_assert(Words <= Backend::template max_words<Slots>(),
+                  "the message does not fit into the queue");
+
+    static constexpr uint32_t slots = Slots;
+    static constexpr uint32_t words = Words;
+
+    Queue() : qp_(NULL) {}
+
+    explicit Queue(struct smlt_qp *qp) : qp_(NULL)
+    {
+        attach(qp);
+    }
+
+    /**
+     * @brief attaches the queue to a queuepair end
+     *
+     * @param qp    queuepair end created by smlt_queuepair_create()
+     *
+     * @returns SMLT_SUCCESS or SMLT_ERR_INVAL if the backend or the number
+     *          of slots of the queuepair do not match
+     */
+    errval_t attach(struct smlt_qp *qp)
+    {
+        if (qp == NULL || qp->type != Backend::type
+                || Backend::num_slots(qp) != Slots) {
+            qp_ = NULL;
+            return SMLT_ERR_INVAL;
+        }
+        qp_ = qp;
+        return SMLT_SUCCESS;
+    }
+
+    ///< returns TRUE if the queue is attached to a queuepair
+    bool valid() const
+    {
+        return qp_ != NULL;
+    }
+
+    ///< returns the queuepair end
+    struct smlt_qp *get() const
+    {
+        return qp_;
+    }
+
+    /*
+     * sending
+     */
+
+    ///< returns TRUE if a message can be sent
+    bool can_send()
+    {
+        return Backend::template can_send<Slots>(qp_);
+    }
+
+    /**
+     * @brief sends a message of Words words
+     *
+     * @returns SMLT_SUCCESS or SMLT_ERR_QUEUE_FULL
+     */
+    errval_t try_send(const word_t *data)
+    {
+        return Backend::template try_send<Slots, Words>(qp_,
+                                                        detail::WordSrc{data});
+    }
+
+    ///< sends a message of Words words, BLOCKING while the queue is full
+    void send(const word_t *data)
+    {
+        while (try_send(data) == SMLT_ERR_QUEUE_FULL)
+            ;
+    }
+
+    /**
+     * @brief sends a notification (zero payload message)
+     *
+     * @returns SMLT_SUCCESS or SMLT_ERR_QUEUE_FULL
+     */
+    errval_t try_notify()
+    {
+        return Backend::template try_send<Slots, 0>(qp_, detail::NullSrc());
+    }
+
+    ///< sends a notification, BLOCKING while the queue is full
+    void notify()
+    {
+        while (try_notify() == SMLT_ERR_QUEUE_FULL)
+            ;
+    }
+
+    /*
+     * receiving
+     */
+
+    ///< returns TRUE if there is a message to be received
+    bool can_recv()
+    {
+        return Backend::template can_recv<Slots>(qp_);
+    }
+
+    /**
+     * @brief receives a message of up to Words words
+     *
+     * @param data  buffer of Words words, NULL drops the payload
+     *
+     * @returns SMLT_SUCCESS or SMLT_ERR_QUEUE_EMPTY
+     */
+    errval_t try_recv(word_t *data)
+    {
+        if (data == NULL) {
+            return Backend::template try_recv<Slots, Words>(qp_,
+                                                            detail::NullSink());
+        }
+        return Backend::template try_recv<Slots, Words>(qp_,
+                                                        detail::WordSink{data});
+    }
+
+    ///< receives a message, BLOCKING while the queue is empty
+    errval_t recv(word_t *data)
+    {
+        errval_t err;
+        do {
+            err = try_recv(data);
+        } while (err == SMLT_ERR_QUEUE_EMPTY);
+        return err;
+    }
+
+    ///< receives a notification, BLOCKING while the queue is empty
+    void recv_notification()
+    {
+        recv(NULL);
+    }
+
+    /*
+     * typed messages, see smlt::send() and smlt::recv()
+     */
+
+    ///< sends the bytes of obj as a message, see smlt::try_send()
+    template <typename T>
+    errval_t try_send_obj(const T &obj)
+    {
+        typedef detail::Payload<T, Backend::template max_words<Slots>()> p;
+        return Backend::template try_send<Slots, p::words>(qp_,
+                                                  detail::ObjSrc<T>{&obj});
+    }
+
+    ///< receives a message into the bytes of obj, see smlt::try_recv()
+    template <typename T>
+    errval_t try_recv_obj(T &obj)
+    {
+        typedef detail::Payload<T, Backend::template max_words<Slots>()> p;
+        return Backend::template try_recv<Slots, p::words>(qp_,
+                                                  detail::ObjSink<T>{&obj});
+    }
+
+  private:
+    struct smlt_qp *qp_;
+};
+
+/*
+ * ===========================================================================
+ * Typed messages
+ * ===========================================================================
+ *
+ * A trivially copyable T is sent as its raw bytes, copied directly between
+ * the object and the slots of the queue without a struct smlt_msg. A T
+ * larger than a slot is fragmented over several slots on the FFQ and SHM
+ * backends, a T that does not fit at all fails to compile. The functions
+ * work on a Queue and on the ends of a Channel.
+ */
+
+/**
+ * @brief sends obj on a queue or channel end
+ *
+ * @returns SMLT_SUCCESS or SMLT_ERR_QUEUE_FULL
+ */
+template <typename T, typename End>
+static inline errval_t try_send(End &end, const T &obj)
+{
+    return end.try_send_obj(obj);
+}
+
+///< sends obj on a queue or channel end, BLOCKING while it is full
+template <typename T, typename End>
+static inline void send(End &end, const T &obj)
+{
+    while (end.try_send_obj(obj) == SMLT_ERR_QUEUE_FULL)
+        ;
+}
+
+/**
+ * @brief receives a T from a queue or channel end into obj
+ *
+ * @returns SMLT_SUCCESS, SMLT_ERR_QUEUE_EMPTY or SMLT_ERR_INVAL if the
+ *          message was larger than a T
+ */
+template <typename T, typename End>
+static inline errval_t try_recv(End &end, T &obj)
+{
+    return end.try_recv_obj(obj);
+}
+
+///< receives a T into obj, BLOCKING while the queue is empty
+template <typename T, typename End>
+static inline errval_t recv(End &end, T &obj)
+{
+    errval_t err;
+    do {
+        err = end.try_recv_obj(obj);
+    } while (err == SMLT_ERR_QUEUE_EMPTY);
+    return err;
+}
+
+///< receives a T, BLOCKING while the queue is empty
+template <typename T, typename End>
+static inline T recv(End &end)
+{
+    /* T does not need to be default constructible */
+    typename std::aligned_storage<sizeof(T), alignof(T)>::type buf;
+    T *obj = reinterpret_cast<T *>(&buf);
+    recv(end, *obj);
+    return *obj;
+}
+
+} /* namespace smlt */
+
+#endif /* SMLT_QUEUE_HPP_ */
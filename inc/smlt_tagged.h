@@ -0,0 +1,127 @@
+/*
+ * Copyright (c) 2016 ETH Zurich.
+ * All rights reserved.
+ *
+ * This file is distributed under the terms in the attached LICENSE file.
+ * If you do not find this file, copies can be found by writing to:
+ * ETH Zurich D-INFK, Universitaetstr. 6, CH-8092 Zurich. Attn: Systems Group.
+ */
+#ifndef SMLT_TAGGED_H_
+#define SMLT_TAGGED_H_ 1
+
+#include <smlt_reduction.h>
+
+/* forward declaration */
+struct smlt_context;
+struct smlt_msg;
+
+/*
+ * ===========================================================================
+ * Smelt tagged collectives configuration
+ * ===========================================================================
+ */
+
+///< number of distinct tags per context
+#define SMLT_TAG_MAX            16
+
+///< number of words of a message on the wire (a single queue slot)
+#define SMLT_TAG_MSG_WORDS      7
+
+///< number of payload words of a tagged message, the first word is the header
+#define SMLT_TAG_PAYLOAD_WORDS  (SMLT_TAG_MSG_WORDS - 1)
+
+///< number of messages of other operations that can be held back per channel
+#define SMLT_TAG_PENDING        16
+
+/*
+ * ===========================================================================
+ * type declarations
+ * ===========================================================================
+ */
+
+///< identifies the operation stream a collective belongs to
+typedef uint16_t smlt_tag_t;
+
+///< the header word: the tag in the upper 16 bits, the sequence number below
+#define SMLT_TAG_HDR(_tag, _seq) \
+    (((uint64_t)(_tag) << 48) | ((uint64_t)(_seq) & 0xffffffffffffULL))
+
+/*
+ * ===========================================================================
+ * tagged collectives
+ * ===========================================================================
+ *
+ * Every node numbers the operations it issues on a tag. Messages carry the
+ * tag and this sequence number, and the receive path holds back messages of
+ * other operations until they are asked for. Hence, collectives on different
+ * tags may be in flight on the same context at the same time, while the
+ * operations of one tag are executed in the same order on all nodes.
+ *
+ * Tagged and untagged collectives must not overlap on the same context.
+ */
+
+/**
+ * @brief performs a tagged broadcast from the root to all nodes
+ *
+ * @param ctx   the Smelt context to broadcast on
+ * @param tag   the tag of the operation
+ * @param msg   input on the root, returns the message on the other nodes
+ *
+ * @returns SMLT_SUCCESS or SMLT_ERR_INVAL if the tag or message is too large
+ */
+errval_t smlt_broadcast_tagged(struct smlt_context *ctx, smlt_tag_t tag,
+                               struct smlt_msg *msg);
+
+/**
+ * @brief performs a tagged broadcast without any payload
+ *
+ * @param ctx   the Smelt context to broadcast on
+ * @param tag   the tag of the operation
+ *
+ * @returns SMLT_SUCCESS or SMLT_ERR_INVAL if the tag is too large
+ */
+errval_t smlt_broadcast_notify_tagged(struct smlt_context *ctx, smlt_tag_t tag);
+
+/**
+ * @brief performs a tagged reduction towards the root
+ *
+ * @param ctx       the Smelt context
+ * @param tag       the tag of the operation
+ * @param input     input for the reduction
+ * @param result    returns the aggregate of the subtree
+ * @param operation function to be called to calculate the aggregate
+ *
+ * @returns SMLT_SUCCESS or SMLT_ERR_INVAL if the tag or message is too large
+ */
+errval_t smlt_reduce_tagged(struct smlt_context *ctx, smlt_tag_t tag,
+                            struct smlt_msg *input,
+                            struct smlt_msg *result,
+                            smlt_reduce_fn_t operation);
+
+/**
+ * @brief performs a tagged reduction without any payload
+ *
+ * @param ctx   the Smelt context
+ * @param tag   the tag of the operation
+ *
+ * @returns SMLT_SUCCESS or SMLT_ERR_INVAL if the tag is too large
+ */
+errval_t smlt_reduce_notify_tagged(struct smlt_context *ctx, smlt_tag_t tag);
+
+/**
+ * @brief performs a tagged reduction and distributes the result to all nodes
+ *
+ * @param ctx       the Smelt context
+ * @param tag       the tag of the operation
+ * @param input     input for the reduction
+ * @param result    returns the result of the reduction
+ * @param operation function to be called to calculate the aggregate
+ *
+ * @returns SMLT_SUCCESS or SMLT_ERR_INVAL if the tag or message is too large
+ */
+errval_t smlt_reduce_all_tagged(struct smlt_context *ctx, smlt_tag_t tag,
+                                struct smlt_msg *input,
+                                struct smlt_msg *result,
+                                smlt_reduce_fn_t operation);
+
+#endif /* SMLT_TAGGED_H_ */
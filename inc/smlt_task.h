@@ -0,0 +1,132 @@
+/*
+ * Copyright (c) 2016 ETH Zurich.
+ * All rights reserved.
+ *
+ * This file is distributed under the terms in the attached LICENSE file.
+ * If you do not find this file, copies can be found by writing to:
+ * ETH Zurich D-INFK, Universitaetstr. 6, CH-8092 Zurich. Attn: Systems Group.
+ */
+#ifndef SMLT_TASK_H_
+#define SMLT_TASK_H_ 1
+
+/* forward declaration */
+struct smlt_context;
+
+/*
+ * ===========================================================================
+ * Smelt task runtime configuration
+ * ===========================================================================
+ */
+
+///< number of tasks a node can hold, a power of two
+#define SMLT_TASK_DEQUE_SLOTS       1024
+
+///< maximum number of victims of a node
+#define SMLT_TASK_MAX_VICTIMS       8
+
+///< maximum number of victims in other clusters
+#define SMLT_TASK_REMOTE_VICTIMS    2
+
+/*
+ * ===========================================================================
+ * type declarations
+ * ===========================================================================
+ */
+
+///< the function of a task
+typedef void (*smlt_task_fn_t)(void *arg);
+
+/**
+ * the task runtime of a context
+ */
+struct smlt_task_runtime;
+
+/*
+ * ===========================================================================
+ * task runtime
+ * ===========================================================================
+ *
+ * Every node of a context keeps its tasks in a private deque: it pushes and
+ * pops its own tasks at the bottom, newest first. A node that runs out of
+ * tasks sends a steal request to one of its victims, which answers with the
+ * oldest tasks of its deque. The victims of a node are the nodes in its own
+ * cluster first, and a few nodes in other clusters, so work is balanced
+ * within a NUMA node before it crosses the interconnect.
+ *
+ * The victim answers steal requests between two tasks and when a task calls
+ * smlt_task_poll(), so the deques are never accessed concurrently.
+ *
+ * A node whose deque runs empty is idle and keeps stealing. The runtime
+ * counts the nodes that hold or run tasks, smlt_task_run() returns once all
+ * nodes called it and the count dropped to zero. The nodes then meet at the
+ * split barrier of the context, answering the last steal requests.
+ * Tasks must not run other collectives on the context.
+ */
+
+/**
+ * @brief creates a task runtime over all nodes of a context
+ *
+ * @param ctx   the Smelt context
+ * @param ret   returns the runtime
+ *
+ * @returns SMLT_SUCCESS, SMLT_ERR_INVAL or SMLT_ERR_MALLOC_FAIL
+ *
+ * Called once, before the nodes use the runtime.
+ */
+errval_t smlt_task_runtime_create(struct smlt_context *ctx,
+                                  struct smlt_task_runtime **ret);
+
+/**
+ * @brief frees a task runtime
+ *
+ * @param rt    the runtime
+ *
+ * @returns SMLT_SUCCESS
+ */
+errval_t smlt_task_runtime_free(struct smlt_task_runtime *rt);
+
+/**
+ * @brief adds a task to the deque of the calling node
+ *
+ * @param rt    the runtime
+ * @param fn    function of the task
+ * @param arg   argument of the function
+ *
+ * @returns SMLT_SUCCESS or SMLT_ERR_INVAL if the node is not in the context
+ *
+ * If the deque is full, the task is executed right away.
+ */
+errval_t smlt_task_spawn(struct smlt_task_runtime *rt, smlt_task_fn_t fn,
+                         void *arg);
+
+/**
+ * @brief answers the pending steal requests to the calling node
+ *
+ * @param rt    the runtime
+ *
+ * Long running tasks call this to keep the other nodes busy.
+ */
+void smlt_task_poll(struct smlt_task_runtime *rt);
+
+/**
+ * @brief runs tasks until all nodes of the context are idle
+ *
+ * @param rt    the runtime
+ *
+ * @returns SMLT_SUCCESS or SMLT_ERR_INVAL if the node is not in the context
+ *
+ * Called by every node of the context. This function is BLOCKING.
+ */
+errval_t smlt_task_run(struct smlt_task_runtime *rt);
+
+/**
+ * @brief obtains the number of tasks the calling node executed
+ *
+ * @param rt        the runtime
+ * @param executed  returns the number of tasks executed
+ * @param stolen    returns the number of tasks obtained by stealing
+ */
+void smlt_task_get_stats(struct smlt_task_runtime *rt, uint64_t *executed,
+                         uint64_t *stolen);
+
+#endif /* SMLT_TASK_H_ */
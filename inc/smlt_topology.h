@@ -21,10 +21,27 @@
 struct smlt_topology;
 struct smlt_topology_node;
 struct smlt_generated_model;
+struct smlt_sparse_model;
 
 ///< refer to the current smelt topology
 #define SMLT_TOPOLOGY_CURRENT NULL;
 
+/*
+ * ===========================================================================
+ * names of the built-in topologies
+ * ===========================================================================
+ *
+ * The k-ary and cluster topologies take an optional fan-out, e.g. "kary-4".
+ */
+#define SMLT_TOPO_BINARY     "binary"     ///< binary tree
+#define SMLT_TOPO_KARY       "kary"       ///< k-ary tree
+#define SMLT_TOPO_BINOMIAL   "binomial"   ///< binomial tree
+#define SMLT_TOPO_FIBONACCI  "fibonacci"  ///< Fibonacci tree
+#define SMLT_TOPO_CLUSTER    "cluster"    ///< two-level tree over the NUMA nodes
+
+///< fan-out of the k-ary tree if none is given
+#define SMLT_TOPO_DEFAULT_FANOUT 4
+
 /*
  * ===========================================================================
  * numeric values for encoding the topology in an integer matrix
@@ -67,12 +84,35 @@ errval_t smlt_topology_init(void);
  *
  * @return SMELT_SUCCESS or error value
  *
- * If the model is NULL, then a binary tree will be generated
+ * If the model is NULL, then the built-in topology given by name (or
+ * SMLT_TOPO if name is NULL) is generated over all nodes. If the name is
+ * not a built-in topology, then a binary tree will be generated
+ *
+ * The model is indexed by core id, the topology nodes carry the id of
+ * the node running on the core.
  */
 errval_t smlt_topology_create(struct smlt_generated_model* model,
                               const char *name,
                               struct smlt_topology **ret_topology);
 
+/**
+ * @brief creates a new Smelt topology out of a sparse model
+ *
+ * @param sparse        the sparse model
+ * @param name          name of the topology
+ * @param ret_topology  returned pointer to the topology
+ *
+ * @return SMELT_SUCCESS or error value
+ *         SMLT_ERR_NODE_INVALD if no node runs on a core of the model
+ *
+ * Dense models passed to smlt_topology_create() are converted into this
+ * representation first. The model is indexed by core id, only the cores
+ * that are part of the tree become topology nodes.
+ */
+errval_t smlt_topology_create_sparse(struct smlt_sparse_model* sparse,
+                                     const char *name,
+                                     struct smlt_topology **ret_topology);
+
 /**
  * @brief destroys a smelt topology.
  *
@@ -124,7 +164,7 @@ struct smlt_topology_node *smlt_topology_node_next(struct smlt_topology_node *no
  * @param topo the topology
  * @param id the node id
  *
- * @return
+ * @return the topology node or NULL if the node is not part of the topology
  */
 struct smlt_topology_node *smlt_topology_node_by_id(struct smlt_topology* topo, smlt_nid_t id);
 
@@ -243,6 +283,15 @@ uint32_t smlt_topology_node_get_num_children_shm(struct smlt_topology_node *node
  */
 smlt_nid_t smlt_topology_node_get_id(struct smlt_topology_node *node);
 
+/**
+ * @brief obtains the core the topology node runs on
+ *
+ * @param node  the Smelt topology node
+ *
+ * @return core id
+ */
+coreid_t smlt_topology_node_get_core(struct smlt_topology_node *node);
+
 
 /**
  * @brief returns if shared memory is used to improve performance
@@ -0,0 +1,112 @@
+/*
+ * Copyright (c) 2016 ETH Zurich.
+ * All rights reserved.
+ *
+ * This file is distributed under the terms in the attached LICENSE file.
+ * If you do not find this file, copies can be found by writing to:
+ * ETH Zurich D-INFK, Universitaetstr. 6, CH-8092 Zurich. Attn: Systems Group.
+ */
+#ifndef SMLT_TUNE_H_
+#define SMLT_TUNE_H_ 1
+
+#include <smlt_barrier.h>
+
+/*
+ * ===========================================================================
+ * Smelt auto-tuner
+ * ===========================================================================
+ *
+ * The auto-tuner measures the built-in and model based topologies and the
+ * barrier algorithms on a set of cores, for every collective. Each variant
+ * is measured SMLT_TUNE_RUNS times (default 1000). The resulting decision
+ * table is stored on disk, keyed by the machine name and the set of cores,
+ * in SMLT_TUNE_CACHE_DIR (default /tmp). Setting SMLT_TUNE_CACHE=0 disables
+ * the lookups.
+ *
+ * Contexts created from cores without a topology name and without SMLT_TOPO
+ * use the topology that is best over all collectives. Barriers created with
+ * SMLT_BARRIER_DEFAULT use the best barrier algorithm, unless SMLT_BARRIER
+ * is set.
+ *
+ * The topology of a context is fixed and all its collectives use it, hence
+ * the collectives are measured with a single message size only: a broadcast
+ * cannot pick a topology by size, as the receivers learn the size from the
+ * message.
+ */
+
+///< maximum length of a topology name in the decision table
+#define SMLT_TUNE_NAMELEN 64
+
+/**
+ * the tuned collective operations
+ */
+typedef enum smlt_tune_op {
+    SMLT_TUNE_BARRIER,
+    SMLT_TUNE_BROADCAST,
+    SMLT_TUNE_REDUCE,
+    SMLT_TUNE_REDUCE_ALL,
+    SMLT_TUNE_NUM_OPS
+} smlt_tune_op_t;
+
+/**
+ * the fastest variant of a collective operation
+ */
+struct smlt_tune_entry
+{
+    char topo[SMLT_TUNE_NAMELEN];       ///< topology of the context
+    uint32_t barrier;                   ///< barrier algorithm (barrier only)
+    uint64_t cycles;                    ///< cycles per operation
+};
+
+/**
+ * @brief measures all variants and stores the decision table
+ *
+ * @param cores     the cores to tune for, cores[0] becomes the root
+ * @param len       length of the cores array
+ *
+ * @returns SMLT_SUCCESS or error value
+ *
+ * Has to be called from a thread that is not a Smelt node, the nodes of the
+ * cores must be idle. An existing table for the cores is replaced.
+ */
+errval_t smlt_tune_run(coreid_t *cores, uint32_t len);
+
+/**
+ * @brief obtains the fastest variant of a collective operation
+ *
+ * @param cores     the cores of the context
+ * @param len       length of the cores array
+ * @param op        the collective operation
+ * @param entry     returns the entry of the decision table
+ *
+ * @returns SMLT_SUCCESS or SMLT_ERR_TUNE_NOTFOUND if the cores are not tuned
+ */
+errval_t smlt_tune_get_entry(coreid_t *cores, uint32_t len, smlt_tune_op_t op,
+                             struct smlt_tune_entry *entry);
+
+/**
+ * @brief obtains the topology that is the best over all collectives
+ *
+ * @param cores     the cores of the context
+ * @param len       length of the cores array
+ * @param name      returns the name of the topology
+ * @param namelen   size of the name buffer
+ *
+ * @returns SMLT_SUCCESS or SMLT_ERR_TUNE_NOTFOUND if the cores are not tuned
+ */
+errval_t smlt_tune_get_topology(coreid_t *cores, uint32_t len, char *name,
+                                size_t namelen);
+
+/**
+ * @brief obtains the fastest barrier algorithm
+ *
+ * @param cores     the cores of the context
+ * @param len       length of the cores array
+ * @param type      returns the barrier algorithm
+ *
+ * @returns SMLT_SUCCESS or SMLT_ERR_TUNE_NOTFOUND if the cores are not tuned
+ */
+errval_t smlt_tune_get_barrier(coreid_t *cores, uint32_t len,
+                               smlt_barrier_type_t *type);
+
+#endif /* SMLT_TUNE_H_ */
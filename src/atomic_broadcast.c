@@ -0,0 +1,327 @@
+/*
+ * Copyright (c) 2016 ETH Zurich.
+ * All rights reserved.
+ *
+ * This file is distributed under the terms in the attached LICENSE file.
+ * If you do not find this file, copies can be found by writing to:
+ * ETH Zurich D-INFK, Universitaetstr. 6, CH-8092 Zurich. Attn: Systems Group.
+ */
+#include <smlt.h>
+#include <smlt_channel.h>
+#include <smlt_context.h>
+#include <smlt_broadcast.h>
+#include "internal.h"
+
+#include <string.h>
+
+/*
+ * ===========================================================================
+ * wire format
+ * ===========================================================================
+ *
+ * word 0: message type, number of payload words and the origin node
+ * word 1: sequence number assigned by the root (unused on the way up)
+ * word 2: payload
+ */
+
+#define SMLT_ABCAST_MSG_WORDS (SMLT_ABCAST_PAYLOAD_WORDS + 2)
+
+#define SMLT_ABCAST_TYPE_SUBMIT  1  ///< a submission travelling to the root
+#define SMLT_ABCAST_TYPE_DELIVER 2  ///< a sequenced message travelling down
+#define SMLT_ABCAST_TYPE_END     3  ///< end of the stream of a round
+
+#define SMLT_ABCAST_HDR(_type, _words, _origin)                 \
+    (((uint64_t)(_type) << 56) | ((uint64_t)(_words) << 48) |   \
+     (uint64_t)(uint32_t)(_origin))
+
+#define SMLT_ABCAST_HDR_TYPE(_hdr)   ((uint32_t)((_hdr) >> 56))
+#define SMLT_ABCAST_HDR_WORDS(_hdr)  ((uint32_t)(((_hdr) >> 48) & 0xff))
+#define SMLT_ABCAST_HDR_ORIGIN(_hdr) ((smlt_nid_t)((_hdr) & 0xffffffff))
+
+/*
+ * ===========================================================================
+ * type definitions
+ * ===========================================================================
+ */
+
+typedef smlt_msg_payload_t smlt_abcast_buf_t[SMLT_ABCAST_MSG_WORDS];
+
+/**
+ * per node state of the atomic broadcast on a context
+ */
+struct smlt_abcast_state
+{
+    uint64_t seq;                       ///< last delivered sequence number
+    struct smlt_channel *parent;        ///< channel to the parent, NULL if root
+    uint32_t parent_idx;                ///< index on a shared memory parent
+    struct smlt_channel *children;      ///< channels to the children
+    uint32_t num_children;              ///< number of child channels
+    uint32_t num_queues;                ///< number of queues from the children
+    struct smlt_qp **queues;            ///< queues from the children
+    uint32_t batch_max;                 ///< capacity of the batch (root only)
+    smlt_abcast_buf_t *batch;           ///< submissions of a round (root only)
+};
+
+/*
+ * ===========================================================================
+ * state management
+ * ===========================================================================
+ */
+
+/**
+ * @brief creates the atomic broadcast state of the current node
+ *
+ * @param ctx   Smelt context
+ *
+ * @return the state or NULL if the allocation failed
+ *
+ * The root gets room for one submission per node of the context.
+ */
+struct smlt_abcast_state *smlt_abcast_state_create(struct smlt_context *ctx)
+{
+    struct smlt_context_links l;
+
+    if (smlt_err_is_fail(smlt_context_get_links(ctx, &l))) {
+        return NULL;
+    }
+
+    uint32_t batch_max = l.parent ? 0 : smlt_context_get_num_nodes(ctx);
+
+    size_t size = sizeof(struct smlt_abcast_state)
+                  + batch_max * sizeof(smlt_abcast_buf_t)
+                  + l.num_queues * sizeof(struct smlt_qp *);
+
+    struct smlt_abcast_state *as = (struct smlt_abcast_state *)
+        smlt_platform_alloc(size, SMLT_ARCH_CACHELINE_SIZE, true);
+    if (as == NULL) {
+        return NULL;
+    }
+
+    as->parent = l.parent;
+    as->parent_idx = l.parent_idx;
+    as->children = l.children;
+    as->num_children = l.num_children;
+    as->num_queues = l.num_queues;
+    as->batch_max = batch_max;
+    as->batch = (smlt_abcast_buf_t *)(as + 1);
+    as->queues = (struct smlt_qp **)(as->batch + batch_max);
+
+    smlt_context_get_child_queues(&l, as->queues);
+
+    return as;
+}
+
+/**
+ * @brief frees the atomic broadcast state
+ *
+ * @param as    the state to free
+ */
+void smlt_abcast_state_destroy(struct smlt_abcast_state *as)
+{
+    smlt_platform_free(as);
+}
+
+/*
+ * ===========================================================================
+ * helpers
+ * ===========================================================================
+ */
+
+static inline errval_t smlt_abcast_send(struct smlt_channel *chan,
+                                        smlt_msg_payload_t *buf)
+{
+    struct smlt_msg raw = {
+        .words = 2 + SMLT_ABCAST_HDR_WORDS(buf[0]),
+        .bufsize = sizeof(smlt_abcast_buf_t),
+        .data = buf
+    };
+
+    return smlt_channel_send(chan, &raw);
+}
+
+static inline errval_t smlt_abcast_recv_queue(struct smlt_qp *qp,
+                                              smlt_msg_payload_t *buf)
+{
+    struct smlt_msg raw = {
+        .words = SMLT_ABCAST_MSG_WORDS,
+        .bufsize = sizeof(smlt_abcast_buf_t),
+        .data = buf
+    };
+
+    return smlt_queuepair_recv(qp, &raw);
+}
+
+static inline errval_t smlt_abcast_recv_parent(struct smlt_abcast_state *as,
+                                               smlt_msg_payload_t *buf)
+{
+    struct smlt_msg raw = {
+        .words = SMLT_ABCAST_MSG_WORDS,
+        .bufsize = sizeof(smlt_abcast_buf_t),
+        .data = buf
+    };
+
+    return smlt_channel_recv_index(as->parent, &raw, as->parent_idx);
+}
+
+/**
+ * @brief forwards a sequenced message to the children and delivers it
+ */
+static errval_t smlt_abcast_deliver(struct smlt_abcast_state *as,
+                                    smlt_msg_payload_t *buf,
+                                    smlt_abcast_deliver_fn_t deliver,
+                                    void *arg)
+{
+    errval_t err;
+
+    for (uint32_t i = 0; i < as->num_children; i++) {
+        err = smlt_abcast_send(&as->children[i], buf);
+        if (smlt_err_is_fail(err)) {
+            return err;
+        }
+    }
+
+    if (SMLT_ABCAST_HDR_TYPE(buf[0]) != SMLT_ABCAST_TYPE_DELIVER) {
+        return SMLT_SUCCESS;
+    }
+
+    COND_PANIC(buf[1] == as->seq + 1, "atomic broadcast out of order");
+    as->seq = buf[1];
+
+    if (deliver) {
+        struct smlt_msg msg = {
+            .words = SMLT_ABCAST_HDR_WORDS(buf[0]),
+            .bufsize = SMLT_ABCAST_PAYLOAD_WORDS * sizeof(smlt_msg_payload_t),
+            .data = &buf[2]
+        };
+        deliver(&msg, SMLT_ABCAST_HDR_ORIGIN(buf[0]), buf[1], arg);
+    }
+
+    return SMLT_SUCCESS;
+}
+
+/*
+ * ===========================================================================
+ * atomic broadcast
+ * ===========================================================================
+ */
+
+/**
+ * @brief performs a round of the totally ordered atomic broadcast
+ *
+ * @param ctx       the Smelt context to broadcast on
+ * @param msg       the message to submit, NULL for none
+ * @param deliver   function called for each message of the round in order
+ * @param arg       argument passed to the deliver function
+ *
+ * @returns SMLT_SUCCESS or SMLT_ERR_INVAL if the message is too large
+ *
+ * Every node streams its own submission and those of its subtree to the
+ * parent, terminated by an end marker. The root collects the whole batch
+ * before sequencing it, so that no node sends down the tree while its
+ * children may still be blocked sending up.
+ */
+errval_t smlt_atomic_broadcast(struct smlt_context *ctx,
+                               struct smlt_msg *msg,
+                               smlt_abcast_deliver_fn_t deliver,
+                               void *arg)
+{
+    errval_t err;
+    smlt_abcast_buf_t buf;
+
+    if (msg && msg->words > SMLT_ABCAST_PAYLOAD_WORDS) {
+        return SMLT_ERR_INVAL;
+    }
+
+    struct smlt_abcast_state *as = smlt_context_get_abcast_state(ctx);
+    if (as == NULL) {
+        return SMLT_ERR_INVAL;
+    }
+
+    uint32_t num_batch = 0;
+
+    if (msg) {
+        buf[0] = SMLT_ABCAST_HDR(SMLT_ABCAST_TYPE_SUBMIT, msg->words,
+                                 smlt_node_self_id);
+        buf[1] = 0;
+        memcpy(&buf[2], msg->data, msg->words * sizeof(smlt_msg_payload_t));
+
+        if (as->parent) {
+            err = smlt_abcast_send(as->parent, buf);
+            if (smlt_err_is_fail(err)) {
+                return err;
+            }
+        } else {
+            memcpy(as->batch[num_batch++], buf, sizeof(buf));
+        }
+    }
+
+    // collect the submissions of the subtree
+    // --------------------------------------------------
+    for (uint32_t i = 0; i < as->num_queues; i++) {
+        while (1) {
+            err = smlt_abcast_recv_queue(as->queues[i], buf);
+            if (smlt_err_is_fail(err)) {
+                return err;
+            }
+
+            if (SMLT_ABCAST_HDR_TYPE(buf[0]) == SMLT_ABCAST_TYPE_END) {
+                break;
+            }
+
+            if (as->parent) {
+                err = smlt_abcast_send(as->parent, buf);
+                if (smlt_err_is_fail(err)) {
+                    return err;
+                }
+            } else {
+                COND_PANIC(num_batch < as->batch_max,
+                           "more than one submission per node and round");
+                memcpy(as->batch[num_batch++], buf, sizeof(buf));
+            }
+        }
+    }
+
+    // sequence the batch and distribute it
+    // --------------------------------------------------
+    if (as->parent) {
+        buf[0] = SMLT_ABCAST_HDR(SMLT_ABCAST_TYPE_END, 0, smlt_node_self_id);
+        err = smlt_abcast_send(as->parent, buf);
+        if (smlt_err_is_fail(err)) {
+            return err;
+        }
+
+        do {
+            err = smlt_abcast_recv_parent(as, buf);
+            if (smlt_err_is_fail(err)) {
+                return err;
+            }
+
+            err = smlt_abcast_deliver(as, buf, deliver, arg);
+            if (smlt_err_is_fail(err)) {
+                return err;
+            }
+        } while (SMLT_ABCAST_HDR_TYPE(buf[0]) != SMLT_ABCAST_TYPE_END);
+    } else {
+        for (uint32_t i = 0; i < num_batch; i++) {
+            smlt_msg_payload_t *b = as->batch[i];
+            b[0] = SMLT_ABCAST_HDR(SMLT_ABCAST_TYPE_DELIVER,
+                                   SMLT_ABCAST_HDR_WORDS(b[0]),
+                                   SMLT_ABCAST_HDR_ORIGIN(b[0]));
+            b[1] = as->seq + 1;
+
+            err = smlt_abcast_deliver(as, b, deliver, arg);
+            if (smlt_err_is_fail(err)) {
+                return err;
+            }
+        }
+
+        buf[0] = SMLT_ABCAST_HDR(SMLT_ABCAST_TYPE_END, 0, smlt_node_self_id);
+        buf[1] = as->seq;
+        err = smlt_abcast_deliver(as, buf, deliver, arg);
+        if (smlt_err_is_fail(err)) {
+            return err;
+        }
+    }
+
+    return SMLT_SUCCESS;
+}
@@ -16,7 +16,40 @@
 #include <ffq/smlt_ffq_queue.h>
 
 /**
- * @brief Initialize UMP transmit queue state
+ * @brief sets the common fields of the queue state
+ *
+ * @param       q       Pointer to queue-state structure to initialize.
+ * @param       buf     Pointer to ring buffer for the queue.
+ * @param       slots   Size (in slots) of buffer.
+ */
+static void smlt_ffq_queue_init_common(struct smlt_ffq_queue *q, void *buf,
+                                       smlt_ffq_idx_t slots)
+{
+    q->size = slots;
+    q->slots = (volatile struct smlt_ffq_slot *)buf;
+    q->release = (volatile uint64_t *)(q->slots + slots);
+    q->pos = 0;
+    q->seq = 1;
+    q->released = 0;
+
+    /* releasing half of the queue at once would stall the sender */
+    q->batch = SMLT_FFQ_RELEASE_BATCH;
+    if (q->batch > slots / 2) {
+        q->batch = slots / 2;
+    }
+    if (q->batch == 0) {
+        q->batch = 1;
+    }
+
+    /*
+     * up to batch-1 consumed slots may not be released yet, a message
+     * taking more slots could wait for them forever
+     */
+    q->max_slots = slots - q->batch + 1;
+}
+
+/**
+ * @brief Initialize FFQ transmit queue state
  *
  * @param       c       Pointer to queue-state structure to initialize.
  * @param       buf     Pointer to ring buffer for the queue.
@@ -30,19 +63,23 @@
 errval_t smlt_ffq_queue_init_tx(struct smlt_ffq_queue *q, void *buf,
                                 smlt_ffq_idx_t slots)
 {
+    if (slots == 0) {
+        return SMLT_ERR_INVAL;
+    }
+
+    smlt_ffq_queue_init_common(q, buf, slots);
     q->direction = SMLT_FFQ_DIRECTION_SEND;
-    q->size = slots;
-    q->slots = (volatile struct smlt_ffq_slot *)buf;
-    q->pos = 0;
+
     for (smlt_ffq_idx_t i = 0; i < slots; ++i) {
-        q->slots[i].data[0] = SMLT_FFQ_SLOT_EMPTY;
+        q->slots[i].header = 0;
     }
+    *q->release = 0;
 
     return SMLT_SUCCESS;
 }
 
 /**
- * @brief Initialize UMP receive queue state
+ * @brief Initialize FFQ receive queue state
  *
  * @param       c       Pointer to queue-state structure to initialize.
  * @param       buf     Pointer to ring buffer for the queue.
@@ -56,10 +93,12 @@ errval_t smlt_ffq_queue_init_tx(struct smlt_ffq_queue *q, void *buf,
 errval_t smlt_ffq_queue_init_rx(struct smlt_ffq_queue *q, void *buf,
                                 smlt_ffq_idx_t slots)
 {
+    if (slots == 0) {
+        return SMLT_ERR_INVAL;
+    }
+
+    smlt_ffq_queue_init_common(q, buf, slots);
     q->direction = SMLT_FFQ_DIRECTION_RECV;
-    q->size = slots;
-    q->slots = (volatile struct smlt_ffq_slot *)buf;
-    q->pos = 0;
 
     return SMLT_SUCCESS;
 }
@@ -37,7 +37,7 @@ errval_t smlt_ffq_queuepair_init(smlt_ffq_idx_t num_slots, uint8_t node_src,
     void *shm_src = NULL;
     void *shm_dst = NULL;
 
-    size_t chan_size = num_slots * SMLT_FFQ_MSG_BYTES;
+    size_t chan_size = SMLT_FFQ_QUEUE_BYTES(num_slots);
 
     /* initialize queue SRC->DST */
     shm_src = smlt_platform_alloc_on_node(chan_size, BASE_PAGE_SIZE,
@@ -94,6 +94,13 @@ errval_t smlt_ffq_queuepair_init(smlt_ffq_idx_t num_slots, uint8_t node_src,
  */
 errval_t smlt_ffq_queuepair_destroy(struct smlt_ffq_queuepair *qp)
 {
+    /* each end frees the buffer it receives on */
+    if (qp->rx.slots) {
+        smlt_platform_free((void *)qp->rx.slots);
+    }
+
+    memset(qp, 0, sizeof(*qp));
+
     return SMLT_SUCCESS;
 }
 
@@ -159,12 +166,27 @@ bool smlt_ffq_queuepair_can_send(struct smlt_qp *qp)
   * @param msg    the Smelt message to receive in
   *
   * @returns SMELT_SUCCESS of the messessage could be received.
+  *
+  * msg->words gives the capacity of the message. It is set to the length of
+  * messages spanning several slots, SMLT_ERR_INVAL is returned if such a
+  * message had to be truncated.
   */
 errval_t smlt_ffq_queuepair_recv(struct smlt_qp *qp,
                                  struct smlt_msg *msg)
 {
+    errval_t err;
+    uint32_t words;
+
     struct smlt_ffq_queuepair *ffq = &qp->q.ffq;
-    return smlt_ffq_queuepair_recv_raw(ffq, msg->data, msg->words);
+    err = smlt_ffq_queuepair_recv_raw(ffq, msg->data, msg->words, &words);
+    if (err == SMLT_ERR_QUEUE_EMPTY) {
+        return err;
+    }
+
+    /* the length of the message, at most what fits into msg */
+    msg->words = (words > msg->words ? msg->words : words);
+
+    return err;
 }
 
  /**
@@ -177,7 +199,7 @@ errval_t smlt_ffq_queuepair_recv(struct smlt_qp *qp,
  errval_t smlt_ffq_queuepair_recv_notify(struct smlt_qp *qp)
  {
     struct smlt_ffq_queuepair *ffq = &qp->q.ffq;
-    return smlt_ffq_queuepair_recv_raw(ffq, NULL, 0);
+    return smlt_ffq_queuepair_recv_raw(ffq, NULL, 0, NULL);
  }
 
  /**
@@ -28,7 +28,7 @@
 #include <shm/swmr.h>
 
 
-#define SLOT_SIZE CACHELINE_SIZE/sizeof(uintptr_t)
+#define SLOT_SIZE (CACHELINE_SIZE/sizeof(uintptr_t))
 
 //#define DEBUG_SHM
 
@@ -48,7 +48,7 @@
  * cluster, starting at 0, i.e. for three readers, the id's would be
  * 0, 1 and 2.
  *
- * \param sep_header use a seperate cachline for the header
+ * \param sep_header keep the headers in a separate, compact array
  */
 void swmr_init_context(void* shm, struct swmr_context* queue,
                        uint8_t num_readers, uint8_t id, bool sep_header,
@@ -69,11 +69,85 @@ void swmr_init_context(void* shm, struct swmr_context* queue,
     queue->data = (uint8_t*) shm+((num_readers+1)*sizeof(union pos_point));
     queue->next_sync = queue->num_slots-1;
     queue->next_seq = 1;
+    queue->cached_pos = NULL;
     if (sep_header) {
-        queue->header = (uint8_t*) queue->data + queue_size*CACHELINE_SIZE;
+        /* one header word per slot, following the data slots */
+        queue->header = (uint8_t*) queue->data + queue->num_slots*CACHELINE_SIZE;
+        queue->header_stride = 1;
     } else {
+        /* the header is the first word of the data slot */
         queue->header = (uint8_t*) queue->data;
+        queue->header_stride = SLOT_SIZE;
     }
+    swmr_set_publish_interval(queue, SWMR_PUBLISH_INTERVAL);
+}
+
+/**
+ * \brief sets how often a reader publishes its position
+ *
+ * \param context  the reader context
+ * \param interval publish after every interval-th read
+ *
+ * The interval is rounded down to a power of two and limited to a quarter
+ * of the queue, so the writer can always make progress.
+ */
+void swmr_set_publish_interval(struct swmr_context* context,
+                               uint32_t interval)
+{
+    uint64_t max = context->num_slots / 4;
+    uint64_t pow = 1;
+
+    while ((pow << 1) <= interval && (pow << 1) <= max) {
+        pow <<= 1;
+    }
+
+    context->publish_mask = pow - 1;
+}
+
+/**
+ * \brief obtains the header word of a slot
+ *
+ * \param context  the queue context
+ * \param pos      the slot
+ *
+ * \returns pointer to the header word
+ */
+static inline volatile uintptr_t* swmr_header(struct swmr_context* context,
+                                             uint64_t pos)
+{
+    return (volatile uintptr_t*) context->header + pos*context->header_stride;
+}
+
+/**
+ * \brief publishes the position of the reader every publish interval
+ *
+ * \param context  the reader context
+ */
+static inline void swmr_publish_pos(struct swmr_context* context)
+{
+    if ((context->next_seq & context->publish_mask) == 0) {
+        context->readers_pos[context->id].pos = (context->next_seq -1);
+    }
+}
+
+/**
+ * \brief computes the size of the shared memory of a queue
+ *
+ * \param queue_size size of the queue in cachelines
+ * \param sep_header whether the headers are kept in a separate array
+ *
+ * \returns size in bytes
+ */
+size_t swmr_queue_bytes(uint32_t queue_size, bool sep_header)
+{
+    size_t bytes = queue_size * SMLT_ARCH_CACHELINE_SIZE;
+    if (sep_header) {
+        uint32_t header_lines = (queue_size * sizeof(uintptr_t) +
+                                 SMLT_ARCH_CACHELINE_SIZE - 1) /
+                                SMLT_ARCH_CACHELINE_SIZE;
+        bytes += header_lines * SMLT_ARCH_CACHELINE_SIZE;
+    }
+    return bytes;
 }
 
 void swmr_queue_create(struct swmr_queue** queue,
@@ -90,15 +164,9 @@ void swmr_queue_create(struct swmr_queue** queue,
         queue_size += SWMRQ_SIZE;
     }
 
-    if (sep_header) {
-        shm = smlt_platform_alloc_on_node(queue_size*SMLT_ARCH_CACHELINE_SIZE*2,
-                                          SMLT_ARCH_CACHELINE_SIZE,
-                                          numa_node_of_cpu(dst[0]), true);
-    } else {
-        shm = smlt_platform_alloc_on_node(queue_size*SMLT_ARCH_CACHELINE_SIZE,
-                                          SMLT_ARCH_CACHELINE_SIZE,
-                                          numa_node_of_cpu(dst[0]), true);
-    }
+    shm = smlt_platform_alloc_on_node(swmr_queue_bytes(queue_size, sep_header),
+                                      SMLT_ARCH_CACHELINE_SIZE,
+                                      numa_node_of_cpu(dst[0]), true);
 
     assert(shm != NULL);
 
@@ -116,15 +184,37 @@ void swmr_queue_create(struct swmr_queue** queue,
     }
 }
 
+/**
+ * \brief frees the shared memory and the reader contexts of a queue
+ *
+ * \param queue the queue to destroy
+ */
+void swmr_queue_destroy(struct swmr_queue* queue)
+{
+    if (queue->src.cached_pos) {
+        smlt_platform_free(queue->src.cached_pos);
+    }
+
+    if (queue->src.shm) {
+        smlt_platform_free(queue->src.shm);
+    }
+
+    if (queue->dst) {
+        smlt_platform_free(queue->dst);
+    }
+
+    memset(queue, 0, sizeof(*queue));
+}
+
 
 errval_t smlt_swmr_send(struct swmr_queue *qp, struct smlt_msg *msg)
 {
-    if (msg->words <= 7) {
+    if (msg->words <= SWMR_PAYLOAD_WORDS) {
         uintptr_t* data = (uintptr_t*) msg->data;
         swmr_send_raw(&qp->src, data[0], data[1], data[2],
                       data[3], data[4], data[5], data[6]);
     } else {
-        // TODO Fragment ? Or Bulkload style?
+        swmr_send(&qp->src, (uintptr_t*) msg->data, msg->words);
     }
     return SMLT_SUCCESS;
 }
@@ -141,9 +231,36 @@ void swmr_get_next_sync(struct swmr_context* context,
                    uint64_t* next)
 {
     uint64_t min = 0xFFFFFFFF;
+
+    if (context->cached_pos == NULL) {
+        context->cached_pos = (uint64_t*) smlt_platform_alloc(
+                                    context->num_readers * sizeof(uint64_t),
+                                    SMLT_ARCH_CACHELINE_SIZE, true);
+        if (context->cached_pos == NULL) {
+            for (int i = 0; i < context->num_readers; i++) {
+                if (min > context->readers_pos[i].pos) {
+                    min = context->readers_pos[i].pos;
+                }
+            }
+            *next = min+(context->num_slots-1);
+            return;
+        }
+    }
+
+    /*
+     * positions only grow, so the cached position is a lower bound. Only the
+     * readers lagging more than half a queue behind are read again, which
+     * still leaves the writer at least half a queue to write.
+     */
+    uint64_t half = context->num_slots / 2;
     for (int i = 0; i < context->num_readers; i++) {
-        if (min > context->readers_pos[i].pos) {
-            min = context->readers_pos[i].pos;
+        uint64_t pos = context->cached_pos[i];
+        if (pos + half < context->next_seq) {
+            pos = context->readers_pos[i].pos;
+            context->cached_pos[i] = pos;
+        }
+        if (min > pos) {
+            min = pos;
         }
     }
 
@@ -196,7 +313,7 @@ void swmr_send_raw(struct swmr_context* context,
 
     uint64_t offset = context->l_pos*SLOT_SIZE;
     uintptr_t* data = (uintptr_t*) context->data + offset;
-    uintptr_t* header = (uintptr_t*) context->header + offset;
+    volatile uintptr_t* header = swmr_header(context, context->l_pos);
 
     data[1] = p1;
     data[2] = p2;
@@ -210,6 +327,7 @@ void swmr_send_raw(struct swmr_context* context,
                 sched_getcpu(), context->l_pos,
                 context->next_seq);
 #endif
+    smlt_arch_write_barrier();
     header[0] = context->next_seq;
     context->next_seq++;
 
@@ -217,7 +335,7 @@ void swmr_send_raw(struct swmr_context* context,
     context->l_pos++;
 /*
     printf("Core %d: DATA %p %ld HEADER %p %ld  offset %ld \n", sched_getcpu(),
-           (void*) data, data[0], (void*) header, header[0], offset);
+           (void*) data, data[0], (void*) header, *header, offset);
 */
 }
 
@@ -239,9 +357,7 @@ void swmr_send_raw0(struct swmr_context* context)
        context->next_sync = next_sync;
     }
 
-    uintptr_t* slot_start = (uintptr_t*) context->data + (context->l_pos*SLOT_SIZE);
-
-    slot_start[0] = context->next_seq;
+    *swmr_header(context, context->l_pos) = context->next_seq;
 
     context->next_seq++;
 
@@ -250,12 +366,205 @@ void swmr_send_raw0(struct swmr_context* context)
 }
 
 
+/*
+ * ===========================================================================
+ * Messages spanning several slots
+ * ===========================================================================
+ *
+ * A message of more than SWMR_PAYLOAD_WORDS words is written as a sequence
+ * of consecutive slots. The header of the first slot carries SWMR_HEADER_LONG
+ * and its first data word holds the length of the message in words. Every
+ * slot still gets its own sequence number, so the writer reuses the regular
+ * flow control and a message may be larger than the queue: the readers
+ * consume the slots while the writer produces them.
+ */
+
+/**
+ * \brief waits for the next free slot of the writer
+ *
+ * \param context  the writer context
+ * \param header   returns the header word of the slot
+ *
+ * \returns pointer to the slot, the payload starts at index 1
+ */
+static uintptr_t* swmr_get_send_slot(struct swmr_context* context,
+                                     volatile uintptr_t** header)
+{
+    uint64_t next_sync;
+
+    if (context->l_pos == context->num_slots) {
+        context->l_pos = 0;
+    }
+
+    if (context->next_seq == context->next_sync) {
+        swmr_get_next_sync(context, &next_sync);
+        while (context->next_seq == next_sync) {
+            swmr_get_next_sync(context, &next_sync);
+        }
+        context->next_sync = next_sync;
+    }
+
+    uint64_t offset = context->l_pos*SLOT_SIZE;
+    *header = swmr_header(context, context->l_pos);
+    return (uintptr_t*) context->data + offset;
+}
+
+/**
+ * \brief publishes the current slot of the writer
+ *
+ * \param context  the writer context
+ * \param header   the header word of the slot
+ * \param flags    flags to be stored with the sequence number
+ */
+static void swmr_commit_send_slot(struct swmr_context* context,
+                                  volatile uintptr_t* header,
+                                  uintptr_t flags)
+{
+    smlt_arch_write_barrier();
+
+    *header = context->next_seq | flags;
+    context->next_seq++;
+    context->l_pos++;
+}
+
+/**
+ * \brief waits until the current slot of a reader is written
+ *
+ * \param context  the reader context
+ * \param header   returns the header word of the slot
+ *
+ * \returns pointer to the slot, the payload starts at index 1
+ */
+static uintptr_t* swmr_get_recv_slot(struct swmr_context* context,
+                                     uintptr_t* header)
+{
+    uint64_t offset = context->l_pos*SLOT_SIZE;
+    volatile uintptr_t* h = swmr_header(context, context->l_pos);
+
+    while ((*h & ~SWMR_HEADER_LONG) != context->next_seq) {
+        ;
+    }
+
+    *header = *h;
+    smlt_arch_write_barrier();
+
+    return (uintptr_t*) context->data + offset;
+}
+
+/**
+ * \brief advances the reader to the next slot
+ *
+ * \param context  the reader context
+ */
+static void swmr_release_recv_slot(struct swmr_context* context)
+{
+    context->l_pos++;
+    context->next_seq++;
+    if (context->l_pos == context->num_slots) {
+        context->l_pos = 0;
+    }
+
+    swmr_publish_pos(context);
+}
+
+/**
+ * \brief sends a message of arbitrary length, blocks until it is written
+ *
+ * \param context  the writer context
+ * \param data     the payload
+ * \param words    length of the payload in words
+ */
+void swmr_send(struct swmr_context* context, const uintptr_t* data,
+               uint32_t words)
+{
+    uintptr_t *slot;
+    volatile uintptr_t *header;
+
+    if (words <= SWMR_PAYLOAD_WORDS) {
+        slot = swmr_get_send_slot(context, &header);
+        for (uint32_t i = 0; i < words; i++) {
+            slot[i + 1] = data[i];
+        }
+        swmr_commit_send_slot(context, header, 0);
+        return;
+    }
+
+    /* the first slot holds the length and the start of the payload */
+    slot = swmr_get_send_slot(context, &header);
+    slot[1] = words;
+    for (uint32_t i = 0; i < SWMR_PAYLOAD_WORDS - 1; i++) {
+        slot[i + 2] = data[i];
+    }
+    swmr_commit_send_slot(context, header, SWMR_HEADER_LONG);
+
+    for (uint32_t w = SWMR_PAYLOAD_WORDS - 1; w < words;
+         w += SWMR_PAYLOAD_WORDS) {
+        uint32_t n = words - w;
+        if (n > SWMR_PAYLOAD_WORDS) {
+            n = SWMR_PAYLOAD_WORDS;
+        }
+
+        slot = swmr_get_send_slot(context, &header);
+        for (uint32_t i = 0; i < n; i++) {
+            slot[i + 1] = data[w + i];
+        }
+        swmr_commit_send_slot(context, header, 0);
+    }
+}
+
+/**
+ * \brief receives a message of arbitrary length, blocks until it arrives
+ *
+ * \param context  the reader context
+ * \param data     buffer for the payload
+ * \param capacity size of the buffer in words
+ *
+ * \returns the length of the message in words
+ *
+ * Single slot messages always return SWMR_PAYLOAD_WORDS words, the buffer has
+ * to hold at least that many. Words of longer messages that do not fit into
+ * the buffer are dropped, the message is consumed in any case.
+ */
+uint32_t swmr_receive(struct swmr_context* context, uintptr_t* data,
+                      uint32_t capacity)
+{
+    uintptr_t hdr;
+    uintptr_t *slot = swmr_get_recv_slot(context, &hdr);
+
+    if (!(hdr & SWMR_HEADER_LONG)) {
+        for (uint32_t i = 0; i < SWMR_PAYLOAD_WORDS; i++) {
+            data[i] = slot[i + 1];
+        }
+        swmr_release_recv_slot(context);
+        return SWMR_PAYLOAD_WORDS;
+    }
+
+    uint32_t words = slot[1];
+    for (uint32_t i = 0; i < SWMR_PAYLOAD_WORDS - 1 && i < capacity; i++) {
+        data[i] = slot[i + 2];
+    }
+    swmr_release_recv_slot(context);
+
+    for (uint32_t w = SWMR_PAYLOAD_WORDS - 1; w < words;
+         w += SWMR_PAYLOAD_WORDS) {
+        slot = swmr_get_recv_slot(context, &hdr);
+        for (uint32_t i = 0; i < SWMR_PAYLOAD_WORDS && w + i < words; i++) {
+            if (w + i < capacity) {
+                data[w + i] = slot[i + 1];
+            }
+        }
+        swmr_release_recv_slot(context);
+    }
+
+    return words;
+}
+
+
 bool swmr_can_receive(struct swmr_context* context)
 {
-    uintptr_t* start;
-    start = (uintptr_t*) context->data + ((context->l_pos)*SLOT_SIZE);
+    volatile uintptr_t* header = swmr_header(context, context->l_pos);
 
-    if (context->next_seq == start[0]) {
+    if (context->next_seq == (*header & ~SWMR_HEADER_LONG)) {
         return true;
     } else {
         return false;
@@ -263,6 +572,8 @@ bool swmr_can_receive(struct swmr_context* context)
 }
 
 // returns NULL if reader reached writers pos
+// a message spanning several slots is received one slot at a time, the
+// first one holds the length of the message, see swmr_send()
 bool swmr_receive_non_blocking(struct swmr_context* context,
               uintptr_t *p1,
               uintptr_t *p2,
@@ -275,13 +586,14 @@ bool swmr_receive_non_blocking(struct swmr_context* context,
     //assert (context!=NULL);
     uint64_t offset = (context->l_pos*SLOT_SIZE);
     uintptr_t* start = (uintptr_t*) context->data + offset;
-    uintptr_t* header = (uintptr_t*) context->header + offset;
+    volatile uintptr_t* header = swmr_header(context, context->l_pos);
 /*
     printf("Core %d: DATA %p %ld HEADER %p %ld offset %ld lpos %d \n", sched_getcpu(),
-           (void*) start, start[0], (void*) header, header[0], offset, context->l_pos);
+           (void*) start, start[0], (void*) header, *header, offset, context->l_pos);
     sleep(1);
 */
-    if (context->next_seq == header[0]) {
+    if (context->next_seq == (*header & ~SWMR_HEADER_LONG)) {
+        smlt_arch_write_barrier();
         *p1 = start[1];
         *p2 = start[2];
         *p3 = start[3];
@@ -301,10 +613,7 @@ bool swmr_receive_non_blocking(struct swmr_context* context,
             context->l_pos = 0;
         }
 
-   	    // only update read pointer every 16th read
-        if ((context->next_seq & 0x20) == 0) {
-            context->readers_pos[context->id].pos = (context->next_seq -1);
-        }
+        swmr_publish_pos(context);
         return true;
     }
     return false;
@@ -315,20 +624,16 @@ bool swmr_receive_non_blocking(struct swmr_context* context,
 bool swmr_receive_non_blocking0(struct swmr_context* context)
 {
     //assert (context!=NULL);
-    uintptr_t* start;
-    start = (uintptr_t*) context->data + ((context->l_pos)*SLOT_SIZE);
+    volatile uintptr_t* header = swmr_header(context, context->l_pos);
 
-    if (context->next_seq == start[0]) {
+    if (context->next_seq == (*header & ~SWMR_HEADER_LONG)) {
         context->l_pos++;
         context->next_seq++;
         if (context->l_pos == context->num_slots) {
             context->l_pos = 0;
         }
 
-	    // only update read pointer every 16th read
-        if ((context->next_seq & 0x20) == 0) {
-            context->readers_pos[context->id].pos = (context->next_seq -1);
-        }
+        swmr_publish_pos(context);
         return true;
     }
     return false;
@@ -358,15 +663,18 @@ void swmr_receive_raw0(struct swmr_context* context)
 
 errval_t smlt_swmr_recv(struct swmr_context *context, struct smlt_msg *msg)
 {
-    if (msg->words <= 7) {
-        uintptr_t* data = (uintptr_t*) msg->data;
-        swmr_receive_raw(context, &data[0], &data[1], &data[2],
-                      &data[3], &data[4], &data[5], &data[6]);
-    } else {
-        // TODO Fragment ? Or Bulkload style?
+    uint32_t capacity = msg->bufsize / sizeof(uintptr_t);
+    uint32_t words = swmr_receive(context, (uintptr_t*) msg->data, capacity);
+    if (words > SWMR_PAYLOAD_WORDS) {
+        if (words > capacity) {
+            msg->words = capacity;
+            return SMLT_ERR_INVAL;
+        }
+        msg->words = words;
     }
     return SMLT_SUCCESS;
 }
+
 errval_t smlt_swmr_recv0(struct swmr_context *context)
 {
     swmr_receive_raw0(context);
@@ -10,9 +10,11 @@
 #include <stdio.h>
 
 #include <limits.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include <smlt.h>
+#include <smlt_debug.h>
 #include <ump/smlt_ump_queue.h>
 
 /**
@@ -92,6 +94,7 @@ errval_t smlt_ump_queue_init_tx(struct smlt_ump_queue *q, void *buf,
     }
 
     q->direction = SMLT_UMP_DIRECTION_SEND;
+    q->push = SMLT_UMP_PUSH_NONE;
 
     /*
      * we clear the buffer of the messages, this has to be done on the sending
@@ -132,3 +135,77 @@ errval_t smlt_ump_queue_init_rx(struct smlt_ump_queue *q, void *buf,
 
     return SMLT_SUCCESS;
 }
+
+/*
+ * ===========================================================================
+ * push modes
+ * ===========================================================================
+ */
+
+///< names of the push modes
+static const char *push_names[SMLT_UMP_PUSH_NUM_MODES] = {
+    "none", "stream", "cldemote", "clwb"
+};
+
+/**
+ * @brief obtains the name of a push mode
+ *
+ * @param push  the push mode
+ *
+ * @returns string representation of the mode
+ */
+const char *smlt_ump_queue_push_name(smlt_ump_push_t push)
+{
+    if (push >= SMLT_UMP_PUSH_NUM_MODES) {
+        return "unknown";
+    }
+    return push_names[push];
+}
+
+/**
+ * @brief selects the push mode for a queue between two NUMA nodes
+ *
+ * @param node_src  the node of the sender
+ * @param node_dst  the node of the receiver
+ *
+ * @returns the push mode to be used for sending
+ */
+smlt_ump_push_t smlt_ump_queue_push_mode(uint8_t node_src, uint8_t node_dst)
+{
+    static bool warned = false;
+
+    const char *name = getenv("SMLT_UMP_PUSH");
+    if (name == NULL) {
+        return SMLT_UMP_PUSH_NONE;
+    }
+
+    if (node_src == node_dst) {
+        const char *local = getenv("SMLT_UMP_PUSH_LOCAL");
+        if (local == NULL || strcmp(local, "1") != 0) {
+            return SMLT_UMP_PUSH_NONE;
+        }
+    }
+
+    smlt_ump_push_t push;
+    for (push = SMLT_UMP_PUSH_NONE; push < SMLT_UMP_PUSH_NUM_MODES; push++) {
+        if (strcmp(name, push_names[push]) == 0) {
+            break;
+        }
+    }
+
+    if (push == SMLT_UMP_PUSH_NUM_MODES) {
+        push = SMLT_UMP_PUSH_NONE;
+    } else if (push == SMLT_UMP_PUSH_CLWB && !smlt_arch_has_clwb()) {
+        push = SMLT_UMP_PUSH_NONE;
+    } else if (push == SMLT_UMP_PUSH_CLDEMOTE && !smlt_arch_has_cldemote()) {
+        push = SMLT_UMP_PUSH_NONE;
+    }
+
+    if (push == SMLT_UMP_PUSH_NONE && strcmp(name, "none") != 0 && !warned) {
+        SMLT_WARNING("UMP push mode '%s' not available, using regular stores\n",
+                     name);
+        warned = true;
+    }
+
+    return push;
+}
@@ -83,6 +83,9 @@ errval_t smlt_ump_queuepair_init(smlt_ump_idx_t num_slots, uint8_t node_src,
         return smlt_err_push(err, SMLT_ERR_QUEUE_INIT);
     }
 
+    src->tx.push = smlt_ump_queue_push_mode(node_src, node_dst);
+    dst->tx.push = smlt_ump_queue_push_mode(node_dst, node_src);
+
     src->seq_id = 1;
     dst->seq_id = 1;
 
@@ -94,9 +97,28 @@ errval_t smlt_ump_queuepair_init(smlt_ump_idx_t num_slots, uint8_t node_src,
 }
 
 
+/**
+ * @brief destroys one end of the queuepair
+ *
+ * @param qp    the ump queuepair end to destroy
+ *
+ * @returns SMLT_SUCCESS
+ *
+ * Each end frees the ring buffer it transmits on, hence both ends need
+ * to be destroyed to release the queuepair.
+ */
 errval_t smlt_ump_queuepair_destroy(struct smlt_ump_queuepair *qp)
 {
-    // TODO how to destroy a ump queuepair?
+    if (qp->tx.buf) {
+        smlt_platform_free((void *)qp->tx.buf);
+    }
+
+    if (qp->other) {
+        qp->other->other = NULL;
+    }
+
+    memset(qp, 0, sizeof(*qp));
+
     return SMLT_SUCCESS;
 }
 
@@ -126,11 +148,7 @@ errval_t smlt_ump_queuepair_try_send(struct smlt_qp *qp,
         return SMLT_ERR_QUEUE_FULL;
     }
 
-    for (uint32_t i = 0; i < msg->words; ++i) {
-        m->data[i] = msg->data[i];
-    }
-
-    return smlt_ump_queuepair_send_raw(ump, m);
+    return smlt_ump_queuepair_send_words(ump, m, msg->data, msg->words);
 }
 /**
 * @brief sends a notification on the queuepair
@@ -13,7 +13,9 @@
 #include <smlt_channel.h>
 #include <smlt_reduction.h>
 #include <smlt_broadcast.h>
+#include <smlt_context.h>
 #include <shm/smlt_shm.h>
+#include "internal.h"
 
 struct smlt_dissem_barrier {
     int num_threads;
@@ -64,6 +66,250 @@ errval_t smlt_barrier_wait(struct smlt_context *ctx)
     return smlt_broadcast_notify(ctx);
 }
 
+/*
+ * ===========================================================================
+ * Split barrier
+ * ===========================================================================
+ */
+
+/**
+ * per node state of the split barrier on a context
+ */
+struct smlt_barrier_state
+{
+    uint64_t arrived;                   ///< last epoch the node arrived at
+    uint64_t departed;                  ///< last epoch the node departed from
+    uint64_t reported;                  ///< last epoch reported to the parent
+    uint64_t released;                  ///< last epoch released
+    struct smlt_channel *parent;        ///< channel to the parent, NULL if root
+    uint32_t parent_idx;                ///< index on a shared memory parent
+    struct smlt_channel *children;      ///< channels to the children
+    uint32_t num_children;              ///< number of child channels
+    uint64_t *forwarded;                ///< last release sent per child channel
+    uint32_t num_queues;                ///< number of queues from the children
+    struct smlt_qp **queues;            ///< queues from the children
+    uint64_t *child_arrived;            ///< last epoch reported per queue
+};
+
+/**
+ * @brief creates the split barrier state of the current node
+ *
+ * @param ctx   Smelt context
+ *
+ * @return the state or NULL if the allocation failed
+ */
+struct smlt_barrier_state *smlt_barrier_state_create(struct smlt_context *ctx)
+{
+    struct smlt_context_links l;
+
+    if (smlt_err_is_fail(smlt_context_get_links(ctx, &l))) {
+        return NULL;
+    }
+
+    size_t size = sizeof(struct smlt_barrier_state)
+                  + (l.num_children + l.num_queues) * sizeof(uint64_t)
+                  + l.num_queues * sizeof(struct smlt_qp *);
+
+    struct smlt_barrier_state *bs = (struct smlt_barrier_state *)
+        smlt_platform_alloc(size, SMLT_ARCH_CACHELINE_SIZE, true);
+    if (bs == NULL) {
+        return NULL;
+    }
+
+    bs->parent = l.parent;
+    bs->parent_idx = l.parent_idx;
+    bs->children = l.children;
+    bs->num_children = l.num_children;
+    bs->num_queues = l.num_queues;
+    bs->forwarded = (uint64_t *)(bs + 1);
+    bs->child_arrived = bs->forwarded + l.num_children;
+    bs->queues = (struct smlt_qp **)(bs->child_arrived + l.num_queues);
+
+    smlt_context_get_child_queues(&l, bs->queues);
+
+    return bs;
+}
+
+/**
+ * @brief frees the split barrier state
+ *
+ * @param bs    the state to free
+ */
+void smlt_barrier_state_destroy(struct smlt_barrier_state *bs)
+{
+    smlt_platform_free(bs);
+}
+
+/**
+ * @brief makes progress on the split barrier without blocking
+ *
+ * Arrivals and releases are cumulative: a message that cannot be sent right
+ * away is covered by the next one, so the node never blocks on a full queue.
+ */
+static errval_t smlt_barrier_progress(struct smlt_barrier_state *bs)
+{
+    errval_t err;
+    smlt_msg_payload_t epoch;
+    struct smlt_msg msg = {
+        .words = 1,
+        .bufsize = sizeof(epoch),
+        .data = &epoch
+    };
+
+    // collect the arrivals of the children
+    for (uint32_t i = 0; i < bs->num_queues; i++) {
+        while (smlt_queuepair_can_recv(bs->queues[i])) {
+            err = smlt_queuepair_recv(bs->queues[i], &msg);
+            if (smlt_err_is_fail(err)) {
+                return err;
+            }
+            if (epoch > bs->child_arrived[i]) {
+                bs->child_arrived[i] = epoch;
+            }
+        }
+    }
+
+    uint64_t arrived = bs->arrived;
+    for (uint32_t i = 0; i < bs->num_queues; i++) {
+        if (bs->child_arrived[i] < arrived) {
+            arrived = bs->child_arrived[i];
+        }
+    }
+
+    // report the arrival of the subtree, the root releases it
+    if (arrived > bs->reported) {
+        if (bs->parent == NULL) {
+            bs->reported = arrived;
+            bs->released = arrived;
+        } else if (smlt_channel_can_send(bs->parent)) {
+            epoch = arrived;
+            err = smlt_channel_send(bs->parent, &msg);
+            if (smlt_err_is_fail(err)) {
+                return err;
+            }
+            bs->reported = arrived;
+        }
+    }
+
+    // receive releases from the parent
+    if (bs->parent) {
+        while (smlt_channel_can_recv_index(bs->parent, bs->parent_idx)) {
+            err = smlt_channel_recv_index(bs->parent, &msg, bs->parent_idx);
+            if (smlt_err_is_fail(err)) {
+                return err;
+            }
+            if (epoch > bs->released) {
+                bs->released = epoch;
+            }
+        }
+    }
+
+    // forward releases to the children
+    for (uint32_t i = 0; i < bs->num_children; i++) {
+        if (bs->forwarded[i] < bs->released &&
+            smlt_channel_can_send(&bs->children[i])) {
+            epoch = bs->released;
+            err = smlt_channel_send(&bs->children[i], &msg);
+            if (smlt_err_is_fail(err)) {
+                return err;
+            }
+            bs->forwarded[i] = bs->released;
+        }
+    }
+
+    return SMLT_SUCCESS;
+}
+
+/**
+ * @brief checks if the node can depart from the epoch
+ */
+static inline bool smlt_barrier_is_released(struct smlt_barrier_state *bs,
+                                            uint64_t epoch)
+{
+    if (bs->released < epoch) {
+        return false;
+    }
+
+    // the children must have been released too before the node leaves
+    for (uint32_t i = 0; i < bs->num_children; i++) {
+        if (bs->forwarded[i] < epoch) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief arrives at the next epoch of the split barrier without blocking
+ *
+ * @param ctx the Smelt context
+ *
+ * @returns SMLT_SUCCESS or SMLT_ERR_INVAL if the node is not in the context
+ */
+errval_t smlt_barrier_arrive(struct smlt_context *ctx)
+{
+    struct smlt_barrier_state *bs = smlt_context_get_barrier_state(ctx);
+    if (bs == NULL) {
+        return SMLT_ERR_INVAL;
+    }
+
+    bs->arrived++;
+
+    return smlt_barrier_progress(bs);
+}
+
+/**
+ * @brief checks if the oldest epoch not departed from has been released
+ *
+ * @param ctx the Smelt context
+ *
+ * @returns TRUE if smlt_barrier_depart() would not block
+ */
+bool smlt_barrier_test(struct smlt_context *ctx)
+{
+    struct smlt_barrier_state *bs = smlt_context_get_barrier_state(ctx);
+    if (bs == NULL || bs->departed == bs->arrived) {
+        return false;
+    }
+
+    if (smlt_err_is_fail(smlt_barrier_progress(bs))) {
+        return false;
+    }
+
+    return smlt_barrier_is_released(bs, bs->departed + 1);
+}
+
+/**
+ * @brief waits until the oldest epoch not departed from has been released
+ *
+ * @param ctx the Smelt context
+ *
+ * @returns SMLT_SUCCESS or SMLT_ERR_INVAL if the node is not in the context
+ *          or has not arrived at a new epoch
+ */
+errval_t smlt_barrier_depart(struct smlt_context *ctx)
+{
+    errval_t err;
+
+    struct smlt_barrier_state *bs = smlt_context_get_barrier_state(ctx);
+    if (bs == NULL || bs->departed == bs->arrived) {
+        return SMLT_ERR_INVAL;
+    }
+
+    uint64_t epoch = bs->departed + 1;
+    while (!smlt_barrier_is_released(bs, epoch)) {
+        err = smlt_barrier_progress(bs);
+        if (smlt_err_is_fail(err)) {
+            return err;
+        }
+    }
+
+    bs->departed = epoch;
+
+    return SMLT_SUCCESS;
+}
+
 errval_t smlt_dissem_barrier_init(uint32_t* cores, uint32_t num_cores,
                                   struct smlt_dissem_barrier** bar)
 {
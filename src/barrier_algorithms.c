@@ -0,0 +1,481 @@
+/*
+ * Copyright (c) 2016 ETH Zurich.
+ * All rights reserved.
+ *
+ * This file is distributed under the terms in the attached LICENSE file.
+ * If you do not find this file, copies can be found by writing to:
+ * ETH Zurich D-INFK, Universitaetstr. 6, CH-8092 Zurich. Attn: Systems Group.
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <smlt.h>
+#include <smlt_barrier.h>
+#include <smlt_context.h>
+#include <smlt_tune.h>
+#include "internal.h"
+
+/*
+ * ===========================================================================
+ * type definitions
+ * ===========================================================================
+ */
+
+///< fan-in of the counters of the combining tree
+#define SMLT_BARRIER_COMBINING_FANIN 4
+
+///< fan-in of the MCS arrival tree
+#define SMLT_BARRIER_MCS_FANIN 4
+
+/**
+ * per node flags of the shared memory barriers, one cache line per node
+ *
+ * Every flag holds the epoch of the last barrier it was set for, so the
+ * flags never have to be reset.
+ */
+struct smlt_barrier_slot
+{
+    uint64_t epoch;                     ///< epoch of the last barrier entered
+    volatile uint64_t arrived;          ///< tournament: the node has arrived
+    volatile uint64_t wakeup;           ///< set by the parent on release
+    union {
+        volatile uint8_t child[SMLT_BARRIER_MCS_FANIN];
+        volatile uint32_t all;
+    } ready;                            ///< MCS: low byte of the child epochs
+} SMLT_ARCH_ATTR_ALIGN;
+
+/**
+ * a counter of the combining tree
+ */
+struct smlt_barrier_counter
+{
+    volatile uint32_t count;            ///< number of arrivals this epoch
+    uint32_t expected;                  ///< number of arrivals to wait for
+    struct smlt_barrier_counter *parent;///< next counter, NULL for the root
+} SMLT_ARCH_ATTR_ALIGN;
+
+/**
+ * the smelt barrier data structure
+ */
+struct smlt_barrier
+{
+    smlt_barrier_type_t type;
+    struct smlt_context *ctx;
+    uint32_t num_nodes;
+
+    /* dissemination barrier */
+    struct smlt_dissem_barrier *dissem;
+
+    /* shared memory barriers */
+    struct smlt_barrier_slot *slots;
+    struct smlt_barrier_counter *counters;
+    volatile uint64_t release SMLT_ARCH_ATTR_ALIGN;
+};
+
+/**
+ * names of the barrier types, used by the SMLT_BARRIER environment variable
+ */
+static const char *smlt_barrier_names[SMLT_BARRIER_NUM_TYPES] = {
+    [SMLT_BARRIER_DEFAULT]       = "default",
+    [SMLT_BARRIER_TREE]          = "tree",
+    [SMLT_BARRIER_DISSEMINATION] = "dissemination",
+    [SMLT_BARRIER_TOURNAMENT]    = "tournament",
+    [SMLT_BARRIER_COMBINING]     = "combining",
+    [SMLT_BARRIER_MCS]           = "mcs",
+};
+
+/*
+ * ===========================================================================
+ * barrier names
+ * ===========================================================================
+ */
+
+/**
+ * @brief obtains the name of a barrier algorithm
+ *
+ * @param type  the barrier type
+ *
+ * @returns the name or NULL if the type is unknown
+ */
+const char *smlt_barrier_type_to_name(smlt_barrier_type_t type)
+{
+    if (type >= SMLT_BARRIER_NUM_TYPES) {
+        return NULL;
+    }
+    return smlt_barrier_names[type];
+}
+
+/**
+ * @brief looks up a barrier algorithm by its name
+ *
+ * @param name  the name of the algorithm
+ *
+ * @returns the barrier type or SMLT_BARRIER_NUM_TYPES if it is unknown
+ */
+smlt_barrier_type_t smlt_barrier_type_from_name(const char *name)
+{
+    if (name == NULL) {
+        return SMLT_BARRIER_NUM_TYPES;
+    }
+
+    for (uint32_t i = 0; i < SMLT_BARRIER_NUM_TYPES; i++) {
+        if (strcmp(smlt_barrier_names[i], name) == 0) {
+            return (smlt_barrier_type_t)i;
+        }
+    }
+
+    return SMLT_BARRIER_NUM_TYPES;
+}
+
+/**
+ * @brief resolves the default barrier type
+ *
+ * SMLT_BARRIER takes precedence over the decision table of the auto-tuner.
+ */
+static smlt_barrier_type_t smlt_barrier_select(struct smlt_context *ctx)
+{
+    smlt_barrier_type_t type;
+
+    const char *name = getenv("SMLT_BARRIER");
+    if (name == NULL) {
+        uint32_t num_nodes = smlt_context_get_num_nodes(ctx);
+        coreid_t cores[num_nodes];
+        for (uint32_t i = 0; i < num_nodes; i++) {
+            cores[i] = smlt_get_core_by_id(smlt_context_get_node_id(ctx, i));
+        }
+
+        if (smlt_err_is_ok(smlt_tune_get_barrier(cores, num_nodes, &type))) {
+            return type;
+        }
+        return SMLT_BARRIER_TREE;
+    }
+
+    type = smlt_barrier_type_from_name(name);
+    if (type == SMLT_BARRIER_NUM_TYPES || type == SMLT_BARRIER_DEFAULT) {
+        SMLT_WARNING("unknown barrier '%s', using the tree barrier\n", name);
+        return SMLT_BARRIER_TREE;
+    }
+
+    return type;
+}
+
+/*
+ * ===========================================================================
+ * creation and destruction
+ * ===========================================================================
+ */
+
+/**
+ * @brief builds the combining tree of counters
+ *
+ * The counters are stored level by level, the leaves come first. Node i
+ * arrives at leaf counter i / SMLT_BARRIER_COMBINING_FANIN.
+ */
+static errval_t smlt_barrier_combining_init(struct smlt_barrier *bar)
+{
+    const uint32_t fanin = SMLT_BARRIER_COMBINING_FANIN;
+
+    uint32_t num_counters = 0;
+    uint32_t width = bar->num_nodes;
+    do {
+        width = (width + fanin - 1) / fanin;
+        num_counters += width;
+    } while (width > 1);
+
+    bar->counters = (struct smlt_barrier_counter *)
+        smlt_platform_alloc(num_counters * sizeof(struct smlt_barrier_counter),
+                            SMLT_ARCH_CACHELINE_SIZE, true);
+    if (bar->counters == NULL) {
+        return SMLT_ERR_MALLOC_FAIL;
+    }
+
+    struct smlt_barrier_counter *level = bar->counters;
+    uint32_t below = bar->num_nodes;
+    do {
+        width = (below + fanin - 1) / fanin;
+        struct smlt_barrier_counter *next = level + width;
+        for (uint32_t i = 0; i < width; i++) {
+            uint32_t rest = below - i * fanin;
+            level[i].expected = rest < fanin ? rest : fanin;
+            level[i].parent = width > 1 ? &next[i / fanin] : NULL;
+        }
+        level = next;
+        below = width;
+    } while (width > 1);
+
+    return SMLT_SUCCESS;
+}
+
+/**
+ * @brief creates a barrier over all nodes of a context
+ *
+ * @param ctx   the Smelt context
+ * @param type  the barrier algorithm to use
+ * @param ret   returns the barrier
+ *
+ * @returns SMLT_SUCCESS, SMLT_ERR_INVAL for an unknown type,
+ *          SMLT_ERR_MALLOC_FAIL or SMLT_ERR_CHAN_CREATE
+ */
+errval_t smlt_barrier_create(struct smlt_context *ctx,
+                             smlt_barrier_type_t type,
+                             struct smlt_barrier **ret)
+{
+    errval_t err;
+
+    if (ctx == NULL || type >= SMLT_BARRIER_NUM_TYPES) {
+        return SMLT_ERR_INVAL;
+    }
+
+    if (type == SMLT_BARRIER_DEFAULT) {
+        type = smlt_barrier_select(ctx);
+    }
+
+    struct smlt_barrier *bar = (struct smlt_barrier *)
+        smlt_platform_alloc(sizeof(struct smlt_barrier),
+                            SMLT_ARCH_CACHELINE_SIZE, true);
+    if (bar == NULL) {
+        return SMLT_ERR_MALLOC_FAIL;
+    }
+
+    bar->type = type;
+    bar->ctx = ctx;
+    bar->num_nodes = smlt_context_get_num_nodes(ctx);
+
+    switch (type) {
+    case SMLT_BARRIER_TREE:
+        err = SMLT_SUCCESS;
+        break;
+    case SMLT_BARRIER_DISSEMINATION: {
+        uint32_t nids[bar->num_nodes];
+        for (uint32_t i = 0; i < bar->num_nodes; i++) {
+            nids[i] = smlt_context_get_node_id(ctx, i);
+        }
+        err = smlt_dissem_barrier_init(nids, bar->num_nodes, &bar->dissem);
+        break;
+    }
+    case SMLT_BARRIER_COMBINING:
+        err = smlt_barrier_combining_init(bar);
+        break;
+    case SMLT_BARRIER_TOURNAMENT:
+    case SMLT_BARRIER_MCS:
+        bar->slots = (struct smlt_barrier_slot *)
+            smlt_platform_alloc(bar->num_nodes * sizeof(struct smlt_barrier_slot),
+                                SMLT_ARCH_CACHELINE_SIZE, true);
+        err = bar->slots ? SMLT_SUCCESS : SMLT_ERR_MALLOC_FAIL;
+        break;
+    default:
+        err = SMLT_ERR_INVAL;
+        break;
+    }
+
+    if (smlt_err_is_fail(err)) {
+        smlt_barrier_free(bar);
+        return err;
+    }
+
+    SMLT_DEBUG(SMLT_DBG__GENERAL, "created %s barrier over %u nodes\n",
+               smlt_barrier_type_to_name(type), bar->num_nodes);
+
+    *ret = bar;
+
+    return SMLT_SUCCESS;
+}
+
+/**
+ * @brief frees a barrier
+ *
+ * @param bar   the barrier to free
+ *
+ * @returns SMLT_SUCCESS
+ */
+errval_t smlt_barrier_free(struct smlt_barrier *bar)
+{
+    if (bar->dissem) {
+        smlt_dissem_barrier_destroy(bar->dissem);
+    }
+
+    if (bar->slots) {
+        smlt_platform_free(bar->slots);
+    }
+
+    if (bar->counters) {
+        smlt_platform_free(bar->counters);
+    }
+
+    smlt_platform_free(bar);
+
+    return SMLT_SUCCESS;
+}
+
+/**
+ * @brief obtains the algorithm of a barrier
+ *
+ * @param bar   the barrier
+ *
+ * @returns the barrier type, never SMLT_BARRIER_DEFAULT
+ */
+smlt_barrier_type_t smlt_barrier_get_type(struct smlt_barrier *bar)
+{
+    return bar->type;
+}
+
+/*
+ * ===========================================================================
+ * shared memory barriers
+ * ===========================================================================
+ */
+
+/**
+ * @brief tournament barrier with statically determined winners
+ *
+ * In round k, node i with bit k set loses against node i - 2^k and waits to
+ * be woken up. The winner of the last round wakes up the nodes it beat, in
+ * reverse order, which in turn wake up the nodes they beat.
+ */
+static void smlt_barrier_tournament(struct smlt_barrier *bar, uint32_t rank)
+{
+    struct smlt_barrier_slot *self = &bar->slots[rank];
+    uint64_t epoch = ++self->epoch;
+
+    uint32_t k = 0;
+    while ((1u << k) < bar->num_nodes) {
+        if (rank & (1u << k)) {
+            self->arrived = epoch;
+            while (self->wakeup < epoch) {
+                /* spin */
+            }
+            break;
+        }
+
+        uint32_t loser = rank + (1u << k);
+        if (loser < bar->num_nodes) {
+            while (bar->slots[loser].arrived < epoch) {
+                /* spin */
+            }
+        }
+        k++;
+    }
+
+    while (k-- > 0) {
+        uint32_t loser = rank + (1u << k);
+        if (loser < bar->num_nodes) {
+            bar->slots[loser].wakeup = epoch;
+        }
+    }
+}
+
+/**
+ * @brief combining tree barrier
+ *
+ * The last node to arrive at a counter resets it and moves on to the parent
+ * counter. The last one to arrive at the root releases everybody.
+ */
+static void smlt_barrier_combining(struct smlt_barrier *bar, uint32_t rank)
+{
+    uint64_t epoch = bar->release + 1;
+
+    struct smlt_barrier_counter *c;
+    c = &bar->counters[rank / SMLT_BARRIER_COMBINING_FANIN];
+    while (c) {
+        if (__sync_add_and_fetch(&c->count, 1) != c->expected) {
+            break;
+        }
+
+        // nobody uses the counter again before the release
+        c->count = 0;
+
+        if (c->parent == NULL) {
+            bar->release = epoch;
+            return;
+        }
+        c = c->parent;
+    }
+
+    while (bar->release < epoch) {
+        /* spin */
+    }
+}
+
+/**
+ * @brief MCS tree barrier
+ *
+ * Nodes arrive on a 4-ary tree: every child sets its byte in the word of its
+ * parent, so the parent spins on a single word. The wakeup uses a binary
+ * tree where every node spins on its own flag.
+ */
+static void smlt_barrier_mcs(struct smlt_barrier *bar, uint32_t rank)
+{
+    const uint32_t fanin = SMLT_BARRIER_MCS_FANIN;
+    struct smlt_barrier_slot *self = &bar->slots[rank];
+    uint64_t epoch = ++self->epoch;
+
+    // a node is at most one epoch ahead, the low byte is enough
+    union {
+        uint8_t child[SMLT_BARRIER_MCS_FANIN];
+        uint32_t all;
+    } expected, mask;
+
+    for (uint32_t i = 0; i < fanin; i++) {
+        expected.child[i] = (uint8_t)epoch;
+        mask.child[i] = (fanin * rank + i + 1 < bar->num_nodes) ? 0xff : 0;
+    }
+
+    while ((self->ready.all ^ expected.all) & mask.all) {
+        /* spin */
+    }
+
+    if (rank != 0) {
+        uint32_t parent = (rank - 1) / fanin;
+        bar->slots[parent].ready.child[(rank - 1) % fanin] = (uint8_t)epoch;
+
+        while (self->wakeup < epoch) {
+            /* spin */
+        }
+    }
+
+    for (uint32_t i = 2 * rank + 1; i <= 2 * rank + 2; i++) {
+        if (i < bar->num_nodes) {
+            bar->slots[i].wakeup = epoch;
+        }
+    }
+}
+
+/*
+ * ===========================================================================
+ * barrier
+ * ===========================================================================
+ */
+
+/**
+ * @brief waits until all nodes of the context entered the barrier
+ *
+ * @param bar   the barrier
+ *
+ * @returns SMLT_SUCCESS or SMLT_ERR_INVAL if the node is not in the context
+ */
+errval_t smlt_barrier_enter(struct smlt_barrier *bar)
+{
+    uint32_t rank = smlt_context_get_rank(bar->ctx);
+    if (rank == SMLT_CONTEXT_RANK_NONE) {
+        return SMLT_ERR_INVAL;
+    }
+
+    switch (bar->type) {
+    case SMLT_BARRIER_TREE:
+        return smlt_barrier_wait(bar->ctx);
+    case SMLT_BARRIER_DISSEMINATION:
+        return smlt_dissem_barrier_wait(bar->dissem);
+    case SMLT_BARRIER_TOURNAMENT:
+        smlt_barrier_tournament(bar, rank);
+        break;
+    case SMLT_BARRIER_COMBINING:
+        smlt_barrier_combining(bar, rank);
+        break;
+    case SMLT_BARRIER_MCS:
+        smlt_barrier_mcs(bar, rank);
+        break;
+    default:
+        return SMLT_ERR_INVAL;
+    }
+
+    return SMLT_SUCCESS;
+}
@@ -26,9 +26,29 @@ cycles_t smlt_bench_tsc_overhead = 0;
                               char *label,
                               uint32_t num_measurements)
 {
+    ctl->data = (cycles_t *)smlt_platform_alloc(num_measurements * sizeof(cycles_t),
+                                                SMLT_DEFAULT_ALIGNMENT, true);
+    if (ctl->data == NULL) {
+        return SMLT_ERR_MALLOC_FAIL;
+    }
+
+    ctl->max_data = num_measurements;
+    ctl->label = label;
+
+    smlt_bench_ctl_reset(ctl);
+
     return SMLT_SUCCESS;
 }
 
+void smlt_bench_ctl_destroy(struct smlt_bench_ctl *ctl)
+{
+    if (ctl->data) {
+        smlt_platform_free(ctl->data);
+    }
+    ctl->data = NULL;
+    ctl->max_data = 0;
+}
+
 void smlt_bench_ctl_reset(struct smlt_bench_ctl *ctl)
 {
     memset(&ctl->a, 0, sizeof(ctl->a));
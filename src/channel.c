@@ -7,6 +7,7 @@
  * ETH Zurich D-INFK, Universitaetstr. 6, CH-8092 Zurich. Attn: Systems Group.
  */
 
+#include <smlt.h>
 #include <smlt_platform.h>
 #include <smlt_error.h>
 #include <smlt_queuepair.h>
@@ -24,17 +25,42 @@
   *
   * @param type     type of the channel (o2o o2m m2o m2m)
   * @param chan     return pointer to the channel
-  * @param src      src core id // TODO use nid ?
-  * @param dst      array of core ids to desinations
+  * @param src      src node id
+  * @param dst      array of node ids of the desinations
   * @param count    length of array dst;
   *
   * @returns SMLT_SUCCESS or failure
+  *
+  * The queues are placed on the NUMA nodes of the cores the nodes run on.
   */
 errval_t smlt_channel_create(struct smlt_channel **chan,
                              uint32_t* src,
                              uint32_t* dst,
                              uint16_t count_src,
                              uint16_t count_dst)
+{
+    return smlt_channel_create_flags(chan, src, dst, count_src, count_dst,
+                                     SMLT_CHANNEL_FLAG_NONE);
+}
+
+ /**
+  * @brief creates the queue pair with options
+  *
+  * @param chan     return pointer to the channel
+  * @param src      src node id
+  * @param dst      array of node ids of the desinations
+  * @param count_src    length of array src;
+  * @param count_dst    length of array dst;
+  * @param flags    SMLT_CHANNEL_FLAG_* options of the channel
+  *
+  * @returns SMLT_SUCCESS or failure
+  */
+errval_t smlt_channel_create_flags(struct smlt_channel **chan,
+                                   uint32_t* src,
+                                   uint32_t* dst,
+                                   uint16_t count_src,
+                                   uint16_t count_dst,
+                                   uint32_t flags)
 {
     uint32_t num_chan = (count_src > count_dst) ? count_src : count_dst;
 
@@ -54,6 +80,8 @@ errval_t smlt_channel_create(struct smlt_channel **chan,
     (*chan)->owner = src[0];
 
     errval_t err;
+    coreid_t src_core = smlt_get_core_by_id(src[0]);
+    coreid_t dst_core = smlt_get_core_by_id(dst[0]);
     if (count_dst == 1) {
         (*chan)->trg =   dst[0];
             // 1:1
@@ -70,7 +98,8 @@ errval_t smlt_channel_create(struct smlt_channel **chan,
             #endif
 
             err = smlt_queuepair_create(SMLT_QP_TYPE_UMP,
-                                    &(*chan)->c.mp.send, &(*chan)->c.mp.recv, src[0], dst[0]);
+                                    &(*chan)->c.mp.send, &(*chan)->c.mp.recv,
+                                    src_core, dst_core);
             if (smlt_err_is_fail(err)) {
                 return smlt_err_push(err, SMLT_ERR_CHAN_CREATE);
             }
@@ -78,7 +107,8 @@ errval_t smlt_channel_create(struct smlt_channel **chan,
         // 1:n
         (*chan)->use_shm = true;
         struct swmr_queue* send = &((*chan)->c.shm.send_owner);
-        swmr_queue_create(&send, src[0], dst, num_chan, false);
+        swmr_queue_create(&send, src_core, &dst_core, num_chan,
+                          !!(flags & SMLT_CHANNEL_FLAG_SEP_HEADER));
 
         ((*chan)->c.shm.dst) = (uint32_t*) smlt_platform_alloc(sizeof(uint32_t)*
                                             count_dst, SMLT_DEFAULT_ALIGNMENT, true);
@@ -99,7 +129,7 @@ errval_t smlt_channel_create(struct smlt_channel **chan,
             err = smlt_queuepair_create(SMLT_QP_TYPE_UMP,
                                         &((*chan)->c.shm.recv[i]),
                                         &((*chan)->c.shm.recv_owner[i]),
-                                        src[0], dst[i]);
+                                        src_core, smlt_get_core_by_id(dst[i]));
             if (smlt_err_is_fail(err)) {
                 return smlt_err_push(err, SMLT_ERR_CHAN_CREATE);
             }
@@ -109,25 +139,46 @@ errval_t smlt_channel_create(struct smlt_channel **chan,
 }
 
  /**
-  * @brief destroys the channel
+  * @brief destroys the channel and frees its queues
   *
-  * @param
+  * @param chan     the channel to destroy
   *
-  * @returns 0
+  * @returns SMLT_SUCCESS or failure
   */
 errval_t smlt_channel_destroy(struct smlt_channel *chan)
 {
     uint32_t num_chan = (chan->m > chan->n) ? chan->m : chan->n;
 
     errval_t err;
-    // TODO adapt to SWMR
+    if (!chan->use_shm) {
+        err = smlt_queuepair_destroy(chan->c.mp.send);
+        if (smlt_err_is_fail(err)) {
+            return smlt_err_push(err, SMLT_ERR_CHAN_DESTROY);
+        }
+        err = smlt_queuepair_destroy(chan->c.mp.recv);
+        if (smlt_err_is_fail(err)) {
+            return smlt_err_push(err, SMLT_ERR_CHAN_DESTROY);
+        }
+        smlt_platform_free(chan->c.mp.send);
+        smlt_platform_free(chan->c.mp.recv);
+        return SMLT_SUCCESS;
+    }
+
     for (unsigned int i = 0; i < num_chan; i++) {
-            err = smlt_queuepair_destroy(&chan->c.mp.send[i]);
-            if (smlt_err_is_fail(err)) {
-                return smlt_err_push(err, SMLT_ERR_CHAN_DESTROY);
-            }
-            smlt_platform_free(chan->c.mp.send);
-            smlt_platform_free(chan->c.mp.recv);
+        err = smlt_queuepair_destroy(chan->c.shm.recv[i]);
+        if (smlt_err_is_fail(err)) {
+            return smlt_err_push(err, SMLT_ERR_CHAN_DESTROY);
+        }
+        err = smlt_queuepair_destroy(chan->c.shm.recv_owner[i]);
+        if (smlt_err_is_fail(err)) {
+            return smlt_err_push(err, SMLT_ERR_CHAN_DESTROY);
+        }
+        smlt_platform_free(chan->c.shm.recv[i]);
+        smlt_platform_free(chan->c.shm.recv_owner[i]);
     }
+    smlt_platform_free(chan->c.shm.recv);
+    smlt_platform_free(chan->c.shm.recv_owner);
+    smlt_platform_free(chan->c.shm.dst);
+    swmr_queue_destroy(&chan->c.shm.send_owner);
     return SMLT_SUCCESS;
 }
@@ -0,0 +1,522 @@
+/*
+ * Copyright (c) 2016 ETH Zurich.
+ * All rights reserved.
+ *
+ * This file is distributed under the terms in the attached LICENSE file.
+ * If you do not find this file, copies can be found by writing to:
+ * ETH Zurich D-INFK, Universitaetstr. 6, CH-8092 Zurich. Attn: Systems Group.
+ */
+#include <smlt.h>
+#include <smlt_channel.h>
+#include <smlt_context.h>
+#include <smlt_consensus.h>
+#include "smlt_debug.h"
+#include "internal.h"
+
+#include <string.h>
+
+/*
+ * ===========================================================================
+ * wire format
+ * ===========================================================================
+ *
+ * word 0: message type, flags and number of payload words
+ * word 1: log index
+ * word 2: payload (entries only)
+ */
+
+#define SMLT_CONSENSUS_MSG_WORDS (SMLT_CONSENSUS_PAYLOAD_WORDS + 2)
+
+#define SMLT_CONSENSUS_TYPE_ENTRY  1   ///< a log entry, down the tree
+#define SMLT_CONSENSUS_TYPE_COMMIT 2   ///< the commit index, down the tree
+#define SMLT_CONSENSUS_TYPE_STOP   3   ///< shutdown, down the tree
+#define SMLT_CONSENSUS_TYPE_ACK    4   ///< the subtree stored the log, up
+
+#define SMLT_CONSENSUS_FLAG_LAST   1   ///< the last entry of a batch
+
+#define SMLT_CONSENSUS_HDR(_type, _flags, _words) \
+    (((uint64_t)(_type) << 56) | ((uint64_t)(_flags) << 48) | (uint64_t)(_words))
+
+#define SMLT_CONSENSUS_HDR_TYPE(_hdr)  ((uint32_t)((_hdr) >> 56))
+#define SMLT_CONSENSUS_HDR_FLAGS(_hdr) ((uint32_t)(((_hdr) >> 48) & 0xff))
+#define SMLT_CONSENSUS_HDR_WORDS(_hdr) ((uint32_t)((_hdr) & 0xff))
+
+/*
+ * ===========================================================================
+ * type definitions
+ * ===========================================================================
+ */
+
+typedef smlt_msg_payload_t smlt_consensus_entry_t[SMLT_CONSENSUS_MSG_WORDS];
+
+/**
+ * per node state of the replicated log
+ */
+struct smlt_consensus
+{
+    smlt_consensus_apply_fn_t apply;    ///< called for committed entries
+    void *arg;                          ///< argument of the apply function
+    bool stopped;                       ///< the leader shut the log down
+
+    struct smlt_channel *parent;        ///< channel to the parent, NULL if leader
+    uint32_t parent_idx;                ///< index on a shared memory parent
+    struct smlt_channel *children;      ///< channels to the children
+    uint32_t num_children;              ///< number of child channels
+    uint32_t num_queues;                ///< number of queues from the children
+    struct smlt_qp **queues;            ///< queues from the children
+    uint64_t *acked;                    ///< acknowledged index per queue
+
+    uint32_t batch_size;                ///< entries per batch
+    uint32_t batch_len;                 ///< entries of the unsent batch
+    uint32_t window;                    ///< capacity of the log
+    smlt_consensus_entry_t *log;        ///< ring buffer of the log
+
+    uint64_t last_idx;                  ///< last entry in the log
+    uint64_t stored_idx;                ///< last entry of a complete batch
+    uint64_t ack_idx;                   ///< last index acknowledged upwards
+    uint64_t applied_idx;               ///< last applied entry
+};
+
+/*
+ * ===========================================================================
+ * creation and destruction
+ * ===========================================================================
+ */
+
+/**
+ * @brief creates the replicated log state of the calling node
+ *
+ * @param ctx           the Smelt context to replicate on
+ * @param batch_size    number of entries the leader sends per batch
+ * @param window        maximum number of uncommitted entries
+ * @param apply         function called for every committed entry
+ * @param arg           argument passed to the apply function
+ * @param ret           returns the replicated log
+ *
+ * @returns SMLT_SUCCESS, SMLT_ERR_INVAL if the sizes are not valid
+ *          or SMLT_ERR_MALLOC_FAIL
+ */
+errval_t smlt_consensus_create(struct smlt_context *ctx, uint32_t batch_size,
+                               uint32_t window,
+                               smlt_consensus_apply_fn_t apply, void *arg,
+                               struct smlt_consensus **ret)
+{
+    errval_t err;
+    struct smlt_context_links l;
+
+    if (batch_size == 0 || window < batch_size) {
+        return SMLT_ERR_INVAL;
+    }
+
+    err = smlt_context_get_links(ctx, &l);
+    if (smlt_err_is_fail(err)) {
+        return err;
+    }
+
+    size_t size = sizeof(struct smlt_consensus)
+                  + window * sizeof(smlt_consensus_entry_t)
+                  + l.num_queues * (sizeof(uint64_t) + sizeof(struct smlt_qp *));
+
+    struct smlt_consensus *cons = (struct smlt_consensus *)
+        smlt_platform_alloc(size, SMLT_ARCH_CACHELINE_SIZE, true);
+    if (cons == NULL) {
+        return SMLT_ERR_MALLOC_FAIL;
+    }
+
+    cons->apply = apply;
+    cons->arg = arg;
+    cons->parent = l.parent;
+    cons->parent_idx = l.parent_idx;
+    cons->children = l.children;
+    cons->num_children = l.num_children;
+    cons->num_queues = l.num_queues;
+    cons->batch_size = batch_size;
+    cons->window = window;
+    cons->log = (smlt_consensus_entry_t *)(cons + 1);
+    cons->acked = (uint64_t *)(cons->log + window);
+    cons->queues = (struct smlt_qp **)(cons->acked + l.num_queues);
+
+    smlt_context_get_child_queues(&l, cons->queues);
+
+    *ret = cons;
+
+    return SMLT_SUCCESS;
+}
+
+/**
+ * @brief destroys the replicated log state of the calling node
+ *
+ * @param cons  the replicated log
+ *
+ * @returns SMLT_SUCCESS
+ */
+errval_t smlt_consensus_destroy(struct smlt_consensus *cons)
+{
+    smlt_platform_free(cons);
+
+    return SMLT_SUCCESS;
+}
+
+/*
+ * ===========================================================================
+ * helpers
+ * ===========================================================================
+ */
+
+static inline errval_t smlt_consensus_send(struct smlt_channel *chan,
+                                           smlt_msg_payload_t *buf)
+{
+    struct smlt_msg raw = {
+        .words = 2 + SMLT_CONSENSUS_HDR_WORDS(buf[0]),
+        .bufsize = sizeof(smlt_consensus_entry_t),
+        .data = buf
+    };
+
+    return smlt_channel_send(chan, &raw);
+}
+
+static errval_t smlt_consensus_send_children(struct smlt_consensus *cons,
+                                             smlt_msg_payload_t *buf)
+{
+    errval_t err;
+
+    for (uint32_t i = 0; i < cons->num_children; i++) {
+        err = smlt_consensus_send(&cons->children[i], buf);
+        if (smlt_err_is_fail(err)) {
+            return err;
+        }
+    }
+
+    return SMLT_SUCCESS;
+}
+
+/**
+ * @brief applies the entries up to the commit index
+ */
+static void smlt_consensus_apply(struct smlt_consensus *cons, uint64_t commit)
+{
+    while (cons->applied_idx < commit) {
+        uint64_t idx = ++cons->applied_idx;
+        smlt_msg_payload_t *e = cons->log[idx % cons->window];
+
+        if (cons->apply) {
+            struct smlt_msg cmd = {
+                .words = SMLT_CONSENSUS_HDR_WORDS(e[0]),
+                .bufsize = SMLT_CONSENSUS_PAYLOAD_WORDS * sizeof(smlt_msg_payload_t),
+                .data = &e[2]
+            };
+            cons->apply(idx, &cmd, cons->arg);
+        }
+    }
+}
+
+/**
+ * @brief acknowledges what the whole subtree stored
+ *
+ * Acknowledgements are cumulative, so one that cannot be sent right away
+ * is simply retried on the next poll. Hence, nodes never block sending up
+ * the tree, which would deadlock with the leader sending down.
+ */
+static errval_t smlt_consensus_update_ack(struct smlt_consensus *cons)
+{
+    uint64_t idx = cons->stored_idx;
+    for (uint32_t i = 0; i < cons->num_queues; i++) {
+        if (cons->acked[i] < idx) {
+            idx = cons->acked[i];
+        }
+    }
+
+    if (idx <= cons->ack_idx) {
+        return SMLT_SUCCESS;
+    }
+
+    smlt_consensus_entry_t buf;
+
+    if (cons->parent == NULL) {
+        // the leader: the entries are stored on all nodes
+        cons->ack_idx = idx;
+
+        buf[0] = SMLT_CONSENSUS_HDR(SMLT_CONSENSUS_TYPE_COMMIT, 0, 0);
+        buf[1] = idx;
+        smlt_consensus_apply(cons, idx);
+
+        return smlt_consensus_send_children(cons, buf);
+    }
+
+    if (!smlt_channel_can_send(cons->parent)) {
+        return SMLT_SUCCESS;
+    }
+
+    cons->ack_idx = idx;
+
+    buf[0] = SMLT_CONSENSUS_HDR(SMLT_CONSENSUS_TYPE_ACK, 0, 0);
+    buf[1] = idx;
+
+    return smlt_consensus_send(cons->parent, buf);
+}
+
+/**
+ * @brief handles a message from the parent
+ */
+static errval_t smlt_consensus_handle(struct smlt_consensus *cons,
+                                      smlt_msg_payload_t *buf)
+{
+    errval_t err;
+
+    err = smlt_consensus_send_children(cons, buf);
+    if (smlt_err_is_fail(err)) {
+        return err;
+    }
+
+    switch(SMLT_CONSENSUS_HDR_TYPE(buf[0])) {
+    case SMLT_CONSENSUS_TYPE_ENTRY :
+        COND_PANIC(buf[1] == cons->last_idx + 1, "log entry out of order");
+        cons->last_idx = buf[1];
+        memcpy(cons->log[buf[1] % cons->window], buf,
+               sizeof(smlt_consensus_entry_t));
+        if (SMLT_CONSENSUS_HDR_FLAGS(buf[0]) & SMLT_CONSENSUS_FLAG_LAST) {
+            cons->stored_idx = buf[1];
+        }
+        break;
+    case SMLT_CONSENSUS_TYPE_COMMIT :
+        smlt_consensus_apply(cons, buf[1]);
+        break;
+    case SMLT_CONSENSUS_TYPE_STOP :
+        cons->stopped = true;
+        break;
+    default:
+        SMLT_WARNING("unknown consensus message type %u\n",
+                     SMLT_CONSENSUS_HDR_TYPE(buf[0]));
+        break;
+    }
+
+    return SMLT_SUCCESS;
+}
+
+/*
+ * ===========================================================================
+ * replica functions
+ * ===========================================================================
+ */
+
+/**
+ * @brief processes the pending messages without blocking
+ *
+ * @param cons  the replicated log
+ *
+ * @returns SMLT_SUCCESS
+ */
+errval_t smlt_consensus_poll(struct smlt_consensus *cons)
+{
+    errval_t err;
+    smlt_consensus_entry_t buf;
+    struct smlt_msg raw = {
+        .words = SMLT_CONSENSUS_MSG_WORDS,
+        .bufsize = sizeof(buf),
+        .data = buf
+    };
+
+    if (cons->parent) {
+        while (!cons->stopped &&
+               smlt_channel_can_recv_index(cons->parent, cons->parent_idx)) {
+            raw.words = SMLT_CONSENSUS_MSG_WORDS;
+            err = smlt_channel_recv_index(cons->parent, &raw, cons->parent_idx);
+            if (smlt_err_is_fail(err)) {
+                return err;
+            }
+
+            err = smlt_consensus_handle(cons, buf);
+            if (smlt_err_is_fail(err)) {
+                return err;
+            }
+        }
+    }
+
+    for (uint32_t i = 0; i < cons->num_queues; i++) {
+        while (smlt_queuepair_can_recv(cons->queues[i])) {
+            raw.words = SMLT_CONSENSUS_MSG_WORDS;
+            err = smlt_queuepair_recv(cons->queues[i], &raw);
+            if (smlt_err_is_fail(err)) {
+                return err;
+            }
+
+            if (SMLT_CONSENSUS_HDR_TYPE(buf[0]) == SMLT_CONSENSUS_TYPE_ACK &&
+                buf[1] > cons->acked[i]) {
+                cons->acked[i] = buf[1];
+            }
+        }
+    }
+
+    return smlt_consensus_update_ack(cons);
+}
+
+/**
+ * @brief replicates the log until the leader shuts it down
+ *
+ * @param cons  the replicated log
+ *
+ * @returns SMLT_SUCCESS or SMLT_ERR_INVAL if the node is the leader
+ */
+errval_t smlt_consensus_run(struct smlt_consensus *cons)
+{
+    errval_t err;
+
+    if (cons->parent == NULL) {
+        return SMLT_ERR_INVAL;
+    }
+
+    while (!cons->stopped) {
+        err = smlt_consensus_poll(cons);
+        if (smlt_err_is_fail(err)) {
+            return err;
+        }
+    }
+
+    return SMLT_SUCCESS;
+}
+
+/**
+ * @brief obtains the index of the last applied entry
+ *
+ * @param cons  the replicated log
+ *
+ * @returns the index of the last applied entry, 0 if there is none
+ */
+uint64_t smlt_consensus_get_applied(struct smlt_consensus *cons)
+{
+    return cons->applied_idx;
+}
+
+/*
+ * ===========================================================================
+ * leader functions
+ * ===========================================================================
+ */
+
+/**
+ * @brief appends a command to the log
+ *
+ * @param cons  the replicated log
+ * @param cmd   the command to append
+ *
+ * @returns SMLT_SUCCESS, SMLT_ERR_INVAL if the command is too large or
+ *          the calling node is not the leader
+ */
+errval_t smlt_consensus_propose(struct smlt_consensus *cons,
+                                struct smlt_msg *cmd)
+{
+    errval_t err;
+
+    if (cons->parent || cmd->words > SMLT_CONSENSUS_PAYLOAD_WORDS) {
+        return SMLT_ERR_INVAL;
+    }
+
+    // the slot of the new entry must have been applied
+    while (cons->last_idx + 1 - cons->applied_idx > cons->window) {
+        err = smlt_consensus_poll(cons);
+        if (smlt_err_is_fail(err)) {
+            return err;
+        }
+    }
+
+    uint64_t idx = ++cons->last_idx;
+    smlt_msg_payload_t *e = cons->log[idx % cons->window];
+    e[0] = SMLT_CONSENSUS_HDR(SMLT_CONSENSUS_TYPE_ENTRY, 0, cmd->words);
+    e[1] = idx;
+    memcpy(&e[2], cmd->data, cmd->words * sizeof(smlt_msg_payload_t));
+
+    if (++cons->batch_len == cons->batch_size) {
+        return smlt_consensus_flush(cons);
+    }
+
+    return SMLT_SUCCESS;
+}
+
+/**
+ * @brief sends the current, possibly partial, batch
+ *
+ * @param cons  the replicated log
+ *
+ * @returns SMLT_SUCCESS or SMLT_ERR_INVAL if the node is not the leader
+ */
+errval_t smlt_consensus_flush(struct smlt_consensus *cons)
+{
+    errval_t err;
+
+    if (cons->parent) {
+        return SMLT_ERR_INVAL;
+    }
+
+    if (cons->batch_len == 0) {
+        return smlt_consensus_poll(cons);
+    }
+
+    uint64_t first = cons->last_idx - cons->batch_len + 1;
+    for (uint64_t idx = first; idx <= cons->last_idx; idx++) {
+        smlt_msg_payload_t *e = cons->log[idx % cons->window];
+        if (idx == cons->last_idx) {
+            e[0] |= SMLT_CONSENSUS_HDR(0, SMLT_CONSENSUS_FLAG_LAST, 0);
+        }
+
+        err = smlt_consensus_send_children(cons, e);
+        if (smlt_err_is_fail(err)) {
+            return err;
+        }
+    }
+
+    cons->batch_len = 0;
+    cons->stored_idx = cons->last_idx;
+
+    return smlt_consensus_poll(cons);
+}
+
+/**
+ * @brief flushes the batch and waits until all entries are committed
+ *
+ * @param cons  the replicated log
+ *
+ * @returns SMLT_SUCCESS or SMLT_ERR_INVAL if the node is not the leader
+ */
+errval_t smlt_consensus_sync(struct smlt_consensus *cons)
+{
+    errval_t err;
+
+    err = smlt_consensus_flush(cons);
+    if (smlt_err_is_fail(err)) {
+        return err;
+    }
+
+    while (cons->applied_idx < cons->last_idx) {
+        err = smlt_consensus_poll(cons);
+        if (smlt_err_is_fail(err)) {
+            return err;
+        }
+    }
+
+    return SMLT_SUCCESS;
+}
+
+/**
+ * @brief commits all entries and stops the replicas
+ *
+ * @param cons  the replicated log
+ *
+ * @returns SMLT_SUCCESS or SMLT_ERR_INVAL if the node is not the leader
+ */
+errval_t smlt_consensus_shutdown(struct smlt_consensus *cons)
+{
+    errval_t err;
+
+    err = smlt_consensus_sync(cons);
+    if (smlt_err_is_fail(err)) {
+        return err;
+    }
+
+    smlt_consensus_entry_t buf;
+    buf[0] = SMLT_CONSENSUS_HDR(SMLT_CONSENSUS_TYPE_STOP, 0, 0);
+    buf[1] = cons->last_idx;
+
+    cons->stopped = true;
+
+    return smlt_consensus_send_children(cons, buf);
+}
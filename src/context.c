@@ -9,11 +9,18 @@
 
 #include <smlt.h>
 #include <smlt_topology.h>
+#include <smlt_generator.h>
 #include <smlt_context.h>
 #include <smlt_channel.h>
+#include <smlt_reduction.h>
+#include <smlt_broadcast.h>
+#include <smlt_barrier.h>
+#include <smlt_tune.h>
 #include "smlt_debug.h"
+#include "internal.h"
 
 #include <stdio.h>
+#include <stdlib.h>
 
 #define SMLT_CONTEXT_NAME_MAX 16
 
@@ -31,6 +38,20 @@ struct smlt_context_node
     struct smlt_channel *children;
     uint32_t num_children;
     uint32_t index;
+
+    /* state of smlt_context_split() */
+    uint32_t split_color;
+    uint32_t split_key;
+    struct smlt_context *split_ctx;
+
+    /* state of the tagged collectives, created on first use */
+    struct smlt_tag_state *tag_state;
+
+    /* state of the atomic broadcast, created on first use */
+    struct smlt_abcast_state *abcast_state;
+
+    /* state of the split barrier, created on first use */
+    struct smlt_barrier_state *barrier_state;
 };
 
 /**
@@ -39,6 +60,7 @@ struct smlt_context_node
 struct smlt_context
 {
     struct smlt_topology *topology;
+    bool owns_topology;                 ///< destroy the topology with the context
     char name[SMLT_CONTEXT_NAME_MAX];
     uint32_t num_nodes;
     smlt_nid_t max_nid;
@@ -47,6 +69,27 @@ struct smlt_context
 };
 
 
+/**
+ * per node state of a context set, padded to avoid false sharing
+ */
+struct smlt_context_set_node
+{
+    uint32_t active;        ///< index of the context the node currently uses
+    uint8_t pad[SMLT_ARCH_CACHELINE_SIZE - sizeof(uint32_t)];
+};
+
+/**
+ * a set of prepared contexts over the same nodes
+ */
+struct smlt_context_set
+{
+    uint32_t num_contexts;
+    struct smlt_context **contexts;
+    smlt_nid_t max_nid;
+    struct smlt_context_set_node *nodes;    ///< indexed by node id
+};
+
+
 /*
  * ===========================================================================
  * Smelt context creation
@@ -54,17 +97,48 @@ struct smlt_context
  */
 
 
+/**
+ * @brief looks up a message passing channel of another context
+ *
+ * @param ctx   the context to search, may be NULL
+ * @param src   node id of the sending end
+ * @param dst   node id of the receiving end
+ *
+ * @return the channel from src to dst or NULL if there is none
+ */
+static struct smlt_channel *smlt_context_find_channel(struct smlt_context *ctx,
+                                                      smlt_nid_t src,
+                                                      smlt_nid_t dst)
+{
+    if (ctx == NULL || src > ctx->max_nid || ctx->nid_to_node[src] == NULL) {
+        return NULL;
+    }
+
+    struct smlt_context_node *n = ctx->nid_to_node[src];
+    for (uint32_t i = 0; i < n->num_children; i++) {
+        struct smlt_channel *chan = &n->children[i];
+        if (!chan->use_shm && chan->owner == src && chan->trg == dst) {
+            return chan;
+        }
+    }
+
+    return NULL;
+}
+
 /**
  * @brief creates a new smelt context from the topology
  *
  * @param topo      Smelt topology to create the context from
+ * @param reuse     context whose message passing channels are reused for
+ *                  matching edges, or NULL
  * @param ret_ctx   returns the new Smelt context
  *
  * @return  SMLT_ERR_MALLOC_FAIL
  *          SMLT_SUCCESS
  */
-errval_t smlt_context_create(struct smlt_topology *topo,
-                             struct smlt_context **ret_ctx)
+static errval_t smlt_context_create_reuse(struct smlt_topology *topo,
+                                          struct smlt_context *reuse,
+                                          struct smlt_context **ret_ctx)
 {
 
     struct smlt_context *ctx;
@@ -81,6 +155,7 @@ errval_t smlt_context_create(struct smlt_topology *topo,
     if (ctx == NULL) {
         return SMLT_ERR_MALLOC_FAIL;
     }
+    ctx->topology = topo;
     ctx->num_nodes = num_nodes;
     ctx->max_nid = 0;
     /* loop over the nodes and allocate resources */
@@ -116,8 +191,15 @@ errval_t smlt_context_create(struct smlt_topology *topo,
                 uint32_t dst = smlt_topology_node_get_id(children[i]);
                 uint32_t src = smlt_topology_node_get_id(tn);
                 struct smlt_channel * chan = &(n->children[i]);
-                smlt_channel_create(&chan, &src,
-                                    &dst, 1, 1);
+                struct smlt_channel *other = smlt_context_find_channel(reuse,
+                                                                       src, dst);
+                if (other) {
+                    *chan = *other;
+                    chan->borrowed = true;
+                } else {
+                    smlt_channel_create(&chan, &src,
+                                        &dst, 1, 1);
+                }
             }
         }
 
@@ -192,7 +274,7 @@ errval_t smlt_context_create(struct smlt_topology *topo,
             uint32_t num_children;
             children = smlt_topology_node_children_shm(tp, &num_children);
             for (unsigned j = 0; j < num_children; j++) {
-                if (smlt_topology_node_get_id(children[j]) == i) {
+                if (smlt_topology_node_get_id(children[j]) == current_nid) {
                     child_use_shm = true;
                 }
             }
@@ -214,17 +296,154 @@ errval_t smlt_context_create(struct smlt_topology *topo,
     return SMLT_SUCCESS;
 }
 
+/**
+ * @brief creates a new smelt context from the topology
+ *
+ * @param topo      Smelt topology to create the context from
+ * @param ret_ctx   returns the new Smelt context
+ *
+ * @return  SMLT_ERR_MALLOC_FAIL
+ *          SMLT_SUCCESS
+ */
+errval_t smlt_context_create(struct smlt_topology *topo,
+                             struct smlt_context **ret_ctx)
+{
+    return smlt_context_create_reuse(topo, NULL, ret_ctx);
+}
+
+/**
+ * @brief creates a context spanning the nodes on the given cores
+ *
+ * @param cores     the cores, cores[0] becomes the root
+ * @param len       length of the cores array
+ * @param name      name of the tree topology, NULL for SMLT_TOPO
+ * @param reuse     context whose channels are reused, or NULL
+ * @param ret_ctx   returns the new Smelt context
+ *
+ * @return SMLT_SUCCESS or error value
+ *
+ * If the Simulator cannot provide the topology, then a NUMA-aware cluster
+ * tree is built instead.
+ */
+static errval_t smlt_context_create_sub(coreid_t *cores, uint32_t len,
+                                        const char *name,
+                                        struct smlt_context *reuse,
+                                        struct smlt_context **ret_ctx)
+{
+    errval_t err;
+    struct smlt_topology *topo;
+    struct smlt_sparse_model *sparse;
+    char tuned[SMLT_TUNE_NAMELEN];
+
+    if (name == NULL && getenv("SMLT_TOPO") == NULL &&
+        smlt_err_is_ok(smlt_tune_get_topology(cores, len, tuned,
+                                              sizeof(tuned)))) {
+        SMLT_DEBUG(SMLT_DBG__INIT, "using tuned topology %s\n", tuned);
+        name = tuned;
+    }
+
+    if (smlt_generator_is_builtin(name)) {
+        err = smlt_generate_builtin_sparse_model(name, cores, len, &sparse);
+    } else {
+        err = smlt_generate_sparse_model(cores, len, name, &sparse);
+        if (smlt_err_is_fail(err)) {
+            SMLT_DEBUG(SMLT_DBG__INIT, "no model for %s, using cluster tree\n",
+                       name ? name : "SMLT_TOPO");
+            err = smlt_generate_builtin_sparse_model(SMLT_TOPO_CLUSTER, cores,
+                                                     len, &sparse);
+        }
+    }
+
+    if (smlt_err_is_fail(err)) {
+        return err;
+    }
+
+    err = smlt_topology_create_sparse(sparse, name, &topo);
+    smlt_sparse_model_destroy(sparse);
+    if (smlt_err_is_fail(err)) {
+        return err;
+    }
+
+    err = smlt_context_create_reuse(topo, reuse, ret_ctx);
+    if (smlt_err_is_fail(err)) {
+        smlt_topology_destroy(topo);
+        return err;
+    }
+
+    (*ret_ctx)->owns_topology = true;
+
+    return SMLT_SUCCESS;
+}
+
+/**
+ * @brief creates a new smelt context over a set of cores
+ *
+ * @param cores     the cores of the context, cores[0] becomes the root
+ * @param len       length of the cores array
+ * @param name      name of the tree topology, NULL for SMLT_TOPO
+ * @param ret_ctx   returns the new Smelt context
+ *
+ * @return  SMLT_ERR_INVAL if no node runs on one of the cores
+ *          SMLT_ERR_MALLOC_FAIL
+ *          SMLT_SUCCESS
+ */
+errval_t smlt_context_create_from_cores(coreid_t *cores, uint32_t len,
+                                        const char *name,
+                                        struct smlt_context **ret_ctx)
+{
+    if (cores == NULL || len == 0) {
+        return SMLT_ERR_INVAL;
+    }
+
+    for (uint32_t i = 0; i < len; i++) {
+        if (smlt_get_id_by_core(cores[i]) == SMLT_NID_INVALID) {
+            return SMLT_ERR_INVAL;
+        }
+    }
+
+    return smlt_context_create_sub(cores, len, name, NULL, ret_ctx);
+}
+
 /**
  * @brief destroys the Smelt context and frees its resources
  *
  * @param ctx   Smelt context to destroy
  *
  * @return  SMLT_SUCCESS
+ *
+ * Channels reused from another context by smlt_context_split() are left to
+ * that context, hence contexts obtained from a split have to be destroyed
+ * before the context they were split from.
  */
 errval_t smlt_context_destroy(struct smlt_context *ctx)
 {
     for (uint32_t i = 0; i < ctx->num_nodes; ++i) {
-        /* TODO: create the bindings */
+        struct smlt_context_node *n = &ctx->all_nodes[i];
+        if (n->children) {
+            for (uint32_t c = 0; c < n->num_children; c++) {
+                if (!n->children[c].borrowed) {
+                    smlt_channel_destroy(&n->children[c]);
+                }
+            }
+            smlt_platform_free(n->children);
+        }
+        if (ctx->all_nodes[i].tag_state) {
+            smlt_tag_state_destroy(ctx->all_nodes[i].tag_state);
+        }
+        if (ctx->all_nodes[i].abcast_state) {
+            smlt_abcast_state_destroy(ctx->all_nodes[i].abcast_state);
+        }
+        if (ctx->all_nodes[i].barrier_state) {
+            smlt_barrier_state_destroy(ctx->all_nodes[i].barrier_state);
+        }
+    }
+
+    if (ctx->nid_to_node) {
+        smlt_platform_free(ctx->nid_to_node);
+    }
+
+    if (ctx->owns_topology) {
+        smlt_topology_destroy(ctx->topology);
     }
 
     smlt_platform_free(ctx);
@@ -232,6 +451,298 @@ errval_t smlt_context_destroy(struct smlt_context *ctx)
     return SMLT_SUCCESS;
 }
 
+/*
+ * ===========================================================================
+ * Splitting contexts
+ * ===========================================================================
+ */
+
+/**
+ * orders the nodes of a split by color, key and node id
+ */
+static int smlt_context_split_cmp(const void *a, const void *b)
+{
+    const struct smlt_context_node *x = *(struct smlt_context_node * const *)a;
+    const struct smlt_context_node *y = *(struct smlt_context_node * const *)b;
+
+    if (x->split_color != y->split_color) {
+        return (x->split_color < y->split_color) ? -1 : 1;
+    }
+    if (x->split_key != y->split_key) {
+        return (x->split_key < y->split_key) ? -1 : 1;
+    }
+    return (x->node_id < y->node_id) ? -1 : (x->node_id > y->node_id);
+}
+
+/**
+ * @brief creates the contexts of all colors, executed by the root
+ *
+ * @param ctx   the context to split
+ *
+ * @return SMLT_SUCCESS or error value
+ */
+static errval_t smlt_context_split_build(struct smlt_context *ctx)
+{
+    errval_t err = SMLT_SUCCESS;
+
+    struct smlt_context_node **members = (struct smlt_context_node **)
+        smlt_platform_alloc(ctx->num_nodes * sizeof(void *),
+                            SMLT_DEFAULT_ALIGNMENT, true);
+    coreid_t *cores = (coreid_t *)
+        smlt_platform_alloc(ctx->num_nodes * sizeof(coreid_t),
+                            SMLT_DEFAULT_ALIGNMENT, true);
+    if (members == NULL || cores == NULL) {
+        panic("Failed to allocate memory for the split");
+    }
+
+    uint32_t num_members = 0;
+    for (uint32_t i = 0; i < ctx->num_nodes; i++) {
+        ctx->all_nodes[i].split_ctx = NULL;
+        if (ctx->all_nodes[i].split_color != SMLT_CONTEXT_SPLIT_UNDEFINED) {
+            members[num_members++] = &ctx->all_nodes[i];
+        }
+    }
+
+    qsort(members, num_members, sizeof(void *), smlt_context_split_cmp);
+
+    const char *name = smlt_topology_get_name(ctx->topology);
+
+    for (uint32_t i = 0; i < num_members && smlt_err_is_ok(err);) {
+        uint32_t len = 0;
+        uint32_t color = members[i]->split_color;
+        for (uint32_t j = i; j < num_members && members[j]->split_color == color;
+             j++) {
+            cores[len++] = smlt_get_core_by_id(members[j]->node_id);
+        }
+
+        struct smlt_context *sub;
+        err = smlt_context_create_sub(cores, len, name, ctx, &sub);
+        if (smlt_err_is_ok(err)) {
+            for (uint32_t j = i; j < i + len; j++) {
+                members[j]->split_ctx = sub;
+            }
+        }
+
+        i += len;
+    }
+
+    smlt_platform_free(cores);
+    smlt_platform_free(members);
+
+    return err;
+}
+
+/**
+ * @brief splits the context into disjoint sub-contexts
+ *
+ * @param ctx       the context to split
+ * @param color     nodes with the same color end up in the same context,
+ *                  SMLT_CONTEXT_SPLIT_UNDEFINED to not take part
+ * @param key       orders the nodes within the new context, the node with
+ *                  the lowest key becomes the root
+ * @param ret_ctx   returns the new context, NULL for SMLT_CONTEXT_SPLIT_UNDEFINED
+ *
+ * @return SMLT_SUCCESS or error value
+ *
+ * This has to be called by all nodes of the context. The new trees are built
+ * with the topology of ctx, message passing channels of ctx are reused for
+ * edges present in both trees.
+ */
+errval_t smlt_context_split(struct smlt_context *ctx, uint32_t color,
+                            uint32_t key, struct smlt_context **ret_ctx)
+{
+    errval_t err;
+
+    if (smlt_node_self_id > ctx->max_nid ||
+        ctx->nid_to_node[smlt_node_self_id] == NULL) {
+        return SMLT_ERR_NODE_INVALD;
+    }
+
+    struct smlt_context_node *n = ctx->nid_to_node[smlt_node_self_id];
+    n->split_color = color;
+    n->split_key = key;
+
+    err = smlt_reduce_notify(ctx);
+    if (smlt_err_is_fail(err)) {
+        return err;
+    }
+
+    if (smlt_context_is_root(ctx)) {
+        err = smlt_context_split_build(ctx);
+        if (smlt_err_is_fail(err)) {
+            SMLT_ERROR("failed to split the context\n");
+        }
+    }
+
+    err = smlt_broadcast_notify(ctx);
+    if (smlt_err_is_fail(err)) {
+        return err;
+    }
+
+    *ret_ctx = n->split_ctx;
+    if (color != SMLT_CONTEXT_SPLIT_UNDEFINED && *ret_ctx == NULL) {
+        return SMLT_ERR_INIT;
+    }
+
+    return SMLT_SUCCESS;
+}
+
+
+/*
+ * ===========================================================================
+ * Switching contexts
+ * ===========================================================================
+ */
+
+/**
+ * @brief creates a set of contexts to switch between at runtime
+ *
+ * @param contexts      the prepared contexts, contexts[0] is active initially
+ * @param num_contexts  number of contexts
+ * @param ret_set       returns the context set
+ *
+ * @return SMLT_ERR_INVAL if the contexts do not span the same nodes
+ *         SMLT_ERR_MALLOC_FAIL
+ *         SMLT_SUCCESS
+ */
+errval_t smlt_context_set_create(struct smlt_context **contexts,
+                                 uint32_t num_contexts,
+                                 struct smlt_context_set **ret_set)
+{
+    if (contexts == NULL || num_contexts == 0) {
+        return SMLT_ERR_INVAL;
+    }
+
+    struct smlt_context *first = contexts[0];
+    for (uint32_t i = 1; i < num_contexts; i++) {
+        struct smlt_context *ctx = contexts[i];
+        if (ctx->num_nodes != first->num_nodes) {
+            return SMLT_ERR_INVAL;
+        }
+        for (uint32_t j = 0; j < first->num_nodes; j++) {
+            smlt_nid_t nid = first->all_nodes[j].node_id;
+            if (nid > ctx->max_nid || ctx->nid_to_node[nid] == NULL) {
+                return SMLT_ERR_INVAL;
+            }
+        }
+    }
+
+    struct smlt_context_set *set = (struct smlt_context_set *)
+        smlt_platform_alloc(sizeof(*set), SMLT_ARCH_CACHELINE_SIZE, true);
+    if (set == NULL) {
+        return SMLT_ERR_MALLOC_FAIL;
+    }
+
+    set->contexts = (struct smlt_context **)
+        smlt_platform_alloc(num_contexts * sizeof(void *),
+                            SMLT_ARCH_CACHELINE_SIZE, true);
+    set->nodes = (struct smlt_context_set_node *)
+        smlt_platform_alloc((first->max_nid + 1) * sizeof(*set->nodes),
+                            SMLT_ARCH_CACHELINE_SIZE, true);
+    if (set->contexts == NULL || set->nodes == NULL) {
+        smlt_context_set_destroy(set);
+        return SMLT_ERR_MALLOC_FAIL;
+    }
+
+    for (uint32_t i = 0; i < num_contexts; i++) {
+        set->contexts[i] = contexts[i];
+    }
+    set->num_contexts = num_contexts;
+    set->max_nid = first->max_nid;
+
+    *ret_set = set;
+
+    return SMLT_SUCCESS;
+}
+
+/**
+ * @brief destroys the context set, but not its contexts
+ *
+ * @param set   the context set
+ *
+ * @return SMLT_SUCCESS
+ */
+errval_t smlt_context_set_destroy(struct smlt_context_set *set)
+{
+    if (set->contexts) {
+        smlt_platform_free(set->contexts);
+    }
+    if (set->nodes) {
+        smlt_platform_free(set->nodes);
+    }
+    smlt_platform_free(set);
+
+    return SMLT_SUCCESS;
+}
+
+/**
+ * @brief returns the context the current node uses
+ *
+ * @param set   the context set
+ *
+ * @return the active context or NULL if the node is not part of the set
+ */
+struct smlt_context *smlt_context_set_get_active(struct smlt_context_set *set)
+{
+    if (smlt_node_self_id > set->max_nid) {
+        return NULL;
+    }
+
+    struct smlt_context *ctx = set->contexts[set->nodes[smlt_node_self_id].active];
+    if (smlt_node_self_id > ctx->max_nid ||
+        ctx->nid_to_node[smlt_node_self_id] == NULL) {
+        return NULL;
+    }
+
+    return ctx;
+}
+
+/**
+ * @brief switches all nodes of the set to another prepared context
+ *
+ * @param set   the context set
+ * @param idx   index of the context to switch to
+ *
+ * @return SMLT_ERR_INVAL if there is no such context
+ *         SMLT_ERR_NODE_INVALD if the node is not part of the set
+ *         SMLT_SUCCESS
+ *
+ * This has to be called by all nodes of the set with the same index. A
+ * barrier on the active context ensures that every node has completed its
+ * collectives before the new one is used. Channels shared between the two
+ * contexts keep their order, so messages of the new context are received
+ * only after the barrier's.
+ */
+errval_t smlt_context_switch(struct smlt_context_set *set, uint32_t idx)
+{
+    errval_t err;
+
+    if (idx >= set->num_contexts) {
+        return SMLT_ERR_INVAL;
+    }
+
+    struct smlt_context *ctx = set->contexts[idx];
+    if (smlt_node_self_id > set->max_nid ||
+        smlt_node_self_id > ctx->max_nid ||
+        ctx->nid_to_node[smlt_node_self_id] == NULL) {
+        return SMLT_ERR_NODE_INVALD;
+    }
+
+    struct smlt_context_set_node *n = &set->nodes[smlt_node_self_id];
+    if (n->active == idx) {
+        return SMLT_SUCCESS;
+    }
+
+    err = smlt_barrier_wait(set->contexts[n->active]);
+    if (smlt_err_is_fail(err)) {
+        return err;
+    }
+
+    n->active = idx;
+
+    return SMLT_SUCCESS;
+}
+
 
 /*
  * ===========================================================================
@@ -254,8 +765,8 @@ errval_t smlt_context_node_get_children_channels(struct smlt_context *ctx,
                                                  struct smlt_channel **ret_chan,
                                                  uint32_t *ret_count)
 {
-    if (ctx->max_nid < node->id) {
-        return -1; /* TODO: ERROR VALUE */
+    if (ctx->max_nid < node->id || ctx->nid_to_node[node->id] == NULL) {
+        return SMLT_ERR_NODE_INVALD;
     }
 
     if (ret_chan) {
@@ -282,8 +793,8 @@ errval_t smlt_context_node_get_parent_channel(struct smlt_context *ctx,
                                               struct smlt_node *node,
                                               struct smlt_channel **ret_chan)
 {
-    if (ctx->max_nid < node->id) {
-        return -1; /* TODO: ERROR VALUE */
+    if (ctx->max_nid < node->id || ctx->nid_to_node[node->id] == NULL) {
+        return SMLT_ERR_NODE_INVALD;
     }
 
     if (ret_chan) {
@@ -292,6 +803,60 @@ errval_t smlt_context_node_get_parent_channel(struct smlt_context *ctx,
     return SMLT_SUCCESS;
 }
 
+/**
+ * @brief obtains the channels of the current node in the tree of a context
+ *
+ * @param ctx       Smelt context
+ * @param links     returns the channels and the number of owner queues
+ *
+ * @return SMLT_SUCCESS or SMLT_ERR_NODE_INVALD if the node is not part of
+ *         the context
+ */
+errval_t smlt_context_get_links(struct smlt_context *ctx,
+                                struct smlt_context_links *links)
+{
+    errval_t err;
+
+    err = smlt_context_get_children_channels(ctx, &links->children,
+                                             &links->num_children);
+    if (smlt_err_is_fail(err)) {
+        return err;
+    }
+
+    err = smlt_context_get_parent_channel(ctx, &links->parent);
+    if (smlt_err_is_fail(err)) {
+        return err;
+    }
+
+    links->parent_idx = links->parent ? smlt_context_node_get_child_idx(ctx) : 0;
+
+    links->num_queues = 0;
+    for (uint32_t i = 0; i < links->num_children; i++) {
+        links->num_queues += smlt_channel_get_num_owner_queues(&links->children[i]);
+    }
+
+    return SMLT_SUCCESS;
+}
+
+/**
+ * @brief obtains the owner queues of all child channels, in child order
+ *
+ * @param links     the channels of the current node
+ * @param queues    returns links->num_queues owner queues
+ */
+void smlt_context_get_child_queues(struct smlt_context_links *links,
+                                   struct smlt_qp **queues)
+{
+    uint32_t q = 0;
+    for (uint32_t i = 0; i < links->num_children; i++) {
+        struct smlt_channel *chan = &links->children[i];
+        uint32_t num = smlt_channel_get_num_owner_queues(chan);
+        for (uint32_t j = 0; j < num; j++) {
+            queues[q++] = smlt_channel_get_owner_queue(chan, j);
+        }
+    }
+}
+
 
 /*
  * ===========================================================================
@@ -311,7 +876,7 @@ errval_t smlt_context_node_get_parent_channel(struct smlt_context *ctx,
 bool smlt_context_node_is_root(struct smlt_context *ctx,
                                struct smlt_node *node)
 {
-    if (ctx->max_nid < node->id) {
+    if (ctx->max_nid < node->id || ctx->nid_to_node[node->id] == NULL) {
         return 0;
     }
     return (ctx->nid_to_node[node->id]->parent == NULL);
@@ -328,13 +893,56 @@ bool smlt_context_node_is_root(struct smlt_context *ctx,
 bool smlt_context_node_is_leaf(struct smlt_context *ctx,
                                struct smlt_node *node)
 {
-    if (ctx->max_nid < node->id) {
+    if (ctx->max_nid < node->id || ctx->nid_to_node[node->id] == NULL) {
         return 0;
     }
     return (ctx->nid_to_node[node->id]->num_children == 0);
 }
 
 
+/**
+ * @brief obtains the number of nodes of the context
+ *
+ * @param ctx   Smelt context
+ *
+ * @return number of nodes
+ */
+uint32_t smlt_context_get_num_nodes(struct smlt_context *ctx)
+{
+    return ctx->num_nodes;
+}
+
+/**
+ * @brief obtains the id of the node with the given rank
+ *
+ * @param ctx   Smelt context
+ * @param rank  rank of the node, smaller than the number of nodes
+ *
+ * @return the node id
+ */
+smlt_nid_t smlt_context_get_node_id(struct smlt_context *ctx, uint32_t rank)
+{
+    assert(rank < ctx->num_nodes);
+    return ctx->all_nodes[rank].node_id;
+}
+
+/**
+ * @brief obtains the rank of the calling node in the context
+ *
+ * @param ctx   Smelt context
+ *
+ * @return the rank or SMLT_CONTEXT_RANK_NONE if the node is not part of it
+ */
+uint32_t smlt_context_get_rank(struct smlt_context *ctx)
+{
+    if (smlt_node_self_id > ctx->max_nid ||
+        ctx->nid_to_node[smlt_node_self_id] == NULL) {
+        return SMLT_CONTEXT_RANK_NONE;
+    }
+
+    return (uint32_t)(ctx->nid_to_node[smlt_node_self_id] - ctx->all_nodes);
+}
+
 /**
  * @brief gets the index into receiving array
  *
@@ -348,6 +956,72 @@ uint32_t smlt_context_node_get_child_idx(struct smlt_context *ctx)
     return ctx->nid_to_node[smlt_node_self_id]->index;
 }
 
+/**
+ * @brief obtains the tagged collectives state of the current node
+ *
+ * @param ctx   Smelt context
+ *
+ * @return the state or NULL if the node is not part of the context
+ */
+struct smlt_tag_state *smlt_context_get_tag_state(struct smlt_context *ctx)
+{
+    if (smlt_node_self_id > ctx->max_nid ||
+        ctx->nid_to_node[smlt_node_self_id] == NULL) {
+        return NULL;
+    }
+
+    struct smlt_context_node *n = ctx->nid_to_node[smlt_node_self_id];
+    if (n->tag_state == NULL) {
+        n->tag_state = smlt_tag_state_create(ctx);
+    }
+
+    return n->tag_state;
+}
+
+/**
+ * @brief obtains the atomic broadcast state of the current node
+ *
+ * @param ctx   Smelt context
+ *
+ * @return the state or NULL if the node is not part of the context
+ */
+struct smlt_abcast_state *smlt_context_get_abcast_state(struct smlt_context *ctx)
+{
+    if (smlt_node_self_id > ctx->max_nid ||
+        ctx->nid_to_node[smlt_node_self_id] == NULL) {
+        return NULL;
+    }
+
+    struct smlt_context_node *n = ctx->nid_to_node[smlt_node_self_id];
+    if (n->abcast_state == NULL) {
+        n->abcast_state = smlt_abcast_state_create(ctx);
+    }
+
+    return n->abcast_state;
+}
+
+/**
+ * @brief obtains the split barrier state of the current node
+ *
+ * @param ctx   Smelt context
+ *
+ * @return the state or NULL if the node is not part of the context
+ */
+struct smlt_barrier_state *smlt_context_get_barrier_state(struct smlt_context *ctx)
+{
+    if (smlt_node_self_id > ctx->max_nid ||
+        ctx->nid_to_node[smlt_node_self_id] == NULL) {
+        return NULL;
+    }
+
+    struct smlt_context_node *n = ctx->nid_to_node[smlt_node_self_id];
+    if (n->barrier_state == NULL) {
+        n->barrier_state = smlt_barrier_state_create(ctx);
+    }
+
+    return n->barrier_state;
+}
+
 /**
  * @brief checks if the node does shared memory operations
  *
@@ -0,0 +1,72 @@
+/*
+ * Copyright (c) 2016 ETH Zurich.
+ * All rights reserved.
+ *
+ * This file is distributed under the terms in the attached LICENSE file.
+ * If you do not find this file, copies can be found by writing to:
+ * ETH Zurich D-INFK, Universitaetstr. 6, CH-8092 Zurich. Attn: Systems Group.
+ */
+#include <smlt.h>
+
+/**
+ * @brief returns a string representation of the error code
+ *
+ * @param errval    error value to print
+ *
+ * @return pointer to the string of the error code
+ *
+ * Some of the older codes share a value, their strings name all of them.
+ */
+char* smlt_err_get_code(errval_t errval)
+{
+    switch (smlt_err_no(errval)) {
+    case SMLT_SUCCESS:
+        return "SMLT_SUCCESS";
+    case SMLT_ERR_NODE_INVALD:
+        return "SMLT_ERR_NODE_INVALD";
+    case SMLT_ERR_INIT:
+        return "SMLT_ERR_INIT";
+    case SMLT_ERR_MALLOC_FAIL:
+        return "SMLT_ERR_MALLOC_FAIL";
+    case SMLT_ERR_INVAL:
+        return "SMLT_ERR_INVAL";
+    case SMLT_ERR_NODE_START:
+        return "SMLT_ERR_NODE_START/SMLT_ERR_BAD_ALIGNMENT";
+    case SMLT_ERR_NODE_CREATE:
+        return "SMLT_ERR_NODE_CREATE/SMLT_ERR_PLATFORM_INIT";
+    case SMLT_ERR_NODE_JOIN:
+        return "SMLT_ERR_NODE_JOIN/SMLT_ERR_TOPOLOGY_INIT";
+    case SMLT_ERR_SHM_INIT:
+        return "SMLT_ERR_SHM_INIT/SMLT_ERR_ALLOC_UMP/SMLT_ERR_GENERATOR";
+    case SMLT_ERR_CHAN_CREATE:
+        return "SMLT_ERR_CHAN_CREATE/SMLT_ERR_ALLOC_FFQ";
+    case SMLT_ERR_CHAN_DESTROY:
+        return "SMLT_ERR_CHAN_DESTROY/SMLT_ERR_ALLOC_SHM";
+    case SMLT_ERR_CHAN_WOULD_BLOCK:
+        return "SMLT_ERR_CHAN_WOULD_BLOCK/SMLT_ERR_DESTROY_UMP";
+    case SMLT_ERR_QUEUE_RECV:
+        return "SMLT_ERR_QUEUE_RECV/SMLT_ERR_DESTROY_FFQ";
+    case SMLT_ERR_QUEUE_SEND:
+        return "SMLT_ERR_QUEUE_SEND/SMLT_ERR_DESTRYO_SHM";
+    case SMLT_ERR_QUEUE_STATE:
+        return "SMLT_ERR_QUEUE_STATE";
+    case SMLT_ERR_QUEUE_EMPTY:
+        return "SMLT_ERR_QUEUE_EMPTY";
+    case SMLT_ERR_QUEUE_FULL:
+        return "SMLT_ERR_QUEUE_FULL";
+    case SMLT_ERR_QUEUE_PREPARE:
+        return "SMLT_ERR_QUEUE_PREPARE";
+    case SMLT_ERR_QUEUE_INIT:
+        return "SMLT_ERR_QUEUE_INIT";
+    case SMLT_ERR_SEND:
+        return "SMLT_ERR_SEND";
+    case SMLT_ERR_NOTIFY:
+        return "SMLT_ERR_NOTIFY";
+    case SMLT_ERR_PROFILE_IO:
+        return "SMLT_ERR_PROFILE_IO";
+    case SMLT_ERR_TUNE_NOTFOUND:
+        return "SMLT_ERR_TUNE_NOTFOUND";
+    default:
+        return "SMLT_ERR";
+    }
+}
@@ -10,13 +10,30 @@
 #include <smlt_error.h>
 #include <smlt_generator.h>
 #include <smlt_platform.h>
+#include <smlt_topology.h>
+#include <smlt_profiler.h>
 #include "smlt_debug.h"
 #include "tree_config.h"
 #include <stdio.h> // reading json string from file
+#include <string.h>
 #include <unistd.h>
 
 /**
- * @brief generates a model using the simulator
+ * @brief frees a dense model
+ */
+static void smlt_generator_model_free(struct smlt_generated_model *model)
+{
+    if (model->model) {
+        smlt_platform_free(model->model);
+    }
+    if (model->leafs) {
+        smlt_platform_free(model->leafs);
+    }
+    smlt_platform_free(model);
+}
+
+/**
+ * @brief obtains a model from the model cache or the Simulator
  *
  * @param cores         an arry of cores that contains the
  *                      cores of the model
@@ -25,25 +42,42 @@
  *                      simulator
  * @param mode          encoded model (model itself, leafs, last_node)
  *
+ * @return SMLT_SUCCESS or SMLT_ERR_GENERATOR if the Simulator is not
+ *         reachable or returned a model that does not cover the cores
  */
-errval_t smlt_generate_model(coreid_t* cores, uint32_t len,
-                         const char* name, struct smlt_generated_model** model)
+static errval_t smlt_generator_simulate(coreid_t* cores, uint32_t len,
+                                        const char* name,
+                                        struct smlt_generated_model** model)
 {
+    errval_t err;
+
+    err = smlt_model_cache_lookup(cores, len, name, model);
+    if (smlt_err_is_ok(err)) {
+        return SMLT_SUCCESS;
+    }
+
     *model = (struct smlt_generated_model*) smlt_platform_alloc(
                                                 sizeof(struct smlt_generated_model),
                                                 SMLT_DEFAULT_ALIGNMENT,
                                                 true);
-    COND_PANIC(model!=NULL, "Failed to allocated memory for model");
+    if (*model == NULL) {
+        return SMLT_ERR_MALLOC_FAIL;
+    }
 
-    uint32_t len_model;
-    int err = smlt_tree_generate(len, cores, name, &((*model)->model),
+    uint32_t len_model = 0;
+    int ret = smlt_tree_generate(len, cores, name, &((*model)->model),
                                  &((*model)->num_leafs), &((*model)->leafs),
                                  &((*model)->root), &len_model);
 
-    if (len_model != sysconf(_SC_NPROCESSORS_ONLN)) {
+    bool covered = (ret == 0);
+    for (uint32_t i = 0; covered && i < len; i++) {
+        covered = (cores[i] < len_model);
+    }
 
-        // The Simulator returned a model that does not match the requested size
-        panic("Simulator failed, aborting");
+    if (!covered) {
+        smlt_generator_model_free(*model);
+        *model = NULL;
+        return SMLT_ERR_GENERATOR;
     }
 
     printf("Model Generated %" PRIu32 "\n", len_model);
@@ -60,14 +94,597 @@ errval_t smlt_generate_model(coreid_t* cores, uint32_t len,
     (*model)->ncores = len;
     (*model)->len = len_model;
 
-    if (err) {
+    if (all_zeros) {
+        smlt_generator_model_free(*model);
+        *model = NULL;
+        return SMLT_ERR_GENERATOR;
+    }
+
+    err = smlt_model_cache_store(*model, cores, len, name);
+    if (smlt_err_is_fail(err)) {
+        SMLT_WARNING("failed to store the model in the model cache\n");
+    }
+
+    return SMLT_SUCCESS;
+}
+
+/**
+ * @brief generates a sparse model from the cost profile of this machine
+ *
+ * Used when the Simulator is not reachable or returned a model that does
+ * not cover the requested cores.
+ */
+static errval_t smlt_generator_from_local_profile(coreid_t* cores, uint32_t len,
+                                                  struct smlt_sparse_model** sparse)
+{
+    errval_t err;
+    struct smlt_profile *profile;
+
+    SMLT_WARNING("Simulator failed, using the local cost profile\n");
+
+    err = smlt_profiler_load(NULL, &profile);
+    if (smlt_err_is_fail(err)) {
         return SMLT_ERR_GENERATOR;
-    } else if (all_zeros) {
+    }
+
+    err = smlt_generate_sparse_model_from_profile(profile, cores, len, sparse);
+    smlt_profiler_destroy(profile);
+
+    return err;
+}
+
+/**
+ * @brief generates a model using the simulator
+ *
+ * @param cores         an arry of cores that contains the
+ *                      cores of the model
+ * @param len           length of the cores array
+ * @param name          name of the tree topology generated by the
+ *                      simulator
+ * @param mode          encoded model (model itself, leafs, last_node)
+ *
+ */
+errval_t smlt_generate_model(coreid_t* cores, uint32_t len,
+                         const char* name, struct smlt_generated_model** model)
+{
+    errval_t err;
+    struct smlt_sparse_model *sparse;
+
+    if (smlt_generator_is_builtin(name)) {
+        return smlt_generate_builtin_model(name, cores, len, model);
+    }
+
+    err = smlt_generator_simulate(cores, len, name, model);
+    if (smlt_err_no(err) != SMLT_ERR_GENERATOR) {
+        return err;
+    }
+
+    err = smlt_generator_from_local_profile(cores, len, &sparse);
+    if (smlt_err_is_fail(err)) {
+        return err;
+    }
+
+    err = smlt_sparse_model_to_dense(sparse, model);
+    smlt_sparse_model_destroy(sparse);
+    if (smlt_err_is_ok(err)) {
+        (*model)->ncores = len;
+    }
+
+    return err;
+}
+
+/**
+ * @brief generates a sparse model
+ *
+ * @param cores         an arry of cores that contains the
+ *                      cores of the model, cores[0] becomes the root
+ * @param len           length of the cores array
+ * @param name          name of the tree topology, NULL for SMLT_TOPO
+ * @param sparse        the sparse model
+ *
+ * Built-in topologies and models from the local cost profile are built
+ * without a matrix, hence there is no limit on the number of children.
+ */
+errval_t smlt_generate_sparse_model(coreid_t* cores, uint32_t len,
+                                    const char* name,
+                                    struct smlt_sparse_model** sparse)
+{
+    errval_t err;
+    struct smlt_generated_model *model;
+
+    if (smlt_generator_is_builtin(name)) {
+        return smlt_generate_builtin_sparse_model(name, cores, len, sparse);
+    }
+
+    err = smlt_generator_simulate(cores, len, name, &model);
+    if (smlt_err_is_ok(err)) {
+        err = smlt_sparse_model_from_dense(model, sparse);
+        smlt_generator_model_free(model);
+        return err;
+    }
+
+    if (smlt_err_no(err) != SMLT_ERR_GENERATOR) {
+        return err;
+    }
+
+    return smlt_generator_from_local_profile(cores, len, sparse);
+}
+
+/*
+ * ===========================================================================
+ * building models
+ * ===========================================================================
+ */
+
+/**
+ * @brief allocates an empty sparse model for the given cores
+ *
+ * The model is indexed by core id, cores[0] becomes the root.
+ */
+static errval_t smlt_generator_model_alloc(coreid_t* cores, uint32_t len,
+                                           struct smlt_sparse_model **m)
+{
+    uint32_t len_model = 0;
+    for (uint32_t i = 0; i < len; i++) {
+        if (cores[i] >= len_model) {
+            len_model = cores[i] + 1;
+        }
+    }
+
+    return smlt_sparse_model_create(len_model, cores[0], m);
+}
+
+/**
+ * @brief appends a message passing child to a node of the model
+ */
+static errval_t smlt_generator_model_add_child(struct smlt_sparse_model *m,
+                                               coreid_t parent, coreid_t child)
+{
+    errval_t err = smlt_sparse_model_add_child(m, parent, child,
+                                               SMLT_MODEL_EDGE_MP);
+    if (smlt_err_is_fail(err)) {
+        SMLT_ERROR("failed to add core %" PRIu32 " as child of %" PRIu32
+                   " to the model\n", child, parent);
         return SMLT_ERR_GENERATOR;
+    }
+
+    return SMLT_SUCCESS;
+}
+
+/**
+ * @brief finalizes the sparse model, destroys it on failure
+ */
+static errval_t smlt_generator_model_finish(struct smlt_sparse_model *m,
+                                            errval_t err,
+                                            struct smlt_sparse_model **sparse)
+{
+    if (smlt_err_is_ok(err)) {
+        err = smlt_sparse_model_finalize(m);
+    }
+
+    if (smlt_err_is_fail(err)) {
+        smlt_sparse_model_destroy(m);
+        return err;
+    }
+
+    *sparse = m;
+
+    return SMLT_SUCCESS;
+}
+
+/**
+ * @brief converts a generated sparse model to the dense one
+ */
+static errval_t smlt_generator_model_to_dense(errval_t err,
+                                              struct smlt_sparse_model *sparse,
+                                              uint32_t len,
+                                              struct smlt_generated_model **model)
+{
+    if (smlt_err_is_fail(err)) {
+        return err;
+    }
+
+    err = smlt_sparse_model_to_dense(sparse, model);
+    smlt_sparse_model_destroy(sparse);
+    if (smlt_err_is_ok(err)) {
+        (*model)->ncores = len;
+    }
+
+    return err;
+}
+
+/**
+ * @brief generates a sparse model from a measured cost profile
+ *
+ * @param profile       the pairwise link costs of the machine
+ * @param cores         an arry of cores that contains the
+ *                      cores of the model, cores[0] becomes the root
+ * @param len           length of the cores array
+ * @param sparse        the sparse model
+ *
+ * The tree is built greedily: every step connects the not yet reached core
+ * that can be reached the earliest by any core that already has the message.
+ */
+errval_t smlt_generate_sparse_model_from_profile(struct smlt_profile *profile,
+                                                 coreid_t* cores, uint32_t len,
+                                                 struct smlt_sparse_model** sparse)
+{
+    errval_t err;
+    struct smlt_sparse_model *m;
+
+    if (profile == NULL || cores == NULL || len == 0) {
+        return SMLT_ERR_INVAL;
+    }
+
+    for (uint32_t i = 0; i < len; i++) {
+        if (smlt_profiler_core_idx(profile, cores[i]) < 0) {
+            SMLT_WARNING("core %" PRIu32 " is not part of the profile\n",
+                         cores[i]);
+            return SMLT_ERR_GENERATOR;
+        }
+    }
+
+    err = smlt_generator_model_alloc(cores, len, &m);
+    if (smlt_err_is_fail(err)) {
+        return err;
+    }
+
+    uint32_t *pidx = (uint32_t *)smlt_platform_alloc(len * sizeof(uint32_t),
+                                                     SMLT_DEFAULT_ALIGNMENT, true);
+    uint64_t *t_avail = (uint64_t *)smlt_platform_alloc(len * sizeof(uint64_t),
+                                                        SMLT_DEFAULT_ALIGNMENT,
+                                                        true);
+    bool *reached = (bool *)smlt_platform_alloc(len * sizeof(bool),
+                                                SMLT_DEFAULT_ALIGNMENT, true);
+
+    if (!pidx || !t_avail || !reached) {
+        err = SMLT_ERR_MALLOC_FAIL;
+        goto out;
+    }
+
+    for (uint32_t i = 0; i < len; i++) {
+        pidx[i] = smlt_profiler_core_idx(profile, cores[i]);
+    }
+
+    reached[0] = true;
+    for (uint32_t step = 1; step < len; step++) {
+        uint64_t best = UINT64_MAX;
+        uint32_t best_s = 0, best_r = 0;
+
+        for (uint32_t s = 0; s < len; s++) {
+            if (!reached[s]) {
+                continue;
+            }
+            for (uint32_t r = 0; r < len; r++) {
+                if (reached[r]) {
+                    continue;
+                }
+                uint64_t t = t_avail[s] + smlt_profiler_msg_cost(profile,
+                                                                  pidx[s],
+                                                                  pidx[r]);
+                if (t < best) {
+                    best = t;
+                    best_s = s;
+                    best_r = r;
+                }
+            }
+        }
+
+        uint32_t idx = pidx[best_s] * profile->ncores + pidx[best_r];
+
+        reached[best_r] = true;
+        t_avail[best_s] += profile->send[idx];
+        t_avail[best_r] = best;
+
+        err = smlt_generator_model_add_child(m, cores[best_s], cores[best_r]);
+        if (smlt_err_is_fail(err)) {
+            break;
+        }
+    }
+
+ out:
+    if (pidx) {
+        smlt_platform_free(pidx);
+    }
+    if (t_avail) {
+        smlt_platform_free(t_avail);
+    }
+    if (reached) {
+        smlt_platform_free(reached);
+    }
+
+    return smlt_generator_model_finish(m, err, sparse);
+}
+
+/**
+ * @brief generates a model from a measured cost profile
+ *
+ * @param profile       the pairwise link costs of the machine
+ * @param cores         an arry of cores that contains the
+ *                      cores of the model, cores[0] becomes the root
+ * @param len           length of the cores array
+ * @param model         encoded model (model itself, leafs, last_node)
+ */
+errval_t smlt_generate_model_from_profile(struct smlt_profile *profile,
+                                          coreid_t* cores, uint32_t len,
+                                          struct smlt_generated_model** model)
+{
+    struct smlt_sparse_model *sparse = NULL;
+
+    errval_t err = smlt_generate_sparse_model_from_profile(profile, cores, len,
+                                                           &sparse);
+    return smlt_generator_model_to_dense(err, sparse, len, model);
+}
+
+/*
+ * ===========================================================================
+ * built-in topologies
+ * ===========================================================================
+ */
+
+/**
+ * @brief builds a k-ary tree over cores[first..first+len)
+ */
+static errval_t smlt_generator_kary(struct smlt_sparse_model *m,
+                                    coreid_t* cores, uint32_t len,
+                                    uint32_t fanout)
+{
+    errval_t err = SMLT_SUCCESS;
+
+    for (uint32_t i = 1; i < len && smlt_err_is_ok(err); i++) {
+        err = smlt_generator_model_add_child(m, cores[(i - 1) / fanout],
+                                             cores[i]);
+    }
+
+    return err;
+}
+
+/**
+ * @brief builds the tree in which every node forwards the message as soon
+ *        as it can, given a send overhead of one and a latency of latency
+ *
+ * A latency of one results in a binomial tree, a latency of two in a
+ * Fibonacci tree.
+ */
+static errval_t smlt_generator_greedy(struct smlt_sparse_model *m,
+                                      coreid_t* cores, uint32_t len,
+                                      uint32_t latency)
+{
+    errval_t err = SMLT_SUCCESS;
+
+    uint32_t *t_avail = (uint32_t *)smlt_platform_alloc(len * sizeof(uint32_t),
+                                                        SMLT_DEFAULT_ALIGNMENT,
+                                                        true);
+    if (t_avail == NULL) {
+        return SMLT_ERR_MALLOC_FAIL;
+    }
+
+    for (uint32_t next = 1; next < len && smlt_err_is_ok(err); next++) {
+        uint32_t s = 0;
+        for (uint32_t i = 1; i < next; i++) {
+            if (t_avail[i] < t_avail[s]) {
+                s = i;
+            }
+        }
+
+        t_avail[next] = t_avail[s] + latency;
+        t_avail[s] += 1;
+
+        err = smlt_generator_model_add_child(m, cores[s], cores[next]);
+    }
+
+    smlt_platform_free(t_avail);
+
+    return err;
+}
+
+/**
+ * @brief builds a two level tree, the root connects to one leader per NUMA
+ *        node, the leaders connect to the cores of their NUMA node
+ */
+static errval_t smlt_generator_cluster(struct smlt_sparse_model *m,
+                                       coreid_t* cores, uint32_t len,
+                                       uint32_t fanout)
+{
+    errval_t err = SMLT_SUCCESS;
+
+    coreid_t *members = (coreid_t *)smlt_platform_alloc(len * sizeof(coreid_t),
+                                                        SMLT_DEFAULT_ALIGNMENT,
+                                                        true);
+    bool *done = (bool *)smlt_platform_alloc(len * sizeof(bool),
+                                             SMLT_DEFAULT_ALIGNMENT, true);
+    if (!members || !done) {
+        err = SMLT_ERR_MALLOC_FAIL;
+        goto out;
+    }
+
+    /* the cluster of the root is handled first such that the root leads it */
+    uint32_t num_clusters = 0;
+    for (uint32_t i = 0; i < len && smlt_err_is_ok(err); i++) {
+        if (done[i]) {
+            continue;
+        }
+
+        uint8_t cluster = smlt_platform_cluster_of_core(cores[i]);
+        uint32_t num_members = 0;
+        for (uint32_t j = i; j < len; j++) {
+            if (!done[j] && smlt_platform_cluster_of_core(cores[j]) == cluster) {
+                members[num_members++] = cores[j];
+                done[j] = true;
+            }
+        }
+
+        /* members[0] is the leader of the cluster */
+        if (members[0] != cores[0]) {
+            err = smlt_generator_model_add_child(m, cores[0], members[0]);
+        }
+        num_clusters++;
+    }
+
+    memset(done, 0, len * sizeof(bool));
+
+    /* the root also sends to the leaders of the other clusters */
+    uint32_t root_fanout = fanout;
+    if (num_clusters - 1 + root_fanout > TOPO_MATRIX_MAX_MP) {
+        root_fanout = (num_clusters <= TOPO_MATRIX_MAX_MP)
+                          ? TOPO_MATRIX_MAX_MP - (num_clusters - 1) : 1;
+    }
+
+    for (uint32_t i = 0; i < len && smlt_err_is_ok(err); i++) {
+        if (done[i]) {
+            continue;
+        }
+
+        uint8_t cluster = smlt_platform_cluster_of_core(cores[i]);
+        uint32_t num_members = 0;
+        for (uint32_t j = i; j < len; j++) {
+            if (!done[j] && smlt_platform_cluster_of_core(cores[j]) == cluster) {
+                members[num_members++] = cores[j];
+                done[j] = true;
+            }
+        }
+
+        err = smlt_generator_kary(m, members, num_members,
+                                  (i == 0) ? root_fanout : fanout);
+    }
+
+ out:
+    if (members) {
+        smlt_platform_free(members);
+    }
+    if (done) {
+        smlt_platform_free(done);
+    }
+
+    return err;
+}
+
+/**
+ * @brief splits the topology name into its base name and fan-out
+ *
+ * @return the length of the base name
+ */
+static size_t smlt_generator_parse_name(const char *name, uint32_t *fanout)
+{
+    const char *sep = strchr(name, '-');
+    if (sep == NULL) {
+        return strlen(name);
+    }
+
+    char *end;
+    unsigned long val = strtoul(sep + 1, &end, 10);
+    if (*end != '\0' || end == sep + 1) {
+        return strlen(name);
+    }
+
+    if (val >= 1 && val <= UINT32_MAX) {
+        *fanout = (uint32_t)val;
     } else {
-        return SMLT_SUCCESS;
+        SMLT_WARNING("invalid fan-out in topology %s\n", name);
+    }
+
+    return sep - name;
+}
+
+#define SMLT_GENERATOR_NAME_IS(name, len, str) \
+    ((len) == sizeof(str) - 1 && strncmp(name, str, len) == 0)
+
+/**
+ * @brief checks whether the name refers to a built-in topology
+ *
+ * @param name  name of the topology, NULL for SMLT_TOPO
+ *
+ * @return true if smlt_generate_builtin_model() can generate the topology
+ */
+bool smlt_generator_is_builtin(const char *name)
+{
+    uint32_t fanout;
+
+    if (name == NULL) {
+        name = getenv("SMLT_TOPO");
+    }
+    if (name == NULL) {
+        return false;
     }
+
+    size_t len = smlt_generator_parse_name(name, &fanout);
+
+    return (SMLT_GENERATOR_NAME_IS(name, len, SMLT_TOPO_BINARY) ||
+            SMLT_GENERATOR_NAME_IS(name, len, SMLT_TOPO_KARY) ||
+            SMLT_GENERATOR_NAME_IS(name, len, SMLT_TOPO_BINOMIAL) ||
+            SMLT_GENERATOR_NAME_IS(name, len, SMLT_TOPO_FIBONACCI) ||
+            SMLT_GENERATOR_NAME_IS(name, len, SMLT_TOPO_CLUSTER));
 }
+
+/**
+ * @brief generates one of the built-in tree topologies as sparse model
+ *
+ * @param name          name of the topology, NULL for SMLT_TOPO
+ * @param cores         an arry of cores that contains the
+ *                      cores of the model, cores[0] becomes the root
+ * @param len           length of the cores array
+ * @param sparse        the sparse model
+ */
+errval_t smlt_generate_builtin_sparse_model(const char* name, coreid_t* cores,
+                                            uint32_t len,
+                                            struct smlt_sparse_model** sparse)
+{
+    errval_t err;
+    struct smlt_sparse_model *m;
+    uint32_t fanout = 0;
+
+    if (name == NULL) {
+        name = getenv("SMLT_TOPO");
+    }
+    if (name == NULL || cores == NULL || len == 0) {
+        return SMLT_ERR_INVAL;
+    }
+
+    size_t name_len = smlt_generator_parse_name(name, &fanout);
+
+    err = smlt_generator_model_alloc(cores, len, &m);
+    if (smlt_err_is_fail(err)) {
+        return err;
+    }
+
+    if (SMLT_GENERATOR_NAME_IS(name, name_len, SMLT_TOPO_BINARY)) {
+        err = smlt_generator_kary(m, cores, len, 2);
+    } else if (SMLT_GENERATOR_NAME_IS(name, name_len, SMLT_TOPO_KARY)) {
+        err = smlt_generator_kary(m, cores, len,
+                                  fanout ? fanout : SMLT_TOPO_DEFAULT_FANOUT);
+    } else if (SMLT_GENERATOR_NAME_IS(name, name_len, SMLT_TOPO_BINOMIAL)) {
+        err = smlt_generator_greedy(m, cores, len, 1);
+    } else if (SMLT_GENERATOR_NAME_IS(name, name_len, SMLT_TOPO_FIBONACCI)) {
+        err = smlt_generator_greedy(m, cores, len, 2);
+    } else if (SMLT_GENERATOR_NAME_IS(name, name_len, SMLT_TOPO_CLUSTER)) {
+        err = smlt_generator_cluster(m, cores, len,
+                                     fanout ? fanout : TOPO_MATRIX_MAX_MP);
+    } else {
+        err = SMLT_ERR_INVAL;
+    }
+
+    return smlt_generator_model_finish(m, err, sparse);
+}
+
+/**
+ * @brief generates one of the built-in tree topologies
+ *
+ * @param name          name of the topology, NULL for SMLT_TOPO
+ * @param cores         an arry of cores that contains the
+ *                      cores of the model, cores[0] becomes the root
+ * @param len           length of the cores array
+ * @param model         encoded model (model itself, leafs, last_node)
+ */
+errval_t smlt_generate_builtin_model(const char* name, coreid_t* cores,
+                                     uint32_t len,
+                                     struct smlt_generated_model** model)
+{
+    struct smlt_sparse_model *sparse = NULL;
+
+    errval_t err = smlt_generate_builtin_sparse_model(name, cores, len, &sparse);
+    return smlt_generator_model_to_dense(err, sparse, len, model);
+}
+
 /**
  * @brief generates a model from a file storing a json string
  *
@@ -90,26 +707,31 @@ errval_t smlt_generate_modal_from_file(char* filepath, uint32_t ncores,
     char *json_string;
     uint64_t file_size;
     FILE *file = fopen(filepath, "rb");
+    if (file == NULL) {
+        return SMLT_ERR_GENERATOR;
+    }
 
     // seek end
     fseek(file, 0, SEEK_END);
     file_size = ftell(file);
     rewind(file);
 
-    // read contents
-    json_string = (char*) smlt_platform_alloc(file_size * (sizeof(char)),
+    // read contents, the parser expects a zero terminated string
+    json_string = (char*) smlt_platform_alloc((file_size + 1) * (sizeof(char)),
                                        SMLT_DEFAULT_ALIGNMENT, true);
+    assert(json_string != NULL);
     uint64_t read = fread(json_string, sizeof(char), file_size, file);
-    if (read <= 0) {
+    fclose(file);
+    if (read != file_size) {
+       smlt_platform_free(json_string);
        return SMLT_ERR_GENERATOR;
     }
 
-    fclose(file);
-
     uint32_t len_model;
     int err = smlt_tree_parse(json_string, ncores, &((*model)->model),
                               &((*model)->num_leafs), &((*model)->leafs),
                               &((*model)->root), &len_model);
+    smlt_platform_free(json_string);
 
     (*model)->len = len_model;
     if (err) {
@@ -121,14 +743,44 @@ errval_t smlt_generate_modal_from_file(char* filepath, uint32_t ncores,
 
 /**
  * @brief update measurements on the generator
- *        i.e. make new measurements and send them to
- *        generator service
+ *        i.e. measure the pairwise link costs of the machine and
+ *        store them in the per-host profile cache
  *
- * @return SMLT_SUCCESS or SMLT_ERR_GENERATOR if communication
- *         to the generator failed
+ * @return SMLT_SUCCESS or SMLT_ERR_GENERATOR if the measurement
+ *         or storing the profile failed
  */
 errval_t smlt_generator_update_measurments(void)
 {
-    assert(!"NYI");
+    errval_t err;
+    struct smlt_profile *profile;
+
+    uint32_t ncores = smlt_get_num_proc();
+    if (ncores == 0) {
+        ncores = smlt_platform_num_cores();
+    }
+
+    coreid_t *cores = (coreid_t *)smlt_platform_alloc(ncores * sizeof(coreid_t),
+                                                      SMLT_DEFAULT_ALIGNMENT,
+                                                      true);
+    if (cores == NULL) {
+        return SMLT_ERR_MALLOC_FAIL;
+    }
+
+    for (uint32_t i = 0; i < ncores; i++) {
+        cores[i] = smlt_get_core_by_id(i);
+    }
+
+    err = smlt_profiler_measure(cores, ncores, 0, &profile);
+    smlt_platform_free(cores);
+    if (smlt_err_is_fail(err)) {
+        return smlt_err_push(err, SMLT_ERR_GENERATOR);
+    }
+
+    err = smlt_profiler_store(profile, NULL);
+    smlt_profiler_destroy(profile);
+    if (smlt_err_is_fail(err)) {
+        return smlt_err_push(err, SMLT_ERR_GENERATOR);
+    }
+
     return SMLT_SUCCESS;
 }
@@ -61,6 +61,168 @@ struct binding_lst {
  * =============================================================================
  */
 
+/*
+ * =============================================================================
+ * Tree links
+ * =============================================================================
+ */
+
+struct smlt_context;
+struct smlt_channel;
+struct smlt_qp;
+
+/**
+ * the channels of the current node in the tree of a context
+ */
+struct smlt_context_links
+{
+    struct smlt_channel *parent;    ///< channel to the parent, NULL if root
+    uint32_t parent_idx;            ///< index of the node in the parent channel
+    struct smlt_channel *children;  ///< channels to the children
+    uint32_t num_children;          ///< number of child channels
+    uint32_t num_queues;            ///< number of owner queues to the children
+};
+
+/**
+ * @brief obtains the channels of the current node in the tree of a context
+ *
+ * @param ctx       Smelt context
+ * @param links     returns the channels and the number of owner queues
+ *
+ * @return SMLT_SUCCESS or SMLT_ERR_NODE_INVALD if the node is not part of
+ *         the context
+ */
+errval_t smlt_context_get_links(struct smlt_context *ctx,
+                                struct smlt_context_links *links);
+
+/**
+ * @brief obtains the owner queues of all child channels, in child order
+ *
+ * @param links     the channels of the current node
+ * @param queues    returns links->num_queues owner queues
+ */
+void smlt_context_get_child_queues(struct smlt_context_links *links,
+                                   struct smlt_qp **queues);
+
+/*
+ * =============================================================================
+ * Tagged collectives
+ * =============================================================================
+ */
+
+struct smlt_tag_state;
+
+/**
+ * @brief obtains the tagged collectives state of the current node
+ *
+ * @param ctx   Smelt context
+ *
+ * @return the state, created on first use, or NULL
+ */
+struct smlt_tag_state *smlt_context_get_tag_state(struct smlt_context *ctx);
+
+/**
+ * @brief creates the tagged collectives state of the current node
+ *
+ * @param ctx   Smelt context
+ *
+ * @return the state or NULL if the allocation failed
+ */
+struct smlt_tag_state *smlt_tag_state_create(struct smlt_context *ctx);
+
+/**
+ * @brief frees the tagged collectives state
+ *
+ * @param ts    the state to free
+ */
+void smlt_tag_state_destroy(struct smlt_tag_state *ts);
+
+/*
+ * =============================================================================
+ * Atomic broadcast
+ * =============================================================================
+ */
+
+struct smlt_abcast_state;
+
+/**
+ * @brief obtains the atomic broadcast state of the current node
+ *
+ * @param ctx   Smelt context
+ *
+ * @return the state, created on first use, or NULL
+ */
+struct smlt_abcast_state *smlt_context_get_abcast_state(struct smlt_context *ctx);
+
+/**
+ * @brief creates the atomic broadcast state of the current node
+ *
+ * @param ctx   Smelt context
+ *
+ * @return the state or NULL if the allocation failed
+ */
+struct smlt_abcast_state *smlt_abcast_state_create(struct smlt_context *ctx);
+
+/**
+ * @brief frees the atomic broadcast state
+ *
+ * @param as    the state to free
+ */
+void smlt_abcast_state_destroy(struct smlt_abcast_state *as);
+
+/*
+ * =============================================================================
+ * Split barrier
+ * =============================================================================
+ */
+
+struct smlt_barrier_state;
+
+/**
+ * @brief obtains the split barrier state of the current node
+ *
+ * @param ctx   Smelt context
+ *
+ * @return the state, created on first use, or NULL
+ */
+struct smlt_barrier_state *smlt_context_get_barrier_state(struct smlt_context *ctx);
+
+/**
+ * @brief creates the split barrier state of the current node
+ *
+ * @param ctx   Smelt context
+ *
+ * @return the state or NULL if the allocation failed
+ */
+struct smlt_barrier_state *smlt_barrier_state_create(struct smlt_context *ctx);
+
+/**
+ * @brief frees the split barrier state
+ *
+ * @param bs    the state to free
+ */
+void smlt_barrier_state_destroy(struct smlt_barrier_state *bs);
+
+/*
+ * =============================================================================
+ * Caches
+ * =============================================================================
+ */
+
+///< initial value of smlt_model_cache_hash()
+#define SMLT_MODEL_CACHE_HASH_INIT 0xcbf29ce484222325ULL
+
+/**
+ * @brief adds data to an FNV-1a hash
+ *
+ * @param hash  the hash so far, SMLT_MODEL_CACHE_HASH_INIT to start
+ * @param data  the data to add
+ * @param len   length of the data in bytes
+ *
+ * @return the new hash
+ */
+uint64_t smlt_model_cache_hash(uint64_t hash, const void *data, size_t len);
+
 /*
  * =============================================================================
  * Platform specific functions
@@ -82,4 +244,12 @@ errval_t smlt_platform_thread_start_hook(void);
  */
 errval_t smlt_platform_thread_end_hook(void);
 
+/**
+ * @brief obtains the name of the machine
+ *
+ * @param buf   buffer to write the name to
+ * @param len   length of the buffer
+ */
+void smlt_platform_get_machine_name(char *buf, size_t len);
+
 #endif /* INTERNAL_DEBUG_H */
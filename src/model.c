@@ -0,0 +1,390 @@
+/*
+ * Copyright (c) 2016 ETH Zurich.
+ * All rights reserved.
+ *
+ * This file is distributed under the terms in the attached LICENSE file.
+ * If you do not find this file, copies can be found by writing to:
+ * ETH Zurich D-INFK, Universitaetstr. 6, CH-8092 Zurich. Attn: Systems Group.
+ */
+#include <string.h>
+
+#include <smlt.h>
+#include <smlt_generator.h>
+#include <smlt_topology.h>
+#include "smlt_debug.h"
+
+/*
+ * ===========================================================================
+ * creating sparse models
+ * ===========================================================================
+ */
+
+/**
+ * @brief creates an empty sparse model
+ *
+ * @param len       number of nodes in the model
+ * @param root      the root node
+ * @param sparse    returns the sparse model
+ *
+ * @return SMLT_SUCCESS or SMLT_ERR_MALLOC_FAIL
+ */
+errval_t smlt_sparse_model_create(uint32_t len, uint32_t root,
+                                  struct smlt_sparse_model **sparse)
+{
+    if (len == 0 || root >= len) {
+        return SMLT_ERR_INVAL;
+    }
+
+    struct smlt_sparse_model *m = (struct smlt_sparse_model *)
+        smlt_platform_alloc(sizeof(*m), SMLT_DEFAULT_ALIGNMENT, true);
+    if (m == NULL) {
+        return SMLT_ERR_MALLOC_FAIL;
+    }
+
+    m->len = len;
+    m->root = root;
+    m->parent = (uint32_t *)smlt_platform_alloc(len * sizeof(uint32_t),
+                                                SMLT_DEFAULT_ALIGNMENT, false);
+    m->parent_edge = (uint8_t *)smlt_platform_alloc(len * sizeof(uint8_t),
+                                                    SMLT_DEFAULT_ALIGNMENT, true);
+    m->child_idx = (uint32_t *)smlt_platform_alloc(len * sizeof(uint32_t),
+                                                   SMLT_DEFAULT_ALIGNMENT, true);
+    m->num_children = (uint32_t *)smlt_platform_alloc(len * sizeof(uint32_t),
+                                                      SMLT_DEFAULT_ALIGNMENT,
+                                                      true);
+    m->num_children_shm = (uint32_t *)smlt_platform_alloc(len * sizeof(uint32_t),
+                                                          SMLT_DEFAULT_ALIGNMENT,
+                                                          true);
+    m->child_offset = (uint32_t *)smlt_platform_alloc((len + 1) * sizeof(uint32_t),
+                                                      SMLT_DEFAULT_ALIGNMENT,
+                                                      true);
+    m->children = (uint32_t *)smlt_platform_alloc(len * sizeof(uint32_t),
+                                                  SMLT_DEFAULT_ALIGNMENT, true);
+
+    if (!m->parent || !m->parent_edge || !m->child_idx || !m->num_children ||
+        !m->num_children_shm || !m->child_offset || !m->children) {
+        smlt_sparse_model_destroy(m);
+        return SMLT_ERR_MALLOC_FAIL;
+    }
+
+    for (uint32_t i = 0; i < len; i++) {
+        m->parent[i] = SMLT_MODEL_NO_PARENT;
+    }
+
+    *sparse = m;
+
+    return SMLT_SUCCESS;
+}
+
+/**
+ * @brief frees the sparse model
+ *
+ * @param sparse    the sparse model
+ */
+void smlt_sparse_model_destroy(struct smlt_sparse_model *sparse)
+{
+    if (sparse == NULL) {
+        return;
+    }
+
+    void *bufs[] = {
+        sparse->parent, sparse->parent_edge, sparse->child_idx,
+        sparse->num_children, sparse->num_children_shm, sparse->child_offset,
+        sparse->children, sparse->leafs
+    };
+
+    for (uint32_t i = 0; i < sizeof(bufs) / sizeof(bufs[0]); i++) {
+        if (bufs[i]) {
+            smlt_platform_free(bufs[i]);
+        }
+    }
+
+    smlt_platform_free(sparse);
+}
+
+/**
+ * @brief connects a child at a given position of the parent's children
+ */
+static errval_t smlt_sparse_model_set_child(struct smlt_sparse_model *m,
+                                            uint32_t parent, uint32_t child,
+                                            uint8_t edge, uint32_t idx)
+{
+    if (parent >= m->len || child >= m->len || child == m->root ||
+        m->parent[child] != SMLT_MODEL_NO_PARENT) {
+        return SMLT_ERR_INVAL;
+    }
+
+    m->parent[child] = parent;
+    m->parent_edge[child] = edge;
+    m->child_idx[child] = idx;
+
+    uint32_t *count = (edge == SMLT_MODEL_EDGE_SHM) ? m->num_children_shm
+                                                    : m->num_children;
+    if (idx >= count[parent]) {
+        count[parent] = idx + 1;
+    }
+
+    return SMLT_SUCCESS;
+}
+
+/**
+ * @brief appends a child to the children of the parent
+ *
+ * @param sparse    the sparse model
+ * @param parent    the parent node
+ * @param child     the child node
+ * @param edge      the type of the edge (SMLT_MODEL_EDGE_*)
+ *
+ * @return SMLT_SUCCESS or SMLT_ERR_INVAL if the child is already connected
+ *
+ * The children are sent to in the order they are added.
+ */
+errval_t smlt_sparse_model_add_child(struct smlt_sparse_model *sparse,
+                                     uint32_t parent, uint32_t child,
+                                     uint8_t edge)
+{
+    if (parent >= sparse->len) {
+        return SMLT_ERR_INVAL;
+    }
+
+    uint32_t idx = (edge == SMLT_MODEL_EDGE_SHM) ? sparse->num_children_shm[parent]
+                                                 : sparse->num_children[parent];
+
+    return smlt_sparse_model_set_child(sparse, parent, child, edge, idx);
+}
+
+/**
+ * @brief builds the child lists and the leafs of the sparse model
+ *
+ * @param sparse    the sparse model
+ *
+ * @return SMLT_SUCCESS or SMLT_ERR_GENERATOR if the child positions of a
+ *         node are not contiguous
+ *
+ * Nodes that are neither the root nor connected to a parent are not part
+ * of the model and hence are no leafs.
+ */
+errval_t smlt_sparse_model_finalize(struct smlt_sparse_model *sparse)
+{
+    struct smlt_sparse_model *m = sparse;
+
+    m->child_offset[0] = 0;
+    for (uint32_t i = 0; i < m->len; i++) {
+        m->child_offset[i + 1] = m->child_offset[i] + m->num_children[i]
+                                 + m->num_children_shm[i];
+    }
+
+    if (m->child_offset[m->len] > m->len) {
+        return SMLT_ERR_GENERATOR;
+    }
+
+    /* mark all slots as empty to detect holes */
+    for (uint32_t i = 0; i < m->child_offset[m->len]; i++) {
+        m->children[i] = SMLT_MODEL_NO_PARENT;
+    }
+
+    uint32_t num_leafs = 0;
+    for (uint32_t i = 0; i < m->len; i++) {
+        uint32_t p = m->parent[i];
+        if (p != SMLT_MODEL_NO_PARENT) {
+            uint32_t pos = m->child_offset[p] + m->child_idx[i];
+            if (m->parent_edge[i] == SMLT_MODEL_EDGE_SHM) {
+                pos += m->num_children[p];
+            }
+            m->children[pos] = i;
+        }
+
+        if ((p != SMLT_MODEL_NO_PARENT || i == m->root) &&
+            m->child_offset[i] == m->child_offset[i + 1]) {
+            num_leafs++;
+        }
+    }
+
+    for (uint32_t i = 0; i < m->child_offset[m->len]; i++) {
+        if (m->children[i] == SMLT_MODEL_NO_PARENT) {
+            return SMLT_ERR_GENERATOR;
+        }
+    }
+
+    if (m->leafs) {
+        smlt_platform_free(m->leafs);
+    }
+
+    m->leafs = (uint32_t *)smlt_platform_alloc(num_leafs * sizeof(uint32_t),
+                                              SMLT_DEFAULT_ALIGNMENT, true);
+    if (m->leafs == NULL) {
+        return SMLT_ERR_MALLOC_FAIL;
+    }
+
+    m->num_leafs = 0;
+    for (uint32_t i = 0; i < m->len; i++) {
+        if ((m->parent[i] != SMLT_MODEL_NO_PARENT || i == m->root) &&
+            m->child_offset[i] == m->child_offset[i + 1]) {
+            m->leafs[m->num_leafs++] = i;
+        }
+    }
+
+    return SMLT_SUCCESS;
+}
+
+/*
+ * ===========================================================================
+ * conversion
+ * ===========================================================================
+ */
+
+/**
+ * @brief converts a dense model into the sparse representation
+ *
+ * @param model     the dense model
+ * @param sparse    returns the sparse model
+ *
+ * @return SMLT_SUCCESS or SMLT_ERR_GENERATOR if the model cannot be parsed
+ *
+ * The matrix is scanned once. The leafs of the dense model are kept.
+ */
+errval_t smlt_sparse_model_from_dense(struct smlt_generated_model *model,
+                                      struct smlt_sparse_model **sparse)
+{
+    errval_t err;
+    struct smlt_sparse_model *m;
+
+    err = smlt_sparse_model_create(model->len, model->root, &m);
+    if (smlt_err_is_fail(err)) {
+        return err;
+    }
+
+    for (uint32_t x = 0; x < model->len; x++) {
+        uint16_t *row = &model->model[x * model->len];
+        for (uint32_t y = 0; y < model->len; y++) {
+            uint16_t val = row[y];
+            if (val == 0 || val == TOPO_MATRIX_PARENT) {
+                // no connection, parents are given by the child entries
+                continue;
+            }
+
+            if (val <= TOPO_MATRIX_MAX_MP) {
+                // message passing (child)
+                SMLT_DEBUG(SMLT_DBG__INIT, "Child of %d is %d at pos %d \n",
+                           x, y, val - 1);
+                err = smlt_sparse_model_set_child(m, x, y, SMLT_MODEL_EDGE_MP,
+                                                  val - 1);
+            } else if ((val <= TOPO_MATRIX_SHM_SLAVE_MAX) &&
+                       (val >= TOPO_MATRIX_SHM_SLAVE_START)) {
+                // shared memory regions (slave)
+                SMLT_DEBUG(SMLT_DBG__INIT, "Parent (SHM) of %d is %d \n", x, y);
+                err = smlt_sparse_model_add_child(m, y, x, SMLT_MODEL_EDGE_SHM);
+            } else if ((val >= TOPO_MATRIX_SHM_MASTER_START) &&
+                       (val <= TOPO_MATRIX_SHM_MASTER_MAX)) {
+                // shared memory regions (masters)
+                assert (!"NYI Hybrid models");
+                err = SMLT_ERR_GENERATOR;
+            } else {
+                SMLT_ERROR("Encountered unexpected integer value in "
+                           "topology matrix - cannot parse\n");
+                err = SMLT_ERR_GENERATOR;
+            }
+
+            if (smlt_err_is_fail(err)) {
+                smlt_sparse_model_destroy(m);
+                return SMLT_ERR_GENERATOR;
+            }
+        }
+    }
+
+    err = smlt_sparse_model_finalize(m);
+    if (smlt_err_is_fail(err)) {
+        smlt_sparse_model_destroy(m);
+        return err;
+    }
+
+    /* keep the leafs as given by the model */
+    smlt_platform_free(m->leafs);
+    m->leafs = (uint32_t *)smlt_platform_alloc(model->num_leafs * sizeof(uint32_t),
+                                              SMLT_DEFAULT_ALIGNMENT, true);
+    if (m->leafs == NULL) {
+        smlt_sparse_model_destroy(m);
+        return SMLT_ERR_MALLOC_FAIL;
+    }
+    if (model->num_leafs) {
+        memcpy(m->leafs, model->leafs, model->num_leafs * sizeof(uint32_t));
+    }
+    m->num_leafs = model->num_leafs;
+
+    *sparse = m;
+
+    return SMLT_SUCCESS;
+}
+
+/**
+ * @brief converts a sparse model into the dense matrix representation
+ *
+ * @param sparse    the sparse model
+ * @param model     returns the dense model
+ *
+ * @return SMLT_SUCCESS, SMLT_ERR_MALLOC_FAIL or SMLT_ERR_GENERATOR if a
+ *         node has more than TOPO_MATRIX_MAX_MP message passing children,
+ *         which the matrix cannot encode
+ */
+errval_t smlt_sparse_model_to_dense(struct smlt_sparse_model *sparse,
+                                    struct smlt_generated_model **model)
+{
+    uint32_t len = sparse->len;
+
+    for (uint32_t i = 0; i < len; i++) {
+        if (sparse->num_children[i] > TOPO_MATRIX_MAX_MP) {
+            SMLT_WARNING("node %" PRIu32 " has %" PRIu32 " children, the dense "
+                         "model supports %u\n", i, sparse->num_children[i],
+                         TOPO_MATRIX_MAX_MP);
+            return SMLT_ERR_GENERATOR;
+        }
+    }
+
+    struct smlt_generated_model *m = (struct smlt_generated_model *)
+        smlt_platform_alloc(sizeof(*m), SMLT_DEFAULT_ALIGNMENT, true);
+    if (m == NULL) {
+        return SMLT_ERR_MALLOC_FAIL;
+    }
+
+    m->model = (uint16_t *)smlt_platform_alloc(len * len * sizeof(uint16_t),
+                                               SMLT_DEFAULT_ALIGNMENT, true);
+    m->leafs = (uint32_t *)smlt_platform_alloc(sparse->num_leafs * sizeof(uint32_t),
+                                              SMLT_DEFAULT_ALIGNMENT, true);
+    if (m->model == NULL || m->leafs == NULL) {
+        if (m->model) {
+            smlt_platform_free(m->model);
+        }
+        smlt_platform_free(m);
+        return SMLT_ERR_MALLOC_FAIL;
+    }
+
+    m->len = len;
+    m->root = sparse->root;
+    m->ncores = 0;
+
+    for (uint32_t i = 0; i < len; i++) {
+        uint32_t p = sparse->parent[i];
+        if (p != SMLT_MODEL_NO_PARENT || i == sparse->root) {
+            m->ncores++;
+        }
+        if (p == SMLT_MODEL_NO_PARENT) {
+            continue;
+        }
+
+        if (sparse->parent_edge[i] == SMLT_MODEL_EDGE_SHM) {
+            m->model[i * len + p] = TOPO_MATRIX_SHM_SLAVE_START;
+        } else {
+            m->model[p * len + i] = sparse->child_idx[i] + 1;
+            m->model[i * len + p] = TOPO_MATRIX_PARENT;
+        }
+    }
+
+    if (sparse->num_leafs) {
+        memcpy(m->leafs, sparse->leafs, sparse->num_leafs * sizeof(uint32_t));
+    }
+    m->num_leafs = sparse->num_leafs;
+
+    *model = m;
+
+    return SMLT_SUCCESS;
+}
@@ -0,0 +1,348 @@
+/*
+ * Copyright (c) 2016 ETH Zurich.
+ * All rights reserved.
+ *
+ * This file is distributed under the terms in the attached LICENSE file.
+ * If you do not find this file, copies can be found by writing to:
+ * ETH Zurich D-INFK, Universitaetstr. 6, CH-8092 Zurich. Attn: Systems Group.
+ */
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <smlt.h>
+#include <smlt_generator.h>
+#include "internal.h"
+
+#define SMLT_MODEL_CACHE_MAGIC   0x434d4c53 /* "SLMC" */
+#define SMLT_MODEL_CACHE_VERSION 1
+#define SMLT_MODEL_CACHE_NAMELEN 64
+#define SMLT_MODEL_CACHE_PATHLEN 256
+#define SMLT_MODEL_CACHE_MAX_LEN 65536  /* bounds the size of the matrix */
+
+#define SMLT_MODEL_CACHE_DEFAULT_TOPO "adaptivetree-shuffle-sort"
+
+/**
+ * header of a cached model, followed by the core ids, the leafs and
+ * the model matrix.
+ */
+struct smlt_model_cache_hdr
+{
+    uint32_t magic;
+    uint32_t version;
+    uint64_t key;                               ///< hash over the key fields
+    char machine[SMLT_MODEL_CACHE_NAMELEN];     ///< machine name
+    char topo[SMLT_MODEL_CACHE_NAMELEN];        ///< topology name
+    uint32_t ncores;                            ///< number of cores
+    uint32_t len;                               ///< length of a model column
+    uint32_t root;                              ///< root of the model
+    uint32_t num_leafs;                         ///< number of leafs
+};
+
+/**
+ * the lookup key of a model
+ */
+struct smlt_model_cache_key
+{
+    char machine[SMLT_MODEL_CACHE_NAMELEN];
+    char topo[SMLT_MODEL_CACHE_NAMELEN];
+    uint64_t hash;
+};
+
+static size_t smlt_model_cache_size(uint32_t ncores, uint32_t num_leafs,
+                                    uint32_t len)
+{
+    return sizeof(struct smlt_model_cache_hdr)
+           + (size_t)ncores * sizeof(uint32_t)
+           + (size_t)num_leafs * sizeof(uint32_t)
+           + (size_t)len * len * sizeof(uint16_t);
+}
+
+/**
+ * @brief checks the dimensions of a cached model against the requested cores
+ *
+ * The files live in a shared directory, the header is not trusted before
+ * its sizes are known to describe a model of these cores.
+ */
+static bool smlt_model_cache_hdr_valid(struct smlt_model_cache_hdr *hdr,
+                                       coreid_t *cores, uint32_t len)
+{
+    if (hdr->ncores != len || hdr->num_leafs > len ||
+        hdr->len > SMLT_MODEL_CACHE_MAX_LEN || hdr->root >= hdr->len) {
+        return false;
+    }
+
+    /* the matrix is indexed by core id */
+    for (uint32_t i = 0; i < len; i++) {
+        if (cores[i] >= hdr->len) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static bool smlt_model_cache_enabled(void)
+{
+    const char *env = getenv("SMLT_MODEL_CACHE");
+    return (env == NULL || strcmp(env, "0") != 0);
+}
+
+/**
+ * @brief adds data to an FNV-1a hash
+ *
+ * @param hash  the hash so far, SMLT_MODEL_CACHE_HASH_INIT to start
+ * @param data  the data to add
+ * @param len   length of the data in bytes
+ *
+ * @return the new hash
+ */
+uint64_t smlt_model_cache_hash(uint64_t hash, const void *data, size_t len)
+{
+    const uint8_t *p = (const uint8_t *)data;
+
+    /* FNV-1a */
+    for (size_t i = 0; i < len; i++) {
+        hash ^= p[i];
+        hash *= 0x100000001b3ULL;
+    }
+
+    return hash;
+}
+
+static void smlt_model_cache_get_key(coreid_t *cores, uint32_t len,
+                                     const char *name,
+                                     struct smlt_model_cache_key *key)
+{
+    memset(key, 0, sizeof(*key));
+
+    smlt_platform_get_machine_name(key->machine, sizeof(key->machine));
+
+    /* the Simulator resolves a missing name the same way */
+    if (name == NULL) {
+        name = getenv("SMLT_TOPO");
+    }
+    if (name == NULL) {
+        name = SMLT_MODEL_CACHE_DEFAULT_TOPO;
+    }
+    snprintf(key->topo, sizeof(key->topo), "%s", name);
+
+    key->hash = SMLT_MODEL_CACHE_HASH_INIT;
+    key->hash = smlt_model_cache_hash(key->hash, key->machine,
+                                      sizeof(key->machine));
+    key->hash = smlt_model_cache_hash(key->hash, key->topo, sizeof(key->topo));
+    for (uint32_t i = 0; i < len; i++) {
+        uint32_t core = cores[i];
+        key->hash = smlt_model_cache_hash(key->hash, &core, sizeof(core));
+    }
+}
+
+static void smlt_model_cache_get_path(struct smlt_model_cache_key *key,
+                                      char *buf, size_t len)
+{
+    const char *dir = getenv("SMLT_MODEL_CACHE_DIR");
+    if (dir == NULL) {
+        dir = "/tmp";
+    }
+
+    snprintf(buf, len, "%s/smlt-model-%016" PRIx64 ".bin", dir, key->hash);
+}
+
+/**
+ * @brief looks up a previously generated model in the model cache
+ *
+ * @param cores         an arry of cores that contains the
+ *                      cores of the model
+ * @param len           length of the cores array
+ * @param name          name of the tree topology, NULL for SMLT_TOPO
+ * @param model         encoded model (model itself, leafs, last_node)
+ *
+ * @return SMLT_SUCCESS if the model was found, SMLT_ERR_GENERATOR otherwise
+ *
+ * The model is copied out of the cache file into allocated buffers, it is
+ * owned by the caller like a model returned by the Simulator.
+ */
+errval_t smlt_model_cache_lookup(coreid_t* cores, uint32_t len,
+                                 const char* name,
+                                 struct smlt_generated_model** model)
+{
+    struct smlt_model_cache_key key;
+    char path[SMLT_MODEL_CACHE_PATHLEN];
+    struct stat st;
+
+    if (!smlt_model_cache_enabled()) {
+        return SMLT_ERR_GENERATOR;
+    }
+
+    smlt_model_cache_get_key(cores, len, name, &key);
+    smlt_model_cache_get_path(&key, path, sizeof(path));
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return SMLT_ERR_GENERATOR;
+    }
+
+    if (fstat(fd, &st) != 0 ||
+        (size_t)st.st_size < sizeof(struct smlt_model_cache_hdr)) {
+        close(fd);
+        return SMLT_ERR_GENERATOR;
+    }
+
+    void *buf = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (buf == MAP_FAILED) {
+        return SMLT_ERR_GENERATOR;
+    }
+
+    struct smlt_model_cache_hdr *hdr = (struct smlt_model_cache_hdr *)buf;
+    uint32_t *hdr_cores = (uint32_t *)(hdr + 1);
+
+    if (hdr->magic != SMLT_MODEL_CACHE_MAGIC ||
+        hdr->version != SMLT_MODEL_CACHE_VERSION ||
+        hdr->key != key.hash || !smlt_model_cache_hdr_valid(hdr, cores, len) ||
+        (size_t)st.st_size != smlt_model_cache_size(hdr->ncores,
+                                                    hdr->num_leafs,
+                                                    hdr->len) ||
+        memcmp(hdr->machine, key.machine, sizeof(key.machine)) != 0 ||
+        memcmp(hdr->topo, key.topo, sizeof(key.topo)) != 0) {
+        goto mismatch;
+    }
+
+    for (uint32_t i = 0; i < len; i++) {
+        if (hdr_cores[i] != cores[i]) {
+            goto mismatch;
+        }
+    }
+
+    uint32_t *hdr_leafs = hdr_cores + hdr->ncores;
+    for (uint32_t i = 0; i < hdr->num_leafs; i++) {
+        if (hdr_leafs[i] >= hdr->len) {
+            goto mismatch;
+        }
+    }
+
+    /* copy out of the mapping, the model is freed like a generated one */
+    struct smlt_generated_model *m = (struct smlt_generated_model*)
+        smlt_platform_alloc(sizeof(struct smlt_generated_model),
+                            SMLT_DEFAULT_ALIGNMENT, true);
+    if (m == NULL) {
+        munmap(buf, st.st_size);
+        return SMLT_ERR_MALLOC_FAIL;
+    }
+
+    size_t leafs_size = (size_t)hdr->num_leafs * sizeof(uint32_t);
+    size_t model_size = (size_t)hdr->len * hdr->len * sizeof(uint16_t);
+
+    m->leafs = NULL;
+    if (leafs_size) {
+        m->leafs = (uint32_t *)smlt_platform_alloc(leafs_size,
+                                                   SMLT_DEFAULT_ALIGNMENT, true);
+    }
+    m->model = (uint16_t *)smlt_platform_alloc(model_size,
+                                               SMLT_DEFAULT_ALIGNMENT, true);
+    if (m->model == NULL || (leafs_size && m->leafs == NULL)) {
+        if (m->model) {
+            smlt_platform_free(m->model);
+        }
+        if (m->leafs) {
+            smlt_platform_free(m->leafs);
+        }
+        smlt_platform_free(m);
+        munmap(buf, st.st_size);
+        return SMLT_ERR_MALLOC_FAIL;
+    }
+
+    m->ncores = hdr->ncores;
+    m->len = hdr->len;
+    m->root = hdr->root;
+    m->num_leafs = hdr->num_leafs;
+    if (leafs_size) {
+        memcpy(m->leafs, hdr_leafs, leafs_size);
+    }
+    memcpy(m->model, hdr_leafs + hdr->num_leafs, model_size);
+
+    munmap(buf, st.st_size);
+
+    SMLT_DEBUG(SMLT_DBG__INIT, "using cached model %s\n", path);
+
+    *model = m;
+
+    return SMLT_SUCCESS;
+
+ mismatch:
+    SMLT_DEBUG(SMLT_DBG__INIT, "cached model %s does not match\n", path);
+    munmap(buf, st.st_size);
+    return SMLT_ERR_GENERATOR;
+}
+
+/**
+ * @brief stores a generated model in the model cache
+ *
+ * @param model         the model to store
+ * @param cores         an arry of cores that contains the
+ *                      cores of the model
+ * @param len           length of the cores array
+ * @param name          name of the tree topology, NULL for SMLT_TOPO
+ *
+ * @return SMLT_SUCCESS or SMLT_ERR_GENERATOR if writing the file failed
+ */
+errval_t smlt_model_cache_store(struct smlt_generated_model* model,
+                                coreid_t* cores, uint32_t len,
+                                const char* name)
+{
+    struct smlt_model_cache_key key;
+    char path[SMLT_MODEL_CACHE_PATHLEN];
+    char tmp_path[SMLT_MODEL_CACHE_PATHLEN + 16];
+
+    if (!smlt_model_cache_enabled()) {
+        return SMLT_SUCCESS;
+    }
+
+    smlt_model_cache_get_key(cores, len, name, &key);
+    smlt_model_cache_get_path(&key, path, sizeof(path));
+
+    struct smlt_model_cache_hdr hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    hdr.magic = SMLT_MODEL_CACHE_MAGIC;
+    hdr.version = SMLT_MODEL_CACHE_VERSION;
+    hdr.key = key.hash;
+    memcpy(hdr.machine, key.machine, sizeof(hdr.machine));
+    memcpy(hdr.topo, key.topo, sizeof(hdr.topo));
+    hdr.ncores = len;
+    hdr.len = model->len;
+    hdr.root = model->root;
+    hdr.num_leafs = model->num_leafs;
+
+    /* write to a private file first, concurrent starts may race on the cache */
+    snprintf(tmp_path, sizeof(tmp_path), "%s.%d", path, (int)getpid());
+
+    FILE *file = fopen(tmp_path, "wb");
+    if (file == NULL) {
+        SMLT_WARNING("could not open %s for writing\n", tmp_path);
+        return SMLT_ERR_GENERATOR;
+    }
+
+    bool ok = fwrite(&hdr, sizeof(hdr), 1, file) == 1;
+    for (uint32_t i = 0; ok && i < len; i++) {
+        uint32_t core = cores[i];
+        ok = fwrite(&core, sizeof(core), 1, file) == 1;
+    }
+    if (ok && model->num_leafs) {
+        ok = fwrite(model->leafs, sizeof(uint32_t), model->num_leafs,
+                    file) == model->num_leafs;
+    }
+    if (ok) {
+        size_t n = (size_t)model->len * model->len;
+        ok = fwrite(model->model, sizeof(uint16_t), n, file) == n;
+    }
+
+    if (fclose(file) != 0 || !ok || rename(tmp_path, path) != 0) {
+        unlink(tmp_path);
+        return SMLT_ERR_GENERATOR;
+    }
+
+    return SMLT_SUCCESS;
+}
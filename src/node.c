@@ -130,7 +130,7 @@ errval_t smlt_node_lowlevel_init(smlt_nid_t nid)
         return err;
     }
 
-    coreid_t core = nid;
+    coreid_t core = smlt_get_core_by_id(nid);
     if (smlt_node_self != NULL) {
         core = smlt_node_self->core;
     }
@@ -12,6 +12,8 @@
 #include "../../internal.h"
 
 #include <numa.h>
+#include <stdio.h>
+#include <unistd.h>
 
 
 /**
@@ -144,3 +146,25 @@ uint8_t smlt_platform_cluster_of_core(coreid_t core_id)
 {
     return numa_node_of_cpu(core_id);
 }
+
+/**
+ * @brief obtains the name of the machine
+ *
+ * @param buf   buffer to write the name to
+ * @param len   length of the buffer
+ *
+ * The name is taken from SMLT_MACHINE if set, otherwise the hostname is used.
+ */
+void smlt_platform_get_machine_name(char *buf, size_t len)
+{
+    const char *env = getenv("SMLT_MACHINE");
+    if (env != NULL) {
+        snprintf(buf, len, "%s", env);
+        return;
+    }
+
+    if (gethostname(buf, len) != 0) {
+        snprintf(buf, len, "unknown");
+    }
+    buf[len - 1] = '\0';
+}
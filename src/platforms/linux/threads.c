@@ -14,6 +14,10 @@
 #include <stdlib.h>
 #include <sched.h>
 #include <stdarg.h>
+#include <limits.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
 
 
 
@@ -58,6 +62,36 @@ coreid_t smlt_platform_get_core_id(void)
     return sched_getcpu();
 }
 
+/*
+ * ===========================================================================
+ * Waiting
+ * ===========================================================================
+ */
+
+/**
+ * @brief blocks the calling thread while a word holds the given value
+ *
+ * @param word  the word to wait on
+ * @param val   the value the caller last read from the word
+ */
+void smlt_platform_wait(volatile uint32_t *word, uint32_t val)
+{
+    /* the futex returns right away if the word changed in the meantime */
+    while (*word == val) {
+        syscall(SYS_futex, word, FUTEX_WAIT_PRIVATE, val, NULL, NULL, 0);
+    }
+}
+
+/**
+ * @brief wakes the threads waiting on a word
+ *
+ * @param word  the word, changed by the caller before
+ */
+void smlt_platform_wake(volatile uint32_t *word)
+{
+    syscall(SYS_futex, word, FUTEX_WAKE_PRIVATE, INT_MAX, NULL, NULL, 0);
+}
+
 /**
  * @brief executed when the Smelt thread is initialized
  *
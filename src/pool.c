@@ -0,0 +1,271 @@
+/*
+ * Copyright (c) 2016 ETH Zurich.
+ * All rights reserved.
+ *
+ * This file is distributed under the terms in the attached LICENSE file.
+ * If you do not find this file, copies can be found by writing to:
+ * ETH Zurich D-INFK, Universitaetstr. 6, CH-8092 Zurich. Attn: Systems Group.
+ */
+#include <smlt.h>
+#include <smlt_node.h>
+#include <smlt_context.h>
+#include <smlt_broadcast.h>
+#include <smlt_reduction.h>
+#include <smlt_queuepair.h>
+#include <smlt_pool.h>
+#include "internal.h"
+
+/*
+ * ===========================================================================
+ * type definitions
+ * ===========================================================================
+ */
+
+///< number of words of a work descriptor: the function and its argument
+#define SMLT_POOL_MSG_WORDS     2
+
+///< states of the pool while it is created
+#define SMLT_POOL_STARTING      0
+#define SMLT_POOL_RUNNING       1
+#define SMLT_POOL_FAILED        2
+
+/**
+ * the persistent node threads of a context
+ */
+struct smlt_pool
+{
+    struct smlt_context *ctx;   ///< the context of the nodes
+    struct smlt_qp *submit;     ///< end of the owner of the pool
+    struct smlt_qp *root;       ///< end of the root of the context
+    uint32_t num_nodes;         ///< number of nodes in the pool
+    volatile uint32_t state;    ///< whether all nodes have been started
+    volatile uint32_t done SMLT_ARCH_ATTR_ALIGN; ///< number of regions run
+};
+
+/*
+ * ===========================================================================
+ * worker
+ * ===========================================================================
+ */
+
+/**
+ * @brief the loop of a node of the pool
+ *
+ * @param arg   the pool
+ *
+ * Runs the functions of the parallel regions until it receives a region
+ * without a function.
+ */
+static void *smlt_pool_worker(void *arg)
+{
+    struct smlt_pool *pool = (struct smlt_pool *)arg;
+    bool is_root = smlt_context_is_root(pool->ctx);
+
+    /* the nodes use the context only once all of them are running */
+    smlt_platform_wait(&pool->state, SMLT_POOL_STARTING);
+    if (pool->state == SMLT_POOL_FAILED) {
+        return NULL;
+    }
+
+    smlt_msg_payload_t data[SMLT_UMP_PAYLOAD_WORDS];
+    struct smlt_msg msg = {
+        .words = SMLT_POOL_MSG_WORDS,
+        .bufsize = sizeof(data),
+        .data = data
+    };
+
+    while (true) {
+        if (is_root) {
+            smlt_queuepair_recv(pool->root, &msg);
+        }
+
+        /* the other nodes are parked on the channel from their parent */
+        smlt_broadcast(pool->ctx, &msg);
+
+        smlt_node_start_fn_t fn = (smlt_node_start_fn_t)data[0];
+        if (fn == NULL) {
+            break;
+        }
+
+        fn((void *)data[1]);
+
+        smlt_reduce_notify(pool->ctx);
+
+        if (is_root) {
+            __sync_add_and_fetch(&pool->done, 1);
+            smlt_platform_wake(&pool->done);
+        }
+    }
+
+    return NULL;
+}
+
+/*
+ * ===========================================================================
+ * node pool
+ * ===========================================================================
+ */
+
+/**
+ * @brief sends a work descriptor to the root and waits for the region
+ *
+ * @param pool  the pool
+ * @param fn    the function, NULL stops the nodes
+ * @param arg   argument of the function
+ *
+ * The owner is not pinned and may share a core with a node, so it sleeps
+ * until the root counts the region as done instead of polling.
+ */
+static void smlt_pool_submit(struct smlt_pool *pool, smlt_node_start_fn_t fn,
+                             void *arg)
+{
+    smlt_msg_payload_t data[SMLT_POOL_MSG_WORDS] = {
+        (smlt_msg_payload_t)fn,
+        (smlt_msg_payload_t)arg
+    };
+    struct smlt_msg msg = {
+        .words = SMLT_POOL_MSG_WORDS,
+        .bufsize = sizeof(data),
+        .data = data
+    };
+
+    uint32_t done = pool->done;
+
+    smlt_queuepair_send(pool->submit, &msg);
+
+    if (fn != NULL) {
+        smlt_platform_wait(&pool->done, done);
+    }
+}
+
+/**
+ * @brief starts the nodes of a context as a pool
+ *
+ * @param ctx   the Smelt context
+ * @param ret   returns the pool
+ *
+ * @returns SMLT_SUCCESS, SMLT_ERR_INVAL, SMLT_ERR_MALLOC_FAIL or the error of
+ *          starting a node
+ */
+errval_t smlt_pool_create(struct smlt_context *ctx, struct smlt_pool **ret)
+{
+    errval_t err;
+
+    if (ctx == NULL || ret == NULL) {
+        return SMLT_ERR_INVAL;
+    }
+
+    uint32_t n = smlt_context_get_num_nodes(ctx);
+
+    struct smlt_node *root = NULL;
+    for (uint32_t r = 0; r < n; r++) {
+        struct smlt_node *node = smlt_get_node_by_id(smlt_context_get_node_id(ctx, r));
+        if (smlt_context_node_is_root(ctx, node)) {
+            root = node;
+        }
+    }
+
+    if (root == NULL) {
+        return SMLT_ERR_INVAL;
+    }
+
+    struct smlt_pool *pool = (struct smlt_pool *)
+        smlt_platform_alloc(sizeof(*pool), SMLT_ARCH_CACHELINE_SIZE, true);
+    if (pool == NULL) {
+        return SMLT_ERR_MALLOC_FAIL;
+    }
+
+    pool->ctx = ctx;
+    pool->num_nodes = n;
+    pool->state = SMLT_POOL_STARTING;
+
+    /* the owner is not pinned, its queue lives next to the root */
+    coreid_t core = smlt_node_get_coreid_of_node(root);
+    err = smlt_queuepair_create(SMLT_QP_TYPE_UMP, &pool->submit, &pool->root,
+                                core, core);
+    if (smlt_err_is_fail(err)) {
+        smlt_platform_free(pool);
+        return err;
+    }
+
+    uint32_t started;
+    for (started = 0; started < n; started++) {
+        struct smlt_node *node = smlt_get_node_by_id(smlt_context_get_node_id(ctx, started));
+        err = smlt_node_start(node, smlt_pool_worker, pool);
+        if (smlt_err_is_fail(err)) {
+            break;
+        }
+    }
+
+    if (started < n) {
+        /* the nodes already started return without touching the context */
+        pool->state = SMLT_POOL_FAILED;
+        smlt_platform_wake(&pool->state);
+
+        for (uint32_t r = 0; r < started; r++) {
+            smlt_node_join(smlt_get_node_by_id(smlt_context_get_node_id(ctx, r)));
+        }
+
+        smlt_queuepair_destroy(pool->submit);
+        smlt_queuepair_destroy(pool->root);
+        smlt_platform_free(pool->submit);
+        smlt_platform_free(pool->root);
+        smlt_platform_free(pool);
+
+        return err;
+    }
+
+    pool->state = SMLT_POOL_RUNNING;
+    smlt_platform_wake(&pool->state);
+
+    SMLT_DEBUG(SMLT_DBG__GENERAL, "started pool of %u nodes\n", n);
+
+    *ret = pool;
+
+    return SMLT_SUCCESS;
+}
+
+/**
+ * @brief stops the nodes of a pool and frees it
+ *
+ * @param pool  the pool
+ *
+ * @returns SMLT_SUCCESS
+ */
+errval_t smlt_pool_free(struct smlt_pool *pool)
+{
+    smlt_pool_submit(pool, NULL, NULL);
+
+    for (uint32_t r = 0; r < pool->num_nodes; r++) {
+        smlt_node_join(smlt_get_node_by_id(smlt_context_get_node_id(pool->ctx, r)));
+    }
+
+    smlt_queuepair_destroy(pool->submit);
+    smlt_queuepair_destroy(pool->root);
+    smlt_platform_free(pool->submit);
+    smlt_platform_free(pool->root);
+    smlt_platform_free(pool);
+
+    return SMLT_SUCCESS;
+}
+
+/**
+ * @brief runs a function on every node of the pool
+ *
+ * @param pool  the pool
+ * @param fn    the function, its return value is ignored
+ * @param arg   argument of the function
+ *
+ * @returns SMLT_SUCCESS or SMLT_ERR_INVAL
+ */
+errval_t smlt_pool_run(struct smlt_pool *pool, smlt_node_start_fn_t fn,
+                       void *arg)
+{
+    if (pool == NULL || fn == NULL) {
+        return SMLT_ERR_INVAL;
+    }
+
+    smlt_pool_submit(pool, fn, arg);
+
+    return SMLT_SUCCESS;
+}
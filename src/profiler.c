@@ -0,0 +1,526 @@
+/*
+ * Copyright (c) 2016 ETH Zurich.
+ * All rights reserved.
+ *
+ * This file is distributed under the terms in the attached LICENSE file.
+ * If you do not find this file, copies can be found by writing to:
+ * ETH Zurich D-INFK, Universitaetstr. 6, CH-8092 Zurich. Attn: Systems Group.
+ */
+#include <stdio.h>
+#include <string.h>
+
+#include <smlt.h>
+#include <smlt_node.h>
+#include <smlt_queuepair.h>
+#include <smlt_bench.h>
+#include <smlt_profiler.h>
+#include "internal.h"
+
+#define SMLT_PROFILER_MAGIC   0x504c4d53 /* "SMLP" */
+#define SMLT_PROFILER_VERSION 1
+#define SMLT_PROFILER_NAMELEN 256
+
+/**
+ * header of the binary profile, followed by the core ids and the
+ * send, receive and propagation matrices.
+ */
+struct smlt_profile_hdr
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t ncores;
+    uint32_t batch;
+};
+
+/**
+ * state of a single pairwise measurement
+ */
+struct smlt_profiler_pair
+{
+    uint32_t src;                   ///< index of the sending core
+    uint32_t dst;                   ///< index of the receiving core
+    struct smlt_qp *qp_src;         ///< sender end of the queuepair
+    struct smlt_qp *qp_dst;         ///< receiver end of the queuepair
+    struct smlt_bench_ctl send;     ///< per message send cost
+    struct smlt_bench_ctl recv;     ///< per message receive cost
+    struct smlt_bench_ctl rtt;      ///< round trip time of a single message
+};
+
+/*
+ * ===========================================================================
+ * profile allocation
+ * ===========================================================================
+ */
+
+static size_t smlt_profiler_size(uint32_t ncores)
+{
+    return sizeof(struct smlt_profile_hdr) + (size_t)ncores * sizeof(coreid_t)
+           + 3 * (size_t)ncores * ncores * sizeof(uint32_t);
+}
+
+/**
+ * @brief sets the array pointers of the profile to its buffer
+ */
+static void smlt_profiler_setup(struct smlt_profile *p, uint32_t ncores)
+{
+    size_t n2 = (size_t)ncores * ncores;
+
+    p->ncores = ncores;
+    p->cores = (coreid_t *)((struct smlt_profile_hdr *)p->buf + 1);
+    p->send = (uint32_t *)(p->cores + ncores);
+    p->recv = p->send + n2;
+    p->prop = p->recv + n2;
+}
+
+static struct smlt_profile *smlt_profiler_alloc(uint32_t ncores)
+{
+    struct smlt_profile *p;
+
+    p = (struct smlt_profile *) smlt_platform_alloc(sizeof(*p),
+                                                    SMLT_DEFAULT_ALIGNMENT,
+                                                    true);
+    if (p == NULL) {
+        return NULL;
+    }
+
+    p->bufsize = smlt_profiler_size(ncores);
+    p->buf = smlt_platform_alloc(p->bufsize, SMLT_ARCH_CACHELINE_SIZE, true);
+    if (p->buf == NULL) {
+        smlt_platform_free(p);
+        return NULL;
+    }
+
+    struct smlt_profile_hdr *hdr = (struct smlt_profile_hdr *)p->buf;
+    hdr->magic = SMLT_PROFILER_MAGIC;
+    hdr->version = SMLT_PROFILER_VERSION;
+    hdr->ncores = ncores;
+    hdr->batch = SMLT_PROFILER_BATCH;
+
+    smlt_profiler_setup(p, ncores);
+
+    return p;
+}
+
+/**
+ * @brief frees the profile
+ *
+ * @param profile   the profile to free
+ */
+void smlt_profiler_destroy(struct smlt_profile *profile)
+{
+    if (profile == NULL) {
+        return;
+    }
+
+    smlt_platform_free(profile->buf);
+    smlt_platform_free(profile);
+}
+
+/*
+ * ===========================================================================
+ * measuring
+ * ===========================================================================
+ */
+
+static void *smlt_profiler_sender(void *arg)
+{
+    struct smlt_profiler_pair *p = (struct smlt_profiler_pair *)arg;
+    struct smlt_qp *qp = p->qp_src;
+    cycles_t t;
+
+    /* round trip of a single message */
+    for (uint32_t i = 0; i < SMLT_PROFILER_ROUNDS; i++) {
+        t = smlt_arch_tsc();
+        smlt_queuepair_notify(qp);
+        smlt_queuepair_recv0(qp);
+        smlt_bench_clt_add_value(&p->rtt, smlt_arch_tsc() - t);
+    }
+
+    /* cost of sending a batch of messages back-to-back */
+    for (uint32_t i = 0; i < SMLT_PROFILER_ROUNDS; i++) {
+        t = smlt_arch_tsc();
+        for (uint32_t j = 0; j < SMLT_PROFILER_BATCH; j++) {
+            smlt_queuepair_notify(qp);
+        }
+        smlt_bench_clt_add_value(&p->send,
+                                 (smlt_arch_tsc() - t) / SMLT_PROFILER_BATCH);
+
+        for (uint32_t j = 0; j < SMLT_PROFILER_BATCH; j++) {
+            smlt_queuepair_recv0(qp);
+        }
+    }
+
+    return NULL;
+}
+
+static void *smlt_profiler_receiver(void *arg)
+{
+    struct smlt_profiler_pair *p = (struct smlt_profiler_pair *)arg;
+    struct smlt_qp *qp = p->qp_dst;
+    cycles_t t;
+
+    for (uint32_t i = 0; i < SMLT_PROFILER_ROUNDS; i++) {
+        smlt_queuepair_recv0(qp);
+        smlt_queuepair_notify(qp);
+    }
+
+    for (uint32_t i = 0; i < SMLT_PROFILER_ROUNDS; i++) {
+        while (!smlt_queuepair_can_recv(qp)) {
+            /* wait for the batch to start arriving */
+        }
+
+        t = smlt_arch_tsc();
+        for (uint32_t j = 0; j < SMLT_PROFILER_BATCH; j++) {
+            smlt_queuepair_recv0(qp);
+        }
+        smlt_bench_clt_add_value(&p->recv,
+                                 (smlt_arch_tsc() - t) / SMLT_PROFILER_BATCH);
+
+        for (uint32_t j = 0; j < SMLT_PROFILER_BATCH; j++) {
+            smlt_queuepair_notify(qp);
+        }
+    }
+
+    return NULL;
+}
+
+static uint32_t smlt_profiler_median(struct smlt_bench_ctl *ctl)
+{
+    smlt_bench_ctl_prepare_analysis(ctl, SMLT_BENCH_IGNORE_DEFAULT);
+    if (ctl->a.median > UINT32_MAX) {
+        return UINT32_MAX;
+    }
+    return (uint32_t)ctl->a.median;
+}
+
+/**
+ * @brief measures a set of disjoint core pairs concurrently
+ */
+static errval_t smlt_profiler_run_pairs(struct smlt_profile *profile,
+                                        struct smlt_node **nodes,
+                                        struct smlt_profiler_pair *pairs,
+                                        uint32_t num_pairs)
+{
+    errval_t err;
+
+    for (uint32_t i = 0; i < num_pairs; i++) {
+        struct smlt_profiler_pair *p = &pairs[i];
+
+        err = smlt_queuepair_create(SMLT_QP_TYPE_UMP, &p->qp_src, &p->qp_dst,
+                                    profile->cores[p->src],
+                                    profile->cores[p->dst]);
+        if (smlt_err_is_fail(err)) {
+            return err;
+        }
+
+        smlt_bench_ctl_reset(&p->send);
+        smlt_bench_ctl_reset(&p->recv);
+        smlt_bench_ctl_reset(&p->rtt);
+    }
+
+    for (uint32_t i = 0; i < num_pairs; i++) {
+        struct smlt_profiler_pair *p = &pairs[i];
+
+        err = smlt_node_start(nodes[p->dst], smlt_profiler_receiver, p);
+        if (smlt_err_is_fail(err)) {
+            return smlt_err_push(err, SMLT_ERR_NODE_START);
+        }
+
+        err = smlt_node_start(nodes[p->src], smlt_profiler_sender, p);
+        if (smlt_err_is_fail(err)) {
+            return smlt_err_push(err, SMLT_ERR_NODE_START);
+        }
+    }
+
+    for (uint32_t i = 0; i < num_pairs; i++) {
+        struct smlt_profiler_pair *p = &pairs[i];
+
+        smlt_node_join(nodes[p->src]);
+        smlt_node_join(nodes[p->dst]);
+
+        uint32_t idx = p->src * profile->ncores + p->dst;
+        uint32_t rtt = smlt_profiler_median(&p->rtt);
+
+        profile->send[idx] = smlt_profiler_median(&p->send);
+        profile->recv[idx] = smlt_profiler_median(&p->recv);
+
+        /* whatever is left of the one-way latency is spent on the interconnect */
+        if (rtt / 2 > profile->send[idx] + profile->recv[idx]) {
+            profile->prop[idx] = rtt / 2 - profile->send[idx] - profile->recv[idx];
+        } else {
+            profile->prop[idx] = 0;
+        }
+
+        smlt_queuepair_destroy(p->qp_src);
+        smlt_queuepair_destroy(p->qp_dst);
+        smlt_platform_free(p->qp_src);
+        smlt_platform_free(p->qp_dst);
+    }
+
+    return SMLT_SUCCESS;
+}
+
+/**
+ * @brief measures the pairwise send, receive and propagation costs
+ *
+ * @param cores         array of core ids to profile
+ * @param ncores        length of the cores array
+ * @param max_pairs     maximum number of core pairs measured concurrently,
+ *                      0 measures all disjoint pairs of a round in parallel
+ * @param ret_profile   returns the measured profile
+ *
+ * @return SMLT_SUCCESS or error value
+ */
+errval_t smlt_profiler_measure(coreid_t *cores, uint32_t ncores,
+                               uint32_t max_pairs,
+                               struct smlt_profile **ret_profile)
+{
+    errval_t err = SMLT_SUCCESS;
+
+    if (cores == NULL || ncores < 2 || ret_profile == NULL) {
+        return SMLT_ERR_INVAL;
+    }
+
+    struct smlt_profile *profile = smlt_profiler_alloc(ncores);
+    if (profile == NULL) {
+        return SMLT_ERR_MALLOC_FAIL;
+    }
+    memcpy(profile->cores, cores, ncores * sizeof(coreid_t));
+
+    /* round-robin tournament: an odd number of cores gets a dummy partner */
+    uint32_t num_slots = ncores + (ncores & 1);
+    uint32_t pairs_per_round = num_slots / 2;
+    if (max_pairs == 0 || max_pairs > pairs_per_round) {
+        max_pairs = pairs_per_round;
+    }
+
+    struct smlt_node **nodes = (struct smlt_node **)
+        smlt_platform_alloc(ncores * sizeof(void *), SMLT_DEFAULT_ALIGNMENT, true);
+    struct smlt_profiler_pair *pairs = (struct smlt_profiler_pair *)
+        smlt_platform_alloc(pairs_per_round * sizeof(*pairs),
+                            SMLT_ARCH_CACHELINE_SIZE, true);
+    uint32_t *round = (uint32_t *)
+        smlt_platform_alloc(2 * pairs_per_round * sizeof(uint32_t),
+                            SMLT_DEFAULT_ALIGNMENT, true);
+    if (nodes == NULL || pairs == NULL || round == NULL) {
+        err = SMLT_ERR_MALLOC_FAIL;
+        goto out;
+    }
+
+    for (uint32_t i = 0; i < ncores; i++) {
+        struct smlt_node_args args = {
+            .id = i,
+            .core = cores[i],
+            .num_nodes = 1,
+        };
+        err = smlt_node_create(&nodes[i], &args);
+        if (smlt_err_is_fail(err)) {
+            err = smlt_err_push(err, SMLT_ERR_NODE_CREATE);
+            goto out;
+        }
+    }
+
+    for (uint32_t i = 0; i < pairs_per_round; i++) {
+        err = smlt_bench_ctl_init(&pairs[i].send, "send", SMLT_PROFILER_ROUNDS);
+        if (smlt_err_is_ok(err)) {
+            err = smlt_bench_ctl_init(&pairs[i].recv, "receive",
+                                      SMLT_PROFILER_ROUNDS);
+        }
+        if (smlt_err_is_ok(err)) {
+            err = smlt_bench_ctl_init(&pairs[i].rtt, "rtt", SMLT_PROFILER_ROUNDS);
+        }
+        if (smlt_err_is_fail(err)) {
+            goto out;
+        }
+    }
+
+    for (uint32_t r = 0; r < num_slots - 1; r++) {
+
+        /* the last slot is fixed, the others rotate around it */
+        uint32_t num_round = 0;
+        for (uint32_t k = 0; k < pairs_per_round; k++) {
+            uint32_t a, b;
+            if (k == 0) {
+                a = r;
+                b = num_slots - 1;
+            } else {
+                a = (r + k) % (num_slots - 1);
+                b = (r + num_slots - 1 - k) % (num_slots - 1);
+            }
+
+            if (a >= ncores || b >= ncores) {
+                continue;
+            }
+            round[2 * num_round] = a;
+            round[2 * num_round + 1] = b;
+            num_round++;
+        }
+
+        SMLT_DEBUG(SMLT_DBG__INIT, "profiler: round %" PRIu32 " with %" PRIu32
+                   " pairs\n", r, num_round);
+
+        /* measure both directions of each pair in batches of max_pairs */
+        for (uint32_t dir = 0; dir < 2; dir++) {
+            for (uint32_t start = 0; start < num_round; start += max_pairs) {
+                uint32_t count = num_round - start;
+                if (count > max_pairs) {
+                    count = max_pairs;
+                }
+
+                for (uint32_t i = 0; i < count; i++) {
+                    pairs[i].src = round[2 * (start + i) + dir];
+                    pairs[i].dst = round[2 * (start + i) + !dir];
+                }
+
+                err = smlt_profiler_run_pairs(profile, nodes, pairs, count);
+                if (smlt_err_is_fail(err)) {
+                    goto out;
+                }
+            }
+        }
+    }
+
+ out:
+    if (pairs) {
+        for (uint32_t i = 0; i < pairs_per_round; i++) {
+            smlt_bench_ctl_destroy(&pairs[i].send);
+            smlt_bench_ctl_destroy(&pairs[i].recv);
+            smlt_bench_ctl_destroy(&pairs[i].rtt);
+        }
+        smlt_platform_free(pairs);
+    }
+    if (nodes) {
+        for (uint32_t i = 0; i < ncores; i++) {
+            if (nodes[i]) {
+                smlt_platform_free(nodes[i]);
+            }
+        }
+        smlt_platform_free(nodes);
+    }
+    if (round) {
+        smlt_platform_free(round);
+    }
+
+    if (smlt_err_is_fail(err)) {
+        smlt_profiler_destroy(profile);
+        return err;
+    }
+
+    *ret_profile = profile;
+    return SMLT_SUCCESS;
+}
+
+/*
+ * ===========================================================================
+ * persistence
+ * ===========================================================================
+ */
+
+/**
+ * @brief obtains the path of the per-host profile cache
+ *
+ * @param buf   buffer to write the path to
+ * @param len   length of the buffer
+ */
+void smlt_profiler_get_path(char *buf, size_t len)
+{
+    const char *path = getenv("SMLT_PROFILE");
+    if (path != NULL) {
+        snprintf(buf, len, "%s", path);
+        return;
+    }
+
+    const char *dir = getenv("SMLT_PROFILE_DIR");
+    if (dir == NULL) {
+        dir = "/tmp";
+    }
+
+    char machine[SMLT_PROFILER_NAMELEN];
+    smlt_platform_get_machine_name(machine, sizeof(machine));
+
+    snprintf(buf, len, "%s/smlt-%s.prof", dir, machine);
+}
+
+/**
+ * @brief writes the profile to a file
+ *
+ * @param profile   the profile to store
+ * @param path      path of the file, NULL for the per-host default
+ *
+ * @return SMLT_SUCCESS or SMLT_ERR_PROFILE_IO
+ */
+errval_t smlt_profiler_store(struct smlt_profile *profile, const char *path)
+{
+    char default_path[SMLT_PROFILER_NAMELEN];
+
+    if (path == NULL) {
+        smlt_profiler_get_path(default_path, sizeof(default_path));
+        path = default_path;
+    }
+
+    FILE *file = fopen(path, "wb");
+    if (file == NULL) {
+        SMLT_WARNING("profiler: could not open %s for writing\n", path);
+        return SMLT_ERR_PROFILE_IO;
+    }
+
+    size_t written = fwrite(profile->buf, 1, profile->bufsize, file);
+    fclose(file);
+
+    if (written != profile->bufsize) {
+        return SMLT_ERR_PROFILE_IO;
+    }
+
+    return SMLT_SUCCESS;
+}
+
+/**
+ * @brief reads a profile from a file
+ *
+ * @param path          path of the file, NULL for the per-host default
+ * @param ret_profile   returns the profile
+ *
+ * @return SMLT_SUCCESS or SMLT_ERR_PROFILE_IO
+ */
+errval_t smlt_profiler_load(const char *path, struct smlt_profile **ret_profile)
+{
+    char default_path[SMLT_PROFILER_NAMELEN];
+    struct smlt_profile_hdr hdr;
+
+    if (path == NULL) {
+        smlt_profiler_get_path(default_path, sizeof(default_path));
+        path = default_path;
+    }
+
+    FILE *file = fopen(path, "rb");
+    if (file == NULL) {
+        return SMLT_ERR_PROFILE_IO;
+    }
+
+    /* a profile covers at most the cores of this machine */
+    if (fread(&hdr, sizeof(hdr), 1, file) != 1 ||
+        hdr.magic != SMLT_PROFILER_MAGIC ||
+        hdr.version != SMLT_PROFILER_VERSION || hdr.ncores < 2 ||
+        hdr.ncores > smlt_platform_num_cores()) {
+        fclose(file);
+        return SMLT_ERR_PROFILE_IO;
+    }
+
+    struct smlt_profile *profile = smlt_profiler_alloc(hdr.ncores);
+    if (profile == NULL) {
+        fclose(file);
+        return SMLT_ERR_MALLOC_FAIL;
+    }
+
+    size_t remaining = profile->bufsize - sizeof(hdr);
+    size_t read = fread((char *)profile->buf + sizeof(hdr), 1, remaining, file);
+    fclose(file);
+
+    if (read != remaining) {
+        smlt_profiler_destroy(profile);
+        return SMLT_ERR_PROFILE_IO;
+    }
+
+    *ret_profile = profile;
+    return SMLT_SUCCESS;
+}
@@ -73,13 +73,19 @@ bool smlt_ffq_can_send(struct smlt_qp *qp)
 
 errval_t smlt_shm_send(struct smlt_qp *qp, struct smlt_msg *msg)
 {
-    if (msg->words <= 7) {
+    struct swmr_context *q = &qp->queue_tx.shm.src;
+
+    if (!swmr_can_send(q)) {
+        return SMLT_ERR_QUEUE_FULL;
+    }
+
+    // messages spanning several slots block until the last slot is written
+    if (msg->words <= SWMR_PAYLOAD_WORDS) {
         uintptr_t* data = (uintptr_t*) msg->data;
-        shm_q_send(&qp->queue_tx.shm.src,
-                    data[0], data[1], data[2],
-                    data[3], data[4], data[5], data[6]);
+        swmr_send_raw(q, data[0], data[1], data[2],
+                      data[3], data[4], data[5], data[6]);
     } else {
-        // TODO Fragment ? Or Bulkload style?
+        swmr_send(q, (uintptr_t*) msg->data, msg->words);
     }
     return SMLT_SUCCESS;
 }
@@ -87,35 +93,34 @@ errval_t smlt_shm_send(struct smlt_qp *qp, struct smlt_msg *msg)
 
 errval_t smlt_shm_recv(struct smlt_qp *qp, struct smlt_msg *msg)
 {
-    // TODO msg struct must be allocated i.e. where to encode msg
-    //      size that is allocated
-    // TODO Fragmentation
-    uintptr_t* data = (uintptr_t*) msg->data;
+    struct swmr_context *q = &qp->queue_rx.shm.dst;
 
-    shm_q_recv(&qp->queue_rx.shm.dst, &data[0], &data[1],
-               &data[2], &data[3], &data[4], &data[5], &data[6]);
-    return SMLT_SUCCESS;
+    if (!swmr_can_receive(q)) {
+        return SMLT_ERR_QUEUE_EMPTY;
+    }
+
+    return smlt_swmr_recv(q, msg);
 }
 
 
 errval_t smlt_shm_recv0(struct smlt_qp *qp)
 {
-    shm_q_recv0(&qp->queue_rx.shm.dst);
+    swmr_receive_raw0(&qp->queue_rx.shm.dst);
     return SMLT_SUCCESS;
 }
 
 errval_t smlt_shm_send0(struct smlt_qp *qp)
 {
-    shm_q_send0(&qp->queue_tx.shm.src);
+    swmr_send_raw0(&qp->queue_tx.shm.src);
     return SMLT_SUCCESS;
 }
 
 bool smlt_shm_can_recv(struct smlt_qp *qp)
 {
-    return shm_q_can_recv(&qp->queue_rx.shm.dst);
+    return swmr_can_receive(&qp->queue_rx.shm.dst);
 }
 
 bool smlt_shm_can_send(struct smlt_qp *qp)
 {
-    return shm_q_can_send(&qp->queue_tx.shm.src);
+    return swmr_can_send(&qp->queue_tx.shm.src);
 }
@@ -101,8 +101,18 @@ errval_t smlt_queuepair_create(smlt_qp_type_t type,
             break;
         case SMLT_QP_TYPE_SHM :
             // create two queues
-            (qp_src)->queue_tx.shm = *shm_queuepair_create(core_src, core_dst);
-            (qp_src)->queue_rx.shm = *shm_queuepair_create(core_dst, core_src);
+            err = shm_queuepair_init(&(qp_src)->queue_tx.shm, core_src,
+                                     core_dst, false);
+            if (smlt_err_is_fail(err)) {
+                return smlt_err_push(err, SMLT_ERR_ALLOC_SHM);
+            }
+
+            err = shm_queuepair_init(&(qp_src)->queue_rx.shm, core_dst,
+                                     core_src, false);
+            if (smlt_err_is_fail(err)) {
+                shm_queuepair_destroy(&(qp_src)->queue_tx.shm);
+                return smlt_err_push(err, SMLT_ERR_ALLOC_SHM);
+            }
 
             (qp_dst)->queue_rx.shm = (qp_src)->queue_tx.shm;
             (qp_dst)->queue_tx.shm = (qp_src)->queue_rx.shm;
@@ -136,21 +146,24 @@ errval_t smlt_queuepair_create(smlt_qp_type_t type,
  */
 errval_t smlt_queuepair_destroy(struct smlt_qp *qp)
 {
-    //int ret;
+    errval_t err;
+
     switch(qp->type) {
         case SMLT_QP_TYPE_UMP :
-            // TODO destroy always returns 0
-            //ret = ump_queuepair_destroy(&(qp->queue_tx.ump));
-            //ret = ump_queuepair_destroy(&(qp->queue_rx.ump));
-            //if (ret) {
-                return SMLT_ERR_DESTROY_UMP;
-            //}
+            err = smlt_ump_queuepair_destroy(&qp->q.ump);
+            if (smlt_err_is_fail(err)) {
+                return smlt_err_push(err, SMLT_ERR_DESTROY_UMP);
+            }
             break;
         case SMLT_QP_TYPE_FFQ :
-            // TODO do destroy
+            err = smlt_ffq_queuepair_destroy(&qp->q.ffq);
+            if (smlt_err_is_fail(err)) {
+                return smlt_err_push(err, SMLT_ERR_DESTROY_FFQ);
+            }
             break;
         case SMLT_QP_TYPE_SHM :
-            // TODO do destroy
+            // each end frees the queue it transmits on
+            shm_queuepair_destroy(&qp->queue_tx.shm);
             break;
         default:
             break;
@@ -20,6 +20,82 @@ uint32_t smlt_gbl_num_proc = 0;
 static struct smlt_node **smlt_gbl_all_nodes;
 static uint32_t smlt_gbl_all_node_count;
 
+static coreid_t *smlt_gbl_node_cores;       ///< maps node ids to cores
+static smlt_nid_t *smlt_gbl_core_nodes;     ///< maps cores to node ids
+static uint32_t smlt_gbl_core_nodes_len;    ///< length of the core map
+
+/**
+ * @brief frees the mapping between node ids and cores
+ */
+static void smlt_free_core_map(void)
+{
+    if (smlt_gbl_node_cores) {
+        smlt_platform_free(smlt_gbl_node_cores);
+        smlt_gbl_node_cores = NULL;
+    }
+    if (smlt_gbl_core_nodes) {
+        smlt_platform_free(smlt_gbl_core_nodes);
+        smlt_gbl_core_nodes = NULL;
+    }
+    smlt_gbl_core_nodes_len = 0;
+}
+
+/**
+ * @brief sets up the mapping between node ids and cores
+ *
+ * @param cores     the cores of the nodes, NULL for the identity
+ * @param num_proc  the number of nodes
+ *
+ * @return SMLT_SUCCESS, SMLT_ERR_INVAL or SMLT_ERR_MALLOC_FAIL
+ *
+ * The reverse map only spans up to the highest core in use.
+ */
+static errval_t smlt_init_core_map(coreid_t *cores, uint32_t num_proc)
+{
+    uint32_t num_cores = smlt_platform_num_cores();
+    uint32_t len = 0;
+
+    for (uint32_t i = 0; i < num_proc; i++) {
+        coreid_t core = (cores ? cores[i] : i);
+        if (core >= num_cores) {
+            SMLT_ERROR("core %" PRIu32 " does not exist\n", core);
+            return SMLT_ERR_INVAL;
+        }
+        if (core >= len) {
+            len = core + 1;
+        }
+    }
+
+    smlt_gbl_node_cores = (coreid_t *) smlt_platform_alloc(num_proc * sizeof(coreid_t),
+                                                           SMLT_ARCH_CACHELINE_SIZE,
+                                                           true);
+    smlt_gbl_core_nodes = (smlt_nid_t *) smlt_platform_alloc(len * sizeof(smlt_nid_t),
+                                                             SMLT_ARCH_CACHELINE_SIZE,
+                                                             true);
+    if (smlt_gbl_node_cores == NULL || smlt_gbl_core_nodes == NULL) {
+        smlt_free_core_map();
+        return SMLT_ERR_MALLOC_FAIL;
+    }
+
+    for (uint32_t i = 0; i < len; i++) {
+        smlt_gbl_core_nodes[i] = SMLT_NID_INVALID;
+    }
+
+    for (uint32_t i = 0; i < num_proc; i++) {
+        coreid_t core = (cores ? cores[i] : i);
+        if (smlt_gbl_core_nodes[core] != SMLT_NID_INVALID) {
+            SMLT_ERROR("core %" PRIu32 " is used twice\n", core);
+            smlt_free_core_map();
+            return SMLT_ERR_INVAL;
+        }
+        smlt_gbl_node_cores[i] = core;
+        smlt_gbl_core_nodes[core] = i;
+    }
+    smlt_gbl_core_nodes_len = len;
+
+    return SMLT_SUCCESS;
+}
+
 
 /**
  * @brief initializes the Smelt library
@@ -34,10 +110,29 @@ static uint32_t smlt_gbl_all_node_count;
  * executed on each process.
  */
 errval_t smlt_init(uint32_t num_proc, bool eagerly)
+{
+    return smlt_init_cores(NULL, num_proc, eagerly);
+}
+
+/**
+ * @brief initializes the Smelt library on a set of cores
+ *
+ * @param cores     the cores to run the nodes on, node i runs on cores[i].
+ *                  NULL for the cores 0 .. num_proc-1
+ * @param num_proc  the number of processors
+ * @param eagerly   create an all-to-all connection mesh
+ *
+ * @returns SMLT_SUCCESS on success
+ *          SMLT_ERR_INVAL if a core does not exist or is given twice
+ *
+ * Allows several Smelt instances to run on disjoint subsets of the cores
+ * of a machine. The node ids are always 0 .. num_proc-1.
+ */
+errval_t smlt_init_cores(coreid_t *cores, uint32_t num_proc, bool eagerly)
 {
     errval_t err;
 
-    if (num_proc > sysconf(_SC_NPROCESSORS_ONLN)) {
+    if (cores == NULL && num_proc > sysconf(_SC_NPROCESSORS_ONLN)) {
 
         SMLT_NOTICE("Not enough cores to initialize Smelt, exiting\n");
         return SMLT_ERR_PLATFORM_INIT;
@@ -58,6 +153,17 @@ errval_t smlt_init(uint32_t num_proc, bool eagerly)
         return SMLT_ERR_PLATFORM_INIT;
     }
 
+    if (cores != NULL && smlt_gbl_num_proc != num_proc) {
+        SMLT_ERROR("Platform supports only %" PRIu32 " nodes\n",
+                   smlt_gbl_num_proc);
+        return SMLT_ERR_INVAL;
+    }
+
+    err = smlt_init_core_map(cores, smlt_gbl_num_proc);
+    if (smlt_err_is_fail(err)) {
+        return err;
+    }
+
     // Debug output
 #ifdef SMLT_DEBUG_ENABLED
     SMLT_WARNING("Debug flag (SMLT_DEBUG_ENABLED) is set.\n");
@@ -105,7 +211,7 @@ errval_t smlt_init(uint32_t num_proc, bool eagerly)
     for (uint32_t i=0; i<smlt_gbl_num_proc; i++) {
         struct smlt_node_args args = {
             .id = i,
-            .core = i,
+            .core = smlt_gbl_node_cores[i],
             .num_nodes = smlt_gbl_num_proc,
         };
         err = smlt_node_create(&smlt_gbl_all_nodes[i], &args);
@@ -154,6 +260,41 @@ struct smlt_node *smlt_get_node_by_id(smlt_nid_t id)
     return NULL;
 }
 
+/**
+ * @brief obtains the core a node runs on
+ *
+ * @param id    node id
+ *
+ * @return core id of the node, the node id itself if Smelt is not
+ *         initialized or there is no such node
+ */
+coreid_t smlt_get_core_by_id(smlt_nid_t id)
+{
+    if (smlt_gbl_node_cores && id < smlt_gbl_num_proc) {
+        return smlt_gbl_node_cores[id];
+    }
+    return id;
+}
+
+/**
+ * @brief obtains the node that runs on a core
+ *
+ * @param core  core id
+ *
+ * @return node id or SMLT_NID_INVALID if no node runs on the core. The
+ *         core id itself if Smelt is not initialized
+ */
+smlt_nid_t smlt_get_id_by_core(coreid_t core)
+{
+    if (smlt_gbl_core_nodes == NULL) {
+        return core;
+    }
+    if (core < smlt_gbl_core_nodes_len) {
+        return smlt_gbl_core_nodes[core];
+    }
+    return SMLT_NID_INVALID;
+}
+
 errval_t smlt_add_node(struct smlt_node *node)
 {
     panic("Not yet implemented");
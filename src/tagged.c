@@ -0,0 +1,468 @@
+/*
+ * Copyright (c) 2016 ETH Zurich.
+ * All rights reserved.
+ *
+ * This file is distributed under the terms in the attached LICENSE file.
+ * If you do not find this file, copies can be found by writing to:
+ * ETH Zurich D-INFK, Universitaetstr. 6, CH-8092 Zurich. Attn: Systems Group.
+ */
+#include <smlt.h>
+#include <smlt_channel.h>
+#include <smlt_context.h>
+#include <smlt_tagged.h>
+#include "internal.h"
+
+#include <string.h>
+
+/*
+ * ===========================================================================
+ * type definitions
+ * ===========================================================================
+ */
+
+/**
+ * a receiving end of a node: the channel to the parent or a child queue
+ */
+struct smlt_tag_slot
+{
+    struct smlt_qp *qp;         ///< queue of a child, NULL for the parent
+    uint32_t num_pending;       ///< number of held back messages
+    smlt_msg_payload_t pending[SMLT_TAG_PENDING][SMLT_TAG_MSG_WORDS];
+};
+
+/**
+ * per node state of the tagged collectives on a context
+ */
+struct smlt_tag_state
+{
+    uint64_t seq[SMLT_TAG_MAX];         ///< last sequence number of each tag
+    struct smlt_channel *parent;        ///< channel to the parent, NULL if root
+    uint32_t parent_idx;                ///< index on a shared memory parent
+    struct smlt_channel *children;      ///< channels to the children
+    uint32_t num_children;              ///< number of child channels
+    uint32_t num_slots;                 ///< parent slot plus child queues
+    struct smlt_tag_slot slots[];       ///< slots[0] is the parent
+};
+
+/*
+ * ===========================================================================
+ * state management
+ * ===========================================================================
+ */
+
+/**
+ * @brief creates the tagged collectives state of the current node
+ *
+ * @param ctx   the Smelt context
+ *
+ * @return the state or NULL if the allocation failed
+ *
+ * A shared memory channel to the children provides one queue per reader,
+ * each of which becomes a slot.
+ */
+struct smlt_tag_state *smlt_tag_state_create(struct smlt_context *ctx)
+{
+    struct smlt_context_links l;
+
+    if (smlt_err_is_fail(smlt_context_get_links(ctx, &l))) {
+        return NULL;
+    }
+
+    uint32_t num_slots = 1 + l.num_queues;
+
+    struct smlt_tag_state *ts = (struct smlt_tag_state *)
+        smlt_platform_alloc(sizeof(*ts) + num_slots * sizeof(struct smlt_tag_slot),
+                            SMLT_ARCH_CACHELINE_SIZE, true);
+    if (ts == NULL) {
+        return NULL;
+    }
+
+    ts->parent = l.parent;
+    ts->parent_idx = l.parent_idx;
+    ts->children = l.children;
+    ts->num_children = l.num_children;
+    ts->num_slots = num_slots;
+
+    struct smlt_qp *queues[num_slots];
+    smlt_context_get_child_queues(&l, queues + 1);
+    for (uint32_t s = 1; s < num_slots; s++) {
+        ts->slots[s].qp = queues[s];
+    }
+
+    return ts;
+}
+
+/**
+ * @brief frees the tagged collectives state
+ *
+ * @param ts    the state to free
+ */
+void smlt_tag_state_destroy(struct smlt_tag_state *ts)
+{
+    smlt_platform_free(ts);
+}
+
+/*
+ * ===========================================================================
+ * demultiplexing
+ * ===========================================================================
+ */
+
+static inline void smlt_tag_copy_payload(struct smlt_msg *msg,
+                                         smlt_msg_payload_t *buf)
+{
+    if (msg) {
+        memcpy(msg->data, &buf[1], msg->words * sizeof(smlt_msg_payload_t));
+    }
+}
+
+/**
+ * @brief takes a held back message of the operation out of the slot
+ */
+static bool smlt_tag_take_pending(struct smlt_tag_slot *slot, uint64_t hdr,
+                                  struct smlt_msg *msg)
+{
+    for (uint32_t i = 0; i < slot->num_pending; i++) {
+        if (slot->pending[i][0] == hdr) {
+            smlt_tag_copy_payload(msg, slot->pending[i]);
+            slot->num_pending--;
+            if (i != slot->num_pending) {
+                memcpy(slot->pending[i], slot->pending[slot->num_pending],
+                       sizeof(slot->pending[i]));
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief holds back a message of another operation
+ */
+static void smlt_tag_put_pending(struct smlt_tag_slot *slot,
+                                 smlt_msg_payload_t *buf)
+{
+    COND_PANIC(slot->num_pending < SMLT_TAG_PENDING,
+               "too many tagged operations in flight");
+
+    memcpy(slot->pending[slot->num_pending++], buf,
+           sizeof(slot->pending[0]));
+}
+
+/**
+ * @brief receives the message of the operation from the parent
+ */
+static errval_t smlt_tag_recv_parent(struct smlt_tag_state *ts, uint64_t hdr,
+                                     struct smlt_msg *msg)
+{
+    errval_t err;
+    smlt_msg_payload_t buf[SMLT_TAG_MSG_WORDS];
+    struct smlt_msg raw = {
+        .words = SMLT_TAG_MSG_WORDS,
+        .bufsize = sizeof(buf),
+        .data = buf
+    };
+
+    if (smlt_tag_take_pending(&ts->slots[0], hdr, msg)) {
+        return SMLT_SUCCESS;
+    }
+
+    while (1) {
+        err = smlt_channel_recv_index(ts->parent, &raw, ts->parent_idx);
+        if (smlt_err_is_fail(err)) {
+            return err;
+        }
+
+        if (buf[0] == hdr) {
+            smlt_tag_copy_payload(msg, buf);
+            return SMLT_SUCCESS;
+        }
+
+        smlt_tag_put_pending(&ts->slots[0], buf);
+    }
+}
+
+/**
+ * @brief tries to receive the message of the operation from a child queue
+ *
+ * @return SMLT_SUCCESS or SMLT_ERR_QUEUE_EMPTY
+ */
+static errval_t smlt_tag_try_recv_child(struct smlt_tag_slot *slot, uint64_t hdr,
+                                        struct smlt_msg *msg)
+{
+    errval_t err;
+    smlt_msg_payload_t buf[SMLT_TAG_MSG_WORDS];
+    struct smlt_msg raw = {
+        .words = SMLT_TAG_MSG_WORDS,
+        .bufsize = sizeof(buf),
+        .data = buf
+    };
+
+    if (smlt_tag_take_pending(slot, hdr, msg)) {
+        return SMLT_SUCCESS;
+    }
+
+    while (smlt_queuepair_can_recv(slot->qp)) {
+        /* a receive sets the length, the next message may be longer */
+        raw.words = SMLT_TAG_MSG_WORDS;
+        err = smlt_queuepair_recv(slot->qp, &raw);
+        if (smlt_err_is_fail(err)) {
+            return err;
+        }
+
+        if (buf[0] == hdr) {
+            smlt_tag_copy_payload(msg, buf);
+            return SMLT_SUCCESS;
+        }
+
+        smlt_tag_put_pending(slot, buf);
+    }
+
+    return SMLT_ERR_QUEUE_EMPTY;
+}
+
+/**
+ * @brief sends a tagged message on the channel
+ */
+static errval_t smlt_tag_send(struct smlt_channel *chan, uint64_t hdr,
+                              struct smlt_msg *msg)
+{
+    smlt_msg_payload_t buf[SMLT_TAG_MSG_WORDS];
+    struct smlt_msg raw = {
+        .words = 1,
+        .bufsize = sizeof(buf),
+        .data = buf
+    };
+
+    buf[0] = hdr;
+    if (msg) {
+        memcpy(&buf[1], msg->data, msg->words * sizeof(smlt_msg_payload_t));
+        raw.words += msg->words;
+    }
+
+    return smlt_channel_send(chan, &raw);
+}
+
+/**
+ * @brief looks up the state and starts a new operation on the tag
+ *
+ * @return the state or NULL if the arguments are invalid
+ */
+static struct smlt_tag_state *smlt_tag_begin(struct smlt_context *ctx,
+                                             smlt_tag_t tag,
+                                             struct smlt_msg *msg,
+                                             uint64_t *hdr)
+{
+    if (tag >= SMLT_TAG_MAX ||
+        (msg && msg->words > SMLT_TAG_PAYLOAD_WORDS)) {
+        return NULL;
+    }
+
+    struct smlt_tag_state *ts = smlt_context_get_tag_state(ctx);
+    if (ts == NULL) {
+        return NULL;
+    }
+
+    *hdr = SMLT_TAG_HDR(tag, ++ts->seq[tag]);
+
+    return ts;
+}
+
+/*
+ * ===========================================================================
+ * tagged collectives
+ * ===========================================================================
+ */
+
+static errval_t smlt_tag_broadcast(struct smlt_context *ctx, smlt_tag_t tag,
+                                   struct smlt_msg *msg)
+{
+    errval_t err;
+    uint64_t hdr;
+
+    struct smlt_tag_state *ts = smlt_tag_begin(ctx, tag, msg, &hdr);
+    if (ts == NULL) {
+        return SMLT_ERR_INVAL;
+    }
+
+    if (ts->parent) {
+        err = smlt_tag_recv_parent(ts, hdr, msg);
+        if (smlt_err_is_fail(err)) {
+            return err;
+        }
+    }
+
+    for (uint32_t i = 0; i < ts->num_children; i++) {
+        err = smlt_tag_send(&ts->children[i], hdr, msg);
+        COND_PANIC(smlt_err_is_ok(err), "tagged broadcast failed");
+    }
+
+    return SMLT_SUCCESS;
+}
+
+static errval_t smlt_tag_reduce(struct smlt_context *ctx, smlt_tag_t tag,
+                                struct smlt_msg *input,
+                                struct smlt_msg *result,
+                                smlt_reduce_fn_t operation)
+{
+    errval_t err;
+    uint64_t hdr;
+
+    struct smlt_tag_state *ts = smlt_tag_begin(ctx, tag, input, &hdr);
+    if (ts == NULL) {
+        return SMLT_ERR_INVAL;
+    }
+
+    smlt_msg_payload_t buf[SMLT_TAG_PAYLOAD_WORDS];
+    struct smlt_msg child = {
+        .words = 0,
+        .bufsize = sizeof(buf),
+        .data = buf
+    };
+    struct smlt_msg *recv = NULL;
+
+    if (operation) {
+        if (result != input) {
+            memcpy(result->data, input->data,
+                   input->words * sizeof(smlt_msg_payload_t));
+            result->words = input->words;
+        }
+        child.words = result->words;
+        recv = &child;
+    }
+
+    // children may complete in any order
+    uint32_t num_recv = 0;
+    bool done[ts->num_slots];
+    memset(done, 0, sizeof(done));
+
+    while (num_recv < ts->num_slots - 1) {
+        for (uint32_t s = 1; s < ts->num_slots; s++) {
+            if (done[s]) {
+                continue;
+            }
+
+            err = smlt_tag_try_recv_child(&ts->slots[s], hdr, recv);
+            if (err == SMLT_ERR_QUEUE_EMPTY) {
+                continue;
+            }
+            if (smlt_err_is_fail(err)) {
+                return err;
+            }
+
+            if (operation) {
+                err = operation(result, &child);
+                if (smlt_err_is_fail(err)) {
+                    return err;
+                }
+            }
+
+            done[s] = true;
+            num_recv++;
+        }
+    }
+
+    if (ts->parent) {
+        return smlt_tag_send(ts->parent, hdr, operation ? result : NULL);
+    }
+
+    return SMLT_SUCCESS;
+}
+
+/**
+ * @brief performs a tagged broadcast from the root to all nodes
+ *
+ * @param ctx   the Smelt context to broadcast on
+ * @param tag   the tag of the operation
+ * @param msg   input on the root, returns the message on the other nodes
+ *
+ * @returns SMLT_SUCCESS or SMLT_ERR_INVAL if the tag or message is too large
+ */
+errval_t smlt_broadcast_tagged(struct smlt_context *ctx, smlt_tag_t tag,
+                               struct smlt_msg *msg)
+{
+    if (msg == NULL) {
+        return SMLT_ERR_INVAL;
+    }
+    return smlt_tag_broadcast(ctx, tag, msg);
+}
+
+/**
+ * @brief performs a tagged broadcast without any payload
+ *
+ * @param ctx   the Smelt context to broadcast on
+ * @param tag   the tag of the operation
+ *
+ * @returns SMLT_SUCCESS or SMLT_ERR_INVAL if the tag is too large
+ */
+errval_t smlt_broadcast_notify_tagged(struct smlt_context *ctx, smlt_tag_t tag)
+{
+    return smlt_tag_broadcast(ctx, tag, NULL);
+}
+
+/**
+ * @brief performs a tagged reduction towards the root
+ *
+ * @param ctx       the Smelt context
+ * @param tag       the tag of the operation
+ * @param input     input for the reduction
+ * @param result    returns the aggregate of the subtree
+ * @param operation function to be called to calculate the aggregate
+ *
+ * @returns SMLT_SUCCESS or SMLT_ERR_INVAL if the tag or message is too large
+ *
+ * The result is initialized with the input, and the operation is called
+ * with the result and the aggregate of each child.
+ */
+errval_t smlt_reduce_tagged(struct smlt_context *ctx, smlt_tag_t tag,
+                            struct smlt_msg *input,
+                            struct smlt_msg *result,
+                            smlt_reduce_fn_t operation)
+{
+    if (!operation) {
+        return smlt_reduce_notify_tagged(ctx, tag);
+    }
+    if (input == NULL || result == NULL) {
+        return SMLT_ERR_INVAL;
+    }
+    return smlt_tag_reduce(ctx, tag, input, result, operation);
+}
+
+/**
+ * @brief performs a tagged reduction without any payload
+ *
+ * @param ctx   the Smelt context
+ * @param tag   the tag of the operation
+ *
+ * @returns SMLT_SUCCESS or SMLT_ERR_INVAL if the tag is too large
+ */
+errval_t smlt_reduce_notify_tagged(struct smlt_context *ctx, smlt_tag_t tag)
+{
+    return smlt_tag_reduce(ctx, tag, NULL, NULL, NULL);
+}
+
+/**
+ * @brief performs a tagged reduction and distributes the result to all nodes
+ *
+ * @param ctx       the Smelt context
+ * @param tag       the tag of the operation
+ * @param input     input for the reduction
+ * @param result    returns the result of the reduction
+ * @param operation function to be called to calculate the aggregate
+ *
+ * @returns SMLT_SUCCESS or SMLT_ERR_INVAL if the tag or message is too large
+ */
+errval_t smlt_reduce_all_tagged(struct smlt_context *ctx, smlt_tag_t tag,
+                                struct smlt_msg *input,
+                                struct smlt_msg *result,
+                                smlt_reduce_fn_t operation)
+{
+    errval_t err;
+
+    err = smlt_reduce_tagged(ctx, tag, input, result, operation);
+    if (smlt_err_is_fail(err)) {
+        return err;
+    }
+
+    return smlt_broadcast_tagged(ctx, tag, result);
+}
@@ -0,0 +1,583 @@
+/*
+ * Copyright (c) 2016 ETH Zurich.
+ * All rights reserved.
+ *
+ * This file is distributed under the terms in the attached LICENSE file.
+ * If you do not find this file, copies can be found by writing to:
+ * ETH Zurich D-INFK, Universitaetstr. 6, CH-8092 Zurich. Attn: Systems Group.
+ */
+#include <smlt.h>
+#include <smlt_node.h>
+#include <smlt_context.h>
+#include <smlt_barrier.h>
+#include <smlt_queuepair.h>
+#include <smlt_task.h>
+#include "internal.h"
+
+#include <string.h>
+
+/*
+ * ===========================================================================
+ * type definitions
+ * ===========================================================================
+ */
+
+///< number of words of a steal reply: the count, then function and argument
+#define SMLT_TASK_MSG_WORDS     SMLT_UMP_PAYLOAD_WORDS
+
+///< maximum number of tasks handed out per steal request
+#define SMLT_TASK_STEAL_MAX     ((SMLT_TASK_MSG_WORDS - 1) / 2)
+
+/**
+ * a task in a deque
+ */
+struct smlt_task
+{
+    smlt_task_fn_t fn;
+    void *arg;
+};
+
+/**
+ * per node state of the task runtime
+ */
+struct smlt_task_worker
+{
+    uint64_t top;                       ///< the oldest task
+    uint64_t bottom;                    ///< slot of the next task pushed
+    struct smlt_task *tasks;            ///< SMLT_TASK_DEQUE_SLOTS tasks
+    struct smlt_qp **victims;           ///< queues to the victims, near first
+    uint32_t num_victims;               ///< number of victims
+    uint32_t next_victim;               ///< victim of the next steal request
+    struct smlt_qp **thieves;           ///< queues from the thieves
+    uint32_t num_thieves;               ///< number of thieves
+    struct smlt_qp *pending;            ///< victim of the request in flight
+    bool active;                        ///< counted in num_active
+    uint64_t runs;                      ///< number of calls of smlt_task_run
+    uint64_t executed;                  ///< number of tasks executed
+    uint64_t stolen;                    ///< number of tasks obtained by steals
+};
+
+/**
+ * the task runtime of a context
+ */
+struct smlt_task_runtime
+{
+    struct smlt_context *ctx;           ///< the context of the runtime
+    uint32_t num_workers;               ///< number of nodes of the context
+    uint32_t num_qps;                   ///< number of queuepair ends
+    struct smlt_qp **qps;               ///< both ends of all queuepairs
+    volatile uint64_t started SMLT_ARCH_ATTR_ALIGN; ///< calls of smlt_task_run
+    volatile uint32_t num_active;       ///< nodes holding or running tasks
+    struct smlt_task_worker *workers[] SMLT_ARCH_ATTR_ALIGN; ///< by rank
+};
+
+/*
+ * ===========================================================================
+ * deque
+ * ===========================================================================
+ *
+ * The deque is private to its node. The node pushes and pops at the bottom,
+ * the tasks handed out to thieves are taken from the top.
+ */
+
+static inline bool smlt_task_push(struct smlt_task_worker *w,
+                                  smlt_task_fn_t fn, void *arg)
+{
+    if (w->bottom - w->top == SMLT_TASK_DEQUE_SLOTS) {
+        return false;
+    }
+
+    struct smlt_task *t = &w->tasks[w->bottom & (SMLT_TASK_DEQUE_SLOTS - 1)];
+    t->fn = fn;
+    t->arg = arg;
+    w->bottom++;
+
+    return true;
+}
+
+static inline bool smlt_task_pop(struct smlt_task_worker *w,
+                                 struct smlt_task *t)
+{
+    if (w->bottom == w->top) {
+        return false;
+    }
+
+    w->bottom--;
+    *t = w->tasks[w->bottom & (SMLT_TASK_DEQUE_SLOTS - 1)];
+
+    return true;
+}
+
+static inline bool smlt_task_take(struct smlt_task_worker *w,
+                                  struct smlt_task *t)
+{
+    if (w->bottom == w->top) {
+        return false;
+    }
+
+    *t = w->tasks[w->top & (SMLT_TASK_DEQUE_SLOTS - 1)];
+    w->top++;
+
+    return true;
+}
+
+/*
+ * ===========================================================================
+ * stealing
+ * ===========================================================================
+ */
+
+/**
+ * @brief obtains the state of the calling node
+ */
+static inline struct smlt_task_worker *smlt_task_self(struct smlt_task_runtime *rt)
+{
+    uint32_t rank = smlt_context_get_rank(rt->ctx);
+    if (rank == SMLT_CONTEXT_RANK_NONE) {
+        return NULL;
+    }
+    return rt->workers[rank];
+}
+
+/*
+ * A node is active while it holds or runs tasks. It becomes idle when its
+ * deque runs empty, and active again when a steal reply brings tasks. The
+ * victim counts the thief as active before it sends the tasks, so the count
+ * does not drop to zero while tasks are in flight. Once all nodes called
+ * smlt_task_run() and none is active, no task is left and no new task can
+ * appear.
+ */
+
+static inline void smlt_task_set_idle(struct smlt_task_runtime *rt,
+                                      struct smlt_task_worker *w)
+{
+    if (w->active) {
+        w->active = false;
+        __sync_sub_and_fetch(&rt->num_active, 1);
+    }
+}
+
+static inline bool smlt_task_quiescent(struct smlt_task_runtime *rt,
+                                       struct smlt_task_worker *w)
+{
+    /* started never drops within a run, read it first */
+    if (rt->started < w->runs * rt->num_workers) {
+        return false;
+    }
+    return rt->num_active == 0;
+}
+
+/**
+ * @brief answers the steal requests of the thieves
+ *
+ * A thief gets up to half of the tasks, the oldest first. The thief has at
+ * most one request in flight, so the reply never blocks.
+ */
+static void smlt_task_serve(struct smlt_task_runtime *rt,
+                            struct smlt_task_worker *w)
+{
+    smlt_msg_payload_t data[SMLT_TASK_MSG_WORDS];
+    struct smlt_msg msg = {
+        .words = SMLT_TASK_MSG_WORDS,
+        .bufsize = sizeof(data),
+        .data = data
+    };
+
+    for (uint32_t i = 0; i < w->num_thieves; i++) {
+        struct smlt_qp *qp = w->thieves[i];
+        if (!smlt_queuepair_can_recv(qp)) {
+            continue;
+        }
+
+        smlt_queuepair_recv(qp, &msg);
+
+        uint64_t avail = (w->bottom - w->top + 1) / 2;
+        uint32_t num = avail < SMLT_TASK_STEAL_MAX ? (uint32_t)avail
+                                                   : SMLT_TASK_STEAL_MAX;
+        struct smlt_task t;
+        uint32_t num_taken = 0;
+        while (num_taken < num && smlt_task_take(w, &t)) {
+            data[1 + 2 * num_taken] = (smlt_msg_payload_t)t.fn;
+            data[2 + 2 * num_taken] = (smlt_msg_payload_t)t.arg;
+            num_taken++;
+        }
+        data[0] = num_taken;
+        msg.words = 1 + 2 * num_taken;
+
+        if (num_taken) {
+            __sync_add_and_fetch(&rt->num_active, 1);
+        }
+
+        smlt_queuepair_send(qp, &msg);
+    }
+}
+
+/**
+ * @brief steals from the victims in turn, without blocking
+ *
+ * @param w     the state of the calling node
+ * @param num   returns the number of tasks obtained
+ *
+ * @returns TRUE if a reply has been received
+ */
+static bool smlt_task_steal(struct smlt_task_worker *w, uint32_t *num)
+{
+    smlt_msg_payload_t data[SMLT_TASK_MSG_WORDS];
+    struct smlt_msg msg = {
+        .words = 1,
+        .bufsize = sizeof(data),
+        .data = data
+    };
+
+    if (w->pending == NULL) {
+        w->pending = w->victims[w->next_victim];
+        w->next_victim = (w->next_victim + 1) % w->num_victims;
+        data[0] = 0;
+        smlt_queuepair_send(w->pending, &msg);
+        return false;
+    }
+
+    if (!smlt_queuepair_can_recv(w->pending)) {
+        return false;
+    }
+
+    msg.words = SMLT_TASK_MSG_WORDS;
+    smlt_queuepair_recv(w->pending, &msg);
+    w->pending = NULL;
+
+    *num = (uint32_t)data[0];
+    if (*num) {
+        /* the victim counted this node as active */
+        w->active = true;
+    }
+    for (uint32_t j = 0; j < *num; j++) {
+        smlt_task_push(w, (smlt_task_fn_t)data[1 + 2 * j],
+                       (void *)data[2 + 2 * j]);
+    }
+    w->stolen += *num;
+
+    return true;
+}
+
+/**
+ * @brief selects the victims of a node
+ *
+ * @param clusters  cluster of every node of the context, by rank
+ * @param n         number of nodes of the context
+ * @param rank      rank of the thief
+ * @param victims   returns the ranks of the victims, near ones first
+ *
+ * @returns the number of victims
+ *
+ * The victims are the nodes following the thief in its own cluster, and the
+ * first node of each of the next SMLT_TASK_REMOTE_VICTIMS clusters. Slots
+ * left over are filled with further nodes of other clusters. Following the
+ * rank order, every node can be reached by a chain of steals.
+ */
+static uint32_t smlt_task_select_victims(uint8_t *clusters, uint32_t n,
+                                         uint32_t rank, uint32_t *victims)
+{
+    bool chosen[n];
+    bool seen[UINT8_MAX + 1];
+    uint32_t remote[SMLT_TASK_REMOTE_VICTIMS];
+    uint32_t num_remote = 0;
+    uint32_t num = 0;
+
+    memset(chosen, 0, sizeof(chosen));
+    memset(seen, 0, sizeof(seen));
+    seen[clusters[rank]] = true;
+
+    for (uint32_t d = 1; d < n && num_remote < SMLT_TASK_REMOTE_VICTIMS; d++) {
+        uint32_t v = (rank + d) % n;
+        if (!seen[clusters[v]]) {
+            seen[clusters[v]] = true;
+            remote[num_remote++] = v;
+        }
+    }
+
+    for (uint32_t d = 1; d < n; d++) {
+        uint32_t v = (rank + d) % n;
+        if (num == SMLT_TASK_MAX_VICTIMS - num_remote) {
+            break;
+        }
+        if (clusters[v] == clusters[rank]) {
+            chosen[v] = true;
+            victims[num++] = v;
+        }
+    }
+
+    for (uint32_t i = 0; i < num_remote; i++) {
+        chosen[remote[i]] = true;
+        victims[num++] = remote[i];
+    }
+
+    for (uint32_t d = 1; d < n && num < SMLT_TASK_MAX_VICTIMS; d++) {
+        uint32_t v = (rank + d) % n;
+        if (!chosen[v]) {
+            chosen[v] = true;
+            victims[num++] = v;
+        }
+    }
+
+    return num;
+}
+
+/*
+ * ===========================================================================
+ * task runtime
+ * ===========================================================================
+ */
+
+/**
+ * @brief creates a task runtime over all nodes of a context
+ *
+ * @param ctx   the Smelt context
+ * @param ret   returns the runtime
+ *
+ * @returns SMLT_SUCCESS, SMLT_ERR_INVAL or SMLT_ERR_MALLOC_FAIL
+ */
+errval_t smlt_task_runtime_create(struct smlt_context *ctx,
+                                  struct smlt_task_runtime **ret)
+{
+    errval_t err;
+
+    if (ctx == NULL || ret == NULL) {
+        return SMLT_ERR_INVAL;
+    }
+
+    uint32_t n = smlt_context_get_num_nodes(ctx);
+
+    coreid_t cores[n];
+    uint8_t clusters[n];
+    for (uint32_t r = 0; r < n; r++) {
+        struct smlt_node *node = smlt_get_node_by_id(smlt_context_get_node_id(ctx, r));
+        cores[r] = smlt_node_get_coreid_of_node(node);
+        clusters[r] = smlt_platform_cluster_of_core(cores[r]);
+    }
+
+    uint32_t victims[n][SMLT_TASK_MAX_VICTIMS];
+    uint32_t num_victims[n];
+    uint32_t num_thieves[n];
+    uint32_t num_edges = 0;
+
+    memset(num_thieves, 0, sizeof(num_thieves));
+    for (uint32_t r = 0; r < n; r++) {
+        num_victims[r] = smlt_task_select_victims(clusters, n, r, victims[r]);
+        for (uint32_t i = 0; i < num_victims[r]; i++) {
+            num_thieves[victims[r][i]]++;
+        }
+        num_edges += num_victims[r];
+    }
+
+    struct smlt_task_runtime *rt = (struct smlt_task_runtime *)
+        smlt_platform_alloc(sizeof(*rt) + n * sizeof(rt->workers[0]),
+                            SMLT_ARCH_CACHELINE_SIZE, true);
+    if (rt == NULL) {
+        return SMLT_ERR_MALLOC_FAIL;
+    }
+
+    rt->ctx = ctx;
+    rt->num_workers = n;
+
+    if (num_edges) {
+        rt->qps = (struct smlt_qp **)
+            smlt_platform_alloc(2 * num_edges * sizeof(struct smlt_qp *),
+                                SMLT_ARCH_CACHELINE_SIZE, true);
+        if (rt->qps == NULL) {
+            smlt_task_runtime_free(rt);
+            return SMLT_ERR_MALLOC_FAIL;
+        }
+    }
+
+    /* the state of a node lives in the memory of its cluster */
+    for (uint32_t r = 0; r < n; r++) {
+        size_t size = sizeof(struct smlt_task_worker)
+                      + SMLT_TASK_DEQUE_SLOTS * sizeof(struct smlt_task)
+                      + (num_victims[r] + num_thieves[r]) * sizeof(struct smlt_qp *);
+
+        struct smlt_task_worker *w = (struct smlt_task_worker *)
+            smlt_platform_alloc_on_node(size, SMLT_ARCH_CACHELINE_SIZE,
+                                        clusters[r], true);
+        if (w == NULL) {
+            smlt_task_runtime_free(rt);
+            return SMLT_ERR_MALLOC_FAIL;
+        }
+
+        w->tasks = (struct smlt_task *)(w + 1);
+        w->victims = (struct smlt_qp **)(w->tasks + SMLT_TASK_DEQUE_SLOTS);
+        w->thieves = w->victims + num_victims[r];
+        rt->workers[r] = w;
+    }
+
+    /* a queuepair from every thief to each of its victims */
+    for (uint32_t r = 0; r < n; r++) {
+        for (uint32_t i = 0; i < num_victims[r]; i++) {
+            uint32_t v = victims[r][i];
+            struct smlt_qp *thief, *victim;
+
+            err = smlt_queuepair_create(SMLT_QP_TYPE_UMP, &thief, &victim,
+                                        cores[r], cores[v]);
+            if (smlt_err_is_fail(err)) {
+                smlt_task_runtime_free(rt);
+                return err;
+            }
+
+            rt->qps[rt->num_qps++] = thief;
+            rt->qps[rt->num_qps++] = victim;
+
+            struct smlt_task_worker *w = rt->workers[r];
+            w->victims[w->num_victims++] = thief;
+            w = rt->workers[v];
+            w->thieves[w->num_thieves++] = victim;
+        }
+    }
+
+    SMLT_DEBUG(SMLT_DBG__GENERAL, "created task runtime over %u nodes with "
+               "%u steal queues\n", n, num_edges);
+
+    *ret = rt;
+
+    return SMLT_SUCCESS;
+}
+
+/**
+ * @brief frees a task runtime
+ *
+ * @param rt    the runtime
+ *
+ * @returns SMLT_SUCCESS
+ */
+errval_t smlt_task_runtime_free(struct smlt_task_runtime *rt)
+{
+    for (uint32_t i = 0; i < rt->num_qps; i++) {
+        smlt_queuepair_destroy(rt->qps[i]);
+        smlt_platform_free(rt->qps[i]);
+    }
+
+    if (rt->qps) {
+        smlt_platform_free(rt->qps);
+    }
+
+    for (uint32_t r = 0; r < rt->num_workers; r++) {
+        if (rt->workers[r]) {
+            smlt_platform_free(rt->workers[r]);
+        }
+    }
+
+    smlt_platform_free(rt);
+
+    return SMLT_SUCCESS;
+}
+
+/**
+ * @brief adds a task to the deque of the calling node
+ *
+ * @param rt    the runtime
+ * @param fn    function of the task
+ * @param arg   argument of the function
+ *
+ * @returns SMLT_SUCCESS or SMLT_ERR_INVAL if the node is not in the context
+ */
+errval_t smlt_task_spawn(struct smlt_task_runtime *rt, smlt_task_fn_t fn,
+                         void *arg)
+{
+    struct smlt_task_worker *w = smlt_task_self(rt);
+    if (w == NULL) {
+        return SMLT_ERR_INVAL;
+    }
+
+    if (!smlt_task_push(w, fn, arg)) {
+        fn(arg);
+        w->executed++;
+    }
+
+    return SMLT_SUCCESS;
+}
+
+/**
+ * @brief answers the pending steal requests to the calling node
+ *
+ * @param rt    the runtime
+ */
+void smlt_task_poll(struct smlt_task_runtime *rt)
+{
+    struct smlt_task_worker *w = smlt_task_self(rt);
+    if (w) {
+        smlt_task_serve(rt, w);
+    }
+}
+
+/**
+ * @brief runs tasks until all nodes of the context are idle
+ *
+ * @param rt    the runtime
+ *
+ * @returns SMLT_SUCCESS or SMLT_ERR_INVAL if the node is not in the context
+ */
+errval_t smlt_task_run(struct smlt_task_runtime *rt)
+{
+    errval_t err;
+
+    struct smlt_task_worker *w = smlt_task_self(rt);
+    if (w == NULL) {
+        return SMLT_ERR_INVAL;
+    }
+
+    struct smlt_task t;
+    uint32_t num;
+
+    /* counted as active before started, see smlt_task_quiescent() */
+    w->runs++;
+    w->active = true;
+    __sync_add_and_fetch(&rt->num_active, 1);
+    __sync_add_and_fetch(&rt->started, 1);
+
+    while (true) {
+        smlt_task_serve(rt, w);
+
+        if (smlt_task_pop(w, &t)) {
+            t.fn(t.arg);
+            w->executed++;
+            continue;
+        }
+
+        smlt_task_set_idle(rt, w);
+
+        if (w->pending == NULL && smlt_task_quiescent(rt, w)) {
+            break;
+        }
+
+        smlt_task_steal(w, &num);
+    }
+
+    /*
+     * No tasks are left. The barrier keeps the nodes from starting the next
+     * run while others may still send a steal request of this one.
+     */
+    err = smlt_barrier_arrive(rt->ctx);
+    if (smlt_err_is_fail(err)) {
+        return err;
+    }
+
+    while (!smlt_barrier_test(rt->ctx)) {
+        smlt_task_serve(rt, w);
+    }
+
+    return smlt_barrier_depart(rt->ctx);
+}
+
+/**
+ * @brief obtains the number of tasks the calling node executed
+ *
+ * @param rt        the runtime
+ * @param executed  returns the number of tasks executed
+ * @param stolen    returns the number of tasks obtained by stealing
+ */
+void smlt_task_get_stats(struct smlt_task_runtime *rt, uint64_t *executed,
+                         uint64_t *stolen)
+{
+    struct smlt_task_worker *w = smlt_task_self(rt);
+
+    *executed = w ? w->executed : 0;
+    *stolen = w ? w->stolen : 0;
+}
@@ -21,7 +21,8 @@ struct smlt_topology_node
     struct smlt_topology *topology;         ///< backpointer to the topology
     struct smlt_topology_node *parent;      ///< pointer to the parent node
     struct smlt_topology_node **children;   ///< array of children
-    smlt_nid_t node_id;                     ///<
+    smlt_nid_t node_id;                     ///< the Smelt node id
+    coreid_t core;                          ///< the core the node runs on
     uint32_t array_index;                   ///< Invalid if root
     uint32_t num_children;                  ///<
     bool is_leaf;
@@ -42,14 +43,14 @@ struct smlt_topology
     const char *name;                             ///< name
     struct smlt_topology_node *root;        ///< pointer to the root node
     uint32_t num_nodes;
+    smlt_nid_t max_nid;                     ///< the highest node id
+    struct smlt_topology_node **nid_to_node;///< maps node ids to nodes
     struct smlt_topology_node all_nodes[];   ///< array of all nodes
 };
 
 //prototypes
-static void smlt_topology_create_binary_tree(struct smlt_topology **topology,
-                                             uint32_t num_threads);
-static void smlt_topology_parse_model(struct smlt_generated_model* model,
-                                      struct smlt_topology** topo);
+static errval_t smlt_topology_parse_sparse(struct smlt_sparse_model* sparse,
+                                           struct smlt_topology* topo);
 /**
  * @brief initializes the topology subsystem
  *
@@ -70,33 +71,102 @@ errval_t smlt_topology_init(void)
  *
  * @return SMELT_SUCCESS or error value
  *
- * If the model is NULL, then a binary tree will be generated
+ * If the model is NULL, then the built-in topology given by name (or
+ * SMLT_TOPO if name is NULL) is generated over all nodes. If the name is
+ * not a built-in topology, then a binary tree will be generated
+ *
+ * The model is indexed by core id, the topology contains the cores that
+ * are part of the model and refers to them by the id of the node
+ * running on the core.
  */
 errval_t smlt_topology_create(struct smlt_generated_model* model,
                               const char *name,
                               struct smlt_topology **ret_topology)
 {
+    errval_t err;
+    struct smlt_sparse_model *sparse;
 
     if (model == NULL) {
+        uint32_t num_proc = smlt_get_num_proc();
+        coreid_t *cores = (coreid_t *)smlt_platform_alloc(num_proc * sizeof(coreid_t),
+                                                          SMLT_DEFAULT_ALIGNMENT,
+                                                          true);
+        if (cores == NULL) {
+            return SMLT_ERR_MALLOC_FAIL;
+        }
+
+        for (uint32_t i = 0; i < num_proc; i++) {
+            cores[i] = smlt_get_core_by_id(i);
+        }
 
-        *ret_topology = (struct smlt_topology*)
-                        smlt_platform_alloc(sizeof(struct smlt_topology)+
-                                            sizeof(struct smlt_topology_node)*
-                                            smlt_get_num_proc(),
-                                            SMLT_DEFAULT_ALIGNMENT, true);
-        smlt_topology_create_binary_tree(ret_topology, smlt_get_num_proc());
-        (*ret_topology)->num_nodes = smlt_get_num_proc();
+        if (!smlt_generator_is_builtin(name)) {
+            err = smlt_generate_builtin_sparse_model(SMLT_TOPO_BINARY, cores,
+                                                     num_proc, &sparse);
+        } else {
+            err = smlt_generate_builtin_sparse_model(name, cores, num_proc,
+                                                     &sparse);
+        }
+        smlt_platform_free(cores);
     } else {
-        *ret_topology = (struct smlt_topology*)
-                        smlt_platform_alloc(sizeof(struct smlt_topology)+
-                                            sizeof(struct smlt_topology_node)*
-                                            model->len,
-                                            SMLT_DEFAULT_ALIGNMENT, true);
-        smlt_topology_parse_model(model, ret_topology);
-        (*ret_topology)->num_nodes = model->len;
+        err = smlt_sparse_model_from_dense(model, &sparse);
+    }
+
+    if (smlt_err_is_fail(err)) {
+        return err;
+    }
+
+    err = smlt_topology_create_sparse(sparse, name, ret_topology);
+    smlt_sparse_model_destroy(sparse);
+
+    return err;
+}
+
+/**
+ * @brief creates a new Smelt topology out of a sparse model
+ *
+ * @param sparse        the sparse model
+ * @param name          name of the topology
+ * @param ret_topology  returned pointer to the topology
+ *
+ * @return SMELT_SUCCESS or error value
+ *         SMLT_ERR_NODE_INVALD if no node runs on a core of the model
+ *
+ * Only the cores that are part of the tree become topology nodes, such that
+ * a topology over a few cores stays small regardless of the core ids.
+ */
+errval_t smlt_topology_create_sparse(struct smlt_sparse_model* sparse,
+                                     const char *name,
+                                     struct smlt_topology **ret_topology)
+{
+    errval_t err;
+    struct smlt_topology *topo;
+
+    uint32_t num_nodes = 0;
+    for (uint32_t x = 0; x < sparse->len; x++) {
+        if (x == sparse->root || sparse->parent[x] != SMLT_MODEL_NO_PARENT) {
+            num_nodes++;
+        }
+    }
+
+    topo = (struct smlt_topology*) smlt_platform_alloc(sizeof(struct smlt_topology)+
+                                                       sizeof(struct smlt_topology_node)*
+                                                       num_nodes,
+                                                       SMLT_DEFAULT_ALIGNMENT, true);
+    if (topo == NULL) {
+        return SMLT_ERR_MALLOC_FAIL;
     }
 
-    (*ret_topology)->name = name;
+    topo->num_nodes = num_nodes;
+    topo->name = name;
+
+    err = smlt_topology_parse_sparse(sparse, topo);
+    if (smlt_err_is_fail(err)) {
+        smlt_topology_destroy(topo);
+        return err;
+    }
+
+    *ret_topology = topo;
+
     return SMLT_SUCCESS;
 }
 
@@ -109,6 +179,21 @@ errval_t smlt_topology_create(struct smlt_generated_model* model,
  */
 errval_t smlt_topology_destroy(struct smlt_topology *topology)
 {
+    for (uint32_t i = 0; i < topology->num_nodes; i++) {
+        struct smlt_topology_node *node = &topology->all_nodes[i];
+        if (node->children) {
+            smlt_platform_free(node->children);
+        }
+        if (node->children_shm) {
+            smlt_platform_free(node->children_shm);
+        }
+    }
+
+    if (topology->nid_to_node) {
+        smlt_platform_free(topology->nid_to_node);
+    }
+    smlt_platform_free(topology);
+
     return SMLT_SUCCESS;
 }
 
@@ -124,202 +209,126 @@ smlt_nid_t smlt_topology_get_root_id(struct smlt_topology* topology)
 {
     return topology->root->node_id;
 }
+
 /**
- * \brief Build a binary tree model for the current machine.
+ * \brief build topology from a sparse model.
  *
- * @param topology      returned pointer to the topology
- * @param num_threads   number of threads/processes in the model
- * @param name          name of the topology
+ * @param sparse        the sparse model, indexed by core id
+ * @param topo          the topology to fill in, with num_nodes set
  *
- * @return SMELT_SUCCESS or error value
+ * @return SMLT_SUCCESS, SMLT_ERR_MALLOC_FAIL or SMLT_ERR_NODE_INVALD
+ *
+ * Every node and edge of the model is visited once. The topology nodes
+ * are ordered by core id.
  */
-static void smlt_topology_create_binary_tree(struct smlt_topology **topology,
-                                             uint32_t num_threads)
+static errval_t smlt_topology_parse_sparse(struct smlt_sparse_model* sparse,
+                                           struct smlt_topology* topo)
 {
-    assert (topology!=NULL);
-    // Fill model
-    (*topology)->root = &((*topology)->all_nodes[0]);
+    assert (topo!=NULL);
 
-    for (unsigned int i = 0; i < num_threads;i++) {
+    // position of the model entries in all_nodes
+    uint32_t *pos = (uint32_t*) smlt_platform_alloc(sparse->len * sizeof(uint32_t),
+                                                    SMLT_DEFAULT_ALIGNMENT, true);
+    if (pos == NULL) {
+        return SMLT_ERR_MALLOC_FAIL;
+    }
 
-        struct smlt_topology_node* node = &(*topology)->all_nodes[i];
-        node->topology = *topology;
-        node->use_shm = false;
-        if (i == 0) {
-            node->parent = NULL;
-            node->node_id = 0;
-        } else {
-            if ((i % 2) == 0) {
-                node->parent = &((*topology)->all_nodes[(i/2)-1]);
-                node->array_index = 1;
-            } else {
-                node->parent = &((*topology)->all_nodes[(i/2)]);
-                node->array_index = 0;
-            }
+    topo->max_nid = 0;
+
+    uint32_t n = 0;
+    for (uint32_t x = 0; x < sparse->len; x++) {
+        if (x != sparse->root && sparse->parent[x] == SMLT_MODEL_NO_PARENT) {
+            pos[x] = SMLT_MODEL_NO_PARENT;
+            continue;
         }
 
-        if (i*2+1 < num_threads) {
-            node->children = (struct smlt_topology_node**)
-                             smlt_platform_alloc(sizeof(struct smlt_topology_node*)*2,
-                                                 SMLT_DEFAULT_ALIGNMENT, true);
-            node->children[0] = &(*topology)->all_nodes[i*2+1];
-            node->node_id = i;
-            node->num_children = 1;
-            if (i*2+2 < num_threads) {
-                node->children[1] = &(*topology)->all_nodes[i*2+2];
-                node->num_children = 2;
-            }
-            // TODO set chanel type;
-        } else {
-            node->children = NULL;
-            node->num_children = 0;
-            node->node_id = i;
-            node->is_leaf = true;
+        struct smlt_topology_node* node = &(topo->all_nodes[n]);
+        node->topology = topo;
+        node->core = x;
+        node->node_id = smlt_get_id_by_core(x);
+        if (node->node_id == SMLT_NID_INVALID) {
+            SMLT_ERROR("no node runs on core %" PRIu32 "\n", x);
+            smlt_platform_free(pos);
+            return SMLT_ERR_NODE_INVALD;
         }
+
+        if (topo->max_nid < node->node_id) {
+            topo->max_nid = node->node_id;
+        }
+
+        pos[x] = n++;
     }
-    for (unsigned int i = 0; i < num_threads; i++) {
-        SMLT_DEBUG(SMLT_DBG__INIT, "Parent of node %d %p \n",
-        i, (*topology)->all_nodes[i].parent);
-    }
-}
 
-/**
- * \brief build topology from model.
- *
- * @param topology      returned pointer to the topology
- *
- * @return SMELT_SUCCESS or error value
- */
-static void smlt_topology_parse_model(struct smlt_generated_model* model,
-                                      struct smlt_topology** topo)
-{
+    topo->root = &(topo->all_nodes[pos[sparse->root]]);
 
-    assert (topo!=NULL);
-    // Fill model
-    (*topo)->root = &((*topo)->all_nodes[model->root]);
-    (*topo)->root->parent = NULL;
-    // TODO use node ids instead of cores ids
-    for (unsigned int x = 0; x < model->len;x++){
-        struct smlt_topology_node* node = &((*topo)->all_nodes[x]);
-
-        // find number of children (for MP) and allocate accordingly
-        int max_child = 0;
-        for(unsigned int y = 0; y < model->len; y++){
-            int tmp = model->model[x*model->len+y];
-            if ((tmp > max_child) && (tmp <= TOPO_MATRIX_MAX_MP)){
-                max_child = model->model[x*model->len+y];
-            }
+    for (uint32_t x = 0; x < sparse->len; x++) {
+        if (pos[x] == SMLT_MODEL_NO_PARENT) {
+            continue;
         }
 
+        struct smlt_topology_node* node = &(topo->all_nodes[pos[x]]);
+        uint32_t *children = &sparse->children[sparse->child_offset[x]];
+
+        node->use_shm = false;
+
+        if (sparse->parent[x] != SMLT_MODEL_NO_PARENT) {
+            SMLT_DEBUG(SMLT_DBG__INIT,"Parent of %d is %d \n", x,
+                       sparse->parent[x]);
+            node->parent = &(topo->all_nodes[pos[sparse->parent[x]]]);
+        } else {
+            node->parent = NULL;
+        }
 
-        node->node_id = x;
+        // message passing children
+        node->num_children = sparse->num_children[x];
         node->children = (struct smlt_topology_node**)
                              smlt_platform_alloc(sizeof(struct smlt_topology_node*)*
-                                                 max_child, SMLT_DEFAULT_ALIGNMENT,
-                                                 true);
+                                                 node->num_children,
+                                                 SMLT_DEFAULT_ALIGNMENT, true);
         assert (node->children!=NULL);
-        node->num_children = max_child;
-
-        // find number of children (for SHM) and allocate accordingly
-        int shm_children = 0;
-        for (unsigned z = 0; z < model->len; z++) {
-            int val = model->model[x*(model->len)+z];
-            if ((val <= TOPO_MATRIX_SHM_SLAVE_MAX) && \
-                           (val >= TOPO_MATRIX_SHM_SLAVE_START)) {
-                shm_children++;
-            }
+
+        for (uint32_t i = 0; i < node->num_children; i++) {
+            node->children[i] = &(topo->all_nodes[pos[children[i]]]);
+            node->children[i]->array_index = i;
         }
 
+        // shared memory children
+        children += node->num_children;
+        node->num_children_shm = sparse->num_children_shm[x];
         node->children_shm = (struct smlt_topology_node**)
                              smlt_platform_alloc(sizeof(struct smlt_topology_node*)*
-                                                 shm_children, SMLT_DEFAULT_ALIGNMENT,
-                                                 true);
+                                                 node->num_children_shm,
+                                                 SMLT_DEFAULT_ALIGNMENT, true);
         assert (node->children_shm!=NULL);
-        node->num_children_shm = shm_children;
-
-        // set model
-        for(unsigned int y = 0; y < model->len; y++){
-            int val = model->model[x*(model->len)+y];
-            if (val > 0) {
-
-                if (val == TOPO_MATRIX_PARENT) {
-
-                    // message passing (parent)
-                    // --------------------------------------------------
-
-                    SMLT_DEBUG(SMLT_DBG__INIT,"Parent of %d is %d \n", x, y);
-                    node->parent = &((*topo)->all_nodes[y]);
-
-                    // Check symetry
-                    int val = model->model[y*(model->len)+x];
-                    assert (val>0 && // there should be a connection
-                            val <+ TOPO_MATRIX_MAX_MP); // .. and it should be message-passing one
-
-                } else if (val <= TOPO_MATRIX_MAX_MP) {
-
-                    // message passing (child)
-                    // --------------------------------------------------
-
-                    SMLT_DEBUG(SMLT_DBG__INIT,"Child of %d is %d at pos %d \n",
-                               x, y, val-1);
-                    node->topology = *topo;
-                    node->children[val-1] = &((*topo)->all_nodes[y]);
-                    node->node_id = x; // TODO change to real node ID
-                    (*topo)->all_nodes[y].array_index = val-1;
-
-                } else if ((val >= TOPO_MATRIX_SHM_MASTER_START) &&
-                           (val <= TOPO_MATRIX_SHM_MASTER_MAX)) {
 
-                    // shared memory regions (masters)
-                    // --------------------------------------------------
-
-                    assert (!"NYI Hybrid models");
-                    // master of shared memory channel
-                    /* node->use_shm = true; */
-                    /* SMLT_DEBUG(SMLT_DBG__GENERAL,"Child (SHM) of %d is %d at pos %d \n", */
-                    /*            x, y, shm_child_index); */
-                    /* node->topology = *topo; */
-                    /* node->children_shm[shm_child_index] = &((*topo)->all_nodes[y]); */
-                    /* node->node_id = x; // TODO change to real node ID */
-                    /* (*topo)->all_nodes[y].array_index_shm = shm_child_index; */
-                    /* shm_child_index++; */
-                } else if ((val <= TOPO_MATRIX_SHM_SLAVE_MAX) && \
-                           (val >= TOPO_MATRIX_SHM_SLAVE_START)) {
-
-                    // shared memory regions (slave)
-                    // --------------------------------------------------
-
-                    SMLT_DEBUG(SMLT_DBG__INIT,"Parent (SHM) of %d is %d \n",
-                               x,y);
-                    node->parent = &((*topo)->all_nodes[y]);
-
-                } else  {
-
-                    panic("Encountered unexpected integer value in "
-                          "topology matrix - cannot parse");
-
-                }
+        for (uint32_t i = 0; i < node->num_children_shm; i++) {
+            node->children_shm[i] = &(topo->all_nodes[pos[children[i]]]);
+            node->children_shm[i]->array_index_shm = i;
+        }
+    }
 
-            } else if (val==0) {
-                // Nothing to do here, no connection
-            }
-            else {
-                panic("Encountered unexpected integer value in "
-                      "topology matrix - cannot parse");
+    for (uint32_t j = 0; j < sparse->num_leafs; j++) {
+        uint32_t i = sparse->leafs[j];
+        if (i < sparse->len && i != sparse->root &&
+            pos[i] != SMLT_MODEL_NO_PARENT) {
+            SMLT_DEBUG(SMLT_DBG__INIT,"%d is a leaf \n", i)
+            topo->all_nodes[pos[i]].is_leaf = true;
+        }
+    }
 
-            }
+    smlt_platform_free(pos);
 
-        }
-        node->num_children = max_child;
+    topo->nid_to_node = (struct smlt_topology_node**) smlt_platform_alloc\
+        ((topo->max_nid + 1) * sizeof(void *), SMLT_DEFAULT_ALIGNMENT, true);
+    if (topo->nid_to_node == NULL) {
+        return SMLT_ERR_MALLOC_FAIL;
     }
-    for (unsigned i = 0; i < model->len; i++) {
-        for (unsigned j = 0; j < model->num_leafs; j++) {
-            if ((model->leafs[j] == i) && (i != 0)) {
-                SMLT_DEBUG(SMLT_DBG__INIT,"%d is a leaf \n", i)
-                (*topo)->all_nodes[i].is_leaf = true;
-            }
-        }
+
+    for (uint32_t i = 0; i < topo->num_nodes; i++) {
+        topo->nid_to_node[topo->all_nodes[i].node_id] = &topo->all_nodes[i];
     }
+
+    return SMLT_SUCCESS;
 }
 /*
  * ===========================================================================
@@ -357,11 +366,14 @@ struct smlt_topology_node *smlt_topology_node_next(struct smlt_topology_node *no
  *
  * @param the topology node
  *
- * @return
+ * @return the topology node or NULL if the node is not part of the topology
  */
 struct smlt_topology_node *smlt_topology_node_by_id(struct smlt_topology* topo, smlt_nid_t id)
 {
-    return &(topo->all_nodes[id]);
+    if (id > topo->max_nid) {
+        return NULL;
+    }
+    return topo->nid_to_node[id];
 }
 
 
@@ -527,6 +539,18 @@ smlt_nid_t smlt_topology_node_get_id(struct smlt_topology_node *node)
     return node->node_id;
 }
 
+/**
+ * @brief obtains the core the topology node runs on
+ *
+ * @param node  the Smelt topology node
+ *
+ * @return core id
+ */
+coreid_t smlt_topology_node_get_core(struct smlt_topology_node *node)
+{
+    return node->core;
+}
+
 /**
  * @brief returns if shared memory is used to improve performance
  *
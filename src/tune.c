@@ -0,0 +1,615 @@
+/*
+ * Copyright (c) 2016 ETH Zurich.
+ * All rights reserved.
+ *
+ * This file is distributed under the terms in the attached LICENSE file.
+ * If you do not find this file, copies can be found by writing to:
+ * ETH Zurich D-INFK, Universitaetstr. 6, CH-8092 Zurich. Attn: Systems Group.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <smlt.h>
+#include <smlt_node.h>
+#include <smlt_topology.h>
+#include <smlt_context.h>
+#include <smlt_broadcast.h>
+#include <smlt_reduction.h>
+#include <smlt_barrier.h>
+#include <smlt_tune.h>
+#include "internal.h"
+
+#define SMLT_TUNE_MAGIC   0x4e555453 /* "STUN" */
+#define SMLT_TUNE_VERSION 2
+#define SMLT_TUNE_PATHLEN 256
+
+#define SMLT_TUNE_RUNS    1000  ///< default of measured operations per variant
+
+/// the collectives are measured with a full message
+#define SMLT_TUNE_WORDS   7
+
+#define SMLT_TUNE_NOT_MEASURED ((cycles_t)-1)
+
+/**
+ * the candidate topologies, the last one is generated from the machine model
+ */
+static const char *smlt_tune_topologies[] = {
+    SMLT_TOPO_BINARY,
+    SMLT_TOPO_KARY,
+    SMLT_TOPO_BINOMIAL,
+    SMLT_TOPO_FIBONACCI,
+    SMLT_TOPO_CLUSTER,
+    "adaptivetree-shuffle-sort",
+};
+
+#define SMLT_TUNE_NUM_TOPOLOGIES \
+    (sizeof(smlt_tune_topologies) / sizeof(smlt_tune_topologies[0]))
+
+/*
+ * ===========================================================================
+ * type definitions
+ * ===========================================================================
+ */
+
+/**
+ * the decision table as stored on disk
+ */
+struct smlt_tune_table
+{
+    uint32_t magic;
+    uint32_t version;
+    uint64_t key;                               ///< hash over the key fields
+    char machine[SMLT_TUNE_NAMELEN];            ///< machine name
+    uint32_t ncores;                            ///< number of cores
+    char topo[SMLT_TUNE_NAMELEN];               ///< best over all collectives
+    struct smlt_tune_entry entries[SMLT_TUNE_NUM_OPS];
+};
+
+/**
+ * the measurements on one topology, shared by all nodes
+ */
+struct smlt_tune_bench
+{
+    struct smlt_context *ctx;
+    uint32_t runs;                              ///< measured operations
+    uint32_t warmup;                            ///< operations before
+    struct smlt_barrier *barriers[SMLT_BARRIER_NUM_TYPES];
+    cycles_t barrier_cycles[SMLT_BARRIER_NUM_TYPES];
+    cycles_t cycles[SMLT_TUNE_NUM_OPS];
+};
+
+/*
+ * ===========================================================================
+ * decision table cache
+ * ===========================================================================
+ */
+
+static bool smlt_tune_cache_enabled(void)
+{
+    const char *env = getenv("SMLT_TUNE_CACHE");
+    return (env == NULL || strcmp(env, "0") != 0);
+}
+
+/**
+ * @brief obtains the number of measured operations per variant
+ *
+ * Taken from SMLT_TUNE_RUNS, SMLT_TUNE_RUNS operations by default.
+ */
+static uint32_t smlt_tune_get_runs(void)
+{
+    const char *env = getenv("SMLT_TUNE_RUNS");
+    if (env == NULL) {
+        return SMLT_TUNE_RUNS;
+    }
+
+    long runs = strtol(env, NULL, 10);
+    if (runs <= 0 || runs > UINT32_MAX) {
+        SMLT_WARNING("invalid SMLT_TUNE_RUNS '%s', using %u\n", env,
+                     SMLT_TUNE_RUNS);
+        return SMLT_TUNE_RUNS;
+    }
+
+    return (uint32_t)runs;
+}
+
+static int smlt_tune_core_cmp(const void *a, const void *b)
+{
+    coreid_t x = *(const coreid_t *)a;
+    coreid_t y = *(const coreid_t *)b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * @brief computes the key of the decision table
+ *
+ * The key covers the set of cores, so that the table can be found for a
+ * context whose nodes are in a different order.
+ */
+static uint64_t smlt_tune_get_key(coreid_t *cores, uint32_t len,
+                                  char machine[SMLT_TUNE_NAMELEN])
+{
+    coreid_t sorted[len];
+
+    memset(machine, 0, SMLT_TUNE_NAMELEN);
+    smlt_platform_get_machine_name(machine, SMLT_TUNE_NAMELEN);
+
+    memcpy(sorted, cores, len * sizeof(coreid_t));
+    qsort(sorted, len, sizeof(coreid_t), smlt_tune_core_cmp);
+
+    uint64_t hash = SMLT_MODEL_CACHE_HASH_INIT;
+    hash = smlt_model_cache_hash(hash, machine, SMLT_TUNE_NAMELEN);
+    for (uint32_t i = 0; i < len; i++) {
+        uint32_t core = sorted[i];
+        hash = smlt_model_cache_hash(hash, &core, sizeof(core));
+    }
+
+    return hash;
+}
+
+static void smlt_tune_get_path(uint64_t key, char *buf, size_t len)
+{
+    const char *dir = getenv("SMLT_TUNE_CACHE_DIR");
+    if (dir == NULL) {
+        dir = "/tmp";
+    }
+
+    snprintf(buf, len, "%s/smlt-tune-%016" PRIx64 ".bin", dir, key);
+}
+
+/**
+ * @brief reads the decision table of a set of cores
+ */
+static errval_t smlt_tune_load(coreid_t *cores, uint32_t len,
+                               struct smlt_tune_table *tbl)
+{
+    char machine[SMLT_TUNE_NAMELEN];
+    char path[SMLT_TUNE_PATHLEN];
+
+    if (cores == NULL || len == 0 || !smlt_tune_cache_enabled()) {
+        return SMLT_ERR_TUNE_NOTFOUND;
+    }
+
+    uint64_t key = smlt_tune_get_key(cores, len, machine);
+    smlt_tune_get_path(key, path, sizeof(path));
+
+    FILE *file = fopen(path, "rb");
+    if (file == NULL) {
+        return SMLT_ERR_TUNE_NOTFOUND;
+    }
+
+    bool ok = fread(tbl, sizeof(*tbl), 1, file) == 1;
+    fclose(file);
+
+    if (!ok || tbl->magic != SMLT_TUNE_MAGIC ||
+        tbl->version != SMLT_TUNE_VERSION || tbl->key != key ||
+        tbl->ncores != len ||
+        memcmp(tbl->machine, machine, sizeof(machine)) != 0) {
+        SMLT_DEBUG(SMLT_DBG__INIT, "decision table %s does not match\n", path);
+        return SMLT_ERR_TUNE_NOTFOUND;
+    }
+
+    return SMLT_SUCCESS;
+}
+
+/**
+ * @brief writes the decision table of a set of cores
+ */
+static errval_t smlt_tune_store(coreid_t *cores, uint32_t len,
+                                struct smlt_tune_table *tbl)
+{
+    char path[SMLT_TUNE_PATHLEN];
+    char tmp_path[SMLT_TUNE_PATHLEN + 16];
+
+    tbl->magic = SMLT_TUNE_MAGIC;
+    tbl->version = SMLT_TUNE_VERSION;
+    tbl->key = smlt_tune_get_key(cores, len, tbl->machine);
+    tbl->ncores = len;
+
+    smlt_tune_get_path(tbl->key, path, sizeof(path));
+
+    /* write to a private file first, concurrent runs may race on the cache */
+    snprintf(tmp_path, sizeof(tmp_path), "%s.%d", path, (int)getpid());
+
+    FILE *file = fopen(tmp_path, "wb");
+    if (file == NULL) {
+        SMLT_WARNING("could not open %s for writing\n", tmp_path);
+        return SMLT_ERR_PROFILE_IO;
+    }
+
+    bool ok = fwrite(tbl, sizeof(*tbl), 1, file) == 1;
+
+    if (fclose(file) != 0 || !ok || rename(tmp_path, path) != 0) {
+        unlink(tmp_path);
+        return SMLT_ERR_PROFILE_IO;
+    }
+
+    SMLT_DEBUG(SMLT_DBG__INIT, "stored decision table %s\n", path);
+
+    return SMLT_SUCCESS;
+}
+
+/*
+ * ===========================================================================
+ * measurements
+ * ===========================================================================
+ */
+
+static errval_t smlt_tune_reduce_fn(struct smlt_msg *dest, struct smlt_msg *src)
+{
+    for (uint32_t i = 0; i < src->words; i++) {
+        dest->data[i] += src->data[i];
+    }
+    return SMLT_SUCCESS;
+}
+
+static errval_t smlt_tune_do_op(struct smlt_context *ctx, smlt_tune_op_t op,
+                                struct smlt_msg *in, struct smlt_msg *out)
+{
+    in->words = SMLT_TUNE_WORDS;
+    out->words = SMLT_TUNE_WORDS;
+
+    switch (op) {
+    case SMLT_TUNE_BROADCAST:
+        return smlt_broadcast(ctx, in);
+    case SMLT_TUNE_REDUCE:
+        return smlt_reduce(ctx, in, out, smlt_tune_reduce_fn);
+    case SMLT_TUNE_REDUCE_ALL:
+        return smlt_reduce_all(ctx, in, out, smlt_tune_reduce_fn);
+    default:
+        return SMLT_ERR_INVAL;
+    }
+}
+
+/**
+ * @brief runs the measurements on every node of the context
+ *
+ * The root takes the time. A collective is followed by a tree barrier, so
+ * that its last message has arrived when the time is taken; the measured
+ * cost of that barrier is subtracted again.
+ */
+static void *smlt_tune_worker(void *arg)
+{
+    struct smlt_tune_bench *b = (struct smlt_tune_bench *)arg;
+    struct smlt_context *ctx = b->ctx;
+    bool root = smlt_context_is_root(ctx);
+    cycles_t t0;
+
+    for (uint32_t t = 0; t < SMLT_BARRIER_NUM_TYPES; t++) {
+        if (b->barriers[t] == NULL) {
+            continue;
+        }
+
+        smlt_barrier_wait(ctx);
+        for (uint32_t r = 0; r < b->warmup; r++) {
+            smlt_barrier_enter(b->barriers[t]);
+        }
+
+        t0 = smlt_arch_tsc();
+        for (uint32_t r = 0; r < b->runs; r++) {
+            smlt_barrier_enter(b->barriers[t]);
+        }
+        if (root) {
+            b->barrier_cycles[t] = (smlt_arch_tsc() - t0) / b->runs;
+        }
+    }
+
+    struct smlt_msg *in = smlt_message_alloc(SMELT_MESSAGE_MIN_SIZE);
+    struct smlt_msg *out = smlt_message_alloc(SMELT_MESSAGE_MIN_SIZE);
+    if (in == NULL || out == NULL) {
+        SMLT_ABORT("could not allocate the tuning messages\n");
+    }
+    memset(in->data, 0, SMELT_MESSAGE_MIN_SIZE);
+
+    cycles_t overhead = b->barrier_cycles[SMLT_BARRIER_TREE];
+
+    for (uint32_t op = SMLT_TUNE_BROADCAST; op < SMLT_TUNE_NUM_OPS; op++) {
+        smlt_barrier_wait(ctx);
+        for (uint32_t r = 0; r < b->warmup; r++) {
+            smlt_tune_do_op(ctx, (smlt_tune_op_t)op, in, out);
+        }
+        smlt_barrier_wait(ctx);
+
+        t0 = smlt_arch_tsc();
+        for (uint32_t r = 0; r < b->runs; r++) {
+            smlt_tune_do_op(ctx, (smlt_tune_op_t)op, in, out);
+        }
+        smlt_barrier_wait(ctx);
+
+        if (root) {
+            cycles_t c = smlt_arch_tsc() - t0;
+            b->cycles[op] = (c > overhead ? c - overhead : 0) / b->runs;
+        }
+    }
+
+    smlt_message_free(in);
+    smlt_message_free(out);
+
+    return NULL;
+}
+
+/**
+ * @brief measures the collectives on one topology
+ *
+ * @param all_barriers  measure all barrier algorithms, not only the tree
+ */
+static errval_t smlt_tune_measure(coreid_t *cores, uint32_t len,
+                                  const char *name, bool all_barriers,
+                                  struct smlt_tune_bench *b)
+{
+    errval_t err;
+
+    memset(b, 0, sizeof(*b));
+    b->runs = smlt_tune_get_runs();
+    b->warmup = b->runs / 10;
+    for (uint32_t t = 0; t < SMLT_BARRIER_NUM_TYPES; t++) {
+        b->barrier_cycles[t] = SMLT_TUNE_NOT_MEASURED;
+    }
+    for (uint32_t op = 0; op < SMLT_TUNE_NUM_OPS; op++) {
+        b->cycles[op] = SMLT_TUNE_NOT_MEASURED;
+    }
+
+    err = smlt_context_create_from_cores(cores, len, name, &b->ctx);
+    if (smlt_err_is_fail(err)) {
+        return err;
+    }
+
+    for (uint32_t t = SMLT_BARRIER_TREE; t < SMLT_BARRIER_NUM_TYPES; t++) {
+        if (t != SMLT_BARRIER_TREE && !all_barriers) {
+            continue;
+        }
+        err = smlt_barrier_create(b->ctx, (smlt_barrier_type_t)t,
+                                  &b->barriers[t]);
+        if (smlt_err_is_fail(err)) {
+            goto out;
+        }
+    }
+
+    uint32_t started = 0;
+    for (; started < len; started++) {
+        struct smlt_node *node = smlt_get_node_by_id(smlt_get_id_by_core(cores[started]));
+        if (node == NULL) {
+            err = SMLT_ERR_NODE_INVALD;
+            break;
+        }
+        err = smlt_node_start(node, smlt_tune_worker, b);
+        if (smlt_err_is_fail(err)) {
+            break;
+        }
+    }
+
+    for (uint32_t i = 0; i < started; i++) {
+        smlt_node_join(smlt_get_node_by_id(smlt_get_id_by_core(cores[i])));
+    }
+
+ out:
+    for (uint32_t t = 0; t < SMLT_BARRIER_NUM_TYPES; t++) {
+        if (b->barriers[t]) {
+            smlt_barrier_free(b->barriers[t]);
+        }
+    }
+    smlt_context_destroy(b->ctx);
+
+    return err;
+}
+
+/**
+ * @brief fills the decision table from the measurements
+ */
+static void smlt_tune_decide(struct smlt_tune_bench *benches, bool *measured,
+                             struct smlt_tune_table *tbl)
+{
+    cycles_t best[SMLT_TUNE_NUM_OPS];
+
+    // the barrier over all algorithms and topologies
+    struct smlt_tune_entry *e = &tbl->entries[SMLT_TUNE_BARRIER];
+    e->cycles = SMLT_TUNE_NOT_MEASURED;
+    for (uint32_t i = 0; i < SMLT_TUNE_NUM_TOPOLOGIES; i++) {
+        for (uint32_t t = 0; measured[i] && t < SMLT_BARRIER_NUM_TYPES; t++) {
+            if (benches[i].barrier_cycles[t] < e->cycles) {
+                e->cycles = benches[i].barrier_cycles[t];
+                e->barrier = t;
+                snprintf(e->topo, sizeof(e->topo), "%s",
+                         smlt_tune_topologies[i]);
+            }
+        }
+    }
+    best[SMLT_TUNE_BARRIER] = e->cycles;
+
+    for (uint32_t op = SMLT_TUNE_BROADCAST; op < SMLT_TUNE_NUM_OPS; op++) {
+        e = &tbl->entries[op];
+        e->cycles = SMLT_TUNE_NOT_MEASURED;
+        e->barrier = SMLT_BARRIER_TREE;
+        for (uint32_t i = 0; i < SMLT_TUNE_NUM_TOPOLOGIES; i++) {
+            if (measured[i] && benches[i].cycles[op] < e->cycles) {
+                e->cycles = benches[i].cycles[op];
+                snprintf(e->topo, sizeof(e->topo), "%s",
+                         smlt_tune_topologies[i]);
+            }
+        }
+        best[op] = e->cycles;
+    }
+
+    // the topology of a context: the smallest sum of the slowdowns
+    double best_score = 0;
+    for (uint32_t i = 0; i < SMLT_TUNE_NUM_TOPOLOGIES; i++) {
+        if (!measured[i]) {
+            continue;
+        }
+
+        double score = 0;
+        for (uint32_t op = SMLT_TUNE_BROADCAST; op < SMLT_TUNE_NUM_OPS; op++) {
+            score += (double)(benches[i].cycles[op] + 1)
+                     / (double)(best[op] + 1);
+        }
+
+        if (tbl->topo[0] == 0 || score < best_score) {
+            best_score = score;
+            snprintf(tbl->topo, sizeof(tbl->topo), "%s",
+                     smlt_tune_topologies[i]);
+        }
+    }
+}
+
+/*
+ * ===========================================================================
+ * auto-tuner
+ * ===========================================================================
+ */
+
+/**
+ * @brief measures all variants and stores the decision table
+ *
+ * @param cores     the cores to tune for, cores[0] becomes the root
+ * @param len       length of the cores array
+ *
+ * @returns SMLT_SUCCESS or error value
+ *
+ * Has to be called from a thread that is not a Smelt node, the nodes of the
+ * cores must be idle. An existing table for the cores is replaced.
+ */
+errval_t smlt_tune_run(coreid_t *cores, uint32_t len)
+{
+    errval_t err = SMLT_SUCCESS;
+    bool measured[SMLT_TUNE_NUM_TOPOLOGIES];
+    bool barriers_done = false;
+    uint32_t num_measured = 0;
+
+    if (cores == NULL || len == 0) {
+        return SMLT_ERR_INVAL;
+    }
+
+    struct smlt_tune_bench *benches = (struct smlt_tune_bench *)
+        smlt_platform_alloc(SMLT_TUNE_NUM_TOPOLOGIES *
+                            sizeof(struct smlt_tune_bench),
+                            SMLT_ARCH_CACHELINE_SIZE, true);
+    struct smlt_tune_table *tbl = (struct smlt_tune_table *)
+        smlt_platform_alloc(sizeof(struct smlt_tune_table),
+                            SMLT_ARCH_CACHELINE_SIZE, true);
+    if (benches == NULL || tbl == NULL) {
+        err = SMLT_ERR_MALLOC_FAIL;
+        goto out;
+    }
+
+    for (uint32_t i = 0; i < SMLT_TUNE_NUM_TOPOLOGIES; i++) {
+        SMLT_DEBUG(SMLT_DBG__INIT, "tuning topology %s on %u cores\n",
+                   smlt_tune_topologies[i], len);
+
+        err = smlt_tune_measure(cores, len, smlt_tune_topologies[i],
+                                !barriers_done, &benches[i]);
+        measured[i] = smlt_err_is_ok(err);
+        if (!measured[i]) {
+            SMLT_WARNING("could not measure topology %s\n",
+                         smlt_tune_topologies[i]);
+            continue;
+        }
+
+        barriers_done = true;
+        num_measured++;
+    }
+
+    if (num_measured == 0) {
+        goto out;
+    }
+
+    smlt_tune_decide(benches, measured, tbl);
+
+    err = smlt_tune_store(cores, len, tbl);
+
+ out:
+    if (benches) {
+        smlt_platform_free(benches);
+    }
+    if (tbl) {
+        smlt_platform_free(tbl);
+    }
+
+    return err;
+}
+
+/**
+ * @brief obtains the fastest variant of a collective operation
+ *
+ * @param cores     the cores of the context
+ * @param len       length of the cores array
+ * @param op        the collective operation
+ * @param entry     returns the entry of the decision table
+ *
+ * @returns SMLT_SUCCESS or SMLT_ERR_TUNE_NOTFOUND if the cores are not tuned
+ */
+errval_t smlt_tune_get_entry(coreid_t *cores, uint32_t len, smlt_tune_op_t op,
+                             struct smlt_tune_entry *entry)
+{
+    errval_t err;
+    struct smlt_tune_table tbl;
+
+    if (op >= SMLT_TUNE_NUM_OPS) {
+        return SMLT_ERR_INVAL;
+    }
+
+    err = smlt_tune_load(cores, len, &tbl);
+    if (smlt_err_is_fail(err)) {
+        return err;
+    }
+
+    *entry = tbl.entries[op];
+
+    return SMLT_SUCCESS;
+}
+
+/**
+ * @brief obtains the topology that is the best over all collectives
+ *
+ * @param cores     the cores of the context
+ * @param len       length of the cores array
+ * @param name      returns the name of the topology
+ * @param namelen   size of the name buffer
+ *
+ * @returns SMLT_SUCCESS or SMLT_ERR_TUNE_NOTFOUND if the cores are not tuned
+ */
+errval_t smlt_tune_get_topology(coreid_t *cores, uint32_t len, char *name,
+                                size_t namelen)
+{
+    errval_t err;
+    struct smlt_tune_table tbl;
+
+    err = smlt_tune_load(cores, len, &tbl);
+    if (smlt_err_is_fail(err)) {
+        return err;
+    }
+
+    snprintf(name, namelen, "%s", tbl.topo);
+
+    return SMLT_SUCCESS;
+}
+
+/**
+ * @brief obtains the fastest barrier algorithm
+ *
+ * @param cores     the cores of the context
+ * @param len       length of the cores array
+ * @param type      returns the barrier algorithm
+ *
+ * @returns SMLT_SUCCESS or SMLT_ERR_TUNE_NOTFOUND if the cores are not tuned
+ */
+errval_t smlt_tune_get_barrier(coreid_t *cores, uint32_t len,
+                               smlt_barrier_type_t *type)
+{
+    errval_t err;
+    struct smlt_tune_entry entry;
+
+    err = smlt_tune_get_entry(cores, len, SMLT_TUNE_BARRIER, &entry);
+    if (smlt_err_is_fail(err)) {
+        return err;
+    }
+
+    if (entry.barrier <= SMLT_BARRIER_DEFAULT ||
+        entry.barrier >= SMLT_BARRIER_NUM_TYPES) {
+        return SMLT_ERR_TUNE_NOTFOUND;
+    }
+
+    *type = (smlt_barrier_type_t)entry.barrier;
+
+    return SMLT_SUCCESS;
+}
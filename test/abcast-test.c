@@ -0,0 +1,224 @@
+/**
+ * \brief Testing the total order of the atomic broadcast
+ */
+
+/*
+ * Copyright (c) 2016, ETH Zurich.
+ * All rights reserved.
+ *
+ * This file is distributed under the terms in the attached LICENSE file.
+ * If you do not find this file, copies can be found by writing to:
+ * ETH Zurich D-INFK, Universitaetstr. 6, CH-8092 Zurich. Attn: Systems Group.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <smlt.h>
+#include <smlt_node.h>
+#include <smlt_message.h>
+#include <smlt_broadcast.h>
+#include <smlt_topology.h>
+#include <smlt_context.h>
+
+#define MAX_NODES 64
+
+#define NUM_RUNS 300
+
+static struct smlt_context *context = NULL;
+
+static uint32_t num_nodes;
+
+/**
+ * a delivered message
+ */
+struct delivery {
+    smlt_nid_t origin;
+    uint64_t seq;
+    uint32_t round;                 ///< round in which it was delivered
+    uint32_t words;
+    smlt_msg_payload_t data[SMLT_ABCAST_PAYLOAD_WORDS];
+};
+
+/**
+ * the messages a node delivered, in order
+ */
+struct delivery_log {
+    uint32_t round;
+    uint32_t num;
+    struct delivery *entries;
+};
+
+static struct delivery_log logs[MAX_NODES];
+
+static volatile int num_wrong = 0;
+
+#define CHECK(cond)                                                         \
+    do {                                                                    \
+        if (!(cond)) {                                                      \
+            printf("check failed: %s (line %d)\n", #cond, __LINE__);        \
+            __sync_fetch_and_add(&num_wrong, 1);                            \
+        }                                                                   \
+    } while (0)
+
+/// some nodes do not submit in a round, the others vary the length
+static uint32_t submit_words(smlt_nid_t nid, uint32_t round)
+{
+    if ((nid + round) % 3 == 0) {
+        return 0;
+    }
+    return 1 + (nid * 7 + round) % SMLT_ABCAST_PAYLOAD_WORDS;
+}
+
+static smlt_msg_payload_t payload(smlt_nid_t nid, uint32_t round, uint32_t word)
+{
+    return ((uint64_t)nid << 40) | ((uint64_t)round << 8) | word;
+}
+
+static void deliver(struct smlt_msg *msg, smlt_nid_t origin, uint64_t seq,
+                    void *arg)
+{
+    struct delivery_log *log = (struct delivery_log *)arg;
+    struct delivery *d = &log->entries[log->num++];
+
+    d->origin = origin;
+    d->seq = seq;
+    d->round = log->round;
+    d->words = msg->words;
+    memcpy(d->data, msg->data, msg->words * sizeof(smlt_msg_payload_t));
+}
+
+static void* thr_worker(void* arg)
+{
+    smlt_nid_t nid = smlt_node_get_id();
+    struct delivery_log *log = &logs[nid];
+    struct smlt_msg *msg = smlt_message_alloc(56);
+
+    for (uint32_t i = 0; i < NUM_RUNS; i++) {
+        log->round = i;
+
+        uint32_t words = submit_words(nid, i);
+        msg->words = words;
+        for (uint32_t w = 0; w < words; w++) {
+            msg->data[w] = payload(nid, i, w);
+        }
+
+        errval_t err = smlt_atomic_broadcast(context, words ? msg : NULL,
+                                             deliver, log);
+        CHECK(smlt_err_is_ok(err));
+    }
+
+    // a message must fit
+    msg->words = SMLT_ABCAST_PAYLOAD_WORDS + 1;
+    CHECK(smlt_err_no(smlt_atomic_broadcast(context, msg, deliver, log))
+          == SMLT_ERR_INVAL);
+
+    smlt_message_free(msg);
+
+    return NULL;
+}
+
+static void check_logs(void)
+{
+    uint32_t num_submitted = 0;
+    for (uint32_t i = 0; i < NUM_RUNS; i++) {
+        for (smlt_nid_t n = 0; n < num_nodes; n++) {
+            num_submitted += (submit_words(n, i) != 0);
+        }
+    }
+
+    // every message is delivered once, with its content, in its round
+    struct delivery_log *first = &logs[0];
+    CHECK(first->num == num_submitted);
+
+    uint32_t next_round[MAX_NODES] = { 0 };
+    for (uint32_t k = 0; k < first->num; k++) {
+        struct delivery *d = &first->entries[k];
+
+        CHECK(d->seq == k + 1);
+        CHECK(d->origin < num_nodes);
+        if (d->origin >= num_nodes) {
+            continue;
+        }
+
+        // the messages of a node arrive in the order it submitted them
+        CHECK(d->round >= next_round[d->origin]);
+        next_round[d->origin] = d->round + 1;
+
+        CHECK(d->words == submit_words(d->origin, d->round));
+        for (uint32_t w = 0; w < d->words; w++) {
+            CHECK(d->data[w] == payload(d->origin, d->round, w));
+        }
+    }
+
+    // and all nodes agree on the order
+    for (smlt_nid_t n = 1; n < num_nodes; n++) {
+        CHECK(logs[n].num == first->num);
+        if (logs[n].num == first->num) {
+            CHECK(memcmp(logs[n].entries, first->entries,
+                         first->num * sizeof(struct delivery)) == 0);
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+    size_t num_threads = sysconf(_SC_NPROCESSORS_ONLN);
+    errval_t err;
+
+    err = smlt_init(num_threads, true);
+    if (smlt_err_is_fail(err)) {
+        printf("FAILED TO INITIALIZE !\n");
+        return 1;
+    }
+
+    num_nodes = smlt_get_num_proc();
+    if (num_nodes > MAX_NODES) {
+        printf("too many nodes\n");
+        return 1;
+    }
+
+    struct smlt_topology *topo = NULL;
+    smlt_topology_create(NULL, SMLT_TOPO_BINARY, &topo);
+
+    err = smlt_context_create(topo, &context);
+    if (smlt_err_is_fail(err)) {
+        printf("FAILED TO INITIALIZE CONTEXT !\n");
+        return 1;
+    }
+
+    for (uint32_t i = 0; i < num_nodes; i++) {
+        logs[i].entries = (struct delivery *)calloc(NUM_RUNS * num_nodes,
+                                                    sizeof(struct delivery));
+    }
+
+    struct smlt_node *node;
+    for (uint64_t i = 0; i < num_nodes; i++) {
+        node = smlt_get_node_by_id(i);
+        err = smlt_node_start(node, thr_worker, (void *)i);
+        if (smlt_err_is_fail(err)) {
+            printf("Starting node failed \n");
+            return 1;
+        }
+    }
+
+    for (uint64_t i = 0; i < num_nodes; i++) {
+        node = smlt_get_node_by_id(i);
+        smlt_node_join(node);
+    }
+
+    check_logs();
+
+    for (uint32_t i = 0; i < num_nodes; i++) {
+        free(logs[i].entries);
+    }
+
+    if (!num_wrong) {
+        printf("Atomic Broadcast Test Success\n");
+    } else {
+        printf("Atomic Broadcast Test Failed \n");
+    }
+
+    return num_wrong ? 1 : 0;
+}
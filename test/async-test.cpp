@@ -0,0 +1,182 @@
+/**
+ * \brief Testing the coroutine executor
+ */
+
+/*
+ * Copyright (c) 2016, ETH Zurich.
+ * All rights reserved.
+ *
+ * This file is distributed under the terms in the attached LICENSE file.
+ * If you do not find this file, copies can be found by writing to:
+ * ETH Zurich D-INFK, Universitaetstr. 6, CH-8092 Zurich. Attn: Systems Group.
+ */
+
+#include <stdio.h>
+#include <unistd.h>
+#include <smlt_async.hpp>
+
+/* the node and context headers are C99 only */
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpedantic"
+#pragma GCC diagnostic ignored "-Wvla"
+extern "C" {
+#include <smlt_topology.h>
+#include <smlt_node.h>
+#include <smlt_context.h>
+}
+#pragma GCC diagnostic pop
+
+#define NUM_MSGS 100000
+#define NUM_CONSUMERS 1000
+#define NUM_BARRIERS 1000
+
+static struct smlt_context *context = NULL;
+
+typedef smlt::Queue<smlt::FFQ> queue_t;
+
+/// a message of the producer
+struct Item
+{
+    uint64_t seq;
+    uint64_t check;
+};
+
+/// sends NUM_MSGS items, suspends while the queue is full
+static smlt::async::Task producer(queue_t &tx)
+{
+    for (uint64_t i = 0; i < NUM_MSGS; i++) {
+        co_await smlt::async::send(tx, Item{ i, ~i });
+    }
+}
+
+/// receives its share of the items and adds them up
+static smlt::async::Task consumer(queue_t &rx, uint64_t *sum, int *num_wrong)
+{
+    for (uint64_t i = 0; i < NUM_MSGS / NUM_CONSUMERS; i++) {
+        Item item = co_await smlt::async::recv<Item>(rx);
+        if (item.check != ~item.seq) {
+            (*num_wrong)++;
+        }
+        *sum += item.seq;
+    }
+}
+
+/// a message larger than the object it is received into
+struct Wide
+{
+    uint64_t words[3];
+};
+
+/// receives into an object, the error of a larger message is returned
+static smlt::async::Task receive_into(queue_t &tx, queue_t &rx, int *num_wrong)
+{
+    Item item = { 0, 0 };
+
+    co_await smlt::async::send(tx, Item{ 7, ~7ULL });
+    errval_t err = co_await smlt::async::recv(rx, item);
+    if (smlt_err_is_fail(err) || item.seq != 7 || item.check != ~7ULL) {
+        (*num_wrong)++;
+    }
+
+    co_await smlt::async::send(tx, Wide{ { 1, 2, 3 } });
+    err = co_await smlt::async::recv(rx, item);
+    if (smlt_err_no(err) != SMLT_ERR_INVAL) {
+        (*num_wrong)++;
+    }
+
+    // the words form still takes the buffer
+    smlt::word_t data[queue_t::words] = { 0 };
+    co_await smlt::async::send(tx, Item{ 8, ~8ULL });
+    err = co_await smlt::async::recv(rx, data);
+    if (smlt_err_is_fail(err) || data[0] != 8) {
+        (*num_wrong)++;
+    }
+}
+
+/// enters the barrier of the context repeatedly
+static smlt::async::Task barrier(int *num_wrong)
+{
+    for (uint64_t i = 0; i < NUM_BARRIERS; i++) {
+        errval_t err = co_await smlt::async::barrier(context);
+        if (smlt_err_is_fail(err)) {
+            (*num_wrong)++;
+        }
+    }
+}
+
+static void *thr_worker(void *arg)
+{
+    uint64_t id = (uint64_t)arg;
+    struct smlt_qp *qp1;
+    struct smlt_qp *qp2;
+    int num_wrong = 0;
+    uint64_t sum = 0;
+
+    errval_t err = smlt_queuepair_create(SMLT_QP_TYPE_FFQ, &qp1, &qp2,
+                                         id, id);
+    if (smlt_err_is_fail(err)) {
+        printf("Node %lu: FAILED TO CREATE QUEUEPAIR\n", id);
+        return NULL;
+    }
+
+    queue_t tx(qp1);
+    queue_t rx(qp2);
+
+    smlt::async::Executor exec;
+    exec.spawn(barrier(&num_wrong));
+    for (uint32_t i = 0; i < NUM_CONSUMERS; i++) {
+        exec.spawn(consumer(rx, &sum, &num_wrong));
+    }
+    exec.spawn(producer(tx));
+    exec.run();
+
+    exec.spawn(receive_into(tx, rx, &num_wrong));
+    exec.run();
+
+    if (sum != (uint64_t)NUM_MSGS * (NUM_MSGS - 1) / 2) {
+        num_wrong++;
+    }
+
+    if (!num_wrong) {
+        printf("Node %lu: Test Success \n", id);
+    } else {
+        printf("Node %lu: Test Failed \n", id);
+    }
+    return NULL;
+}
+
+int main(int argc, char **argv)
+{
+    size_t num_threads = sysconf(_SC_NPROCESSORS_ONLN);
+
+    errval_t err = smlt_init(num_threads, true);
+    if (smlt_err_is_fail(err)) {
+        printf("FAILED TO INITIALIZE !\n");
+        return 1;
+    }
+
+    struct smlt_topology *topo = NULL;
+    smlt_topology_create(NULL, "binary_tree", &topo);
+
+    err = smlt_context_create(topo, &context);
+    if (smlt_err_is_fail(err)) {
+        printf("FAILED TO INITIALIZE CONTEXT !\n");
+        return 1;
+    }
+
+    struct smlt_node *node;
+    for (uint64_t i = 0; i < num_threads; i++) {
+        node = smlt_get_node_by_id(i);
+        err = smlt_node_start(node, thr_worker, (void *)i);
+        if (smlt_err_is_fail(err)) {
+            printf("Starting node failed \n");
+        }
+    }
+
+    for (uint64_t i = 0; i < num_threads; i++) {
+        node = smlt_get_node_by_id(i);
+        smlt_node_join(node);
+    }
+
+    return 0;
+}
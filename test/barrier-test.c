@@ -0,0 +1,211 @@
+/**
+ * \brief Testing the barrier algorithms
+ */
+
+/*
+ * Copyright (c) 2016, ETH Zurich.
+ * All rights reserved.
+ *
+ * This file is distributed under the terms in the attached LICENSE file.
+ * If you do not find this file, copies can be found by writing to:
+ * ETH Zurich D-INFK, Universitaetstr. 6, CH-8092 Zurich. Attn: Systems Group.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <smlt.h>
+#include <smlt_node.h>
+#include <smlt_barrier.h>
+#include <smlt_topology.h>
+#include <smlt_context.h>
+
+#define MAX_NODES 64
+
+#define NUM_RUNS 64
+
+// every this many rounds, one node is late
+#define LATE_EVERY 8
+#define LATE_WORK 20000
+
+static struct smlt_context *context = NULL;
+
+// the even nodes, in reverse order
+static struct smlt_context *evens = NULL;
+
+static struct smlt_barrier *barriers[2][SMLT_BARRIER_NUM_TYPES];
+
+static uint32_t num_nodes;
+
+// number of nodes that entered each round
+static volatile uint32_t entered[2][SMLT_BARRIER_NUM_TYPES][NUM_RUNS];
+
+static volatile int num_wrong = 0;
+
+#define CHECK(cond)                                                         \
+    do {                                                                    \
+        if (!(cond)) {                                                      \
+            printf("check failed: %s (line %d)\n", #cond, __LINE__);        \
+            __sync_fetch_and_add(&num_wrong, 1);                            \
+        }                                                                   \
+    } while (0)
+
+/// nobody leaves a round before everyone entered it
+static void run_barrier(uint32_t c, smlt_barrier_type_t type)
+{
+    struct smlt_barrier *bar = barriers[c][type];
+    struct smlt_context *ctx = c ? evens : context;
+    uint32_t num = smlt_context_get_num_nodes(ctx);
+    uint32_t rank = smlt_context_get_rank(ctx);
+
+    for (uint32_t i = 0; i < NUM_RUNS; i++) {
+        // a different node is late every time
+        if (i % LATE_EVERY == 0 && rank == (i / LATE_EVERY) % num) {
+            for (volatile int j = 0; j < LATE_WORK; j++)
+                ;
+        }
+
+        __sync_fetch_and_add(&entered[c][type][i], 1);
+        CHECK(smlt_err_is_ok(smlt_barrier_enter(bar)));
+        if (entered[c][type][i] != num) {
+            printf("%s barrier over %u nodes released round %u early\n",
+                   smlt_barrier_type_to_name(smlt_barrier_get_type(bar)),
+                   num, i);
+            __sync_fetch_and_add(&num_wrong, 1);
+        }
+    }
+}
+
+static void* thr_worker(void* arg)
+{
+    smlt_nid_t nid = smlt_node_get_id();
+
+    for (uint32_t c = 0; c < 2; c++) {
+        if (c == 1 && (evens == NULL || nid % 2 != 0)) {
+            continue;
+        }
+        for (smlt_barrier_type_t t = 0; t < SMLT_BARRIER_NUM_TYPES; t++) {
+            run_barrier(c, t);
+        }
+    }
+
+    return NULL;
+}
+
+static void test_names(void)
+{
+    for (smlt_barrier_type_t t = 0; t < SMLT_BARRIER_NUM_TYPES; t++) {
+        const char *name = smlt_barrier_type_to_name(t);
+        CHECK(name != NULL);
+        if (name) {
+            CHECK(smlt_barrier_type_from_name(name) == t);
+        }
+    }
+    CHECK(smlt_barrier_type_to_name(SMLT_BARRIER_NUM_TYPES) == NULL);
+    CHECK(smlt_barrier_type_from_name("nosuchbarrier") == SMLT_BARRIER_NUM_TYPES);
+
+    struct smlt_barrier *bar = NULL;
+    CHECK(smlt_err_no(smlt_barrier_create(context, SMLT_BARRIER_NUM_TYPES, &bar))
+          == SMLT_ERR_INVAL);
+}
+
+static errval_t create_barriers(uint32_t c, struct smlt_context *ctx)
+{
+    for (smlt_barrier_type_t t = 0; t < SMLT_BARRIER_NUM_TYPES; t++) {
+        errval_t err = smlt_barrier_create(ctx, t, &barriers[c][t]);
+        if (smlt_err_is_fail(err)) {
+            printf("creating barrier %s failed\n", smlt_barrier_type_to_name(t));
+            return err;
+        }
+
+        // the default resolves to an algorithm
+        smlt_barrier_type_t type = smlt_barrier_get_type(barriers[c][t]);
+        CHECK(type != SMLT_BARRIER_DEFAULT && type < SMLT_BARRIER_NUM_TYPES);
+        CHECK(t == SMLT_BARRIER_DEFAULT || type == t);
+    }
+    return SMLT_SUCCESS;
+}
+
+int main(int argc, char **argv)
+{
+    size_t num_threads = sysconf(_SC_NPROCESSORS_ONLN);
+    errval_t err;
+
+    err = smlt_init(num_threads, true);
+    if (smlt_err_is_fail(err)) {
+        printf("FAILED TO INITIALIZE !\n");
+        return 1;
+    }
+
+    num_nodes = smlt_get_num_proc();
+    if (num_nodes > MAX_NODES) {
+        printf("too many nodes\n");
+        return 1;
+    }
+
+    struct smlt_topology *topo = NULL;
+    smlt_topology_create(NULL, SMLT_TOPO_BINARY, &topo);
+
+    err = smlt_context_create(topo, &context);
+    if (smlt_err_is_fail(err)) {
+        printf("FAILED TO INITIALIZE CONTEXT !\n");
+        return 1;
+    }
+
+    test_names();
+
+    if (smlt_err_is_fail(create_barriers(0, context))) {
+        return 1;
+    }
+
+    // an odd number of nodes that does not start at the first one
+    if (num_nodes >= 3) {
+        coreid_t cores[MAX_NODES];
+        uint32_t len = 0;
+        for (int32_t i = num_nodes - 1; i >= 0; i--) {
+            if (i % 2 == 0) {
+                cores[len++] = smlt_get_core_by_id(i);
+            }
+        }
+
+        err = smlt_context_create_from_cores(cores, len, SMLT_TOPO_BINARY,
+                                             &evens);
+        if (smlt_err_is_fail(err) ||
+            smlt_err_is_fail(create_barriers(1, evens))) {
+            printf("FAILED TO INITIALIZE THE SUB-CONTEXT !\n");
+            return 1;
+        }
+    }
+
+    struct smlt_node *node;
+    for (uint64_t i = 0; i < num_nodes; i++) {
+        node = smlt_get_node_by_id(i);
+        err = smlt_node_start(node, thr_worker, (void *)i);
+        if (smlt_err_is_fail(err)) {
+            printf("Starting node failed \n");
+            return 1;
+        }
+    }
+
+    for (uint64_t i = 0; i < num_nodes; i++) {
+        node = smlt_get_node_by_id(i);
+        smlt_node_join(node);
+    }
+
+    for (uint32_t c = 0; c < 2; c++) {
+        for (smlt_barrier_type_t t = 0; t < SMLT_BARRIER_NUM_TYPES; t++) {
+            if (barriers[c][t]) {
+                smlt_barrier_free(barriers[c][t]);
+            }
+        }
+    }
+
+    if (!num_wrong) {
+        printf("Barrier Test Success\n");
+    } else {
+        printf("Barrier Test Failed \n");
+    }
+
+    return num_wrong ? 1 : 0;
+}
@@ -0,0 +1,229 @@
+/**
+ * \brief Testing the built-in tree topologies
+ */
+
+/*
+ * Copyright (c) 2016, ETH Zurich.
+ * All rights reserved.
+ *
+ * This file is distributed under the terms in the attached LICENSE file.
+ * If you do not find this file, copies can be found by writing to:
+ * ETH Zurich D-INFK, Universitaetstr. 6, CH-8092 Zurich. Attn: Systems Group.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <smlt.h>
+#include <smlt_generator.h>
+#include <smlt_topology.h>
+
+#define MAX_CORES 64
+
+static coreid_t cores[MAX_CORES];
+
+static int num_wrong = 0;
+
+#define CHECK(cond)                                                         \
+    do {                                                                    \
+        if (!(cond)) {                                                      \
+            printf("check failed: %s (line %d)\n", #cond, __LINE__);        \
+            num_wrong++;                                                    \
+        }                                                                   \
+    } while (0)
+
+static struct smlt_sparse_model *generate(const char *name, uint32_t len)
+{
+    struct smlt_sparse_model *sparse = NULL;
+
+    errval_t err = smlt_generate_builtin_sparse_model(name, cores, len, &sparse);
+    if (smlt_err_is_fail(err)) {
+        printf("generating %s over %u cores failed\n", name, len);
+        num_wrong++;
+        return NULL;
+    }
+
+    // every core is reached
+    for (uint32_t i = 1; i < len; i++) {
+        CHECK(sparse->parent[cores[i]] != SMLT_MODEL_NO_PARENT);
+    }
+    CHECK(sparse->root == cores[0]);
+
+    return sparse;
+}
+
+/**
+ * @brief time until the last core has the message
+ *
+ * Sending takes one unit, the message arrives latency units after the send
+ * started. A node sends to its children in order.
+ */
+static uint32_t completion_time(struct smlt_sparse_model *m, uint32_t node,
+                                uint32_t t, uint32_t latency)
+{
+    uint32_t last = t;
+    for (uint32_t k = 0; k < m->num_children[node]; k++) {
+        uint32_t child = m->children[m->child_offset[node] + k];
+        uint32_t done = completion_time(m, child, t + k + latency, latency);
+        if (done > last) {
+            last = done;
+        }
+    }
+    return last;
+}
+
+static void test_kary(void)
+{
+    struct smlt_sparse_model *m;
+
+    m = generate(SMLT_TOPO_BINARY, 15);
+    if (m) {
+        for (uint32_t i = 1; i < 15; i++) {
+            CHECK(m->parent[cores[i]] == cores[(i - 1) / 2]);
+        }
+        CHECK(m->num_leafs == 8);
+        smlt_sparse_model_destroy(m);
+    }
+
+    m = generate("kary-3", 13);
+    if (m) {
+        for (uint32_t i = 1; i < 13; i++) {
+            CHECK(m->parent[cores[i]] == cores[(i - 1) / 3]);
+            CHECK(m->child_idx[cores[i]] == (i - 1) % 3);
+        }
+        smlt_sparse_model_destroy(m);
+    }
+
+    // the default fan-out
+    m = generate(SMLT_TOPO_KARY, 10);
+    if (m) {
+        CHECK(m->num_children[cores[0]] == SMLT_TOPO_DEFAULT_FANOUT);
+        smlt_sparse_model_destroy(m);
+    }
+
+    // a chain
+    m = generate("kary-1", 5);
+    if (m) {
+        CHECK(m->num_leafs == 1 && m->leafs[0] == cores[4]);
+        smlt_sparse_model_destroy(m);
+    }
+}
+
+static void test_greedy(void)
+{
+    struct smlt_sparse_model *m;
+
+    // in a binomial tree, the parent is the rank without its highest bit
+    m = generate(SMLT_TOPO_BINOMIAL, 32);
+    if (m) {
+        for (uint32_t i = 1; i < 32; i++) {
+            uint32_t high = 1;
+            while (high * 2 <= i) {
+                high *= 2;
+            }
+            CHECK(m->parent[cores[i]] == cores[i - high]);
+        }
+        CHECK(completion_time(m, cores[0], 0, 1) == 5);
+        smlt_sparse_model_destroy(m);
+    }
+
+    // a Fibonacci tree reaches F(t) cores by time t with a latency of two
+    static const uint32_t fib[][2] = { { 8, 5 }, { 13, 6 }, { 14, 7 },
+                                       { 21, 7 }, { 34, 8 } };
+    for (uint32_t i = 0; i < sizeof(fib) / sizeof(fib[0]); i++) {
+        m = generate(SMLT_TOPO_FIBONACCI, fib[i][0]);
+        if (m) {
+            CHECK(completion_time(m, cores[0], 0, 2) == fib[i][1]);
+            smlt_sparse_model_destroy(m);
+        }
+    }
+}
+
+static void test_cluster(uint32_t num_cores)
+{
+    struct smlt_sparse_model *m = generate(SMLT_TOPO_CLUSTER, num_cores);
+    if (m == NULL) {
+        return;
+    }
+
+    // a core is connected within its cluster, or is the leader of one
+    for (uint32_t i = 1; i < num_cores; i++) {
+        uint32_t p = m->parent[cores[i]];
+        CHECK(p == cores[0] || smlt_platform_cluster_of_core(p) ==
+                               smlt_platform_cluster_of_core(cores[i]));
+    }
+    smlt_sparse_model_destroy(m);
+
+    // the root keeps room for the leaders, the matrix can encode it
+    struct smlt_generated_model *model = NULL;
+    CHECK(smlt_err_is_ok(smlt_generate_builtin_model(SMLT_TOPO_CLUSTER, cores,
+                                                     num_cores, &model)));
+}
+
+static void test_names(void)
+{
+    struct smlt_sparse_model *m = NULL;
+
+    CHECK(smlt_generator_is_builtin(SMLT_TOPO_BINARY));
+    CHECK(smlt_generator_is_builtin("kary-7"));
+    CHECK(smlt_generator_is_builtin("fibonacci"));
+    CHECK(!smlt_generator_is_builtin("adaptivetree"));
+    CHECK(!smlt_generator_is_builtin("kary-x"));
+
+    setenv("SMLT_TOPO", "binomial", 1);
+    CHECK(smlt_generator_is_builtin(NULL));
+    unsetenv("SMLT_TOPO");
+    CHECK(!smlt_generator_is_builtin(NULL));
+
+    CHECK(smlt_err_no(smlt_generate_builtin_sparse_model("adaptivetree", cores,
+                                                         4, &m))
+          == SMLT_ERR_INVAL);
+    CHECK(smlt_err_no(smlt_generate_builtin_sparse_model(SMLT_TOPO_BINARY,
+                                                         cores, 0, &m))
+          == SMLT_ERR_INVAL);
+
+    // cores[0] is the root, in any order
+    coreid_t reversed[3] = { 5, 3, 1 };
+    CHECK(smlt_err_is_ok(smlt_generate_builtin_sparse_model(SMLT_TOPO_BINARY,
+                                                            reversed, 3, &m)));
+    if (m) {
+        CHECK(m->root == 5 && m->parent[3] == 5 && m->parent[1] == 5);
+        CHECK(m->parent[0] == SMLT_MODEL_NO_PARENT);
+        smlt_sparse_model_destroy(m);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t num_threads = (uint32_t) sysconf(_SC_NPROCESSORS_ONLN);
+
+    errval_t err = smlt_init(num_threads, true);
+    if (smlt_err_is_fail(err)) {
+        printf("FAILED TO INITIALIZE !\n");
+        return 1;
+    }
+
+    // every other core, the model is indexed by core id
+    for (uint32_t i = 0; i < MAX_CORES; i++) {
+        cores[i] = 2 * i;
+    }
+
+    test_kary();
+    test_greedy();
+    test_names();
+
+    // the cluster tree needs real cores
+    uint32_t num_cores = num_threads < MAX_CORES ? num_threads : MAX_CORES;
+    for (uint32_t i = 0; i < num_cores; i++) {
+        cores[i] = i;
+    }
+    test_cluster(num_cores);
+
+    if (!num_wrong) {
+        printf("Builtin Topology Test Success\n");
+    } else {
+        printf("Builtin Topology Test Failed \n");
+    }
+
+    return num_wrong ? 1 : 0;
+}
@@ -0,0 +1,200 @@
+/**
+ * \brief Testing the replicated log
+ */
+
+/*
+ * Copyright (c) 2016, ETH Zurich.
+ * All rights reserved.
+ *
+ * This file is distributed under the terms in the attached LICENSE file.
+ * If you do not find this file, copies can be found by writing to:
+ * ETH Zurich D-INFK, Universitaetstr. 6, CH-8092 Zurich. Attn: Systems Group.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <smlt.h>
+#include <smlt_node.h>
+#include <smlt_message.h>
+#include <smlt_barrier.h>
+#include <smlt_topology.h>
+#include <smlt_context.h>
+#include <smlt_consensus.h>
+
+#define MAX_NODES 64
+
+#define NUM_ENTRIES 1000
+
+// batch size and window of the runs
+static const uint32_t configs[][2] = { { 1, 1 }, { 4, 16 }, { 7, 10 } };
+
+#define NUM_CONFIGS (sizeof(configs) / sizeof(configs[0]))
+
+static struct smlt_context *context = NULL;
+
+static uint32_t num_nodes;
+
+/**
+ * what a node applied in a run
+ */
+struct apply_log {
+    uint64_t num;
+    uint64_t num_bad;
+};
+
+static struct apply_log logs[MAX_NODES];
+
+static volatile int num_wrong = 0;
+
+#define CHECK(cond)                                                         \
+    do {                                                                    \
+        if (!(cond)) {                                                      \
+            printf("check failed: %s (line %d)\n", #cond, __LINE__);        \
+            __sync_fetch_and_add(&num_wrong, 1);                            \
+        }                                                                   \
+    } while (0)
+
+/// the commands differ in length and content
+static uint32_t cmd_words(uint64_t idx)
+{
+    return 1 + idx % SMLT_CONSENSUS_PAYLOAD_WORDS;
+}
+
+static smlt_msg_payload_t cmd_word(uint64_t idx, uint32_t word)
+{
+    return idx * 10 + word;
+}
+
+/// entries must be applied once, in log order, with their content
+static void apply(uint64_t idx, struct smlt_msg *cmd, void *arg)
+{
+    struct apply_log *log = (struct apply_log *)arg;
+
+    bool ok = (idx == log->num + 1) && (cmd->words == cmd_words(idx));
+    for (uint32_t w = 0; ok && w < cmd->words; w++) {
+        ok = (cmd->data[w] == cmd_word(idx, w));
+    }
+
+    log->num++;
+    log->num_bad += !ok;
+}
+
+static void run(uint32_t batch_size, uint32_t window, struct smlt_msg *cmd)
+{
+    struct apply_log *log = &logs[smlt_node_get_id()];
+    struct smlt_consensus *cons = NULL;
+    errval_t err;
+
+    log->num = 0;
+    log->num_bad = 0;
+
+    err = smlt_consensus_create(context, batch_size, window, apply, log, &cons);
+    CHECK(smlt_err_is_ok(err));
+    if (smlt_err_is_fail(err)) {
+        return;
+    }
+
+    if (!smlt_context_is_root(context)) {
+        CHECK(smlt_err_no(smlt_consensus_propose(cons, cmd)) == SMLT_ERR_INVAL);
+        CHECK(smlt_err_is_ok(smlt_consensus_run(cons)));
+    } else {
+        CHECK(smlt_err_no(smlt_consensus_run(cons)) == SMLT_ERR_INVAL);
+
+        for (uint64_t idx = 1; idx <= NUM_ENTRIES; idx++) {
+            cmd->words = cmd_words(idx);
+            for (uint32_t w = 0; w < cmd->words; w++) {
+                cmd->data[w] = cmd_word(idx, w);
+            }
+            CHECK(smlt_err_is_ok(smlt_consensus_propose(cons, cmd)));
+
+            // the leader applies everything up to a sync
+            if (idx == NUM_ENTRIES / 2) {
+                CHECK(smlt_err_is_ok(smlt_consensus_sync(cons)));
+                CHECK(smlt_consensus_get_applied(cons) == idx);
+            }
+        }
+
+        cmd->words = SMLT_CONSENSUS_PAYLOAD_WORDS + 1;
+        CHECK(smlt_err_no(smlt_consensus_propose(cons, cmd)) == SMLT_ERR_INVAL);
+
+        CHECK(smlt_err_is_ok(smlt_consensus_shutdown(cons)));
+    }
+
+    // every replica has the whole log
+    CHECK(smlt_consensus_get_applied(cons) == NUM_ENTRIES);
+    CHECK(log->num == NUM_ENTRIES && log->num_bad == 0);
+
+    smlt_consensus_destroy(cons);
+}
+
+static void* thr_worker(void* arg)
+{
+    struct smlt_msg *cmd = smlt_message_alloc(56);
+    struct smlt_consensus *cons = NULL;
+
+    // the batch must fit into the window
+    CHECK(smlt_err_no(smlt_consensus_create(context, 0, 4, apply, NULL, &cons))
+          == SMLT_ERR_INVAL);
+    CHECK(smlt_err_no(smlt_consensus_create(context, 8, 4, apply, NULL, &cons))
+          == SMLT_ERR_INVAL);
+
+    for (uint32_t i = 0; i < NUM_CONFIGS; i++) {
+        run(configs[i][0], configs[i][1], cmd);
+        smlt_barrier_wait(context);
+    }
+
+    smlt_message_free(cmd);
+
+    return NULL;
+}
+
+int main(int argc, char **argv)
+{
+    size_t num_threads = sysconf(_SC_NPROCESSORS_ONLN);
+    errval_t err;
+
+    err = smlt_init(num_threads, true);
+    if (smlt_err_is_fail(err)) {
+        printf("FAILED TO INITIALIZE !\n");
+        return 1;
+    }
+
+    num_nodes = smlt_get_num_proc();
+    if (num_nodes > MAX_NODES) {
+        printf("too many nodes\n");
+        return 1;
+    }
+
+    struct smlt_topology *topo = NULL;
+    smlt_topology_create(NULL, SMLT_TOPO_BINARY, &topo);
+
+    err = smlt_context_create(topo, &context);
+    if (smlt_err_is_fail(err)) {
+        printf("FAILED TO INITIALIZE CONTEXT !\n");
+        return 1;
+    }
+
+    struct smlt_node *node;
+    for (uint64_t i = 0; i < num_nodes; i++) {
+        node = smlt_get_node_by_id(i);
+        err = smlt_node_start(node, thr_worker, (void *)i);
+        if (smlt_err_is_fail(err)) {
+            printf("Starting node failed \n");
+            return 1;
+        }
+    }
+
+    for (uint64_t i = 0; i < num_nodes; i++) {
+        node = smlt_get_node_by_id(i);
+        smlt_node_join(node);
+    }
+
+    if (!num_wrong) {
+        printf("Consensus Test Success\n");
+    } else {
+        printf("Consensus Test Failed \n");
+    }
+
+    return num_wrong ? 1 : 0;
+}
@@ -0,0 +1,218 @@
+/**
+ * \brief Testing the switching between prepared contexts
+ */
+
+/*
+ * Copyright (c) 2016, ETH Zurich.
+ * All rights reserved.
+ *
+ * This file is distributed under the terms in the attached LICENSE file.
+ * If you do not find this file, copies can be found by writing to:
+ * ETH Zurich D-INFK, Universitaetstr. 6, CH-8092 Zurich. Attn: Systems Group.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <smlt.h>
+#include <smlt_node.h>
+#include <smlt_message.h>
+#include <smlt_broadcast.h>
+#include <smlt_topology.h>
+#include <smlt_context.h>
+
+#define MAX_NODES 64
+
+#define NUM_RUNS 60
+
+#define NUM_CONTEXTS 3
+
+// the last node is late for some of the switches
+#define LATE_WORK 100000
+
+static struct smlt_context *contexts[NUM_CONTEXTS];
+static smlt_nid_t roots[NUM_CONTEXTS];
+
+static struct smlt_context_set *set = NULL;
+
+// a set over all nodes but the first one
+static struct smlt_context *partial_ctx = NULL;
+static struct smlt_context_set *partial = NULL;
+
+static uint32_t num_nodes;
+
+static volatile int num_wrong = 0;
+
+#define CHECK(cond)                                                         \
+    do {                                                                    \
+        if (!(cond)) {                                                      \
+            printf("check failed: %s (line %d)\n", #cond, __LINE__);        \
+            __sync_fetch_and_add(&num_wrong, 1);                            \
+        }                                                                   \
+    } while (0)
+
+static void* thr_worker(void* arg)
+{
+    smlt_nid_t nid = smlt_node_get_id();
+    struct smlt_msg *msg = smlt_message_alloc(56);
+
+    CHECK(smlt_context_set_get_active(set) == contexts[0]);
+
+    for (uint32_t i = 0; i < NUM_RUNS; i++) {
+        uint32_t idx = i % NUM_CONTEXTS;
+
+        if (nid == num_nodes - 1 && i % 4 == 0) {
+            for (volatile int j = 0; j < LATE_WORK; j++)
+                ;
+        }
+
+        CHECK(smlt_err_is_ok(smlt_context_switch(set, idx)));
+        struct smlt_context *ctx = smlt_context_set_get_active(set);
+        CHECK(ctx == contexts[idx]);
+
+        // every context has its own root
+        if (smlt_context_is_root(ctx)) {
+            msg->data[0] = nid * NUM_RUNS + i;
+        }
+        smlt_broadcast(ctx, msg);
+        CHECK(msg->data[0] == roots[idx] * NUM_RUNS + i);
+    }
+
+    // switching to the active context or to none at all changes nothing
+    struct smlt_context *active = smlt_context_set_get_active(set);
+    CHECK(smlt_err_is_ok(smlt_context_switch(set, (NUM_RUNS - 1) % NUM_CONTEXTS)));
+    CHECK(smlt_err_no(smlt_context_switch(set, NUM_CONTEXTS)) == SMLT_ERR_INVAL);
+    CHECK(smlt_context_set_get_active(set) == active);
+
+    // nodes outside of the contexts of a set cannot use them
+    if (partial != NULL) {
+        if (nid == 0) {
+            CHECK(smlt_context_set_get_active(partial) == NULL);
+            CHECK(smlt_err_no(smlt_context_switch(partial, 0))
+                  == SMLT_ERR_NODE_INVALD);
+        } else {
+            CHECK(smlt_context_set_get_active(partial) == partial_ctx);
+        }
+    }
+
+    smlt_message_free(msg);
+
+    return NULL;
+}
+
+int main(int argc, char **argv)
+{
+    size_t num_threads = sysconf(_SC_NPROCESSORS_ONLN);
+    coreid_t cores[MAX_NODES];
+    char name[16];
+    errval_t err;
+
+    err = smlt_init(num_threads, true);
+    if (smlt_err_is_fail(err)) {
+        printf("FAILED TO INITIALIZE !\n");
+        return 1;
+    }
+
+    num_nodes = smlt_get_num_proc();
+    if (num_nodes > MAX_NODES) {
+        printf("too many nodes\n");
+        return 1;
+    }
+
+    // a binary tree rooted at the first node
+    struct smlt_topology *topo = NULL;
+    smlt_topology_create(NULL, SMLT_TOPO_BINARY, &topo);
+    err = smlt_context_create(topo, &contexts[0]);
+    roots[0] = 0;
+
+    // a flat tree rooted at the last node
+    for (uint32_t i = 0; i < num_nodes; i++) {
+        cores[i] = smlt_get_core_by_id(num_nodes - 1 - i);
+    }
+    snprintf(name, sizeof(name), "kary-%u", num_nodes);
+    if (smlt_err_is_ok(err)) {
+        err = smlt_context_create_from_cores(cores, num_nodes, name,
+                                             &contexts[1]);
+    }
+    roots[1] = num_nodes - 1;
+
+    // a binomial tree rooted in the middle
+    for (uint32_t i = 0; i < num_nodes; i++) {
+        cores[i] = smlt_get_core_by_id((num_nodes / 2 + i) % num_nodes);
+    }
+    if (smlt_err_is_ok(err)) {
+        err = smlt_context_create_from_cores(cores, num_nodes, SMLT_TOPO_BINOMIAL,
+                                             &contexts[2]);
+    }
+    roots[2] = num_nodes / 2;
+
+    if (smlt_err_is_fail(err)) {
+        printf("FAILED TO INITIALIZE CONTEXT !\n");
+        return 1;
+    }
+
+    // the contexts of a set span the same nodes
+    CHECK(smlt_err_no(smlt_context_set_create(contexts, 0, &set))
+          == SMLT_ERR_INVAL);
+    if (num_nodes > 1) {
+        struct smlt_context *fewer[2] = { contexts[0], NULL };
+        err = smlt_context_create_from_cores(cores, num_nodes - 1,
+                                             SMLT_TOPO_BINARY, &fewer[1]);
+        CHECK(smlt_err_is_ok(err));
+        if (smlt_err_is_ok(err)) {
+            CHECK(smlt_err_no(smlt_context_set_create(fewer, 2, &set))
+                  == SMLT_ERR_INVAL);
+            smlt_context_destroy(fewer[1]);
+        }
+    }
+
+    err = smlt_context_set_create(contexts, NUM_CONTEXTS, &set);
+    if (smlt_err_is_fail(err)) {
+        printf("FAILED TO CREATE THE CONTEXT SET !\n");
+        return 1;
+    }
+
+    if (num_nodes > 1) {
+        for (uint32_t i = 1; i < num_nodes; i++) {
+            cores[i - 1] = smlt_get_core_by_id(i);
+        }
+        err = smlt_context_create_from_cores(cores, num_nodes - 1,
+                                             SMLT_TOPO_BINARY, &partial_ctx);
+        CHECK(smlt_err_is_ok(err));
+        if (smlt_err_is_ok(err)) {
+            err = smlt_context_set_create(&partial_ctx, 1, &partial);
+            CHECK(smlt_err_is_ok(err));
+        }
+    }
+
+    struct smlt_node *node;
+    for (uint64_t i = 0; i < num_nodes; i++) {
+        node = smlt_get_node_by_id(i);
+        err = smlt_node_start(node, thr_worker, (void *)i);
+        if (smlt_err_is_fail(err)) {
+            printf("Starting node failed \n");
+            return 1;
+        }
+    }
+
+    for (uint64_t i = 0; i < num_nodes; i++) {
+        node = smlt_get_node_by_id(i);
+        smlt_node_join(node);
+    }
+
+    smlt_context_set_destroy(set);
+    if (partial != NULL) {
+        smlt_context_set_destroy(partial);
+    }
+    if (partial_ctx != NULL) {
+        smlt_context_destroy(partial_ctx);
+    }
+
+    if (!num_wrong) {
+        printf("Context Switch Test Success\n");
+    } else {
+        printf("Context Switch Test Failed \n");
+    }
+
+    return num_wrong ? 1 : 0;
+}
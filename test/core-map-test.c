@@ -0,0 +1,204 @@
+/**
+ * \brief Testing the mapping between node ids and cores
+ */
+
+/*
+ * Copyright (c) 2016, ETH Zurich.
+ * All rights reserved.
+ *
+ * This file is distributed under the terms in the attached LICENSE file.
+ * If you do not find this file, copies can be found by writing to:
+ * ETH Zurich D-INFK, Universitaetstr. 6, CH-8092 Zurich. Attn: Systems Group.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <smlt.h>
+#include <smlt_node.h>
+#include <smlt_message.h>
+#include <smlt_broadcast.h>
+#include <smlt_topology.h>
+#include <smlt_context.h>
+#include <smlt_generator.h>
+
+#define MAX_NODES 64
+
+#define BCAST_VALUE 0xcafe
+
+static coreid_t cores[MAX_NODES];
+static uint32_t num_nodes;
+
+static struct smlt_context *context = NULL;
+
+// what the nodes saw, indexed by node id
+static coreid_t seen_core[MAX_NODES];
+static uintptr_t seen_bcast[MAX_NODES];
+static uintptr_t seen_sender_core[MAX_NODES];
+
+static int num_wrong = 0;
+
+#define CHECK(cond)                                                         \
+    do {                                                                    \
+        if (!(cond)) {                                                      \
+            printf("check failed: %s (line %d)\n", #cond, __LINE__);        \
+            num_wrong++;                                                    \
+        }                                                                   \
+    } while (0)
+
+static void check_topology(struct smlt_topology *topo)
+{
+    CHECK(smlt_topology_get_num_nodes(topo) == num_nodes);
+    CHECK(smlt_topology_get_root_id(topo) == 0);
+
+    // the nodes carry the id of the node running on their core
+    struct smlt_topology_node *tn = smlt_topology_get_first_node(topo);
+    for (uint32_t i = 0; i < num_nodes; i++) {
+        smlt_nid_t nid = smlt_topology_node_get_id(tn);
+        CHECK(nid < num_nodes);
+        CHECK(smlt_topology_node_get_core(tn) == smlt_get_core_by_id(nid));
+        tn = smlt_topology_node_next(tn);
+    }
+
+    for (smlt_nid_t i = 0; i < num_nodes; i++) {
+        tn = smlt_topology_node_by_id(topo, i);
+        CHECK(tn != NULL && smlt_topology_node_get_id(tn) == i);
+    }
+}
+
+static void* thr_worker(void* arg)
+{
+    smlt_nid_t nid = smlt_node_get_id();
+    struct smlt_msg *msg = smlt_message_alloc(56);
+
+    seen_core[nid] = smlt_node_get_coreid();
+
+    if (smlt_context_is_root(context)) {
+        msg->data[0] = BCAST_VALUE;
+    }
+    smlt_broadcast(context, msg);
+    seen_bcast[nid] = msg->data[0];
+
+    // everyone reports its core to node 0 over the mesh
+    if (nid != 0) {
+        msg->data[0] = smlt_node_get_coreid();
+        smlt_send(0, msg);
+    } else {
+        for (smlt_nid_t i = 1; i < num_nodes; i++) {
+            smlt_recv(i, msg);
+            seen_sender_core[i] = msg->data[0];
+        }
+    }
+
+    smlt_message_free(msg);
+
+    return NULL;
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t num_threads = (uint32_t) sysconf(_SC_NPROCESSORS_ONLN);
+    errval_t err;
+
+    // an identity mapping as long as there is no instance
+    CHECK(smlt_get_core_by_id(3) == 3);
+    CHECK(smlt_get_id_by_core(3) == 3);
+
+    // the cores must exist and be distinct
+    coreid_t missing[1] = { num_threads };
+    CHECK(smlt_err_no(smlt_init_cores(missing, 1, false)) == SMLT_ERR_INVAL);
+    coreid_t twice[2] = { 0, 0 };
+    CHECK(smlt_err_no(smlt_init_cores(twice, 2, false)) == SMLT_ERR_INVAL);
+
+    // a failed initialization leaves no mapping behind
+    CHECK(smlt_get_core_by_id(1) == 1);
+    CHECK(smlt_get_id_by_core(3) == 3);
+
+    // every other core, from the top
+    num_nodes = (num_threads + 1) / 2;
+    if (num_nodes > MAX_NODES) {
+        num_nodes = MAX_NODES;
+    }
+    for (uint32_t i = 0; i < num_nodes; i++) {
+        cores[i] = num_threads - 1 - 2 * i;
+    }
+
+    err = smlt_init_cores(cores, num_nodes, true);
+    if (smlt_err_is_fail(err)) {
+        printf("FAILED TO INITIALIZE !\n");
+        return 1;
+    }
+
+    CHECK(smlt_get_num_proc() == num_nodes);
+    for (smlt_nid_t i = 0; i < num_nodes; i++) {
+        CHECK(smlt_get_core_by_id(i) == cores[i]);
+        CHECK(smlt_get_id_by_core(cores[i]) == i);
+        CHECK(smlt_node_get_coreid_of_node(smlt_get_node_by_id(i)) == cores[i]);
+    }
+    if (num_threads > 1) {
+        CHECK(smlt_get_id_by_core(num_threads - 2) == SMLT_NID_INVALID);
+    }
+    CHECK(smlt_get_id_by_core(num_threads + 10) == SMLT_NID_INVALID);
+
+    // a topology over all nodes
+    struct smlt_topology *topo = NULL;
+    err = smlt_topology_create(NULL, SMLT_TOPO_BINARY, &topo);
+    CHECK(smlt_err_is_ok(err));
+    if (smlt_err_is_fail(err)) {
+        return 1;
+    }
+    check_topology(topo);
+
+    // a model over the cores, the topology nodes are ordered by core
+    struct smlt_sparse_model *sparse = NULL;
+    struct smlt_topology *from_model = NULL;
+    err = smlt_generate_builtin_sparse_model(SMLT_TOPO_BINARY, cores,
+                                             num_nodes, &sparse);
+    CHECK(smlt_err_is_ok(err));
+    if (smlt_err_is_ok(err)) {
+        err = smlt_topology_create_sparse(sparse, "cores", &from_model);
+        CHECK(smlt_err_is_ok(err));
+        if (smlt_err_is_ok(err)) {
+            check_topology(from_model);
+            smlt_topology_destroy(from_model);
+        }
+        smlt_sparse_model_destroy(sparse);
+    }
+
+    err = smlt_context_create(topo, &context);
+    if (smlt_err_is_fail(err)) {
+        printf("FAILED TO INITIALIZE CONTEXT !\n");
+        return 1;
+    }
+
+    struct smlt_node *node;
+    for (uint64_t i = 0; i < num_nodes; i++) {
+        node = smlt_get_node_by_id(i);
+        err = smlt_node_start(node, thr_worker, (void *)i);
+        if (smlt_err_is_fail(err)) {
+            printf("Starting node failed \n");
+            return 1;
+        }
+    }
+
+    for (uint64_t i = 0; i < num_nodes; i++) {
+        node = smlt_get_node_by_id(i);
+        smlt_node_join(node);
+    }
+
+    for (smlt_nid_t i = 0; i < num_nodes; i++) {
+        CHECK(seen_core[i] == cores[i]);
+        CHECK(seen_bcast[i] == BCAST_VALUE);
+        if (i != 0) {
+            CHECK(seen_sender_core[i] == cores[i]);
+        }
+    }
+
+    if (!num_wrong) {
+        printf("Core Map Test Success\n");
+    } else {
+        printf("Core Map Test Failed \n");
+    }
+
+    return num_wrong ? 1 : 0;
+}
@@ -0,0 +1,301 @@
+/**
+ * \brief Testing the C++ queues and channels
+ */
+
+/*
+ * Copyright (c) 2016, ETH Zurich.
+ * All rights reserved.
+ *
+ * This file is distributed under the terms in the attached LICENSE file.
+ * If you do not find this file, copies can be found by writing to:
+ * ETH Zurich D-INFK, Universitaetstr. 6, CH-8092 Zurich. Attn: Systems Group.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <smlt_queue.hpp>
+#include <smlt_channel.hpp>
+
+extern "C" {
+#include <smlt_message.h>
+}
+
+#define NUM_RUNS 1000
+
+/// checks that the payload of the i-th message matches
+template <uint32_t Words>
+static bool check(const smlt::word_t *data, uint64_t i)
+{
+    for (uint32_t j = 0; j < Words; j++) {
+        if (data[j] != i + j) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/// fills the payload of the i-th message
+template <uint32_t Words>
+static void fill(smlt::word_t *data, uint64_t i)
+{
+    for (uint32_t j = 0; j < Words; j++) {
+        data[j] = i + j;
+    }
+}
+
+/**
+ * sends messages from one end of a queuepair to the other, with the C++
+ * queues on both ends and mixed with the C functions
+ */
+template <typename Backend, uint32_t Words>
+static int test_queue(smlt_qp_type_t type, const char *name)
+{
+    struct smlt_qp *qp1;
+    struct smlt_qp *qp2;
+    int num_wrong = 0;
+
+    errval_t err = smlt_queuepair_create(type, &qp1, &qp2, 0, 0);
+    if (smlt_err_is_fail(err)) {
+        printf("%s: FAILED TO CREATE QUEUEPAIR\n", name);
+        return 1;
+    }
+
+    smlt::Queue<Backend, Backend::default_slots, Words> tx(qp1);
+    smlt::Queue<Backend, Backend::default_slots, Words> rx(qp2);
+    if (!tx.valid() || !rx.valid()) {
+        num_wrong++;
+    }
+
+    /* the number of slots has to match */
+    smlt::Queue<Backend, Backend::default_slots + 1, 1> wrong;
+    if (wrong.attach(qp1) != SMLT_ERR_INVAL) {
+        num_wrong++;
+    }
+
+    struct smlt_msg *msg = smlt_message_alloc(Words * sizeof(smlt::word_t));
+    smlt::word_t data[Words];
+
+    for (uint64_t i = 0; i < NUM_RUNS; i++) {
+        /* C++ to C++ */
+        fill<Words>(data, i);
+        tx.send(data);
+        tx.notify();
+        rx.recv(data);
+        if (!check<Words>(data, i)) {
+            num_wrong++;
+        }
+        rx.recv_notification();
+
+        /* C to C++ */
+        fill<Words>(msg->data, i);
+        msg->words = Words;
+        smlt_queuepair_send(qp1, msg);
+        rx.recv(data);
+        if (!check<Words>(data, i)) {
+            num_wrong++;
+        }
+
+        /* C++ to C */
+        fill<Words>(data, i + 1);
+        tx.send(data);
+        msg->words = Words;
+        smlt_queuepair_recv(qp2, msg);
+        if (!check<Words>(msg->data, i + 1)) {
+            num_wrong++;
+        }
+    }
+
+    /*
+     * fill the queue, then drain it. A SHM message spanning several slots
+     * waits for the slots after the first one.
+     */
+    uint64_t sent = 0;
+    bool exact = (type != SMLT_QP_TYPE_SHM || Words <= SWMR_PAYLOAD_WORDS);
+    while (exact && tx.try_send(data) == SMLT_SUCCESS) {
+        sent++;
+    }
+    while (rx.try_recv(data) == SMLT_SUCCESS) {
+        sent--;
+    }
+    if (sent != 0 || tx.can_send() == false) {
+        num_wrong++;
+    }
+
+    smlt_message_free(msg);
+
+    if (!num_wrong) {
+        printf("%s Queue<%u> Test Success \n", name, Words);
+    } else {
+        printf("%s Queue<%u> Test Failed \n", name, Words);
+    }
+    return num_wrong;
+}
+
+/// a payload that does not fill its last word
+struct Odd
+{
+    uint8_t bytes[13];
+};
+
+/// a payload spanning several slots
+struct Big
+{
+    uint64_t words[20];
+};
+
+/// a payload without a default constructor
+struct Tagged
+{
+    explicit Tagged(uint64_t t) : tag(t), value(~t) {}
+    uint64_t tag;
+    uint64_t value;
+};
+
+/// fills an object with the pattern of the i-th message, includes all ones
+template <typename T>
+static void fill_obj(T &obj, uint64_t i)
+{
+    uint8_t *bytes = (uint8_t *)&obj;
+    for (size_t k = 0; k < sizeof(T); k++) {
+        bytes[k] = (i % 3 == 0 && k < 8) ? 0xff : (uint8_t)(i * 7 + k);
+    }
+}
+
+/**
+ * sends objects of type T with smlt::send() and smlt::recv()
+ */
+template <typename Backend, typename T>
+static int test_typed(smlt_qp_type_t type, const char *name)
+{
+    struct smlt_qp *qp1;
+    struct smlt_qp *qp2;
+    int num_wrong = 0;
+
+    errval_t err = smlt_queuepair_create(type, &qp1, &qp2, 0, 0);
+    if (smlt_err_is_fail(err)) {
+        printf("%s: FAILED TO CREATE QUEUEPAIR\n", name);
+        return 1;
+    }
+
+    smlt::Queue<Backend> tx(qp1);
+    smlt::Queue<Backend> rx(qp2);
+
+    T s;
+    T r;
+    for (uint64_t i = 0; i < NUM_RUNS; i++) {
+        fill_obj(s, i);
+        smlt::send(tx, s);
+        err = smlt::recv(rx, r);
+        if (smlt_err_is_fail(err) || memcmp(&s, &r, sizeof(T)) != 0) {
+            num_wrong++;
+        }
+    }
+
+    /* fill the queue, then drain it, see test_queue() */
+    uint64_t sent = 0;
+    bool exact = (type != SMLT_QP_TYPE_SHM || sizeof(T) <= sizeof(smlt::word_t)
+                                                * SWMR_PAYLOAD_WORDS);
+    while (exact && smlt::try_send(tx, s) == SMLT_SUCCESS) {
+        sent++;
+    }
+    while (smlt::try_recv(rx, r) == SMLT_SUCCESS) {
+        sent--;
+    }
+    if (sent != 0) {
+        num_wrong++;
+    }
+
+    /* without a default constructor */
+    for (uint64_t i = 0; i < NUM_RUNS; i++) {
+        smlt::send(tx, Tagged(i));
+        Tagged t = smlt::recv<Tagged>(rx);
+        if (t.tag != i || t.value != ~i) {
+            num_wrong++;
+        }
+    }
+
+    if (!num_wrong) {
+        printf("%s send<%zu bytes> Test Success \n", name, sizeof(T));
+    } else {
+        printf("%s send<%zu bytes> Test Failed \n", name, sizeof(T));
+    }
+    return num_wrong;
+}
+
+/// sends messages on a 1:1 channel to node 0 itself
+static int test_channel(void)
+{
+    struct smlt_channel chan;
+    struct smlt_channel *chanp = &chan;
+    uint32_t node = 0;
+    int num_wrong = 0;
+
+    errval_t err = smlt_channel_create(&chanp, &node, &node, 1, 1);
+    if (smlt_err_is_fail(err)) {
+        printf("FAILED TO CREATE CHANNEL\n");
+        return 1;
+    }
+
+    smlt::Channel<smlt::UMP, 1>::Owner owner;
+    smlt::Channel<smlt::UMP, 1>::Member member;
+    smlt::Channel<smlt::UMP, 4>::Owner wrong;
+
+    if (smlt_err_is_fail(owner.attach(&chan, 0)) ||
+        smlt_err_is_fail(member.attach(&chan, 0)) ||
+        wrong.attach(&chan, 0) != SMLT_ERR_INVAL) {
+        num_wrong++;
+    }
+
+    smlt::word_t data[SMLT_UMP_PAYLOAD_WORDS];
+    for (uint64_t i = 0; i < NUM_RUNS; i++) {
+        fill<SMLT_UMP_PAYLOAD_WORDS>(data, i);
+        owner.send(data);
+        member.recv(data);
+        if (!check<SMLT_UMP_PAYLOAD_WORDS>(data, i)) {
+            num_wrong++;
+        }
+        member.notify();
+        owner.recv_notification();
+
+        /* typed messages in both directions */
+        smlt::send(owner, Tagged(i));
+        Tagged t = smlt::recv<Tagged>(member);
+        smlt::send(member, Tagged(t.tag + 1));
+        if (t.tag != i || smlt::recv<Tagged>(owner).tag != i + 1) {
+            num_wrong++;
+        }
+    }
+
+    if (!num_wrong) {
+        printf("Channel Test Success \n");
+    } else {
+        printf("Channel Test Failed \n");
+    }
+    return num_wrong;
+}
+
+int main(int argc, char **argv)
+{
+    int num_wrong = 0;
+
+    errval_t err = smlt_init(1, true);
+    if (smlt_err_is_fail(err)) {
+        printf("FAILED TO INITIALIZE !\n");
+        return 1;
+    }
+
+    num_wrong += test_queue<smlt::UMP, 1>(SMLT_QP_TYPE_UMP, "UMP");
+    num_wrong += test_queue<smlt::UMP, 7>(SMLT_QP_TYPE_UMP, "UMP");
+    num_wrong += test_queue<smlt::FFQ, 1>(SMLT_QP_TYPE_FFQ, "FFQ");
+    num_wrong += test_queue<smlt::FFQ, 30>(SMLT_QP_TYPE_FFQ, "FFQ");
+    num_wrong += test_queue<smlt::SHM, 7>(SMLT_QP_TYPE_SHM, "SHM");
+    num_wrong += test_queue<smlt::SHM, 20>(SMLT_QP_TYPE_SHM, "SHM");
+    num_wrong += test_typed<smlt::UMP, Odd>(SMLT_QP_TYPE_UMP, "UMP");
+    num_wrong += test_typed<smlt::FFQ, Odd>(SMLT_QP_TYPE_FFQ, "FFQ");
+    num_wrong += test_typed<smlt::FFQ, Big>(SMLT_QP_TYPE_FFQ, "FFQ");
+    num_wrong += test_typed<smlt::SHM, Odd>(SMLT_QP_TYPE_SHM, "SHM");
+    num_wrong += test_typed<smlt::SHM, Big>(SMLT_QP_TYPE_SHM, "SHM");
+    num_wrong += test_channel();
+
+    return num_wrong ? 1 : 0;
+}
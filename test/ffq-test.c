@@ -0,0 +1,265 @@
+/**
+ * \brief Testing the FastForward queue
+ */
+
+/*
+ * Copyright (c) 2016, ETH Zurich.
+ * All rights reserved.
+ *
+ * This file is distributed under the terms in the attached LICENSE file.
+ * If you do not find this file, copies can be found by writing to:
+ * ETH Zurich D-INFK, Universitaetstr. 6, CH-8092 Zurich. Attn: Systems Group.
+ */
+
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <sched.h>
+#include <smlt.h>
+#include <smlt_message.h>
+#include <smlt_queuepair.h>
+#include <ffq/smlt_ffq_queue.h>
+
+#define NUM_SLOTS 64
+#define NUM_MSGS 200000
+
+// lengths of the messages cycle through 0..MAX_WORDS
+#define MAX_WORDS 100
+
+static struct smlt_ffq_queue tx;
+static struct smlt_ffq_queue rx;
+
+/// length of the i-th message
+static uint32_t msg_words(uint64_t i)
+{
+    return (i * 13) % (MAX_WORDS + 1);
+}
+
+/// the j-th word of the i-th message, includes all ones words
+static smlt_ffq_payload_t msg_word(uint64_t i, uint32_t j)
+{
+    return (j == 0 && i % 3 == 0) ? (smlt_ffq_payload_t)-1 : i + j;
+}
+
+/// receives the i-th message and checks it
+static bool recv_check(uint64_t i)
+{
+    smlt_ffq_payload_t r[MAX_WORDS];
+    uint32_t words;
+
+    errval_t err = smlt_ffq_queue_recv_raw(&rx, r, MAX_WORDS, &words);
+    if (smlt_err_is_fail(err) || words != msg_words(i)) {
+        return false;
+    }
+
+    for (uint32_t j = 0; j < words; j++) {
+        if (r[j] != msg_word(i, j)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/// sends the i-th message
+static errval_t send_msg(uint64_t i)
+{
+    smlt_ffq_payload_t s[MAX_WORDS];
+
+    for (uint32_t j = 0; j < msg_words(i); j++) {
+        s[j] = msg_word(i, j);
+    }
+    return smlt_ffq_queue_send_raw(&tx, s, msg_words(i));
+}
+
+/// checks full and empty queues and the limits within a single thread
+static int test_single(void)
+{
+    int num_wrong = 0;
+    uint64_t sent = 0;
+    uint64_t received = 0;
+
+    if (smlt_ffq_queue_recv_raw(&rx, NULL, 0, NULL) != SMLT_ERR_QUEUE_EMPTY) {
+        num_wrong++;
+    }
+
+    // a message that can never fit into the queue
+    smlt_ffq_payload_t big[NUM_SLOTS * SMLT_FFQ_SLOT_WORDS];
+    if (smlt_ffq_queue_send_raw(&tx, big, NUM_SLOTS * SMLT_FFQ_SLOT_WORDS)
+            != SMLT_ERR_INVAL) {
+        num_wrong++;
+    }
+
+    // fill the queue, then drain it
+    while (send_msg(sent) == SMLT_SUCCESS) {
+        sent++;
+    }
+    if (sent == 0) {
+        num_wrong++;
+    }
+    while (received < sent) {
+        if (!recv_check(received++)) {
+            num_wrong++;
+        }
+    }
+    if (smlt_ffq_queue_can_recv(&rx)) {
+        num_wrong++;
+    }
+
+    // keep the queue partially filled while wrapping around several times
+    for (uint64_t i = 0; i < 10 * NUM_SLOTS; i++) {
+        while (send_msg(sent) == SMLT_ERR_QUEUE_FULL) {
+            if (!recv_check(received++)) {
+                num_wrong++;
+            }
+        }
+        sent++;
+    }
+    while (received < sent) {
+        if (!recv_check(received++)) {
+            num_wrong++;
+        }
+    }
+
+    // a truncated message is consumed
+    smlt_ffq_payload_t s[2 * SMLT_FFQ_SLOT_WORDS] = { 0 };
+    smlt_ffq_payload_t r[SMLT_FFQ_SLOT_WORDS];
+    uint32_t words;
+    smlt_ffq_queue_send_raw(&tx, s, 2 * SMLT_FFQ_SLOT_WORDS);
+    smlt_ffq_queue_notify(&tx);
+    if (smlt_ffq_queue_recv_raw(&rx, r, SMLT_FFQ_SLOT_WORDS, &words)
+            != SMLT_ERR_INVAL || words != 2 * SMLT_FFQ_SLOT_WORDS) {
+        num_wrong++;
+    }
+    if (smlt_ffq_queue_recv_raw(&rx, r, SMLT_FFQ_SLOT_WORDS, &words)
+            != SMLT_SUCCESS || words != 0) {
+        num_wrong++;
+    }
+
+    return num_wrong;
+}
+
+/// the receiver learns the length of every message
+static int test_queuepair(void)
+{
+    struct smlt_qp *qp1, *qp2;
+    int num_wrong = 0;
+
+    if (smlt_err_is_fail(smlt_queuepair_create(SMLT_QP_TYPE_FFQ, &qp1, &qp2,
+                                               0, 0))) {
+        return 1;
+    }
+
+    struct smlt_msg *s = smlt_message_alloc(MAX_WORDS * sizeof(smlt_msg_payload_t));
+    struct smlt_msg *r = smlt_message_alloc(MAX_WORDS * sizeof(smlt_msg_payload_t));
+
+    // single slot, several slots, empty
+    uint32_t lengths[] = { 1, SMLT_FFQ_SLOT_WORDS, SMLT_FFQ_SLOT_WORDS + 1,
+                           MAX_WORDS, 0 };
+    for (uint32_t k = 0; k < sizeof(lengths) / sizeof(lengths[0]); k++) {
+        s->words = lengths[k];
+        for (uint32_t j = 0; j < s->words; j++) {
+            s->data[j] = msg_word(k, j);
+        }
+        smlt_queuepair_send(qp1, s);
+
+        r->words = MAX_WORDS;
+        if (smlt_err_is_fail(smlt_queuepair_recv(qp2, r)) ||
+            r->words != lengths[k] ||
+            memcmp(r->data, s->data, lengths[k] * sizeof(smlt_msg_payload_t)) != 0) {
+            num_wrong++;
+        }
+    }
+
+    // the length is capped at the capacity of the message
+    s->words = 3;
+    smlt_queuepair_send(qp1, s);
+    r->words = 2;
+    if (smlt_queuepair_recv(qp2, r) != SMLT_ERR_INVAL || r->words != 2) {
+        num_wrong++;
+    }
+
+    smlt_message_free(s);
+    smlt_message_free(r);
+    smlt_queuepair_destroy(qp1);
+    smlt_queuepair_destroy(qp2);
+
+    return num_wrong;
+}
+
+/// streams messages of all lengths to the reader
+void* thr_writer(void* arg)
+{
+    for (uint64_t i = 0; i < NUM_MSGS; i++) {
+        while (send_msg(i) != SMLT_SUCCESS) {
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+
+void* thr_reader(void* arg)
+{
+    int num_wrong = 0;
+
+    for (uint64_t i = 0; i < NUM_MSGS; i++) {
+        while (!smlt_ffq_queue_can_recv(&rx)) {
+            sched_yield();
+        }
+        if (!recv_check(i)) {
+            num_wrong++;
+        }
+    }
+
+    if (!num_wrong) {
+       printf("Reader Test Success \n");
+    } else {
+       printf("Reader Test Failed \n");
+    }
+    return NULL;
+}
+
+static void init_queue(void *buf)
+{
+    memset(buf, 0, SMLT_FFQ_QUEUE_BYTES(NUM_SLOTS));
+    smlt_ffq_queue_init_tx(&tx, buf, NUM_SLOTS);
+    smlt_ffq_queue_init_rx(&rx, buf, NUM_SLOTS);
+}
+
+int main(int argc, char ** argv)
+{
+    void *buf = NULL;
+    if (posix_memalign(&buf, SMLT_ARCH_CACHELINE_SIZE,
+                       SMLT_FFQ_QUEUE_BYTES(NUM_SLOTS))) {
+        printf("FAILED TO INITIALIZE !\n");
+        return 1;
+    }
+
+    init_queue(buf);
+    if (!test_single()) {
+       printf("Single Test Success \n");
+    } else {
+       printf("Single Test Failed \n");
+    }
+
+    if (!test_queuepair()) {
+       printf("Queuepair Test Success \n");
+    } else {
+       printf("Queuepair Test Failed \n");
+    }
+
+    init_queue(buf);
+
+    pthread_t tids[2];
+    pthread_create(&tids[0], NULL, thr_writer, NULL);
+    pthread_create(&tids[1], NULL, thr_reader, NULL);
+
+    pthread_join(tids[0], NULL);
+    pthread_join(tids[1], NULL);
+
+    free(buf);
+
+    return 0;
+}
@@ -109,6 +109,8 @@ int main(int argc, char **argv)
         smlt_node_join(node);
     }
 
+    smlt_context_destroy(context);
+
     printf("Creating hybrid tree \n");
 
     struct smlt_generated_model *m = NULL;
@@ -139,5 +141,7 @@ int main(int argc, char **argv)
         smlt_node_join(node);
     }
 
+    smlt_context_destroy(context);
+
     return 0;
 }
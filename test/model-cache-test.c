@@ -0,0 +1,272 @@
+/**
+ * \brief Testing the model cache
+ */
+
+/*
+ * Copyright (c) 2016, ETH Zurich.
+ * All rights reserved.
+ *
+ * This file is distributed under the terms in the attached LICENSE file.
+ * If you do not find this file, copies can be found by writing to:
+ * ETH Zurich D-INFK, Universitaetstr. 6, CH-8092 Zurich. Attn: Systems Group.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <smlt.h>
+#include <smlt_generator.h>
+#include <smlt_topology.h>
+#include <smlt_context.h>
+
+#define NUM_CORES 5
+
+#define MAX_NODES 64
+
+// offsets of the column length and the number of leafs in the file header
+#define HDR_LEN_OFFSET       148
+#define HDR_NUM_LEAFS_OFFSET 156
+
+// a topology the Simulator would have to generate
+#define TOPO_NAME "cachedtree"
+
+static coreid_t cores[NUM_CORES] = { 0, 2, 4, 6, 8 };
+
+static int num_wrong = 0;
+
+#define CHECK(cond)                                                         \
+    do {                                                                    \
+        if (!(cond)) {                                                      \
+            printf("check failed: %s (line %d)\n", #cond, __LINE__);        \
+            num_wrong++;                                                    \
+        }                                                                   \
+    } while (0)
+
+static bool same_model(struct smlt_generated_model *a,
+                       struct smlt_generated_model *b)
+{
+    return a->ncores == b->ncores && a->len == b->len && a->root == b->root &&
+           a->num_leafs == b->num_leafs &&
+           memcmp(a->leafs, b->leafs, a->num_leafs * sizeof(uint32_t)) == 0 &&
+           memcmp(a->model, b->model,
+                  (size_t)a->len * a->len * sizeof(uint16_t)) == 0;
+}
+
+static bool same_sparse_model(struct smlt_sparse_model *a,
+                              struct smlt_sparse_model *b)
+{
+    return a->len == b->len && a->root == b->root &&
+           a->num_leafs == b->num_leafs &&
+           memcmp(a->parent, b->parent, a->len * sizeof(uint32_t)) == 0 &&
+           memcmp(a->leafs, b->leafs, a->num_leafs * sizeof(uint32_t)) == 0;
+}
+
+static bool is_cached(coreid_t *c, uint32_t len, const char *name)
+{
+    struct smlt_generated_model *model = NULL;
+    return smlt_err_is_ok(smlt_model_cache_lookup(c, len, name, &model));
+}
+
+/// calls fn on every file of the cache directory
+static void for_each_file(const char *dir, void (*fn)(const char *path))
+{
+    char path[512];
+    struct dirent *e;
+
+    DIR *d = opendir(dir);
+    while ((e = readdir(d)) != NULL) {
+        if (e->d_name[0] == '.') {
+            continue;
+        }
+        snprintf(path, sizeof(path), "%s/%s", dir, e->d_name);
+        fn(path);
+    }
+    closedir(d);
+}
+
+static void truncate_file(const char *path)
+{
+    CHECK(truncate(path, 16) == 0);
+}
+
+/// adds a value to a header field, the size of the file stays the same
+static void patch_field(const char *path, off_t offset, uint32_t delta)
+{
+    uint32_t val;
+    int fd = open(path, O_RDWR);
+    CHECK(fd >= 0);
+    if (fd < 0) {
+        return;
+    }
+    CHECK(pread(fd, &val, sizeof(val), offset) == sizeof(val));
+    val += delta;
+    CHECK(pwrite(fd, &val, sizeof(val), offset) == sizeof(val));
+    close(fd);
+}
+
+// sizes that wrap around to the size of the file in 32-bit arithmetic
+static void widen_len(const char *path)
+{
+    patch_field(path, HDR_LEN_OFFSET, 1U << 31);
+}
+
+static void restore_len(const char *path)
+{
+    patch_field(path, HDR_LEN_OFFSET, 1U << 31);
+}
+
+static void widen_num_leafs(const char *path)
+{
+    patch_field(path, HDR_NUM_LEAFS_OFFSET, 1U << 30);
+}
+
+static void restore_num_leafs(const char *path)
+{
+    patch_field(path, HDR_NUM_LEAFS_OFFSET, 3U << 30);
+}
+
+static void remove_file(const char *path)
+{
+    unlink(path);
+}
+
+int main(int argc, char **argv)
+{
+    size_t num_threads = sysconf(_SC_NPROCESSORS_ONLN);
+    struct smlt_generated_model *model = NULL, *cached = NULL;
+    char dir[64];
+    errval_t err;
+
+    err = smlt_init(num_threads, true);
+    if (smlt_err_is_fail(err)) {
+        printf("FAILED TO INITIALIZE !\n");
+        return 1;
+    }
+
+    snprintf(dir, sizeof(dir), "/tmp/smlt-model-cache-test-%d", getpid());
+    mkdir(dir, 0700);
+    setenv("SMLT_MODEL_CACHE_DIR", dir, 1);
+    setenv("SMLT_MACHINE", "box", 1);
+    unsetenv("SMLT_MODEL_CACHE");
+
+    err = smlt_generate_builtin_model(SMLT_TOPO_BINARY, cores, NUM_CORES,
+                                      &model);
+    if (smlt_err_is_fail(err)) {
+        printf("FAILED TO GENERATE THE MODEL !\n");
+        return 1;
+    }
+
+    CHECK(!is_cached(cores, NUM_CORES, TOPO_NAME));
+    CHECK(smlt_err_is_ok(smlt_model_cache_store(model, cores, NUM_CORES,
+                                                TOPO_NAME)));
+
+    // the stored model reads back the same
+    err = smlt_model_cache_lookup(cores, NUM_CORES, TOPO_NAME, &cached);
+    CHECK(smlt_err_is_ok(err));
+    if (smlt_err_is_ok(err)) {
+        CHECK(same_model(model, cached));
+    }
+
+    // the generator takes it from the cache instead of the Simulator
+    cached = NULL;
+    err = smlt_generate_model(cores, NUM_CORES, TOPO_NAME, &cached);
+    CHECK(smlt_err_is_ok(err));
+    if (smlt_err_is_ok(err)) {
+        CHECK(same_model(model, cached));
+    }
+
+    // cached models are released like generated ones
+    struct smlt_sparse_model *expected = NULL;
+    CHECK(smlt_err_is_ok(smlt_sparse_model_from_dense(model, &expected)));
+    for (int i = 0; expected && i < 3; i++) {
+        struct smlt_sparse_model *sparse = NULL;
+        err = smlt_generate_sparse_model(cores, NUM_CORES, TOPO_NAME, &sparse);
+        CHECK(smlt_err_is_ok(err));
+        if (smlt_err_is_ok(err)) {
+            CHECK(same_sparse_model(sparse, expected));
+            smlt_sparse_model_destroy(sparse);
+        }
+    }
+    if (expected) {
+        smlt_sparse_model_destroy(expected);
+    }
+
+    // a context over the nodes of this machine from a cached topology
+    coreid_t node_cores[MAX_NODES];
+    uint32_t num_nodes = smlt_get_num_proc();
+    num_nodes = num_nodes < MAX_NODES ? num_nodes : MAX_NODES;
+    for (uint32_t i = 0; i < num_nodes; i++) {
+        node_cores[i] = smlt_get_core_by_id(i);
+    }
+
+    struct smlt_generated_model *node_model = NULL;
+    err = smlt_generate_builtin_model(SMLT_TOPO_BINARY, node_cores, num_nodes,
+                                      &node_model);
+    CHECK(smlt_err_is_ok(err));
+    if (smlt_err_is_ok(err)) {
+        CHECK(smlt_err_is_ok(smlt_model_cache_store(node_model, node_cores,
+                                                    num_nodes, TOPO_NAME)));
+        CHECK(is_cached(node_cores, num_nodes, TOPO_NAME));
+
+        for (int i = 0; i < 3; i++) {
+            struct smlt_context *ctx = NULL;
+            err = smlt_context_create_from_cores(node_cores, num_nodes,
+                                                 TOPO_NAME, &ctx);
+            CHECK(smlt_err_is_ok(err));
+            if (smlt_err_is_ok(err)) {
+                CHECK(smlt_context_get_num_nodes(ctx) == num_nodes);
+                smlt_context_destroy(ctx);
+            }
+        }
+    }
+
+    // the key covers the topology, the cores and their order, the machine
+    coreid_t fewer[NUM_CORES - 1] = { 0, 2, 4, 6 };
+    coreid_t reordered[NUM_CORES] = { 2, 0, 4, 6, 8 };
+    CHECK(!is_cached(cores, NUM_CORES, "othertree"));
+    CHECK(!is_cached(fewer, NUM_CORES - 1, TOPO_NAME));
+    CHECK(!is_cached(reordered, NUM_CORES, TOPO_NAME));
+    setenv("SMLT_MACHINE", "otherbox", 1);
+    CHECK(!is_cached(cores, NUM_CORES, TOPO_NAME));
+    setenv("SMLT_MACHINE", "box", 1);
+
+    // a missing name is resolved through SMLT_TOPO
+    setenv("SMLT_TOPO", TOPO_NAME, 1);
+    CHECK(is_cached(cores, NUM_CORES, NULL));
+    unsetenv("SMLT_TOPO");
+
+    // the cache can be switched off
+    setenv("SMLT_MODEL_CACHE", "0", 1);
+    CHECK(!is_cached(cores, NUM_CORES, TOPO_NAME));
+    unsetenv("SMLT_MODEL_CACHE");
+    CHECK(is_cached(cores, NUM_CORES, TOPO_NAME));
+
+    // a header whose sizes do not fit the cores is not trusted
+    for_each_file(dir, widen_len);
+    CHECK(!is_cached(cores, NUM_CORES, TOPO_NAME));
+    for_each_file(dir, restore_len);
+    CHECK(is_cached(cores, NUM_CORES, TOPO_NAME));
+    for_each_file(dir, widen_num_leafs);
+    CHECK(!is_cached(cores, NUM_CORES, TOPO_NAME));
+    for_each_file(dir, restore_num_leafs);
+    CHECK(is_cached(cores, NUM_CORES, TOPO_NAME));
+
+    // a damaged file is not used
+    for_each_file(dir, truncate_file);
+    CHECK(!is_cached(cores, NUM_CORES, TOPO_NAME));
+
+    for_each_file(dir, remove_file);
+    rmdir(dir);
+
+    if (!num_wrong) {
+        printf("Model Cache Test Success\n");
+    } else {
+        printf("Model Cache Test Failed \n");
+    }
+
+    return num_wrong ? 1 : 0;
+}
@@ -0,0 +1,127 @@
+/**
+ * \brief Testing the node pool
+ */
+
+/*
+ * Copyright (c) 2016, ETH Zurich.
+ * All rights reserved.
+ *
+ * This file is distributed under the terms in the attached LICENSE file.
+ * If you do not find this file, copies can be found by writing to:
+ * ETH Zurich D-INFK, Universitaetstr. 6, CH-8092 Zurich. Attn: Systems Group.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <time.h>
+#include <smlt.h>
+#include <smlt_node.h>
+#include <smlt_topology.h>
+#include <smlt_context.h>
+#include <smlt_barrier.h>
+#include <smlt_pool.h>
+
+#define NUM_RUNS 100
+
+static struct smlt_context *context = NULL;
+
+// the last region each node ran, counting from one
+static uint64_t *regions = NULL;
+
+// the number of nodes that ran the current region
+static volatile uint32_t num_ran = 0;
+
+static void *region(void *arg)
+{
+    uint64_t run = (uint64_t)arg;
+
+    __sync_fetch_and_add(&num_ran, 1);
+    regions[smlt_node_get_id()] = run + 1;
+
+    // collectives of the context can be used in a region
+    smlt_barrier_wait(context);
+
+    return NULL;
+}
+
+static double now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+int main(int argc, char **argv)
+{
+    size_t num_threads = sysconf(_SC_NPROCESSORS_ONLN);
+    int num_wrong = 0;
+
+    errval_t err = smlt_init(num_threads, true);
+    if (smlt_err_is_fail(err)) {
+        printf("FAILED TO INITIALIZE !\n");
+        return 1;
+    }
+
+    struct smlt_topology *topo = NULL;
+    smlt_topology_create(NULL, "binary_tree", &topo);
+
+    err = smlt_context_create(topo, &context);
+    if (smlt_err_is_fail(err)) {
+        printf("FAILED TO INITIALIZE CONTEXT !\n");
+        return 1;
+    }
+
+    regions = calloc(num_threads, sizeof(*regions));
+
+    struct smlt_pool *pool;
+    err = smlt_pool_create(context, &pool);
+    if (smlt_err_is_fail(err)) {
+        printf("FAILED TO CREATE THE POOL !\n");
+        return 1;
+    }
+
+    double start = now_us();
+    for (uint64_t i = 0; i < NUM_RUNS; i++) {
+        num_ran = 0;
+        err = smlt_pool_run(pool, region, (void *)i);
+        if (smlt_err_is_fail(err) || num_ran != num_threads) {
+            num_wrong++;
+        }
+        for (size_t n = 0; n < num_threads; n++) {
+            if (regions[n] != i + 1) {
+                num_wrong++;
+            }
+        }
+    }
+    double pool_us = (now_us() - start) / NUM_RUNS;
+
+    if (smlt_pool_run(pool, NULL, NULL) != SMLT_ERR_INVAL) {
+        num_wrong++;
+    }
+
+    smlt_pool_free(pool);
+
+    // the same regions with a thread per node and region
+    start = now_us();
+    for (uint64_t i = 0; i < NUM_RUNS; i++) {
+        for (size_t n = 0; n < num_threads; n++) {
+            smlt_node_start(smlt_get_node_by_id(n), region, (void *)i);
+        }
+        for (size_t n = 0; n < num_threads; n++) {
+            smlt_node_join(smlt_get_node_by_id(n));
+        }
+    }
+    double start_us = (now_us() - start) / NUM_RUNS;
+
+    if (!num_wrong) {
+        printf("Pool Test Success (%.1f us per region, %.1f us with "
+               "smlt_node_start)\n", pool_us, start_us);
+    } else {
+        printf("Pool Test Failed \n");
+    }
+
+    free(regions);
+
+    return num_wrong ? 1 : 0;
+}
@@ -0,0 +1,243 @@
+/**
+ * \brief Testing the link cost profiler
+ */
+
+/*
+ * Copyright (c) 2016, ETH Zurich.
+ * All rights reserved.
+ *
+ * This file is distributed under the terms in the attached LICENSE file.
+ * If you do not find this file, copies can be found by writing to:
+ * ETH Zurich D-INFK, Universitaetstr. 6, CH-8092 Zurich. Attn: Systems Group.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <smlt.h>
+#include <smlt_generator.h>
+#include <smlt_profiler.h>
+#include <smlt_platform.h>
+
+// layout of a profile file, see src/profiler.c
+#define PROFILE_MAGIC   0x504c4d53
+#define PROFILE_VERSION 1
+
+#define NUM_CORES 4
+
+// two pairs of cores, cheap within a pair, expensive across
+static coreid_t cores[NUM_CORES] = { 10, 11, 12, 13 };
+
+#define NEAR_COST 10
+#define FAR_COST 1000
+
+static int num_wrong = 0;
+
+#define CHECK(cond)                                                         \
+    do {                                                                    \
+        if (!(cond)) {                                                      \
+            printf("check failed: %s (line %d)\n", #cond, __LINE__);        \
+            num_wrong++;                                                    \
+        }                                                                   \
+    } while (0)
+
+static uint32_t cost(uint32_t src, uint32_t dst)
+{
+    if (src == dst) {
+        return 0;
+    }
+    return (src / 2 == dst / 2) ? NEAR_COST : FAR_COST;
+}
+
+/// writes a profile file by hand, dropping the last bytes if asked to
+static void write_profile_ncores(const char *path, uint32_t magic,
+                                 uint32_t ncores, size_t drop)
+{
+    uint32_t buf[4 + NUM_CORES + 3 * NUM_CORES * NUM_CORES];
+    uint32_t *p = buf;
+
+    *p++ = magic;
+    *p++ = PROFILE_VERSION;
+    *p++ = ncores;
+    *p++ = SMLT_PROFILER_BATCH;
+
+    for (uint32_t i = 0; i < NUM_CORES; i++) {
+        *p++ = cores[i];
+    }
+    // send, receive and propagation cost
+    for (uint32_t m = 0; m < 3; m++) {
+        for (uint32_t i = 0; i < NUM_CORES; i++) {
+            for (uint32_t j = 0; j < NUM_CORES; j++) {
+                *p++ = cost(i, j);
+            }
+        }
+    }
+
+    FILE *file = fopen(path, "wb");
+    fwrite(buf, 1, sizeof(buf) - drop, file);
+    fclose(file);
+}
+
+static void write_profile(const char *path, uint32_t magic, size_t drop)
+{
+    write_profile_ncores(path, magic, NUM_CORES, drop);
+}
+
+/// profiles must fit this machine, whatever the file claims
+static void test_ncores(const char *path)
+{
+    struct smlt_profile *loaded = NULL;
+    uint32_t num_cores = smlt_platform_num_cores();
+
+    // more cores than the machine has
+    write_profile_ncores(path, PROFILE_MAGIC, num_cores + 1, 0);
+    CHECK(smlt_err_no(smlt_profiler_load(path, &loaded)) == SMLT_ERR_PROFILE_IO);
+
+    // sizes that wrap around in 32-bit arithmetic
+    write_profile_ncores(path, PROFILE_MAGIC, (1U << 31) + NUM_CORES, 0);
+    CHECK(smlt_err_no(smlt_profiler_load(path, &loaded)) == SMLT_ERR_PROFILE_IO);
+
+    write_profile_ncores(path, PROFILE_MAGIC, 1, 0);
+    CHECK(smlt_err_no(smlt_profiler_load(path, &loaded)) == SMLT_ERR_PROFILE_IO);
+
+    unlink(path);
+}
+
+static void test_persistence(const char *path, const char *copy)
+{
+    struct smlt_profile *profile = NULL, *loaded = NULL;
+    errval_t err;
+
+    write_profile(path, PROFILE_MAGIC, 0);
+    err = smlt_profiler_load(path, &profile);
+    CHECK(smlt_err_is_ok(err));
+    if (smlt_err_is_fail(err)) {
+        return;
+    }
+
+    CHECK(profile->ncores == NUM_CORES);
+    CHECK(memcmp(profile->cores, cores, sizeof(cores)) == 0);
+    CHECK(smlt_profiler_core_idx(profile, 12) == 2);
+    CHECK(smlt_profiler_core_idx(profile, 3) == -1);
+    CHECK(smlt_profiler_msg_cost(profile, 0, 1) == 3 * NEAR_COST);
+    CHECK(smlt_profiler_msg_cost(profile, 1, 2) == 3 * FAR_COST);
+
+    // a stored profile reads back the same
+    CHECK(smlt_err_is_ok(smlt_profiler_store(profile, copy)));
+    err = smlt_profiler_load(copy, &loaded);
+    CHECK(smlt_err_is_ok(err));
+    if (smlt_err_is_ok(err)) {
+        CHECK(loaded->bufsize == profile->bufsize);
+        CHECK(memcmp(loaded->buf, profile->buf, profile->bufsize) == 0);
+        smlt_profiler_destroy(loaded);
+    }
+
+    // the generator connects the cheap pairs first
+    struct smlt_sparse_model *sparse = NULL;
+    err = smlt_generate_sparse_model_from_profile(profile, cores, NUM_CORES,
+                                                  &sparse);
+    CHECK(smlt_err_is_ok(err));
+    if (smlt_err_is_ok(err)) {
+        CHECK(sparse->root == 10);
+        CHECK(sparse->parent[11] == 10);
+        for (uint32_t i = 1; i < NUM_CORES; i++) {
+            CHECK(sparse->parent[cores[i]] != SMLT_MODEL_NO_PARENT);
+        }
+        smlt_sparse_model_destroy(sparse);
+    }
+
+    // cores missing from the profile are refused
+    coreid_t others[2] = { 10, 3 };
+    err = smlt_generate_sparse_model_from_profile(profile, others, 2, &sparse);
+    CHECK(smlt_err_no(err) == SMLT_ERR_GENERATOR);
+
+    smlt_profiler_destroy(profile);
+
+    // missing, foreign and truncated files
+    unlink(copy);
+    CHECK(smlt_err_no(smlt_profiler_load(copy, &loaded)) == SMLT_ERR_PROFILE_IO);
+    write_profile(path, ~PROFILE_MAGIC, 0);
+    CHECK(smlt_err_no(smlt_profiler_load(path, &loaded)) == SMLT_ERR_PROFILE_IO);
+    write_profile(path, PROFILE_MAGIC, sizeof(uint32_t));
+    CHECK(smlt_err_no(smlt_profiler_load(path, &loaded)) == SMLT_ERR_PROFILE_IO);
+
+    unlink(path);
+}
+
+static void test_path(void)
+{
+    char path[256];
+
+    setenv("SMLT_PROFILE", "/some/where.prof", 1);
+    smlt_profiler_get_path(path, sizeof(path));
+    CHECK(strcmp(path, "/some/where.prof") == 0);
+    unsetenv("SMLT_PROFILE");
+
+    setenv("SMLT_PROFILE_DIR", "/some", 1);
+    setenv("SMLT_MACHINE", "box", 1);
+    smlt_profiler_get_path(path, sizeof(path));
+    CHECK(strcmp(path, "/some/smlt-box.prof") == 0);
+    unsetenv("SMLT_PROFILE_DIR");
+    unsetenv("SMLT_MACHINE");
+}
+
+static void test_measure(uint32_t num_threads)
+{
+    struct smlt_profile *profile = NULL;
+    coreid_t measured[2] = { 0, 1 };
+    errval_t err;
+
+    CHECK(smlt_err_no(smlt_profiler_measure(measured, 1, 0, &profile))
+          == SMLT_ERR_INVAL);
+
+    if (num_threads < 2) {
+        return;
+    }
+
+    err = smlt_profiler_measure(measured, 2, 0, &profile);
+    CHECK(smlt_err_is_ok(err));
+    if (smlt_err_is_fail(err)) {
+        return;
+    }
+
+    CHECK(profile->ncores == 2);
+    CHECK(profile->cores[0] == 0 && profile->cores[1] == 1);
+    // both directions are measured, the diagonal is not
+    CHECK(profile->send[1] > 0 && profile->send[2] > 0);
+    CHECK(profile->recv[1] > 0 && profile->recv[2] > 0);
+    CHECK(profile->send[0] == 0 && profile->send[3] == 0);
+
+    smlt_profiler_destroy(profile);
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t num_threads = (uint32_t) sysconf(_SC_NPROCESSORS_ONLN);
+    char path[64], copy[64];
+
+    errval_t err = smlt_init(num_threads, true);
+    if (smlt_err_is_fail(err)) {
+        printf("FAILED TO INITIALIZE !\n");
+        return 1;
+    }
+
+    snprintf(path, sizeof(path), "/tmp/smlt-profiler-test-%d.prof", getpid());
+    snprintf(copy, sizeof(copy), "/tmp/smlt-profiler-test-%d.copy", getpid());
+
+    // the hand-written profile needs as many cores on this machine
+    if (smlt_platform_num_cores() >= NUM_CORES) {
+        test_persistence(path, copy);
+    }
+    test_ncores(path);
+    test_path();
+    test_measure(num_threads);
+
+    if (!num_wrong) {
+        printf("Profiler Test Success\n");
+    } else {
+        printf("Profiler Test Failed \n");
+    }
+
+    return num_wrong ? 1 : 0;
+}
@@ -36,6 +36,19 @@
 
 #define LEAF 0
 
+// messages spanning several slots
+#define NUM_LARGE 1000
+#define MAX_LARGE_WORDS 1024
+
+// a message of two slots, received one slot at a time
+#define POLLED_WORDS 10
+
+/// length of the i-th large message
+static uint32_t large_words(uint64_t i)
+{
+    return 8 + (i * 37) % (MAX_LARGE_WORDS - 8);
+}
+
 int sleep_time = 0;
 void* shared_mem;
 static const int num_readers = 3;
@@ -70,6 +83,19 @@ void* thr_writer(void* arg)
         }
     }
 
+    uintptr_t *large = (uintptr_t*) malloc(MAX_LARGE_WORDS * sizeof(uintptr_t));
+    for (uint64_t i = 0; i < NUM_LARGE; i++) {
+        for (uint32_t j = 0; j < large_words(i); j++) {
+            large[j] = i + j;
+        }
+        swmr_send(queue, large, large_words(i));
+    }
+
+    for (uint32_t j = 0; j < POLLED_WORDS; j++) {
+        large[j] = NUM_LARGE + j;
+    }
+    swmr_send(queue, large, POLLED_WORDS);
+
     sleep(1);
 
     printf("###################################################\n");
@@ -119,6 +145,42 @@ void* thr_reader(void* arg)
         }
     }
 
+    uintptr_t *large = (uintptr_t*) malloc(MAX_LARGE_WORDS * sizeof(uintptr_t));
+    for (uint64_t i = 0; i < NUM_LARGE; i++) {
+        uint32_t words = swmr_receive(queue, large, MAX_LARGE_WORDS);
+        if (words != large_words(i)) {
+            num_wrong++;
+            continue;
+        }
+        for (uint32_t j = 0; j < words; j++) {
+            if (large[j] != i + j) {
+                num_wrong++;
+                break;
+            }
+        }
+    }
+
+    /* the first slot holds the length, followed by the start of the payload */
+    while (!swmr_receive_non_blocking(queue, &r[0], &r[1], &r[2], &r[3],
+                                      &r[4], &r[5], &r[6])) {
+    }
+    if (r[0] != POLLED_WORDS) {
+        num_wrong++;
+    }
+    for (uint32_t j = 0; j < 6; j++) {
+        if (r[j + 1] != NUM_LARGE + j) {
+            num_wrong++;
+        }
+    }
+    while (!swmr_receive_non_blocking(queue, &r[0], &r[1], &r[2], &r[3],
+                                      &r[4], &r[5], &r[6])) {
+    }
+    for (uint32_t j = 6; j < POLLED_WORDS; j++) {
+        if (r[j - 6] != NUM_LARGE + j) {
+            num_wrong++;
+        }
+    }
+
     printf("###################################################\n");
     if (num_wrong) {
         printf("Reader %" PRIu64 ": Test Failed \n", ((uint64_t)arg));
@@ -11,7 +11,9 @@
  * ETH Zurich D-INFK, Universitaetstr. 6, CH-8092 Zurich. Attn: Systems Group.
  */
 
+#ifndef _GNU_SOURCE
 #define _GNU_SOURCE
+#endif
 #include <string.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -24,29 +26,62 @@
 #include <smlt.h>
 #include <backends/shm/shm_qp.h>
 
-#define NUM_RUNS 10000000
+#define NUM_RUNS 1000000
+
+// messages of up to MAX_WORDS words, longer ones span several slots
+#define MAX_WORDS 200
 
 struct shm_qp qp[2];
 
+/// length of the i-th message
+static uint32_t msg_words(int i)
+{
+    return 1 + i % MAX_WORDS;
+}
+
+/// checks the payload of the i-th message
+static bool msg_check(int i, uintptr_t *r, uint32_t words)
+{
+    if (words < SWMR_PAYLOAD_WORDS) {
+        // single slot messages always return the full slot
+        return r[0] == (uintptr_t) i;
+    }
+
+    if (words != (msg_words(i) < SWMR_PAYLOAD_WORDS ? SWMR_PAYLOAD_WORDS
+                                                     : msg_words(i))) {
+        return false;
+    }
+
+    for (uint32_t j = 0; j < msg_words(i); j++) {
+        if (r[j] != (uintptr_t) i + j) {
+            return false;
+        }
+    }
+    return true;
+}
+
 void* thr_worker1(void* arg)
 {
     cpu_set_t cpu_mask;
 
     CPU_ZERO(&cpu_mask);
     CPU_SET(0, &cpu_mask);
-    uintptr_t r[8];
-    sched_setaffinity(0, sizeof(cpu_set_t), &cpu_mask);    
+    uintptr_t s[MAX_WORDS];
+    uintptr_t r[MAX_WORDS];
+    sched_setaffinity(0, sizeof(cpu_set_t), &cpu_mask);
 
     int num_wrong = 0;
     for (int i = 0; i < NUM_RUNS; i++) {
+        for (uint32_t j = 0; j < msg_words(i); j++) {
+            s[j] = i + j;
+        }
 
-        shm_q_send(&qp[0].src, i, 0, 0, 0, 0, 0,0);
-        shm_q_recv(&qp[1].dst, &r[0], &r[1], &r[2],
-                   &r[3], &r[4], &r[5], &r[6]);
-        if (r[0] != i) {
+        swmr_send(&qp[0].src, s, msg_words(i));
+        uint32_t words = swmr_receive(&qp[1].dst, r, MAX_WORDS);
+        if (!msg_check(i, r, words)) {
            num_wrong++;
         }
-    }   
+    }
 
     if (!num_wrong) {
        printf("Core 0 Test Success \n");
@@ -62,20 +97,19 @@ void* thr_worker2(void* arg)
 
     CPU_ZERO(&cpu_mask);
     CPU_SET(1, &cpu_mask);
-    uintptr_t r[8];
+    uintptr_t r[MAX_WORDS];
+
+    sched_setaffinity(0, sizeof(cpu_set_t), &cpu_mask);
 
-    sched_setaffinity(0, sizeof(cpu_set_t), &cpu_mask);    
-   
     int num_wrong = 0;
     for (int i = 0; i < NUM_RUNS; i++) {
-        shm_q_recv(&qp[0].dst, &r[0], &r[1], &r[2],
-                   &r[3], &r[4], &r[5], &r[6]);
-        shm_q_send(&qp[1].src, i, 0, 0, 0, 0, 0,0);
-        if (r[0] != i) {
+        uint32_t words = swmr_receive(&qp[0].dst, r, MAX_WORDS);
+        if (!msg_check(i, r, words)) {
            num_wrong++;
         }
+        swmr_send(&qp[1].src, r, msg_words(i));
     }
-    
+
     if (!num_wrong) {
        printf("Core 1 Test Success \n");
     } else {
@@ -86,9 +120,13 @@ void* thr_worker2(void* arg)
 
 int main(int argc, char ** argv)
 {
-    qp[0] = *shm_queuepair_create(0,1);
+    bool sep_header = (argc > 1 && !strcmp(argv[1], "sep"));
 
-    qp[1] = *shm_queuepair_create(1,0);
+    if (smlt_err_is_fail(shm_queuepair_init(&qp[0], 0, 1, sep_header)) ||
+        smlt_err_is_fail(shm_queuepair_init(&qp[1], 1, 0, sep_header))) {
+        printf("FAILED TO INITIALIZE !\n");
+        return 1;
+    }
 
     pthread_t *tids = (pthread_t*) malloc(sizeof(pthread_t)*2);
     pthread_create(&tids[0], NULL, thr_worker1, (void*) 0);
@@ -98,5 +136,8 @@ int main(int argc, char ** argv)
         pthread_join(tids[i], NULL);
     }
 
-}
+    shm_queuepair_destroy(&qp[0]);
+    shm_queuepair_destroy(&qp[1]);
 
+    return 0;
+}
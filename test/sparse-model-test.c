@@ -0,0 +1,260 @@
+/**
+ * \brief Testing the sparse model representation
+ */
+
+/*
+ * Copyright (c) 2016, ETH Zurich.
+ * All rights reserved.
+ *
+ * This file is distributed under the terms in the attached LICENSE file.
+ * If you do not find this file, copies can be found by writing to:
+ * ETH Zurich D-INFK, Universitaetstr. 6, CH-8092 Zurich. Attn: Systems Group.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <smlt.h>
+#include <smlt_generator.h>
+#include <smlt_topology.h>
+
+// more children than the dense matrix can encode
+#define WIDE_FANOUT 200
+
+#define LEN 8
+#define ROOT 2
+
+static int num_wrong = 0;
+
+#define CHECK(cond)                                                         \
+    do {                                                                    \
+        if (!(cond)) {                                                      \
+            printf("check failed: %s (line %d)\n", #cond, __LINE__);        \
+            num_wrong++;                                                    \
+        }                                                                   \
+    } while (0)
+
+/**
+ * @brief builds the model used by the tests
+ *
+ * Root 2 sends to 5 and then to 0, and shares memory with 3 and 4. Node 0
+ * sends to 1, node 5 to 6. Node 7 is not part of the model.
+ */
+static struct smlt_sparse_model *build(void)
+{
+    struct smlt_sparse_model *m = NULL;
+
+    if (smlt_err_is_fail(smlt_sparse_model_create(LEN, ROOT, &m))) {
+        printf("creating the model failed\n");
+        num_wrong++;
+        return NULL;
+    }
+
+    CHECK(smlt_err_is_ok(smlt_sparse_model_add_child(m, 2, 5, SMLT_MODEL_EDGE_MP)));
+    CHECK(smlt_err_is_ok(smlt_sparse_model_add_child(m, 2, 3, SMLT_MODEL_EDGE_SHM)));
+    CHECK(smlt_err_is_ok(smlt_sparse_model_add_child(m, 2, 0, SMLT_MODEL_EDGE_MP)));
+    CHECK(smlt_err_is_ok(smlt_sparse_model_add_child(m, 2, 4, SMLT_MODEL_EDGE_SHM)));
+    CHECK(smlt_err_is_ok(smlt_sparse_model_add_child(m, 0, 1, SMLT_MODEL_EDGE_MP)));
+    CHECK(smlt_err_is_ok(smlt_sparse_model_add_child(m, 5, 6, SMLT_MODEL_EDGE_MP)));
+
+    return m;
+}
+
+static void check_built(struct smlt_sparse_model *m)
+{
+    CHECK(m->len == LEN && m->root == ROOT);
+    CHECK(m->parent[ROOT] == SMLT_MODEL_NO_PARENT);
+    CHECK(m->parent[7] == SMLT_MODEL_NO_PARENT);
+    CHECK(m->parent[5] == 2 && m->parent[0] == 2 && m->parent[1] == 0);
+    CHECK(m->parent_edge[5] == SMLT_MODEL_EDGE_MP);
+    CHECK(m->parent_edge[3] == SMLT_MODEL_EDGE_SHM);
+    CHECK(m->child_idx[5] == 0 && m->child_idx[0] == 1);
+
+    // message passing children in the order they are sent to, then shm
+    CHECK(m->num_children[ROOT] == 2 && m->num_children_shm[ROOT] == 2);
+    uint32_t *children = &m->children[m->child_offset[ROOT]];
+    CHECK(children[0] == 5 && children[1] == 0);
+    CHECK(children[2] == 3 && children[3] == 4);
+    CHECK(m->child_offset[7] == m->child_offset[LEN]);
+
+    // connected nodes without children, in node order
+    CHECK(m->num_leafs == 4);
+    if (m->num_leafs == 4) {
+        CHECK(m->leafs[0] == 1 && m->leafs[1] == 3 && m->leafs[2] == 4 &&
+              m->leafs[3] == 6);
+    }
+}
+
+static void test_build(void)
+{
+    struct smlt_sparse_model *m = NULL;
+
+    CHECK(smlt_err_no(smlt_sparse_model_create(0, 0, &m)) == SMLT_ERR_INVAL);
+    CHECK(smlt_err_no(smlt_sparse_model_create(LEN, LEN, &m)) == SMLT_ERR_INVAL);
+
+    m = build();
+    if (m == NULL) {
+        return;
+    }
+
+    // a node has one parent, the root has none, all nodes are in range
+    CHECK(smlt_err_no(smlt_sparse_model_add_child(m, 6, 1, SMLT_MODEL_EDGE_MP))
+          == SMLT_ERR_INVAL);
+    CHECK(smlt_err_no(smlt_sparse_model_add_child(m, 6, ROOT, SMLT_MODEL_EDGE_MP))
+          == SMLT_ERR_INVAL);
+    CHECK(smlt_err_no(smlt_sparse_model_add_child(m, LEN, 7, SMLT_MODEL_EDGE_MP))
+          == SMLT_ERR_INVAL);
+    CHECK(smlt_err_no(smlt_sparse_model_add_child(m, 6, LEN, SMLT_MODEL_EDGE_MP))
+          == SMLT_ERR_INVAL);
+
+    CHECK(smlt_err_is_ok(smlt_sparse_model_finalize(m)));
+    check_built(m);
+
+    smlt_sparse_model_destroy(m);
+}
+
+static void test_dense(void)
+{
+    struct smlt_generated_model *model = NULL;
+    struct smlt_sparse_model *m, *back = NULL;
+    errval_t err;
+
+    m = build();
+    if (m == NULL || smlt_err_is_fail(smlt_sparse_model_finalize(m))) {
+        printf("building the model failed\n");
+        num_wrong++;
+        smlt_sparse_model_destroy(m);
+        return;
+    }
+
+    err = smlt_sparse_model_to_dense(m, &model);
+    CHECK(smlt_err_is_ok(err));
+    if (smlt_err_is_fail(err)) {
+        smlt_sparse_model_destroy(m);
+        return;
+    }
+
+    CHECK(model->len == LEN && model->root == ROOT && model->ncores == 7);
+    CHECK(model->model[2 * LEN + 5] == 1 && model->model[2 * LEN + 0] == 2);
+    CHECK(model->model[5 * LEN + 2] == TOPO_MATRIX_PARENT);
+    CHECK(model->model[3 * LEN + 2] == TOPO_MATRIX_SHM_SLAVE_START);
+    CHECK(model->model[2 * LEN + 3] == 0);
+    for (uint32_t i = 0; i < LEN; i++) {
+        CHECK(model->model[7 * LEN + i] == 0 && model->model[i * LEN + 7] == 0);
+    }
+    CHECK(model->num_leafs == m->num_leafs);
+
+    // and back again
+    err = smlt_sparse_model_from_dense(model, &back);
+    CHECK(smlt_err_is_ok(err));
+    if (smlt_err_is_ok(err)) {
+        check_built(back);
+        CHECK(memcmp(back->child_offset, m->child_offset,
+                     (LEN + 1) * sizeof(uint32_t)) == 0);
+        CHECK(memcmp(back->children, m->children,
+                     m->child_offset[LEN] * sizeof(uint32_t)) == 0);
+        smlt_sparse_model_destroy(back);
+    }
+
+    smlt_sparse_model_destroy(m);
+}
+
+static void test_wide(void)
+{
+    struct smlt_generated_model *model = NULL;
+    struct smlt_sparse_model *m = NULL;
+    coreid_t cores[WIDE_FANOUT + 1];
+    errval_t err;
+
+    for (uint32_t i = 0; i <= WIDE_FANOUT; i++) {
+        cores[i] = i;
+    }
+
+    // the sparse model has no limit on the fan-out
+    err = smlt_generate_builtin_sparse_model("kary-200", cores,
+                                             WIDE_FANOUT + 1, &m);
+    CHECK(smlt_err_is_ok(err));
+    if (smlt_err_is_ok(err)) {
+        CHECK(m->num_children[0] == WIDE_FANOUT);
+        CHECK(m->num_leafs == WIDE_FANOUT);
+        CHECK(m->children[m->child_offset[0] + WIDE_FANOUT - 1] == WIDE_FANOUT);
+
+        // the matrix cannot hold it
+        CHECK(smlt_err_no(smlt_sparse_model_to_dense(m, &model))
+              == SMLT_ERR_GENERATOR);
+        smlt_sparse_model_destroy(m);
+    }
+
+    CHECK(smlt_err_no(smlt_generate_builtin_model("kary-200", cores,
+                                                  WIDE_FANOUT + 1, &model))
+          == SMLT_ERR_GENERATOR);
+    CHECK(smlt_err_is_ok(smlt_generate_builtin_model("kary-98", cores,
+                                                     WIDE_FANOUT + 1, &model)));
+}
+
+static void test_topology(uint32_t num_threads)
+{
+    struct smlt_topology *topo = NULL;
+    struct smlt_sparse_model *m = NULL;
+    coreid_t cores[WIDE_FANOUT + 1];
+    char name[16];
+    errval_t err;
+
+    uint32_t num = num_threads <= WIDE_FANOUT ? num_threads : WIDE_FANOUT + 1;
+    for (uint32_t i = 0; i < num; i++) {
+        cores[i] = i;
+    }
+
+    // all nodes are children of the root
+    snprintf(name, sizeof(name), "kary-%u", num);
+    err = smlt_generate_builtin_sparse_model(name, cores, num, &m);
+    CHECK(smlt_err_is_ok(err));
+    if (smlt_err_is_fail(err)) {
+        return;
+    }
+
+    err = smlt_topology_create_sparse(m, "flat", &topo);
+    CHECK(smlt_err_is_ok(err));
+    if (smlt_err_is_ok(err)) {
+        CHECK(smlt_topology_get_num_nodes(topo) == num);
+        struct smlt_topology_node *root = smlt_topology_get_first_node(topo);
+        CHECK(smlt_topology_node_is_root(root));
+        CHECK(smlt_topology_node_get_num_children(root) == num - 1);
+        smlt_topology_destroy(topo);
+    }
+    smlt_sparse_model_destroy(m);
+
+    // a core without a node
+    CHECK(smlt_err_is_ok(smlt_sparse_model_create(num + 1, 0, &m)));
+    CHECK(smlt_err_is_ok(smlt_sparse_model_add_child(m, 0, num,
+                                                     SMLT_MODEL_EDGE_MP)));
+    CHECK(smlt_err_is_ok(smlt_sparse_model_finalize(m)));
+    CHECK(smlt_err_no(smlt_topology_create_sparse(m, "missing", &topo))
+          == SMLT_ERR_NODE_INVALD);
+    smlt_sparse_model_destroy(m);
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t num_threads = (uint32_t) sysconf(_SC_NPROCESSORS_ONLN);
+
+    errval_t err = smlt_init(num_threads, true);
+    if (smlt_err_is_fail(err)) {
+        printf("FAILED TO INITIALIZE !\n");
+        return 1;
+    }
+
+    test_build();
+    test_dense();
+    test_wide();
+    test_topology(num_threads);
+
+    if (!num_wrong) {
+        printf("Sparse Model Test Success\n");
+    } else {
+        printf("Sparse Model Test Failed \n");
+    }
+
+    return num_wrong ? 1 : 0;
+}
@@ -0,0 +1,153 @@
+/**
+ * \brief Testing the split barrier
+ */
+
+/*
+ * Copyright (c) 2016, ETH Zurich.
+ * All rights reserved.
+ *
+ * This file is distributed under the terms in the attached LICENSE file.
+ * If you do not find this file, copies can be found by writing to:
+ * ETH Zurich D-INFK, Universitaetstr. 6, CH-8092 Zurich. Attn: Systems Group.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <smlt.h>
+#include <smlt_node.h>
+#include <smlt_barrier.h>
+#include <smlt_topology.h>
+#include <smlt_context.h>
+
+#define NUM_RUNS 500
+
+// every this many epochs, the last node holds back its arrival
+#define LATE_EVERY 50
+
+static struct smlt_context *context = NULL;
+
+static uint32_t num_nodes;
+
+// number of nodes that arrived at each epoch, the first is unused
+static volatile uint32_t arrived[2 * NUM_RUNS + 2];
+
+// number of nodes that saw the epoch held back
+static volatile uint32_t num_held;
+
+static volatile int num_wrong = 0;
+
+#define CHECK(cond)                                                         \
+    do {                                                                    \
+        if (!(cond)) {                                                      \
+            printf("check failed: %s (line %d)\n", #cond, __LINE__);        \
+            __sync_fetch_and_add(&num_wrong, 1);                            \
+        }                                                                   \
+    } while (0)
+
+static void arrive(uint64_t epoch)
+{
+    __sync_fetch_and_add(&arrived[epoch], 1);
+    CHECK(smlt_err_is_ok(smlt_barrier_arrive(context)));
+}
+
+/// nobody departs before everyone arrived
+static void depart(uint64_t epoch)
+{
+    CHECK(smlt_err_is_ok(smlt_barrier_depart(context)));
+    CHECK(arrived[epoch] == num_nodes);
+}
+
+static void* thr_worker(void* arg)
+{
+    smlt_nid_t nid = smlt_node_get_id();
+    bool late = (nid == num_nodes - 1);
+    uint64_t epoch = 0;
+
+    CHECK(smlt_err_no(smlt_barrier_depart(context)) == SMLT_ERR_INVAL);
+
+    // arrive, work, depart
+    for (uint32_t i = 0; i < NUM_RUNS; i++) {
+        epoch++;
+        bool held = (i % LATE_EVERY == 0) && num_nodes > 1;
+
+        if (held && late) {
+            // the others must see the epoch as not released
+            while (num_held < (i / LATE_EVERY + 1) * (num_nodes - 1))
+                ;
+        }
+
+        arrive(epoch);
+
+        if (held && !late) {
+            CHECK(!smlt_barrier_test(context));
+            __sync_fetch_and_add(&num_held, 1);
+        }
+
+        // local work, polling the barrier
+        while (!smlt_barrier_test(context))
+            ;
+        CHECK(smlt_barrier_test(context));
+
+        depart(epoch);
+    }
+
+    // the next arrival overlaps with the previous departure
+    epoch++;
+    arrive(epoch);
+    for (uint32_t i = 0; i < NUM_RUNS; i++) {
+        arrive(epoch + 1);
+        depart(epoch);
+        epoch++;
+    }
+    depart(epoch);
+
+    CHECK(smlt_err_no(smlt_barrier_depart(context)) == SMLT_ERR_INVAL);
+
+    return NULL;
+}
+
+int main(int argc, char **argv)
+{
+    size_t num_threads = sysconf(_SC_NPROCESSORS_ONLN);
+    errval_t err;
+
+    err = smlt_init(num_threads, true);
+    if (smlt_err_is_fail(err)) {
+        printf("FAILED TO INITIALIZE !\n");
+        return 1;
+    }
+    num_nodes = smlt_get_num_proc();
+
+    struct smlt_topology *topo = NULL;
+    smlt_topology_create(NULL, SMLT_TOPO_BINARY, &topo);
+
+    err = smlt_context_create(topo, &context);
+    if (smlt_err_is_fail(err)) {
+        printf("FAILED TO INITIALIZE CONTEXT !\n");
+        return 1;
+    }
+
+    struct smlt_node *node;
+    for (uint64_t i = 0; i < num_nodes; i++) {
+        node = smlt_get_node_by_id(i);
+        err = smlt_node_start(node, thr_worker, (void *)i);
+        if (smlt_err_is_fail(err)) {
+            printf("Starting node failed \n");
+            return 1;
+        }
+    }
+
+    for (uint64_t i = 0; i < num_nodes; i++) {
+        node = smlt_get_node_by_id(i);
+        smlt_node_join(node);
+    }
+
+    if (!num_wrong) {
+        printf("Split Barrier Test Success\n");
+    } else {
+        printf("Split Barrier Test Failed \n");
+    }
+
+    return num_wrong ? 1 : 0;
+}
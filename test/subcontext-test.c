@@ -0,0 +1,232 @@
+/**
+ * \brief Testing contexts over a subset of the nodes
+ */
+
+/*
+ * Copyright (c) 2016, ETH Zurich.
+ * All rights reserved.
+ *
+ * This file is distributed under the terms in the attached LICENSE file.
+ * If you do not find this file, copies can be found by writing to:
+ * ETH Zurich D-INFK, Universitaetstr. 6, CH-8092 Zurich. Attn: Systems Group.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <smlt.h>
+#include <smlt_node.h>
+#include <smlt_message.h>
+#include <smlt_broadcast.h>
+#include <smlt_barrier.h>
+#include <smlt_topology.h>
+#include <smlt_context.h>
+
+#define MAX_NODES 64
+
+#define NUM_RUNS 100
+
+// the node that does not take part in the split
+#define LEFT_OUT 2
+
+static struct smlt_context *context = NULL;
+
+// every third node, from the top
+static struct smlt_context *subset = NULL;
+static coreid_t subset_cores[MAX_NODES];
+static uint32_t subset_len;
+
+static uint32_t num_nodes;
+
+static volatile int num_wrong = 0;
+
+#define CHECK(cond)                                                         \
+    do {                                                                    \
+        if (!(cond)) {                                                      \
+            printf("check failed: %s (line %d)\n", #cond, __LINE__);        \
+            __sync_fetch_and_add(&num_wrong, 1);                            \
+        }                                                                   \
+    } while (0)
+
+static bool in_subset(smlt_nid_t nid)
+{
+    for (uint32_t i = 0; i < subset_len; i++) {
+        if (smlt_get_id_by_core(subset_cores[i]) == nid) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static uint32_t split_color(smlt_nid_t nid)
+{
+    return (nid == LEFT_OUT) ? SMLT_CONTEXT_SPLIT_UNDEFINED : nid % 2;
+}
+
+/// the highest node id of the color becomes the root
+static uint32_t split_key(smlt_nid_t nid)
+{
+    return num_nodes - nid;
+}
+
+/// broadcasts the id of the root and checks it arrives everywhere
+static void check_broadcast(struct smlt_context *ctx, smlt_nid_t root,
+                            struct smlt_msg *msg)
+{
+    for (uint32_t i = 0; i < NUM_RUNS; i++) {
+        if (smlt_context_is_root(ctx)) {
+            msg->data[0] = root * NUM_RUNS + i;
+        }
+        smlt_broadcast(ctx, msg);
+        CHECK(msg->data[0] == root * NUM_RUNS + i);
+    }
+}
+
+static void* thr_worker(void* arg)
+{
+    smlt_nid_t nid = smlt_node_get_id();
+    struct smlt_msg *msg = smlt_message_alloc(56);
+    errval_t err;
+
+    // a context created over some of the cores
+    if (in_subset(nid)) {
+        CHECK(smlt_context_get_rank(subset) != SMLT_CONTEXT_RANK_NONE);
+        CHECK(smlt_context_is_root(subset) ==
+              (smlt_get_core_by_id(nid) == subset_cores[0]));
+        check_broadcast(subset, smlt_get_id_by_core(subset_cores[0]), msg);
+        smlt_barrier_wait(subset);
+    } else {
+        CHECK(smlt_context_get_rank(subset) == SMLT_CONTEXT_RANK_NONE);
+    }
+
+    smlt_barrier_wait(context);
+
+    // splitting the context by the parity of the node id
+    struct smlt_context *sub = NULL;
+    bool sub_root = false;
+    uint32_t color = split_color(nid);
+    err = smlt_context_split(context, color, split_key(nid), &sub);
+    CHECK(smlt_err_is_ok(err));
+
+    if (color == SMLT_CONTEXT_SPLIT_UNDEFINED) {
+        CHECK(sub == NULL);
+    } else if (sub != NULL) {
+        uint32_t count = 0;
+        smlt_nid_t root = 0;
+        for (smlt_nid_t i = 0; i < num_nodes; i++) {
+            if (split_color(i) == color) {
+                count++;
+                root = i;
+            }
+        }
+
+        CHECK(smlt_context_get_num_nodes(sub) == count);
+        CHECK(smlt_context_get_rank(sub) < count);
+        sub_root = smlt_context_is_root(sub);
+        CHECK(sub_root == (nid == root));
+        check_broadcast(sub, root, msg);
+        smlt_barrier_wait(sub);
+    }
+
+    // all sub-contexts are done before the parent is used again
+    smlt_barrier_wait(context);
+    if (sub_root) {
+        smlt_context_destroy(sub);
+    }
+
+    // the same tree again, it reuses the channels of the parent
+    struct smlt_context *copy = NULL;
+    bool copy_root = false;
+    err = smlt_context_split(context, 0, nid, &copy);
+    CHECK(smlt_err_is_ok(err));
+    if (copy != NULL) {
+        copy_root = smlt_context_is_root(copy);
+        check_broadcast(copy, 0, msg);
+        smlt_barrier_wait(copy);
+    }
+
+    smlt_barrier_wait(context);
+    if (copy_root) {
+        smlt_context_destroy(copy);
+    }
+
+    // the sub-contexts leave the channels they reused to the parent
+    smlt_barrier_wait(context);
+    check_broadcast(context, 0, msg);
+
+    smlt_message_free(msg);
+
+    return NULL;
+}
+
+int main(int argc, char **argv)
+{
+    size_t num_threads = sysconf(_SC_NPROCESSORS_ONLN);
+    errval_t err;
+
+    err = smlt_init(num_threads, true);
+    if (smlt_err_is_fail(err)) {
+        printf("FAILED TO INITIALIZE !\n");
+        return 1;
+    }
+    num_nodes = smlt_get_num_proc();
+
+    struct smlt_topology *topo = NULL;
+    smlt_topology_create(NULL, SMLT_TOPO_BINARY, &topo);
+
+    err = smlt_context_create(topo, &context);
+    if (smlt_err_is_fail(err)) {
+        printf("FAILED TO INITIALIZE CONTEXT !\n");
+        return 1;
+    }
+
+    // every core needs a node
+    coreid_t missing[2] = { 0, num_nodes };
+    CHECK(smlt_err_no(smlt_context_create_from_cores(missing, 2, NULL, &subset))
+          == SMLT_ERR_INVAL);
+
+    subset_len = 0;
+    for (int32_t i = num_nodes - 1; i >= 0 && subset_len < MAX_NODES; i--) {
+        if (i % 3 == 0) {
+            subset_cores[subset_len++] = smlt_get_core_by_id(i);
+        }
+    }
+
+    err = smlt_context_create_from_cores(subset_cores, subset_len,
+                                         SMLT_TOPO_BINARY, &subset);
+    if (smlt_err_is_fail(err)) {
+        printf("FAILED TO CREATE THE SUB-CONTEXT !\n");
+        return 1;
+    }
+
+    CHECK(smlt_context_get_num_nodes(subset) == subset_len);
+    for (uint32_t r = 0; r < subset_len; r++) {
+        CHECK(in_subset(smlt_context_get_node_id(subset, r)));
+    }
+
+    struct smlt_node *node;
+    for (uint64_t i = 0; i < num_nodes; i++) {
+        node = smlt_get_node_by_id(i);
+        err = smlt_node_start(node, thr_worker, (void *)i);
+        if (smlt_err_is_fail(err)) {
+            printf("Starting node failed \n");
+            return 1;
+        }
+    }
+
+    for (uint64_t i = 0; i < num_nodes; i++) {
+        node = smlt_get_node_by_id(i);
+        smlt_node_join(node);
+    }
+
+    smlt_context_destroy(subset);
+    smlt_context_destroy(context);
+
+    if (!num_wrong) {
+        printf("Sub-Context Test Success\n");
+    } else {
+        printf("Sub-Context Test Failed \n");
+    }
+
+    return num_wrong ? 1 : 0;
+}
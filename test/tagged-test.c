@@ -0,0 +1,200 @@
+/**
+ * \brief Testing the tagged collectives
+ */
+
+/*
+ * Copyright (c) 2016, ETH Zurich.
+ * All rights reserved.
+ *
+ * This file is distributed under the terms in the attached LICENSE file.
+ * If you do not find this file, copies can be found by writing to:
+ * ETH Zurich D-INFK, Universitaetstr. 6, CH-8092 Zurich. Attn: Systems Group.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <smlt.h>
+#include <smlt_node.h>
+#include <smlt_message.h>
+#include <smlt_barrier.h>
+#include <smlt_topology.h>
+#include <smlt_context.h>
+#include <smlt_tagged.h>
+
+#define NUM_RUNS 200
+
+#define TAG_A 1
+#define TAG_B 7
+
+static struct smlt_context *context = NULL;
+
+static uint32_t num_nodes;
+
+static volatile int num_wrong = 0;
+
+#define CHECK(cond)                                                         \
+    do {                                                                    \
+        if (!(cond)) {                                                      \
+            printf("check failed: %s (line %d)\n", #cond, __LINE__);        \
+            __sync_fetch_and_add(&num_wrong, 1);                            \
+        }                                                                   \
+    } while (0)
+
+/// sums the first word, keeps the maximum of the second
+static errval_t operation(struct smlt_msg *dest, struct smlt_msg *src)
+{
+    dest->data[0] += src->data[0];
+    if (src->data[1] > dest->data[1]) {
+        dest->data[1] = src->data[1];
+    }
+    return SMLT_SUCCESS;
+}
+
+/// half of the nodes issue the operations of a round in the other order
+static bool a_first(smlt_nid_t nid, uint32_t round)
+{
+    return ((nid + round) % 2) == 0;
+}
+
+static void bcast_tag(smlt_tag_t tag, struct smlt_msg *msg, uint64_t val)
+{
+    if (smlt_context_is_root(context)) {
+        msg->data[0] = val;
+        msg->data[SMLT_TAG_PAYLOAD_WORDS - 1] = tag;
+    }
+    CHECK(smlt_err_is_ok(smlt_broadcast_tagged(context, tag, msg)));
+    CHECK(msg->data[0] == val && msg->data[SMLT_TAG_PAYLOAD_WORDS - 1] == tag);
+}
+
+static void reduce_tag(smlt_tag_t tag, struct smlt_msg *in,
+                       struct smlt_msg *out, uint64_t val, uint64_t sum)
+{
+    in->data[0] = val;
+    in->data[1] = smlt_node_get_id();
+    CHECK(smlt_err_is_ok(smlt_reduce_tagged(context, tag, in, out, operation)));
+    if (smlt_context_is_root(context)) {
+        CHECK(out->data[0] == sum && out->data[1] == num_nodes - 1);
+    }
+}
+
+static void* thr_worker(void* arg)
+{
+    smlt_nid_t nid = smlt_node_get_id();
+    struct smlt_msg *in = smlt_message_alloc(56);
+    struct smlt_msg *out = smlt_message_alloc(56);
+    uint64_t ids = (uint64_t)num_nodes * (num_nodes - 1) / 2;
+
+    // the header takes one word of the slot
+    in->words = SMLT_TAG_PAYLOAD_WORDS;
+    out->words = SMLT_TAG_PAYLOAD_WORDS;
+
+    // broadcasts of two tags received in a different order on each node
+    for (uint32_t i = 0; i < NUM_RUNS; i++) {
+        if (a_first(nid, i)) {
+            bcast_tag(TAG_A, in, 2 * i);
+            bcast_tag(TAG_B, in, 2 * i + 1);
+        } else {
+            bcast_tag(TAG_B, in, 2 * i + 1);
+            bcast_tag(TAG_A, in, 2 * i);
+        }
+    }
+
+    smlt_barrier_wait(context);
+
+    // reductions of two tags, the children report in any order
+    for (uint32_t i = 0; i < NUM_RUNS; i++) {
+        if (a_first(nid, i)) {
+            reduce_tag(TAG_A, in, out, nid + i, ids + num_nodes * i);
+            reduce_tag(TAG_B, in, out, 2 * nid, 2 * ids);
+        } else {
+            reduce_tag(TAG_B, in, out, 2 * nid, 2 * ids);
+            reduce_tag(TAG_A, in, out, nid + i, ids + num_nodes * i);
+        }
+    }
+
+    smlt_barrier_wait(context);
+
+    // a reduction while a broadcast is in flight
+    for (uint32_t i = 0; i < NUM_RUNS; i++) {
+        if (smlt_context_is_root(context)) {
+            bcast_tag(TAG_A, in, i);
+            reduce_tag(TAG_B, in, out, i, (uint64_t)num_nodes * i);
+        } else {
+            reduce_tag(TAG_B, in, out, i, (uint64_t)num_nodes * i);
+            bcast_tag(TAG_A, in, i);
+        }
+    }
+
+    // the result of a reduce all reaches every node
+    for (uint32_t i = 0; i < NUM_RUNS; i++) {
+        in->data[0] = nid;
+        in->data[1] = nid;
+        CHECK(smlt_err_is_ok(smlt_reduce_all_tagged(context, TAG_B, in, out,
+                                                    operation)));
+        CHECK(out->data[0] == ids && out->data[1] == num_nodes - 1);
+        CHECK(smlt_err_is_ok(smlt_reduce_notify_tagged(context, TAG_A)));
+        CHECK(smlt_err_is_ok(smlt_broadcast_notify_tagged(context, TAG_A)));
+    }
+
+    // the tag and the payload are limited
+    struct smlt_msg *large = smlt_message_alloc(56);
+    large->words = SMLT_TAG_PAYLOAD_WORDS + 1;
+    CHECK(smlt_err_no(smlt_broadcast_tagged(context, TAG_A, large))
+          == SMLT_ERR_INVAL);
+    CHECK(smlt_err_no(smlt_broadcast_notify_tagged(context, SMLT_TAG_MAX))
+          == SMLT_ERR_INVAL);
+    CHECK(smlt_err_no(smlt_reduce_tagged(context, TAG_A, NULL, out, operation))
+          == SMLT_ERR_INVAL);
+
+    smlt_message_free(large);
+    smlt_message_free(in);
+    smlt_message_free(out);
+
+    return NULL;
+}
+
+int main(int argc, char **argv)
+{
+    size_t num_threads = sysconf(_SC_NPROCESSORS_ONLN);
+    errval_t err;
+
+    err = smlt_init(num_threads, true);
+    if (smlt_err_is_fail(err)) {
+        printf("FAILED TO INITIALIZE !\n");
+        return 1;
+    }
+    num_nodes = smlt_get_num_proc();
+
+    struct smlt_topology *topo = NULL;
+    smlt_topology_create(NULL, SMLT_TOPO_BINARY, &topo);
+
+    err = smlt_context_create(topo, &context);
+    if (smlt_err_is_fail(err)) {
+        printf("FAILED TO INITIALIZE CONTEXT !\n");
+        return 1;
+    }
+
+    struct smlt_node *node;
+    for (uint64_t i = 0; i < num_nodes; i++) {
+        node = smlt_get_node_by_id(i);
+        err = smlt_node_start(node, thr_worker, (void *)i);
+        if (smlt_err_is_fail(err)) {
+            printf("Starting node failed \n");
+            return 1;
+        }
+    }
+
+    for (uint64_t i = 0; i < num_nodes; i++) {
+        node = smlt_get_node_by_id(i);
+        smlt_node_join(node);
+    }
+
+    if (!num_wrong) {
+        printf("Tagged Collectives Test Success\n");
+    } else {
+        printf("Tagged Collectives Test Failed \n");
+    }
+
+    return num_wrong ? 1 : 0;
+}
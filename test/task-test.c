@@ -0,0 +1,161 @@
+/**
+ * \brief Testing the task runtime
+ */
+
+/*
+ * Copyright (c) 2016, ETH Zurich.
+ * All rights reserved.
+ *
+ * This file is distributed under the terms in the attached LICENSE file.
+ * If you do not find this file, copies can be found by writing to:
+ * ETH Zurich D-INFK, Universitaetstr. 6, CH-8092 Zurich. Attn: Systems Group.
+ */
+
+#include <stdio.h>
+#include <unistd.h>
+#include <inttypes.h>
+#include <time.h>
+#include <smlt.h>
+#include <smlt_node.h>
+#include <smlt_topology.h>
+#include <smlt_context.h>
+#include <smlt_barrier.h>
+#include <smlt_task.h>
+
+#define NUM_RUNS 3
+
+// the tasks form a binary tree of this depth
+#define TREE_DEPTH 14
+
+// number of loop iterations of a leaf task
+#define LEAF_WORK 2000
+
+// the task that spawns the tree late polls for at least this many seconds
+#define LATE_SECONDS 5
+
+static struct smlt_context *context = NULL;
+static struct smlt_task_runtime *runtime = NULL;
+
+static volatile uint64_t num_leaves = 0;
+static volatile uint64_t num_stolen = 0;
+
+/// spawns two children until the leaves are reached
+static void tree_task(void *arg)
+{
+    uintptr_t depth = (uintptr_t)arg;
+
+    if (depth == 0) {
+        // some work, so the other nodes get to steal
+        for (volatile int i = 0; i < LEAF_WORK; i++)
+            ;
+        __sync_fetch_and_add(&num_leaves, 1);
+        return;
+    }
+
+    smlt_task_spawn(runtime, tree_task, (void *)(depth - 1));
+    smlt_task_spawn(runtime, tree_task, (void *)(depth - 1));
+}
+
+/// keeps the others idle for a while, then spawns the tree
+static void late_task(void *arg)
+{
+    time_t end = time(NULL) + LATE_SECONDS + 1;
+    while (time(NULL) < end) {
+        smlt_task_poll(runtime);
+    }
+    smlt_task_spawn(runtime, tree_task, arg);
+}
+
+static void *thr_worker(void *arg)
+{
+    uint64_t id = (uint64_t)arg;
+    int num_wrong = 0;
+    errval_t err;
+
+    uint64_t executed, stolen;
+
+    for (int i = 0; i <= NUM_RUNS; i++) {
+        // the root starts the tree, the other nodes steal from it. In the
+        // last run, the idle nodes have to keep stealing until it appears
+        if (smlt_context_is_root(context)) {
+            num_leaves = 0;
+            num_stolen = 0;
+            smlt_task_spawn(runtime, i < NUM_RUNS ? tree_task : late_task,
+                            (void *)TREE_DEPTH);
+        }
+        smlt_task_get_stats(runtime, &executed, &stolen);
+        smlt_barrier_wait(context);
+
+        err = smlt_task_run(runtime);
+        if (smlt_err_is_fail(err) || num_leaves != (1UL << TREE_DEPTH)) {
+            num_wrong++;
+        }
+
+        uint64_t before = stolen;
+        smlt_task_get_stats(runtime, &executed, &stolen);
+        __sync_fetch_and_add(&num_stolen, stolen - before);
+        smlt_barrier_wait(context);
+
+        if (i == NUM_RUNS && smlt_context_get_num_nodes(context) > 1 &&
+            num_stolen == 0) {
+            num_wrong++;
+        }
+
+        // all nodes checked the counters before the root resets them
+        smlt_barrier_wait(context);
+    }
+
+    smlt_task_get_stats(runtime, &executed, &stolen);
+
+    if (!num_wrong) {
+        printf("Node %" PRIu64 ": Test Success (executed %" PRIu64
+               ", stolen %" PRIu64 ")\n", id, executed, stolen);
+    } else {
+        printf("Node %" PRIu64 ": Test Failed \n", id);
+    }
+    return NULL;
+}
+
+int main(int argc, char **argv)
+{
+    size_t num_threads = sysconf(_SC_NPROCESSORS_ONLN);
+
+    errval_t err = smlt_init(num_threads, true);
+    if (smlt_err_is_fail(err)) {
+        printf("FAILED TO INITIALIZE !\n");
+        return 1;
+    }
+
+    struct smlt_topology *topo = NULL;
+    smlt_topology_create(NULL, "binary_tree", &topo);
+
+    err = smlt_context_create(topo, &context);
+    if (smlt_err_is_fail(err)) {
+        printf("FAILED TO INITIALIZE CONTEXT !\n");
+        return 1;
+    }
+
+    err = smlt_task_runtime_create(context, &runtime);
+    if (smlt_err_is_fail(err)) {
+        printf("FAILED TO CREATE THE TASK RUNTIME !\n");
+        return 1;
+    }
+
+    struct smlt_node *node;
+    for (uint64_t i = 0; i < num_threads; i++) {
+        node = smlt_get_node_by_id(i);
+        err = smlt_node_start(node, thr_worker, (void *)i);
+        if (smlt_err_is_fail(err)) {
+            printf("Starting node failed \n");
+        }
+    }
+
+    for (uint64_t i = 0; i < num_threads; i++) {
+        node = smlt_get_node_by_id(i);
+        smlt_node_join(node);
+    }
+
+    smlt_task_runtime_free(runtime);
+
+    return 0;
+}
@@ -0,0 +1,131 @@
+/**
+ * \brief Testing the parser of the Simulator models
+ */
+
+/*
+ * Copyright (c) 2016, ETH Zurich.
+ * All rights reserved.
+ *
+ * This file is distributed under the terms in the attached LICENSE file.
+ * If you do not find this file, copies can be found by writing to:
+ * ETH Zurich D-INFK, Universitaetstr. 6, CH-8092 Zurich. Attn: Systems Group.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <tree_config.h>
+
+static int num_wrong = 0;
+
+#define CHECK(cond)                                                         \
+    do {                                                                    \
+        if (!(cond)) {                                                      \
+            printf("check failed: %s (line %d)\n", #cond, __LINE__);        \
+            num_wrong++;                                                    \
+        }                                                                   \
+    } while (0)
+
+struct parsed {
+    uint16_t *model;
+    uint32_t num_leafs;
+    uint32_t *leafs;
+    uint32_t root;
+    uint32_t len;
+};
+
+static int parse(const char *json, struct parsed *p)
+{
+    // garbage, so fields the parser does not set are noticed
+    memset(p, 0xff, sizeof(*p));
+    return smlt_tree_parse(json, 3, &p->model, &p->num_leafs, &p->leafs,
+                           &p->root, &p->len);
+}
+
+static void release(struct parsed *p)
+{
+    free(p->model);
+    free(p->leafs);
+}
+
+/// a 3x3 model with root 1, sending to 0 and then to 2
+static const uint16_t expected[9] = { 0, 0, 0,
+                                      2, 0, 1,
+                                      0, 0, 0 };
+
+static void test_valid(void)
+{
+    struct parsed p;
+
+    // all keys, unknown ones with nested values, strings holding brackets
+    const char *full =
+        "{\"git-version\": \"abc\", \"root\": 1, \"leaf_nodes\": [0, 2],"
+        " \"extra\": {\"a\": [1, {\"b\": \"]}\\\"\"}], \"c\": true},"
+        " \"model\": [[0,0,0],[2,0,1],[0,0,0]], \"cost\": 12.5}";
+    CHECK(parse(full, &p) == 0);
+    CHECK(p.root == 1 && p.len == 3 && p.num_leafs == 2);
+    CHECK(p.leafs && p.leafs[0] == 0 && p.leafs[1] == 2);
+    CHECK(p.model && memcmp(p.model, expected, sizeof(expected)) == 0);
+    release(&p);
+
+    // any order and any white space
+    const char *spaced =
+        "\n{\t\"model\" :\r\n [ [ 0 , 0 , 0 ] ,\n[2,0,1] , [0,0,0] ] ,"
+        "\"leaf_nodes\":[ ] ,\"root\":\n1 }";
+    CHECK(parse(spaced, &p) == 0);
+    CHECK(p.root == 1 && p.len == 3 && p.num_leafs == 0);
+    CHECK(p.model && memcmp(p.model, expected, sizeof(expected)) == 0);
+    release(&p);
+
+    // a missing root is the first node, missing leafs are none
+    CHECK(parse("{\"model\": [[0,1],[0,0]]}", &p) == 0);
+    CHECK(p.root == 0 && p.len == 2 && p.num_leafs == 0 && p.leafs == NULL);
+    CHECK(p.model && p.model[1] == 1);
+    release(&p);
+}
+
+static void test_invalid(void)
+{
+    static const char *invalid[] = {
+        "",
+        "[]",
+        "{\"root\": 0}",                                  // no model
+        "{\"model\": []}",                                // empty model
+        "{\"model\": [[0,1],[0]]}",                       // short row
+        "{\"model\": [[0,1],[0,0,0]]}",                   // long row
+        "{\"model\": [[0,1]]}",                           // missing row
+        "{\"model\": [[0,1],[0,0],[0,0]]}",               // extra row
+        "{\"model\": [[0,70000],[0,0]]}",                 // beyond uint16_t
+        "{\"model\": [[0,-1],[0,0]]}",                    // negative
+        "{\"model\": [[0,1],[0,0]], \"root\": 2}",        // root outside
+        "{\"model\": [[0,1],[0,0]], \"root\": \"0\"}",    // root not a number
+        "{\"model\": [[0,1],[0,0]], \"leaf_nodes\": [1,]}",
+        "{\"model\": [[0,1],[0,0]] \"root\": 0}",         // missing comma
+        "{\"model\": [[0,1],[0,0]], \"extra\": \"open}",  // open string
+        "{\"model\": [[0,1],[0,0]], \"extra\": [1, 2}",   // open array
+    };
+
+    for (size_t i = 0; i < sizeof(invalid) / sizeof(invalid[0]); i++) {
+        struct parsed p;
+        int ret = parse(invalid[i], &p);
+        if (ret == 0 || p.model != NULL || p.leafs != NULL) {
+            printf("accepted invalid model %zu: %s\n", i, invalid[i]);
+            num_wrong++;
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+    test_valid();
+    test_invalid();
+
+    if (!num_wrong) {
+        printf("Tree Parse Test Success\n");
+    } else {
+        printf("Tree Parse Test Failed \n");
+    }
+
+    return num_wrong ? 1 : 0;
+}
@@ -0,0 +1,182 @@
+/**
+ * \brief Testing the auto-tuner
+ */
+
+/*
+ * Copyright (c) 2016, ETH Zurich.
+ * All rights reserved.
+ *
+ * This file is distributed under the terms in the attached LICENSE file.
+ * If you do not find this file, copies can be found by writing to:
+ * ETH Zurich D-INFK, Universitaetstr. 6, CH-8092 Zurich. Attn: Systems Group.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <smlt.h>
+#include <smlt_barrier.h>
+#include <smlt_context.h>
+#include <smlt_tune.h>
+
+#define MAX_NODES 64
+
+// number of cores that are tuned
+#define MAX_TUNED 3
+
+// measured operations per variant, enough to exercise the measurement
+#define TUNE_RUNS "20"
+
+static int num_wrong = 0;
+
+#define CHECK(cond)                                                         \
+    do {                                                                    \
+        if (!(cond)) {                                                      \
+            printf("check failed: %s (line %d)\n", #cond, __LINE__);        \
+            num_wrong++;                                                    \
+        }                                                                   \
+    } while (0)
+
+static bool is_tuned(coreid_t *cores, uint32_t len)
+{
+    smlt_barrier_type_t type;
+    return smlt_err_is_ok(smlt_tune_get_barrier(cores, len, &type));
+}
+
+static void remove_dir(const char *dir)
+{
+    char path[512];
+    struct dirent *e;
+
+    DIR *d = opendir(dir);
+    while ((e = readdir(d)) != NULL) {
+        if (e->d_name[0] == '.') {
+            continue;
+        }
+        snprintf(path, sizeof(path), "%s/%s", dir, e->d_name);
+        unlink(path);
+    }
+    closedir(d);
+    rmdir(dir);
+}
+
+static void check_table(coreid_t *cores, uint32_t len)
+{
+    struct smlt_tune_entry e;
+    smlt_barrier_type_t type;
+    char topo[SMLT_TUNE_NAMELEN];
+
+    CHECK(smlt_err_is_ok(smlt_tune_get_barrier(cores, len, &type)));
+    CHECK(type != SMLT_BARRIER_DEFAULT && type < SMLT_BARRIER_NUM_TYPES);
+
+    CHECK(smlt_err_is_ok(smlt_tune_get_entry(cores, len, SMLT_TUNE_BARRIER,
+                                             &e)));
+    CHECK(e.barrier == type && e.cycles > 0);
+
+    CHECK(smlt_err_is_ok(smlt_tune_get_topology(cores, len, topo, sizeof(topo))));
+    CHECK(strlen(topo) > 0);
+
+    for (smlt_tune_op_t op = SMLT_TUNE_BROADCAST; op < SMLT_TUNE_NUM_OPS; op++) {
+        CHECK(smlt_err_is_ok(smlt_tune_get_entry(cores, len, op, &e)));
+        CHECK(strlen(e.topo) > 0 && e.cycles != UINT64_MAX);
+    }
+    CHECK(smlt_err_no(smlt_tune_get_entry(cores, len, SMLT_TUNE_NUM_OPS, &e))
+          == SMLT_ERR_INVAL);
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t num_threads = (uint32_t) sysconf(_SC_NPROCESSORS_ONLN);
+    coreid_t cores[MAX_NODES];
+    char dir[64];
+    errval_t err;
+
+    // node i runs on core n-1-i
+    uint32_t num_nodes = num_threads < MAX_NODES ? num_threads : MAX_NODES;
+    for (uint32_t i = 0; i < num_nodes; i++) {
+        cores[i] = num_threads - 1 - i;
+    }
+
+    err = smlt_init_cores(cores, num_nodes, true);
+    if (smlt_err_is_fail(err)) {
+        printf("FAILED TO INITIALIZE !\n");
+        return 1;
+    }
+
+    snprintf(dir, sizeof(dir), "/tmp/smlt-tune-test-%d", getpid());
+    mkdir(dir, 0700);
+    setenv("SMLT_TUNE_CACHE_DIR", dir, 1);
+    setenv("SMLT_MACHINE", "box", 1);
+    unsetenv("SMLT_TUNE_CACHE");
+    unsetenv("SMLT_BARRIER");
+    unsetenv("SMLT_TOPO");
+    setenv("SMLT_TUNE_RUNS", TUNE_RUNS, 1);
+
+    // some of the cores, not in order
+    coreid_t tuned[MAX_TUNED];
+    uint32_t len = num_nodes < MAX_TUNED ? num_nodes : MAX_TUNED;
+    for (uint32_t i = 0; i < len; i++) {
+        tuned[i] = cores[(i + 1) % len];
+    }
+
+    CHECK(!is_tuned(tuned, len));
+    struct smlt_tune_entry e;
+    CHECK(smlt_err_no(smlt_tune_get_entry(tuned, len, SMLT_TUNE_BROADCAST, &e))
+          == SMLT_ERR_TUNE_NOTFOUND);
+
+    err = smlt_tune_run(tuned, len);
+    CHECK(smlt_err_is_ok(err));
+    if (smlt_err_is_fail(err)) {
+        printf("FAILED TO TUNE !\n");
+        remove_dir(dir);
+        return 1;
+    }
+
+    check_table(tuned, len);
+
+    // the key is the set of cores and the machine
+    coreid_t reordered[MAX_TUNED];
+    for (uint32_t i = 0; i < len; i++) {
+        reordered[i] = tuned[len - 1 - i];
+    }
+    CHECK(is_tuned(reordered, len));
+    if (len > 1) {
+        CHECK(!is_tuned(tuned, len - 1));
+    }
+    setenv("SMLT_MACHINE", "otherbox", 1);
+    CHECK(!is_tuned(tuned, len));
+    setenv("SMLT_MACHINE", "box", 1);
+    setenv("SMLT_TUNE_CACHE", "0", 1);
+    CHECK(!is_tuned(tuned, len));
+    unsetenv("SMLT_TUNE_CACHE");
+
+    // the default barrier of a context over the cores is the tuned one
+    struct smlt_context *ctx = NULL;
+    err = smlt_context_create_from_cores(tuned, len, NULL, &ctx);
+    CHECK(smlt_err_is_ok(err));
+    if (smlt_err_is_ok(err)) {
+        smlt_barrier_type_t type = SMLT_BARRIER_NUM_TYPES;
+        struct smlt_barrier *bar = NULL;
+        smlt_tune_get_barrier(tuned, len, &type);
+        err = smlt_barrier_create(ctx, SMLT_BARRIER_DEFAULT, &bar);
+        CHECK(smlt_err_is_ok(err));
+        if (smlt_err_is_ok(err)) {
+            CHECK(smlt_barrier_get_type(bar) == type);
+            smlt_barrier_free(bar);
+        }
+        smlt_context_destroy(ctx);
+    }
+
+    remove_dir(dir);
+
+    if (!num_wrong) {
+        printf("Tune Test Success\n");
+    } else {
+        printf("Tune Test Failed \n");
+    }
+
+    return num_wrong ? 1 : 0;
+}
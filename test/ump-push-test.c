@@ -0,0 +1,197 @@
+/**
+ * \brief Testing the UMP push modes
+ */
+
+/*
+ * Copyright (c) 2016, ETH Zurich.
+ * All rights reserved.
+ *
+ * This file is distributed under the terms in the attached LICENSE file.
+ * If you do not find this file, copies can be found by writing to:
+ * ETH Zurich D-INFK, Universitaetstr. 6, CH-8092 Zurich. Attn: Systems Group.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <smlt.h>
+#include <smlt_message.h>
+#include <smlt_queuepair.h>
+
+// the queue wraps around several times
+#define NUM_MSGS (10 * SMLT_UMP_DEFAULT_SLOTS + 3)
+
+static volatile int num_wrong = 0;
+
+#define CHECK(cond)                                                         \
+    do {                                                                    \
+        if (!(cond)) {                                                      \
+            printf("check failed: %s (line %d)\n", #cond, __LINE__);        \
+            __sync_fetch_and_add(&num_wrong, 1);                            \
+        }                                                                   \
+    } while (0)
+
+/// the messages differ in length and content
+static uint32_t msg_words(uint64_t i)
+{
+    return 1 + i % SMLT_UMP_PAYLOAD_WORDS;
+}
+
+static smlt_msg_payload_t msg_word(uint64_t i, uint32_t word, uint32_t dir)
+{
+    return (i << 8) | (dir << 4) | word;
+}
+
+static void send_all(struct smlt_qp *qp, struct smlt_msg *msg, uint32_t dir)
+{
+    for (uint64_t i = 0; i < NUM_MSGS; i++) {
+        msg->words = msg_words(i);
+        for (uint32_t w = 0; w < msg->words; w++) {
+            msg->data[w] = msg_word(i, w, dir);
+        }
+        CHECK(smlt_err_is_ok(smlt_queuepair_send(qp, msg)));
+    }
+}
+
+/// every message arrives once, in order, with its content
+static void recv_all(struct smlt_qp *qp, struct smlt_msg *msg, uint32_t dir)
+{
+    for (uint64_t i = 0; i < NUM_MSGS; i++) {
+        msg->words = msg_words(i);
+        CHECK(smlt_err_is_ok(smlt_queuepair_recv(qp, msg)));
+
+        bool ok = true;
+        for (uint32_t w = 0; w < msg->words; w++) {
+            ok = ok && (msg->data[w] == msg_word(i, w, dir));
+        }
+        if (!ok) {
+            printf("wrong message %lu in direction %u\n", i, dir);
+            __sync_fetch_and_add(&num_wrong, 1);
+        }
+    }
+}
+
+static void* thr_src(void* arg)
+{
+    struct smlt_qp *qp = (struct smlt_qp *)arg;
+    struct smlt_msg *msg = smlt_message_alloc(56);
+
+    send_all(qp, msg, 0);
+    recv_all(qp, msg, 1);
+
+    smlt_message_free(msg);
+    return NULL;
+}
+
+static void* thr_dst(void* arg)
+{
+    struct smlt_qp *qp = (struct smlt_qp *)arg;
+    struct smlt_msg *msg = smlt_message_alloc(56);
+
+    recv_all(qp, msg, 0);
+    send_all(qp, msg, 1);
+
+    smlt_message_free(msg);
+    return NULL;
+}
+
+/// the mode a queue gets when the CPU features are taken into account
+static smlt_ump_push_t expected_mode(smlt_ump_push_t push)
+{
+    if (push == SMLT_UMP_PUSH_CLWB && !smlt_arch_has_clwb()) {
+        return SMLT_UMP_PUSH_NONE;
+    }
+    if (push == SMLT_UMP_PUSH_CLDEMOTE && !smlt_arch_has_cldemote()) {
+        return SMLT_UMP_PUSH_NONE;
+    }
+    return push;
+}
+
+static void test_names(void)
+{
+    for (smlt_ump_push_t p = 0; p < SMLT_UMP_PUSH_NUM_MODES; p++) {
+        CHECK(strcmp(smlt_ump_queue_push_name(p), "unknown") != 0);
+    }
+    CHECK(strcmp(smlt_ump_queue_push_name(SMLT_UMP_PUSH_NONE), "none") == 0);
+    CHECK(strcmp(smlt_ump_queue_push_name(SMLT_UMP_PUSH_NUM_MODES),
+                 "unknown") == 0);
+}
+
+static void test_select(void)
+{
+    unsetenv("SMLT_UMP_PUSH");
+    unsetenv("SMLT_UMP_PUSH_LOCAL");
+    CHECK(smlt_ump_queue_push_mode(0, 1) == SMLT_UMP_PUSH_NONE);
+
+    // only queues between NUMA nodes, unless asked for
+    setenv("SMLT_UMP_PUSH", "stream", 1);
+    CHECK(smlt_ump_queue_push_mode(0, 1) == SMLT_UMP_PUSH_STREAM);
+    CHECK(smlt_ump_queue_push_mode(1, 0) == SMLT_UMP_PUSH_STREAM);
+    CHECK(smlt_ump_queue_push_mode(1, 1) == SMLT_UMP_PUSH_NONE);
+    setenv("SMLT_UMP_PUSH_LOCAL", "1", 1);
+    CHECK(smlt_ump_queue_push_mode(1, 1) == SMLT_UMP_PUSH_STREAM);
+
+    for (smlt_ump_push_t p = 0; p < SMLT_UMP_PUSH_NUM_MODES; p++) {
+        setenv("SMLT_UMP_PUSH", smlt_ump_queue_push_name(p), 1);
+        CHECK(smlt_ump_queue_push_mode(0, 1) == expected_mode(p));
+    }
+
+    setenv("SMLT_UMP_PUSH", "nosuchmode", 1);
+    CHECK(smlt_ump_queue_push_mode(0, 1) == SMLT_UMP_PUSH_NONE);
+
+    unsetenv("SMLT_UMP_PUSH");
+    unsetenv("SMLT_UMP_PUSH_LOCAL");
+}
+
+static void run(smlt_ump_push_t push)
+{
+    struct smlt_qp *qp1 = NULL;
+    struct smlt_qp *qp2 = NULL;
+    pthread_t tids[2];
+    errval_t err;
+
+    // the test cores may share a NUMA node
+    setenv("SMLT_UMP_PUSH", smlt_ump_queue_push_name(push), 1);
+    setenv("SMLT_UMP_PUSH_LOCAL", "1", 1);
+
+    err = smlt_queuepair_create(SMLT_QP_TYPE_UMP, &qp1, &qp2, 0, 1);
+    CHECK(smlt_err_is_ok(err));
+    if (smlt_err_is_fail(err)) {
+        return;
+    }
+
+    CHECK(qp1->q.ump.tx.push == expected_mode(push));
+    CHECK(qp2->q.ump.tx.push == expected_mode(push));
+
+    pthread_create(&tids[0], NULL, thr_src, (void *)qp1);
+    pthread_create(&tids[1], NULL, thr_dst, (void *)qp2);
+
+    pthread_join(tids[0], NULL);
+    pthread_join(tids[1], NULL);
+
+    smlt_queuepair_destroy(qp1);
+    smlt_queuepair_destroy(qp2);
+
+    unsetenv("SMLT_UMP_PUSH");
+    unsetenv("SMLT_UMP_PUSH_LOCAL");
+}
+
+int main(int argc, char **argv)
+{
+    test_names();
+    test_select();
+
+    for (smlt_ump_push_t p = 0; p < SMLT_UMP_PUSH_NUM_MODES; p++) {
+        run(p);
+    }
+
+    if (!num_wrong) {
+        printf("UMP Push Test Success\n");
+    } else {
+        printf("UMP Push Test Failed \n");
+    }
+
+    return num_wrong ? 1 : 0;
+}